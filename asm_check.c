@@ -0,0 +1,1443 @@
+// Host check of the renderer assembly.
+// Assembles tile_render_direct.asm and the optional modules (multicolour.asm,
+// sound.asm, level_pack.asm) with z80_asm, runs every routine the build
+// defines on the host Z80 core over random screens, tiles and maps, and
+// compares all of memory afterwards with a C model of what the routine must
+// write. Catches wrong bytes, stray writes, an unbalanced SP, a clobbered
+// IX/IY (the sdcc_iy frame pointer) and runs over the routine's "; @budget".
+//
+// Usage: ./asm_check [options] <file.asm> [<file.asm> ...]
+//   -DNAME[=N]         define a symbol before assembly (as z88dk-z80asm -D):
+//                      TILE_FLIP, TILE_ATTRS, MULTICOLOUR, SOUND, MC_LINE_T
+//   -I <dir>           search <dir> first for INCLUDE files (a viewport.inc
+//                      from generate_viewport for another viewport or METATILE)
+//   --levels <tap>     levels.tap for level_pack.asm: load the banks with
+//                      _level_pack_load, then unpack every level
+//   --rounds <n>       random cases per routine (default 40)
+//   --seed <n>         random seed (default 1)
+//   --verbose          print every routine's T-state range
+//
+// Per build flag:
+//   TILE_FLIP     map bytes carry random flip bits (scratch tile excluded)
+//   TILE_ATTRS    the edge attribute routines; the shifts move attributes
+//   MULTICOLOUR   the ranged entries, _mc_colour_row, and _mc_raster against
+//                 a beam model: a band's colours must be in its attribute row
+//                 from before the ULA fetches the band's first line until
+//                 after it fetches its last one. Gated contended, at 224 or
+//                 228 T per line (the pads include MC_CONTENTION_T); the
+//                 uncontended margin is reported.
+//   SOUND         every other case takes an interrupt at a random point: the
+//                 LUT must come back intact and the tick be deferred or
+//                 played; the player's AY writes must follow the song
+//   METATILE      the expanders, and the edge routines read their strips
+//
+// Exit status is non-zero if any routine differs from its model.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "z80_asm.h"
+#include "z80_core.h"
+
+#define CODE_ORG         0x8000
+#define TILES_ADDR       0x6000
+#define REV_ADDR         0x6100
+#define ATTR_ADDR        0x6200
+#define META_ADDR        0x6300
+#define MC_TABLE_ADDR    0x6400
+#define SCRATCH_ADDR     (TILES_ADDR + 31 * 8)
+#define MC_SRC_ADDR      0xD000     // _mc_src (64 band pointers)
+#define OCC_ADDR         0xB000     // _map_row_occ for level_pack.asm (below the bank)
+#define OCC_BYTES        0x1000
+#define HOST_ADDR        0xE100     // band buffer and edge strips
+#define STACK_LOW        0xFE00
+#define STACK_TOP        0xFF00
+#define IDLE_ADDR        0xFFE0     // HALT / JR $-1: the main loop's HALT
+#define RET_ADDR         0xFFF0     // a call ends when PC gets here
+#define SAVED_IX         0x5C3A
+#define SAVED_IY         0x1DE7
+#define MAX_CALL_T       2000000UL
+#define MAX_DIFFS        4
+#define MAX_DEFINES      32
+#define MAX_BLOCKS       8
+
+#define LD_BYTES         0x0556
+#define BANK_PORT_BIT    0x8000     // 0x7FFD: A15 = 0, A1 = 0
+#define AY_SELECT_BIT    0x4000     // 0xFFFD / 0xBFFD: A15 = 1, A1 = 0
+#define AY_REGS          11
+#define IN_LATCH_T       5          // IN r,(C): the core is at T 6, the ULA latches at T 11
+
+// Flags a routine needs in the build
+#define NEED_ATTRS       0x01
+#define NEED_MC          0x02
+#define NEED_META        0x04
+#define NEED_CELLS       0x08       // cell maps only (a metatile map stages one edge)
+
+typedef struct {
+    int cols, rows, col_offset, start_row, height;
+    int map_w, map_h, stride, col_step;
+    long map_addr;
+    int metatile, col_blocks, row_blocks;
+    long col_strip, row_strip;
+    int tile_flip, tile_attrs, multicolour, sound;
+    int step_max;
+    long lut_lo, lut_hi;        // LUT (with the SOUND guard word)
+    long mc_bands, col_strip_host, row_strip_host;
+    int sentinel_col;           // MULTICOLOUR beam-sync sentinel
+    uint8_t sentinel_attr, sentinel_end;
+} build_config;
+
+typedef struct {
+    const char *name;           // routine label
+    const char *budget;         // its "; @budget" constant, NULL if none
+    int need;
+    void (*one)(void);          // one random case: arguments, call, model
+} routine_check;
+
+typedef struct {
+    int t, row;
+    long sfx_ptr, sfx_start;
+    uint8_t regs[AY_REGS];
+} song_model;
+
+typedef struct {
+    unsigned long t;            // end of the instruction that wrote it
+    uint8_t value;
+} attr_write;
+
+static uint8_t image[65536];    // memory after assembly
+static uint8_t mem[65536];
+static uint8_t expect[65536];
+static uint8_t banks[8][16384];
+static int bank_paged;
+
+static z80 cpu;
+static z80_asm *as;
+static long code_lo, code_hi;
+static build_config vp;
+
+static int rounds = 40;
+static int verbose;
+static unsigned long rng_state = 1;
+
+static const char *cur_name;    // routine being checked
+static int cur_case;
+static int failures;
+static int total_cases;
+static long allow_lo, allow_hi; // bytes a case may leave changed
+static unsigned long inject_t;  // call(): interrupt after this many T (0 = none)
+static long int_sp;             // SP the injected interrupt found, -1 if none
+static void (*step_hook)(void); // called after every instruction of a call
+static int beam_on;             // floating bus on the unused (odd) ports
+static int line_t = ZX_LINE_TSTATES;
+static unsigned long frame_len = ZX_FRAME_TSTATES;
+static unsigned long first_fetch = 14338;
+
+static uint8_t ay_select, ay[16];
+static int ay_writes;
+
+static uint8_t tap_data[MAX_BLOCKS][16384];
+static long tap_len[MAX_BLOCKS];
+static int tap_blocks, tap_next;
+
+static void die(const char *msg) {
+    fprintf(stderr, "%s\n", msg);
+    exit(1);
+}
+
+static unsigned long rnd(unsigned long n) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    rng_state &= 0xFFFFFFFFUL;
+    return n ? rng_state % n : 0;
+}
+
+static long sym(const char *name) {
+    long v;
+    if (!z80_asm_lookup(as, name, &v)) {
+        fprintf(stderr, "Error: %s is not defined\n", name);
+        exit(1);
+    }
+    return v;
+}
+
+static long sym_or(const char *name, long fallback) {
+    long v;
+    return z80_asm_lookup(as, name, &v) ? v : fallback;
+}
+
+static int rd16(const uint8_t *m, long a) {
+    return m[a & 0xFFFF] | (m[(a + 1) & 0xFFFF] << 8);
+}
+
+static uint8_t rev8(uint8_t b) {
+    uint8_t r = 0;
+    for (int i = 0; i < 8; i++)
+        if (b & (1 << i)) r |= (uint8_t)(0x80 >> i);
+    return r;
+}
+
+// --- Failure reporting ---
+
+static void fail(const char *fmt, const char *detail) {
+    fprintf(stderr, "FAIL %s (case %d): ", cur_name, cur_case);
+    fprintf(stderr, fmt, detail);
+    fprintf(stderr, "\n");
+    failures++;
+}
+
+static const char *where(long a) {
+    static char buf[64];
+    if (a >= 0x4000 && a < 0x5800) {
+        int y = (int)(((a >> 5) & 0xC0) | ((a >> 8) & 0x07) | ((a >> 2) & 0x38));
+        snprintf(buf, sizeof(buf), " (screen line %d, col %ld)", y, a & 31);
+    } else if (a >= 0x5800 && a < 0x5B00) {
+        snprintf(buf, sizeof(buf), " (attribute row %ld, col %ld)", (a - 0x5800) / 32, a & 31);
+    } else if (a >= vp.lut_lo && a < vp.lut_hi) {
+        snprintf(buf, sizeof(buf), " (LUT byte %ld)", a - vp.lut_lo);
+    } else {
+        buf[0] = 0;
+    }
+    return buf;
+}
+
+// Every byte outside the program image and the stack must match the model;
+// the LUT inside the image must be untouched
+static void compare(void) {
+    int diffs = 0;
+    char msg[128];
+    for (long a = 0x4000; a < STACK_LOW; a++) {
+        int skip = (a >= code_lo && a < code_hi) || (a >= allow_lo && a < allow_hi)
+            || (vp.tile_flip && a >= SCRATCH_ADDR && a < SCRATCH_ADDR + 8);
+        if (a >= vp.lut_lo && a < vp.lut_hi) {
+            if (mem[a] == image[a]) continue;
+            snprintf(msg, sizeof(msg), "0x%04lX is 0x%02X, expected 0x%02X%s",
+                     a, mem[a], image[a], where(a));
+        } else if (skip || mem[a] == expect[a]) {
+            continue;
+        } else {
+            snprintf(msg, sizeof(msg), "0x%04lX is 0x%02X, expected 0x%02X%s",
+                     a, mem[a], expect[a], where(a));
+        }
+        if (diffs++ < MAX_DIFFS) fail("%s", msg);
+    }
+    if (diffs > MAX_DIFFS) {
+        snprintf(msg, sizeof(msg), "%d more bytes differ", diffs - MAX_DIFFS);
+        fail("%s", msg);
+    }
+}
+
+// --- Machine: 128K paging, AY, floating bus, ROM LD-BYTES ---
+
+static void page_bank(int bank) {
+    if (bank == bank_paged) return;
+    memcpy(banks[bank_paged], mem + 0xC000, 16384);
+    memcpy(mem + 0xC000, banks[bank], 16384);
+    bank_paged = bank;
+}
+
+// Byte the ULA puts on the bus at frame time t: per 8 T of the 128 T of a
+// display line, pixel, attribute, pixel, attribute of two columns, then idle
+static uint8_t floating_bus(unsigned long t) {
+    t %= frame_len;
+    if (t < first_fetch) return 0xFF;
+    t -= first_fetch;
+    unsigned long y = t / (unsigned long)line_t, x = t % (unsigned long)line_t;
+    if (y >= 192 || x >= 128 || (x & 7) >= 4) return 0xFF;
+    int col = (int)(x >> 3) * 2 + (int)((x >> 1) & 1);
+    if (x & 1) return mem[0x5800 + (y >> 3) * 32 + col];
+    return mem[0x4000 | ((y & 0xC0) << 5) | ((y & 7) << 8) | ((y & 0x38) << 2) | col];
+}
+
+// Frame time at which the ULA fetches the attribute of screen column col
+// for display line y
+static unsigned long attr_fetch_t(int y, int col) {
+    return first_fetch + (unsigned long)y * line_t + (col >> 1) * 8 + 1 + 2 * (col & 1);
+}
+
+static uint8_t io_in(void *ctx, uint16_t port) {
+    (void)ctx;
+    if (beam_on && (port & 1)) return floating_bus(cpu.frame_t + cpu.pending + IN_LATCH_T);
+    return 0xFF;
+}
+
+static void io_out(void *ctx, uint16_t port, uint8_t value) {
+    (void)ctx;
+    if (port & 0x02) return;
+    if (!(port & BANK_PORT_BIT)) {
+        page_bank(value & 7);
+    } else if (port & AY_SELECT_BIT) {
+        ay_select = value & 0x0F;
+    } else {
+        ay[ay_select] = value;
+        ay_writes++;
+    }
+}
+
+// ROM LD-BYTES (0x0556): the next levels.tap block to IX, DE bytes; returns
+// with carry set (loaded) and interrupts on, as the ROM does
+static void ld_bytes(void) {
+    char msg[96];
+    int len = cpu.d << 8 | cpu.e;
+    if (tap_next >= tap_blocks) {
+        fail("%s", "LD-BYTES called past the last levels.tap block");
+    } else if (len != tap_len[tap_next] || cpu.a != 0xFF || !(cpu.f & 1)) {
+        snprintf(msg, sizeof(msg), "LD-BYTES block %d: DE %d, A 0x%02X, CF %d (block is %ld bytes)",
+                 tap_next, len, cpu.a, cpu.f & 1, tap_len[tap_next]);
+        fail("%s", msg);
+    } else {
+        for (int i = 0; i < len; i++)
+            if (cpu.ix + i >= 0x4000) mem[(cpu.ix + i) & 0xFFFF] = tap_data[tap_next][i];
+        cpu.ix = (uint16_t)(cpu.ix + len);
+        cpu.d = cpu.e = 0;
+    }
+    tap_next++;
+    cpu.f |= 1;
+    cpu.iff1 = cpu.iff2 = 1;
+    cpu.pc = (uint16_t)rd16(mem, cpu.sp);
+    cpu.sp = (uint16_t)(cpu.sp + 2);
+}
+
+// Call a routine the sdcc_iy way: char arguments are one byte, words two,
+// above the return address. Returns its T-states, 0 if it did not return.
+static unsigned long call(const char *name, const uint8_t *args, int nargs) {
+    char msg[96];
+    long addr = sym(name);
+    uint16_t sp = (uint16_t)(STACK_TOP - 2 - nargs);
+    mem[sp] = RET_ADDR & 0xFF;
+    mem[sp + 1] = RET_ADDR >> 8;
+    if (nargs) memcpy(mem + sp + 2, args, (size_t)nargs);
+    cpu.sp = sp;
+    cpu.pc = (uint16_t)addr;
+    cpu.ix = SAVED_IX;
+    cpu.iy = SAVED_IY;
+    cpu.halted = 0;
+    int_sp = -1;
+
+    unsigned long t0 = cpu.tstates;
+    while (cpu.pc != RET_ADDR) {
+        if (inject_t && int_sp < 0 && cpu.tstates - t0 >= inject_t) {
+            uint16_t s = cpu.sp;
+            if (z80_interrupt(&cpu)) int_sp = s;
+        }
+        if (cpu.pc == LD_BYTES) {
+            ld_bytes();
+            continue;
+        }
+        z80_step(&cpu);
+        if (step_hook) step_hook();
+        if (cpu.tstates - t0 > MAX_CALL_T) {
+            snprintf(msg, sizeof(msg), "did not return (PC 0x%04X after %lu T)", cpu.pc, MAX_CALL_T);
+            fail("%s", msg);
+            return 0;
+        }
+    }
+    if (cpu.sp != (uint16_t)(sp + 2)) {
+        snprintf(msg, sizeof(msg), "returned with SP 0x%04X, expected 0x%04X", cpu.sp, (uint16_t)(sp + 2));
+        fail("%s", msg);
+    }
+    if (cpu.ix != SAVED_IX || cpu.iy != SAVED_IY) {
+        snprintf(msg, sizeof(msg), "returned with IX 0x%04X IY 0x%04X (not preserved)", cpu.ix, cpu.iy);
+        fail("%s", msg);
+    }
+    return cpu.tstates - t0;
+}
+
+// --- Random test state ---
+
+static uint8_t random_cell(void) {
+    if (vp.tile_flip) {
+        int flip = (int)rnd(4);
+        if (flip) return (uint8_t)((1 + rnd(30)) | (flip << 6));
+        return (uint8_t)rnd(31);          // not the scratch tile
+    }
+    return (uint8_t)rnd(32);
+}
+
+static uint8_t random_map_byte(void) {
+    int block = vp.metatile * vp.metatile;
+    if (block) return (uint8_t)(rnd(256 / block) * block);
+    return random_cell();
+}
+
+static void randomize(void) {
+    memcpy(mem, image, sizeof(mem));
+    for (long a = 0x4000; a < 0x5B00; a++) {
+        uint8_t v = (uint8_t)rnd(256);
+        mem[a] = v == vp.sentinel_attr ? 0 : v;   // no stray mc_raster sentinels
+    }
+    for (long a = TILES_ADDR; a < TILES_ADDR + 256; a++) mem[a] = (uint8_t)rnd(256);
+    memset(mem + TILES_ADDR, 0, 8);       // tile 0 is blank
+    for (int i = 0; i < 256; i++) mem[REV_ADDR + i] = rev8((uint8_t)i);
+    for (long a = ATTR_ADDR; a < MC_TABLE_ADDR + 1024; a++) mem[a] = (uint8_t)rnd(256);
+    if (vp.metatile)
+        for (int i = 0; i < 256; i++) mem[META_ADDR + i] = random_cell();
+    long map_end = vp.map_addr + (long)vp.stride * vp.map_h;
+    for (long a = vp.map_addr; a < map_end && a < code_lo; a++) mem[a] = random_map_byte();
+    if (vp.metatile) {
+        for (int i = 0; i < vp.col_blocks * vp.metatile; i++) mem[vp.col_strip + i] = random_cell();
+        for (int i = 0; i < vp.row_blocks * vp.metatile; i++) mem[vp.row_strip + i] = random_cell();
+    }
+    for (long a = MC_SRC_ADDR; a < STACK_LOW; a++) mem[a] = (uint8_t)rnd(256);
+    bank_paged = 0;
+    allow_lo = allow_hi = 0;
+}
+
+// --- Models (on expect[], the memory before the call) ---
+
+static long scr_addr(int y, int col) {
+    int sy = vp.start_row * 8 + y;
+    return 0x4000 | ((sy & 0xC0) << 5) | ((sy & 0x07) << 8) | ((sy & 0x38) << 2) | col;
+}
+
+static long attr_addr(int row, int col) {
+    return 0x5800 + (vp.start_row + row) * 32 + col;
+}
+
+static uint8_t tile_byte(uint8_t t, int s) {
+    if (vp.tile_flip && t >= 0x40) {
+        uint8_t b = expect[TILES_ADDR + (t & 0x1F) * 8 + ((t & 0x40) ? 7 - s : s)];
+        return (t & 0x80) ? rev8(b) : b;
+    }
+    return expect[TILES_ADDR + ((t * 8 + s) & 0xFF)];
+}
+
+// Cell r down an edge column from p (a metatile strip stays in its page)
+static long col_cell(long p, int r) {
+    if (vp.col_step == 1) return (p & 0xFF00) | ((p + r) & 0xFF);
+    return p + (long)r * vp.col_step;
+}
+
+static void model_column(int col, long p, int first, int rows) {
+    for (int r = 0; r < rows; r++) {
+        uint8_t t = expect[col_cell(p, r)];
+        for (int s = 0; s < 8; s++)
+            expect[scr_addr((first + r) * 8 + s, col)] = t ? tile_byte(t, s) : 0;
+    }
+}
+
+static void model_row(int row, long p) {
+    for (int c = 0; c < vp.cols; c++)
+        for (int s = 0; s < 8; s++)
+            expect[scr_addr(row * 8 + s, vp.col_offset + c)] = tile_byte(expect[p + c], s);
+}
+
+static void copy_line(int dst_y, int src_y) {
+    memmove(expect + scr_addr(dst_y, vp.col_offset), expect + scr_addr(src_y, vp.col_offset), (size_t)vp.cols);
+}
+
+static void copy_attr_row(int dst, int src) {
+    memmove(expect + attr_addr(dst, vp.col_offset), expect + attr_addr(src, vp.col_offset), (size_t)vp.cols);
+}
+
+// Horizontal shift of char rows [first, first + rows) by n columns
+// (n > 0: left, the content moves to lower columns)
+static void model_shift_h(int first, int rows, int n, int attrs) {
+    int k = n > 0 ? n : -n;
+    for (int y = first * 8; y < (first + rows) * 8; y++) {
+        long a = scr_addr(y, vp.col_offset);
+        if (n > 0) memmove(expect + a, expect + a + k, (size_t)(vp.cols - k));
+        else memmove(expect + a + k, expect + a, (size_t)(vp.cols - k));
+    }
+    for (int r = first; attrs && r < first + rows; r++) {
+        long a = attr_addr(r, vp.col_offset);
+        if (n > 0) memmove(expect + a, expect + a + k, (size_t)(vp.cols - k));
+        else memmove(expect + a + k, expect + a, (size_t)(vp.cols - k));
+    }
+}
+
+// Destination char rows [first, first + rows) from n rows below (n > 0)
+// or above (n < 0), in the order that reads every source before it is
+// overwritten
+static void model_shift_v(int first, int rows, int n, int attrs) {
+    if (n > 0) {
+        for (int y = first * 8; y < (first + rows) * 8; y++) copy_line(y, y + n * 8);
+        for (int r = first; attrs && r < first + rows; r++) copy_attr_row(r, r + n);
+    } else {
+        for (int y = (first + rows) * 8 - 1; y >= first * 8; y--) copy_line(y, y + n * 8);
+        for (int r = first + rows - 1; attrs && r >= first; r--) copy_attr_row(r, r + n);
+    }
+}
+
+// --- Random arguments ---
+
+static void put16(uint8_t *a, long v) {
+    a[0] = (uint8_t)(v & 0xFF);
+    a[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+static int random_col(int width) {
+    return vp.col_offset + (int)rnd((unsigned long)(vp.cols - width + 1));
+}
+
+// An edge column's map pointer (width adjacent columns on the map)
+static long random_col_ptr(int width) {
+    if (vp.metatile) return vp.col_strip + (long)rnd((unsigned long)vp.metatile);
+    long x = (long)rnd((unsigned long)(vp.map_w - width + 1));
+    long y = (long)rnd((unsigned long)(vp.map_h - vp.rows + 1));
+    return vp.map_addr + y * vp.stride + x;
+}
+
+static long random_row_ptr(int height) {
+    if (vp.metatile) return vp.row_strip + (long)rnd((unsigned long)vp.metatile);
+    long x = (long)rnd((unsigned long)(vp.map_w - vp.cols + 1));
+    long y = (long)rnd((unsigned long)(vp.map_h - height + 1));
+    return vp.map_addr + y * vp.stride + x;
+}
+
+static int random_step(int max) {
+    return 1 + (int)rnd((unsigned long)max);
+}
+
+// --- One case per routine ---
+
+static unsigned long case_t;    // T-states of the case's call
+
+static void run(const char *name, const uint8_t *args, int nargs) {
+    case_t = call(name, args, nargs);
+}
+
+static void one_render_column(void) {
+    uint8_t a[3];
+    int col = random_col(1);
+    long p = random_col_ptr(1);
+    a[0] = (uint8_t)col;
+    put16(a + 1, p);
+    model_column(col, p, 0, vp.rows);
+    run("_render_dirty_column", a, 3);
+}
+
+static void one_render_row(void) {
+    uint8_t a[3];
+    int row = (int)rnd((unsigned long)vp.rows);
+    long p = random_row_ptr(1);
+    a[0] = (uint8_t)row;
+    put16(a + 1, p);
+    model_row(row, p);
+    run("_render_dirty_row", a, 3);
+}
+
+static void one_clear_column(void) {
+    uint8_t a[1];
+    int col = random_col(1);
+    a[0] = (uint8_t)col;
+    for (int y = 0; y < vp.height; y++) expect[scr_addr(y, col)] = 0;
+    run("_clear_dirty_column", a, 1);
+}
+
+static void one_clear_row(void) {
+    uint8_t a[1];
+    int row = (int)rnd((unsigned long)vp.rows);
+    a[0] = (uint8_t)row;
+    for (int s = 0; s < 8; s++)
+        memset(expect + scr_addr(row * 8 + s, vp.col_offset), 0, (size_t)vp.cols);
+    run("_clear_dirty_row", a, 1);
+}
+
+static void one_prerender_column(void) {
+    uint8_t a[4];
+    long strip = vp.col_strip_host, p = random_col_ptr(1);
+    put16(a, strip);
+    put16(a + 2, p);
+    for (int r = 0; r < vp.rows; r++) {
+        uint8_t t = expect[col_cell(p, r)];
+        for (int s = 0; s < 8; s++) expect[strip + r * 8 + s] = tile_byte(t, s);
+    }
+    run("_prerender_edge_column", a, 4);
+}
+
+static void one_prerender_row(void) {
+    uint8_t a[4];
+    long strip = vp.row_strip_host, p = random_row_ptr(1);
+    put16(a, strip);
+    put16(a + 2, p);
+    for (int c = 0; c < vp.cols; c++)
+        for (int s = 0; s < 8; s++) expect[strip + s * vp.cols + c] = tile_byte(expect[p + c], s);
+    run("_prerender_edge_row", a, 4);
+}
+
+static void one_blit_column(void) {
+    uint8_t a[3];
+    long strip = vp.col_strip_host;
+    int col = random_col(1);
+    a[0] = (uint8_t)col;
+    put16(a + 1, strip);
+    for (int y = 0; y < vp.height; y++) expect[scr_addr(y, col)] = expect[strip + y];
+    // An interrupt's return address may land in the strip (it is consumed)
+    allow_lo = strip - 2;
+    allow_hi = strip + vp.height;
+    run("_blit_edge_column", a, 3);
+}
+
+static void one_blit_row(void) {
+    uint8_t a[3];
+    long strip = vp.row_strip_host;
+    int row = (int)rnd((unsigned long)vp.rows);
+    a[0] = (uint8_t)row;
+    put16(a + 1, strip);
+    for (int s = 0; s < 8; s++)
+        memcpy(expect + scr_addr(row * 8 + s, vp.col_offset), expect + strip + s * vp.cols, (size_t)vp.cols);
+    run("_blit_edge_row", a, 3);
+}
+
+static void one_save_column(void) {
+    uint8_t a[3];
+    long strip = vp.col_strip_host;
+    int col = random_col(1);
+    a[0] = (uint8_t)col;
+    put16(a + 1, strip);
+    for (int y = 0; y < vp.height; y++) expect[strip + y] = expect[scr_addr(y, col)];
+    allow_lo = strip - 2;               // the guard bytes in front
+    allow_hi = strip;
+    run("_save_edge_column", a, 3);
+}
+
+static void one_save_row(void) {
+    uint8_t a[3];
+    long strip = vp.row_strip_host;
+    int row = (int)rnd((unsigned long)vp.rows);
+    a[0] = (uint8_t)row;
+    put16(a + 1, strip);
+    for (int s = 0; s < 8; s++)
+        memcpy(expect + strip + s * vp.cols, expect + scr_addr(row * 8 + s, vp.col_offset), (size_t)vp.cols);
+    run("_save_edge_row", a, 3);
+}
+
+static void one_shift_left(void) {
+    model_shift_h(0, vp.rows, 1, vp.tile_attrs);
+    run("_shift_viewport_left", NULL, 0);
+}
+
+static void one_shift_right(void) {
+    model_shift_h(0, vp.rows, -1, vp.tile_attrs);
+    run("_shift_viewport_right", NULL, 0);
+}
+
+static void one_shift_up(void) {
+    model_shift_v(0, vp.rows - 1, 1, vp.tile_attrs);
+    run("_shift_viewport_up", NULL, 0);
+}
+
+static void one_shift_down(void) {
+    model_shift_v(1, vp.rows - 1, -1, vp.tile_attrs);
+    run("_shift_viewport_down", NULL, 0);
+}
+
+static void one_shift_left_n(void) {
+    uint8_t a[1];
+    int n = random_step(vp.step_max);
+    a[0] = (uint8_t)n;
+    model_shift_h(0, vp.rows, n, vp.tile_attrs);
+    run("_shift_viewport_left_n", a, 1);
+}
+
+static void one_shift_right_n(void) {
+    uint8_t a[1];
+    int n = random_step(vp.step_max);
+    a[0] = (uint8_t)n;
+    model_shift_h(0, vp.rows, -n, vp.tile_attrs);
+    run("_shift_viewport_right_n", a, 1);
+}
+
+// The vertical _n shifts take n up to 7 (one attribute row per n × 32)
+static void one_shift_up_n(void) {
+    uint8_t a[1];
+    int n = random_step(vp.rows - 1 < 7 ? vp.rows - 1 : 7);
+    a[0] = (uint8_t)n;
+    model_shift_v(0, vp.rows - n, n, vp.tile_attrs);
+    run("_shift_viewport_up_n", a, 1);
+}
+
+static void one_shift_down_n(void) {
+    uint8_t a[1];
+    int n = random_step(vp.rows - 1 < 7 ? vp.rows - 1 : 7);
+    a[0] = (uint8_t)n;
+    model_shift_v(n, vp.rows - n, -n, vp.tile_attrs);
+    run("_shift_viewport_down_n", a, 1);
+}
+
+static void one_render_columns(void) {
+    uint8_t a[4];
+    int n = random_step(vp.step_max);
+    int col = random_col(n);
+    long p = random_col_ptr(n);
+    a[0] = (uint8_t)col;
+    put16(a + 1, p);
+    a[3] = (uint8_t)n;
+    for (int i = 0; i < n; i++) model_column(col + i, p + i, 0, vp.rows);
+    run("_render_dirty_columns", a, 4);
+}
+
+static void one_render_rows(void) {
+    uint8_t a[4];
+    int n = random_step(vp.step_max);
+    int row = (int)rnd((unsigned long)(vp.rows - n + 1));
+    long p = random_row_ptr(n);
+    a[0] = (uint8_t)row;
+    put16(a + 1, p);
+    a[3] = (uint8_t)n;
+    for (int i = 0; i < n; i++) model_row(row + i, p + (long)i * vp.stride);
+    run("_render_dirty_rows", a, 4);
+}
+
+static void one_attr_column(void) {
+    uint8_t a[3];
+    int col = random_col(1);
+    long p = random_col_ptr(1);
+    a[0] = (uint8_t)col;
+    put16(a + 1, p);
+    for (int r = 0; r < vp.rows; r++) expect[attr_addr(r, col)] = expect[ATTR_ADDR + expect[col_cell(p, r)]];
+    run("_attr_dirty_column", a, 3);
+}
+
+static void one_attr_row(void) {
+    uint8_t a[3];
+    int row = (int)rnd((unsigned long)vp.rows);
+    long p = random_row_ptr(1);
+    a[0] = (uint8_t)row;
+    put16(a + 1, p);
+    for (int c = 0; c < vp.cols; c++)
+        expect[attr_addr(row, vp.col_offset + c)] = expect[ATTR_ADDR + expect[p + c]];
+    run("_attr_dirty_row", a, 3);
+}
+
+// A step slice: char rows [first, first + rows)
+static void random_slice(int lo, int top, int *first, int *rows) {
+    *first = lo + (int)rnd((unsigned long)(top - lo));
+    *rows = 1 + (int)rnd((unsigned long)(top - *first));
+}
+
+static void one_render_column_rows(void) {
+    uint8_t a[5];
+    int first, rows;
+    random_slice(0, vp.rows, &first, &rows);
+    int col = random_col(1);
+    long p = col_cell(random_col_ptr(1), first);
+    a[0] = (uint8_t)col;
+    put16(a + 1, p);
+    a[3] = (uint8_t)first;
+    a[4] = (uint8_t)rows;
+    model_column(col, p, first, rows);
+    run("_render_dirty_column_rows", a, 5);
+}
+
+static void one_shift_left_rows(void) {
+    uint8_t a[2];
+    int first, rows;
+    random_slice(0, vp.rows, &first, &rows);
+    a[0] = (uint8_t)first;
+    a[1] = (uint8_t)rows;
+    model_shift_h(first, rows, 1, 0);
+    run("_shift_viewport_left_rows", a, 2);
+}
+
+static void one_shift_right_rows(void) {
+    uint8_t a[2];
+    int first, rows;
+    random_slice(0, vp.rows, &first, &rows);
+    a[0] = (uint8_t)first;
+    a[1] = (uint8_t)rows;
+    model_shift_h(first, rows, -1, 0);
+    run("_shift_viewport_right_rows", a, 2);
+}
+
+static void one_shift_up_rows(void) {
+    uint8_t a[2];
+    int first, rows;
+    random_slice(0, vp.rows - 1, &first, &rows);
+    a[0] = (uint8_t)first;
+    a[1] = (uint8_t)rows;
+    model_shift_v(first, rows, 1, 0);
+    run("_shift_viewport_up_rows", a, 2);
+}
+
+static void one_shift_down_rows(void) {
+    uint8_t a[2];
+    int first, rows;
+    random_slice(1, vp.rows, &first, &rows);
+    a[0] = (uint8_t)first;
+    a[1] = (uint8_t)rows;
+    model_shift_v(first, rows, -1, 0);
+    run("_shift_viewport_down_rows", a, 2);
+}
+
+static void one_mc_colour_row(void) {
+    uint8_t a[5];
+    int band_bytes = 2 * vp.cols;
+    int h = (int)rnd((unsigned long)vp.cols);
+    long ring = vp.mc_bands + (long)rnd((unsigned long)vp.rows) * 4 * band_bytes;
+    long p = random_row_ptr(1);
+    a[0] = (uint8_t)h;
+    put16(a + 1, ring);
+    put16(a + 3, p);
+    for (int k = 0; k < 4; k++)
+        for (int i = 0; i < band_bytes; i++) {
+            int c = ((i - h) % vp.cols + vp.cols) % vp.cols;
+            expect[ring + k * band_bytes + i] = expect[MC_TABLE_ADDR + k * 256 + expect[p + c]];
+        }
+    run("_mc_colour_row", a, 5);
+}
+
+// The beam-sync sentinel two rows above the viewport, 16 columns from
+// SENTINEL_COL: SENTINEL_ATTR, then SENTINEL_END_ATTR in the row between,
+// over cleared pixels
+#define SENTINEL_COLS 16
+
+static void write_sentinel(uint8_t *m) {
+    int row = vp.start_row - 2, col = vp.sentinel_col;
+    memset(m + 0x5800 + row * 32 + col, vp.sentinel_attr, SENTINEL_COLS);
+    memset(m + 0x5800 + (row + 1) * 32 + col, vp.sentinel_end, SENTINEL_COLS);
+    for (int y = row * 8; y < row * 8 + 16; y++) {
+        long a = 0x4000 | ((y & 0xC0) << 5) | ((y & 0x07) << 8) | ((y & 0x38) << 2) | col;
+        memset(m + a, 0, SENTINEL_COLS);
+    }
+}
+
+static void one_mc_init_sync(void) {
+    write_sentinel(expect);
+    run("_mc_init_sync", NULL, 0);
+}
+
+static void one_meta_column(void) {
+    uint8_t a[3];
+    int m = vp.metatile;
+    int sub = (int)rnd((unsigned long)m);
+    long x = (long)rnd((unsigned long)vp.map_w);
+    long y = (long)rnd((unsigned long)(vp.map_h - vp.col_blocks + 1));
+    long p = vp.map_addr + y * vp.stride + x;
+    put16(a, p);
+    a[2] = (uint8_t)sub;
+    for (int b = 0; b < vp.col_blocks; b++) {
+        uint8_t blk = expect[p + (long)b * vp.stride];
+        for (int k = 0; k < m; k++)
+            expect[col_cell(vp.col_strip, b * m + k)] = expect[META_ADDR + ((blk + sub + k * m) & 0xFF)];
+    }
+    run("_meta_expand_column", a, 3);
+}
+
+static void one_meta_row(void) {
+    uint8_t a[3];
+    int m = vp.metatile;
+    int sub = (int)rnd((unsigned long)m) * m;
+    long x = (long)rnd((unsigned long)(vp.map_w - vp.row_blocks + 1));
+    long y = (long)rnd((unsigned long)vp.map_h);
+    long p = vp.map_addr + y * vp.stride + x;
+    put16(a, p);
+    a[2] = (uint8_t)sub;
+    for (int b = 0; b < vp.row_blocks; b++) {
+        uint8_t blk = expect[p + b];
+        for (int k = 0; k < m; k++)
+            expect[vp.row_strip + b * m + k] = expect[META_ADDR + blk + sub + k];
+    }
+    run("_meta_expand_row", a, 3);
+}
+
+static const routine_check checks[] = {
+    { "_render_dirty_column",       "BUDGET_RDC",           0,           one_render_column },
+    { "_render_dirty_row",          "BUDGET_RDR",           0,           one_render_row },
+    { "_clear_dirty_column",        "BUDGET_CDC",           0,           one_clear_column },
+    { "_clear_dirty_row",           "BUDGET_CDR",           0,           one_clear_row },
+    { "_prerender_edge_column",     "BUDGET_PEC",           0,           one_prerender_column },
+    { "_prerender_edge_row",        "BUDGET_PER",           0,           one_prerender_row },
+    { "_blit_edge_column",          "BUDGET_BEC",           0,           one_blit_column },
+    { "_blit_edge_row",             "BUDGET_BER",           0,           one_blit_row },
+    { "_save_edge_column",          "BUDGET_SEC",           0,           one_save_column },
+    { "_save_edge_row",             "BUDGET_SER",           0,           one_save_row },
+    { "_shift_viewport_left",       "BUDGET_SHIFT_H",       0,           one_shift_left },
+    { "_shift_viewport_right",      "BUDGET_SHIFT_H",       0,           one_shift_right },
+    { "_shift_viewport_up",         "BUDGET_SHIFT_UP",      0,           one_shift_up },
+    { "_shift_viewport_down",       "BUDGET_SHIFT_DN",      0,           one_shift_down },
+    { "_shift_viewport_left_n",     "BUDGET_SHIFT_H_N",     0,           one_shift_left_n },
+    { "_shift_viewport_right_n",    "BUDGET_SHIFT_H_N",     0,           one_shift_right_n },
+    { "_shift_viewport_up_n",       "BUDGET_SHIFT_UP_N",    0,           one_shift_up_n },
+    { "_shift_viewport_down_n",     "BUDGET_SHIFT_DN_N",    0,           one_shift_down_n },
+    { "_render_dirty_columns",      "BUDGET_RDCS",          NEED_CELLS,  one_render_columns },
+    { "_render_dirty_rows",         "BUDGET_RDRS",          NEED_CELLS,  one_render_rows },
+    { "_attr_dirty_column",         "BUDGET_ADC",           NEED_ATTRS,  one_attr_column },
+    { "_attr_dirty_row",            "BUDGET_ADR",           NEED_ATTRS,  one_attr_row },
+    { "_render_dirty_column_rows",  "BUDGET_RDC_ROWS",      NEED_MC,     one_render_column_rows },
+    { "_shift_viewport_left_rows",  "BUDGET_SHIFT_H_ROWS",  NEED_MC,     one_shift_left_rows },
+    { "_shift_viewport_right_rows", "BUDGET_SHIFT_H_ROWS",  NEED_MC,     one_shift_right_rows },
+    { "_shift_viewport_up_rows",    "BUDGET_SHIFT_UP_ROWS", NEED_MC,     one_shift_up_rows },
+    { "_shift_viewport_down_rows",  "BUDGET_SHIFT_DN_ROWS", NEED_MC,     one_shift_down_rows },
+    { "_mc_colour_row",             "BUDGET_MCCR",          NEED_MC,     one_mc_colour_row },
+    { "_mc_init_sync",              NULL,                   NEED_MC,     one_mc_init_sync },
+    { "_meta_expand_column",        "BUDGET_MEC",           NEED_META,   one_meta_column },
+    { "_meta_expand_row",           "BUDGET_MER",           NEED_META,   one_meta_row },
+};
+
+// --- SOUND: the song model and the interrupt ---
+
+static long snd_sym[8];
+enum { SND_SONG_A, SND_SONG_B, SND_SONG_C, SND_ENV, SND_PERIODS, SND_SFX_TABLE, SND_SFX_NONE, SND_PENDING };
+
+static void song_init(song_model *m) {
+    m->t = (int)sym("SND_ROW_FRAMES") - 1;
+    m->row = (int)sym("SND_SONG_ROWS") - 1;
+    m->sfx_ptr = m->sfx_start = snd_sym[SND_SFX_NONE];
+    memset(m->regs, 0, sizeof(m->regs));
+    m->regs[7] = (uint8_t)sym("AY_MIXER");
+}
+
+static void song_step(song_model *m) {
+    m->t = (m->t + 1) % (int)sym("SND_ROW_FRAMES");
+    if (m->t == 0) m->row = (m->row + 1) % (int)sym("SND_SONG_ROWS");
+    for (int ch = 0; ch < 3; ch++) {
+        uint8_t note = image[snd_sym[SND_SONG_A + ch] + m->row];
+        int period = rd16(image, snd_sym[SND_PERIODS] + note * 2);
+        m->regs[ch * 2] = (uint8_t)(period & 0xFF);
+        m->regs[ch * 2 + 1] = (uint8_t)(period >> 8);
+        m->regs[8 + ch] = note ? image[snd_sym[SND_ENV] + m->t * 3 + ch] : 0;
+    }
+    if (image[m->sfx_ptr + 2] != 0xFF) {
+        m->regs[4] = image[m->sfx_ptr];
+        m->regs[5] = image[m->sfx_ptr + 1];
+        m->regs[10] = image[m->sfx_ptr + 2];
+        m->sfx_ptr += 3;
+    }
+}
+
+static void song_sfx(song_model *m, int id) {
+    long e = rd16(image, snd_sym[SND_SFX_TABLE] + id * 2);
+    if (e == m->sfx_start && image[m->sfx_ptr + 2] != 0xFF) return;
+    m->sfx_start = m->sfx_ptr = e;
+}
+
+static int ay_matches(const song_model *m) {
+    for (int r = 0; r < AY_REGS; r++)
+        if (ay[r] != m->regs[r]) return 0;
+    return 1;
+}
+
+// The frame interrupt at the main loop's HALT; returns its T-states
+static unsigned long idle_interrupt(void) {
+    cpu.pc = IDLE_ADDR;
+    cpu.sp = STACK_TOP;
+    cpu.halted = 0;
+    unsigned long t0 = cpu.tstates;
+    if (!z80_interrupt(&cpu)) {
+        fail("%s", "interrupts are off at the HALT");
+        return 0;
+    }
+    while (cpu.pc != IDLE_ADDR) {
+        z80_step(&cpu);
+        if (cpu.tstates - t0 > MAX_CALL_T) {
+            fail("%s", "the interrupt did not return");
+            return 0;
+        }
+    }
+    if (cpu.sp != STACK_TOP) fail("%s", "the interrupt returned with SP moved");
+    return cpu.tstates - t0;
+}
+
+static void sound_init(void) {
+    call("_snd_init", NULL, 0);
+}
+
+// After a case in a SOUND build: a tick is deferred if the interrupt found
+// SP in the LUT (or its guard), else played. Either way the next interrupt
+// at the HALT catches up, and the AY then holds the song's second frame.
+static void check_sound_case(void) {
+    char msg[96];
+    int deferred = int_sp >= 0 && (unsigned long)(int_sp - 2 - (vp.lut_lo)) < (unsigned long)(vp.lut_hi - vp.lut_lo);
+    int pending = mem[snd_sym[SND_PENDING]];
+    if (pending != deferred) {
+        snprintf(msg, sizeof(msg), "interrupt at SP 0x%04lX: %d ticks pending, expected %d",
+                 int_sp, pending, deferred);
+        fail("%s", msg);
+    }
+    song_model m;
+    song_init(&m);
+    song_step(&m);
+    if (int_sp >= 0) song_step(&m);
+    idle_interrupt();
+    if (!ay_matches(&m)) fail("%s", "AY registers after the next interrupt differ from the song");
+}
+
+// Song, sound effects, deferred ticks and the catch-up, frame by frame
+static void check_song(void) {
+    char msg[128];
+    song_model m;
+    long lut = vp.lut_lo;
+    unsigned long isr_max = 0;
+    cur_name = "_snd_isr";
+    randomize();
+    memset(ay, 0xAA, sizeof(ay));
+    ay_writes = 0;
+    sound_init();
+    song_init(&m);
+    int v = cpu.i + 1;
+    int ok = cpu.im == 2 && cpu.iff1 && ay_matches(&m) && ay_writes == AY_REGS;
+    for (int k = 0; k < 257; k++) ok = ok && mem[cpu.i * 256 + k] == v;
+    ok = ok && mem[v * 257] == 0xC3 && rd16(mem, v * 257 + 1) == sym("_snd_isr");
+    if (!ok) fail("%s", "_snd_init: IM 2 table, jump or AY state wrong");
+    memcpy(expect, mem, sizeof(expect));    // a deferred tick writes nothing
+
+    int pending = 0;
+    for (int f = 0; f < rounds * 8; f++) {
+        cur_case = f;
+        if (rnd(8) == 0) {
+            uint8_t id = (uint8_t)rnd(2);
+            call("_snd_sfx", &id, 1);
+            song_sfx(&m, id);
+        }
+        if (rnd(4) == 0) {
+            // An SP-hijack section: SP somewhere in the LUT, the word below it
+            // the guard or an entry already popped
+            uint16_t sp = (uint16_t)(lut + 2 + 2 * (long)rnd((unsigned long)(vp.lut_hi - lut) / 2));
+            cpu.pc = IDLE_ADDR;
+            cpu.sp = sp;
+            cpu.halted = 0;
+            ay_writes = 0;
+            if (!z80_interrupt(&cpu)) fail("%s", "interrupts are off after the tick");
+            while (cpu.pc != IDLE_ADDR) z80_step(&cpu);
+            if (pending < 4) pending++;
+            compare();
+            if (cpu.sp != sp || ay_writes || mem[snd_sym[SND_PENDING]] != pending) {
+                snprintf(msg, sizeof(msg), "deferred tick at SP 0x%04X: SP 0x%04X, %d AY writes, %d pending (expected %d)",
+                         sp, cpu.sp, ay_writes, mem[snd_sym[SND_PENDING]], pending);
+                fail("%s", msg);
+            }
+            continue;
+        }
+        for (; pending; pending--) {
+            // Catch-up: the deferred frames move the song on, the AY
+            // only hears the last one
+            song_model skip = m;
+            song_step(&skip);
+            m = skip;
+        }
+        song_step(&m);
+        ay_writes = 0;
+        unsigned long t = idle_interrupt();
+        if (t > isr_max) isr_max = t;
+        if (!ay_matches(&m) || ay_writes != AY_REGS) {
+            snprintf(msg, sizeof(msg), "frame %d: AY %d %d %d / %d %d %d, expected %d %d %d / %d %d %d", f,
+                     ay[0] | ay[1] << 8, ay[2] | ay[3] << 8, ay[4] | ay[5] << 8, ay[8], ay[9], ay[10],
+                     m.regs[0] | m.regs[1] << 8, m.regs[2] | m.regs[3] << 8, m.regs[4] | m.regs[5] << 8,
+                     m.regs[8], m.regs[9], m.regs[10]);
+            fail("%s", msg);
+            song_init(&m);      // resynchronise from the machine's state is not possible: stop
+            break;
+        }
+    }
+    call("_snd_silence", NULL, 0);
+    if (ay[8] || ay[9] || ay[10] || !cpu.iff1) fail("%s", "_snd_silence left a volume on or interrupts off");
+    long budget = sym("BUDGET_SND_ISR");
+    if ((long)isr_max > budget) {
+        snprintf(msg, sizeof(msg), "interrupt takes %lu T, over BUDGET_SND_ISR %ld", isr_max, budget);
+        fail("%s", msg);
+    }
+    total_cases += rounds * 8;
+    if (verbose) printf("  %-28s %7lu T max (budget %ld)\n", "_snd_isr", isr_max, budget);
+}
+
+// --- MULTICOLOUR raster against the beam ---
+
+#define MC_MAX_CELLS (32 * 32)
+static attr_write mc_log[MC_MAX_CELLS][6];
+static int mc_log_n[MC_MAX_CELLS];
+static uint8_t mc_prev[MC_MAX_CELLS];
+
+static long mc_cell_addr(int cell) {
+    return attr_addr(cell / vp.cols, vp.col_offset + cell % vp.cols);
+}
+
+static void mc_hook(void) {
+    for (int cell = 0; cell < vp.rows * vp.cols; cell++) {
+        uint8_t v = mem[mc_cell_addr(cell)];
+        if (v == mc_prev[cell]) continue;
+        mc_prev[cell] = v;
+        if (mc_log_n[cell] < 6) {
+            mc_log[cell][mc_log_n[cell]].t = cpu.frame_t;
+            mc_log[cell][mc_log_n[cell]].value = v;
+        }
+        mc_log_n[cell]++;
+    }
+}
+
+// One raster: bands from distinct colours, start in the top border. Returns
+// the smallest margin in T (negative: a band missed its fetch), or -100000
+// if a cell was not written exactly once per band.
+static long mc_raster_once(int contended, unsigned long *t) {
+    int bands = vp.rows * 4;
+    write_sentinel(mem);
+    // the HUD cell two left of the sentinel ends the fine sync: it must not
+    // look like either sentinel row
+    int edge = vp.sentinel_col - 2;
+    for (int r = vp.start_row - 2; r < vp.start_row; r++) {
+        uint8_t *cell = mem + 0x5800 + r * 32 + edge;
+        if (edge >= 0 && (*cell == vp.sentinel_attr || *cell == vp.sentinel_end)) *cell ^= 0x01;
+    }
+    for (int b = 0; b < bands; b++) {
+        long src = vp.mc_bands + (long)b * vp.cols;
+        put16(mem + MC_SRC_ADDR + b * 2, src);
+        for (int i = 0; i < vp.cols; i++) {
+            uint8_t prev = b % 4 ? mem[src - vp.cols + i] : mem[attr_addr(b / 4, vp.col_offset + i)];
+            uint8_t v;
+            do v = (uint8_t)rnd(256); while (v == prev);
+            mem[src + i] = v;
+        }
+    }
+    for (int cell = 0; cell < vp.rows * vp.cols; cell++) {
+        mc_prev[cell] = mem[mc_cell_addr(cell)];
+        mc_log_n[cell] = 0;
+    }
+    memcpy(expect, mem, sizeof(expect));
+    for (int r = 0; r < vp.rows; r++)
+        memcpy(expect + attr_addr(r, vp.col_offset), mem + vp.mc_bands + (long)(r * 4 + 3) * vp.cols, (size_t)vp.cols);
+
+    unsigned long sentinel_t = first_fetch + (unsigned long)(vp.start_row - 2) * 8 * line_t;
+    cpu.frame_t = rnd(sentinel_t - 4000);
+    cpu.contended = contended;
+    beam_on = 1;
+    step_hook = mc_hook;
+    *t = call("_mc_raster", NULL, 0);
+    step_hook = NULL;
+    beam_on = 0;
+    cpu.contended = 0;
+    compare();
+
+    long margin = 100000;
+    for (int cell = 0; cell < vp.rows * vp.cols; cell++) {
+        int r = cell / vp.cols, col = vp.col_offset + cell % vp.cols;
+        if (mc_log_n[cell] != 4) return -100000;
+        for (int k = 0; k < 4; k++) {
+            int y = (vp.start_row + r) * 8 + 2 * k;
+            // written by the end of its instruction, and the next band's
+            // write at most 6 T before the end of that one
+            long pre = (long)attr_fetch_t(y, col) - (long)mc_log[cell][k].t;
+            if (pre < margin) margin = pre;
+            if (k < 3) {
+                long post = (long)mc_log[cell][k + 1].t - 6 - (long)attr_fetch_t(y + 1, col);
+                if (post < margin) margin = post;
+            }
+        }
+    }
+    return margin;
+}
+
+static void check_mc_raster(void) {
+    char msg[128];
+    unsigned long t, t_max = 0;
+    long worst = 100000, worst_contended = 100000;
+    cur_name = "_mc_raster";
+    for (cur_case = 0; cur_case < rounds; cur_case++) {
+        randomize();
+        long margin = mc_raster_once(1, &t);
+        if (margin == -100000) {
+            fail("%s", "an attribute was not written once per band");
+            break;
+        }
+        if (margin < worst_contended) worst_contended = margin;
+        if (t > t_max) t_max = t;
+        randomize();
+        margin = mc_raster_once(0, &t);
+        if (margin > -100000 && margin < worst) worst = margin;
+    }
+    total_cases += rounds;
+    if (worst_contended < 0) {
+        snprintf(msg, sizeof(msg), "a band's colours miss the ULA's fetch by %ld T (contended)", -worst_contended);
+        fail("%s", msg);
+    }
+    long budget = sym("BUDGET_MCR");
+    if ((long)t_max > budget) {
+        snprintf(msg, sizeof(msg), "%lu T, over BUDGET_MCR %ld", t_max, budget);
+        fail("%s", msg);
+    }
+
+    // No floating bus: one timeout, then off for good
+    cur_case = rounds;
+    randomize();
+    memcpy(expect, mem, sizeof(expect));
+    unsigned long t_off = call("_mc_raster", NULL, 0);
+    unsigned long t_again = call("_mc_raster", NULL, 0);
+    compare();
+    if (t_again > 40) fail("%s", "without a floating bus the raster does not stay off");
+    // The margin is the raster's calibration: printed without --verbose too
+    printf("  %-28s band margin %ld T contended, %ld T uncontended; %lu T max, %lu T timeout, %lu T off\n",
+           "_mc_raster", worst_contended, worst, t_max, t_off, t_again);
+}
+
+// --- Level pack ---
+
+static long lz_decode(const uint8_t *src, long *pos, long n, uint8_t *dst, long cap) {
+    long out = 0;
+    for (;;) {
+        if (*pos >= n) return -1;
+        int token = src[(*pos)++];
+        if (token == 0) return out;
+        if (token < 0x80) {
+            if (*pos + token > n || out + token > cap) return -1;
+            memcpy(dst + out, src + *pos, (size_t)token);
+            *pos += token;
+            out += token;
+        } else {
+            int len = (token & 0x7F) + 3;
+            if (*pos + 2 > n) return -1;
+            long off = src[*pos] | (src[*pos + 1] << 8);
+            *pos += 2;
+            if (off < 1 || off > out || out + len > cap) return -1;
+            for (int i = 0; i < len; i++, out++) dst[out] = dst[out - off];
+        }
+    }
+}
+
+static void load_tap(const char *path) {
+    static uint8_t buf[MAX_BLOCKS * 16400];
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        exit(1);
+    }
+    long n = (long)fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    for (long pos = 0; pos + 2 <= n; ) {
+        long len = buf[pos] | (buf[pos + 1] << 8);
+        if (len < 2 || pos + 2 + len > n || tap_blocks == MAX_BLOCKS || len - 2 > 16384) die("Error: bad levels.tap");
+        tap_len[tap_blocks] = len - 2;          // without flag and checksum
+        memcpy(tap_data[tap_blocks], buf + pos + 3, (size_t)(len - 2));
+        tap_blocks++;
+        pos += 2 + len;
+    }
+}
+
+static void check_levels(void) {
+    char msg[128];
+    static uint8_t out[16384];
+    long bank_table = sym("_level_bank_table"), dir = sym("_level_dir");
+    int bank_count = (int)sym("LEVEL_BANK_COUNT"), levels = (int)sym("LEVEL_COUNT");
+    static uint8_t expect_banks[8][16384];
+
+    cur_name = "_level_pack_load";
+    cur_case = 0;
+    randomize();
+    for (int b = 0; b < 8; b++)
+        for (int i = 0; i < 16384; i++) banks[b][i] = (uint8_t)rnd(256);
+    memcpy(expect_banks, banks, sizeof(banks));
+    memcpy(expect_banks[0], mem + 0xC000, 16384);
+    if (bank_count != tap_blocks) fail("%s", "LEVEL_BANK_COUNT differs from the levels.tap blocks");
+    for (int k = 0; k < bank_count && k < tap_blocks; k++) {
+        int bank = image[bank_table + k * 3];
+        memcpy(expect_banks[bank], tap_data[k], (size_t)tap_len[k]);
+    }
+    memcpy(expect, mem, sizeof(expect));
+    expect[0x5B5C] = 0x10;                      // BANKM: bank 0, 48K ROM
+    tap_next = 0;
+    unsigned long t = call("_level_pack_load", NULL, 0);
+    compare();
+    if (bank_paged != 0 || tap_next != bank_count) fail("%s", "banks not all loaded, or bank 0 not paged back");
+    page_bank(1);
+    page_bank(0);
+    for (int b = 1; b < 8; b++)
+        if (memcmp(banks[b], expect_banks[b], 16384)) {
+            snprintf(msg, sizeof(msg), "RAM bank %d differs from levels.tap", b);
+            fail("%s", msg);
+        }
+    total_cases++;
+    if (verbose) printf("  %-28s %7lu T (%d banks)\n", cur_name, t, bank_count);
+
+    cur_name = "_level_unpack";
+    for (cur_case = 0; cur_case < levels; cur_case++) {
+        uint8_t arg = (uint8_t)cur_case;
+        int bank = image[dir + cur_case * 3];
+        long pos = rd16(image, dir + cur_case * 3 + 1) - 0xC000;
+        const uint8_t *src = bank ? banks[bank] : mem + 0xC000;
+        static const long dest[4] = { TILES_ADDR, 0, OCC_ADDR, 0x4000 };
+        memcpy(expect, mem, sizeof(expect));
+        for (int s = 0; s < 4; s++) {
+            long to = s == 1 ? vp.map_addr : dest[s];
+            long n = lz_decode(src, &pos, 16384, out, sizeof(out));
+            if (n < 0 || to + n > 0x10000 || (s == 2 && n > OCC_BYTES)) {
+                fail("%s", "level stream does not decode");
+                return;
+            }
+            memcpy(expect + to, out, (size_t)n);
+        }
+        expect[0x5B5C] = 0x10;
+        t = call("_level_unpack", &arg, 1);
+        compare();
+        if (bank_paged != 0) fail("%s", "bank 0 not paged back");
+        total_cases++;
+        if (verbose) printf("  %-28s %7lu T (level %d)\n", cur_name, t, cur_case);
+    }
+}
+
+// --- Driver ---
+
+static void check_routine(const routine_check *rc) {
+    char msg[128];
+    unsigned long t_min = 0, t_max = 0, last_t = 0;
+    int injected = 0, taken = 0;
+    cur_name = rc->name;
+    for (cur_case = 0; cur_case < rounds; cur_case++) {
+        randomize();
+        if (vp.sound) sound_init();
+        // SOUND: every other case takes an interrupt inside the call
+        inject_t = vp.sound && (cur_case & 1) && last_t ? 1 + rnd(last_t) : 0;
+        memcpy(expect, mem, sizeof(expect));
+        ay_writes = 0;
+        rc->one();
+        compare();
+        if (vp.sound) check_sound_case();
+        if (inject_t) {
+            injected++;
+            taken += int_sp >= 0;
+        } else if (case_t) {
+            if (!t_min || case_t < t_min) t_min = case_t;
+            if (case_t > t_max) t_max = case_t;
+            last_t = case_t;
+        }
+        inject_t = 0;
+    }
+    total_cases += rounds;
+    long budget = rc->budget ? sym(rc->budget) : 0;
+    if (rc->budget && (long)t_max > budget) {
+        snprintf(msg, sizeof(msg), "%lu T, over %s", t_max, rc->budget);
+        fail("%s", msg);
+    }
+    if (verbose) {
+        printf("  %-28s %7lu..%-7lu T", rc->name, t_min, t_max);
+        if (rc->budget) printf(" (budget %ld)", budget);
+        if (injected) printf(", %d/%d interrupts taken", taken, injected);
+        printf("\n");
+    }
+}
+
+static void read_config(void) {
+    vp.cols = (int)sym("VIEWPORT_COLS");
+    vp.rows = (int)sym("VIEWPORT_CHAR_ROWS");
+    vp.col_offset = (int)sym("VIEWPORT_COL_OFFSET");
+    vp.start_row = (int)sym("VIEWPORT_START_CHAR_ROW");
+    vp.height = (int)sym("VIEWPORT_HEIGHT");
+    vp.map_w = (int)sym("MAP_WIDTH");
+    vp.map_h = (int)sym("MAP_HEIGHT");
+    vp.stride = (int)sym("MAP_STRIDE");
+    vp.col_step = (int)sym("MAP_COL_STEP");
+    vp.map_addr = sym("MAP_ADDR");
+    vp.metatile = (int)sym_or("METATILE", 0);
+    if (vp.metatile) {
+        vp.map_w /= vp.metatile;          // the map bytes are blocks, not cells
+        vp.map_h /= vp.metatile;
+        vp.col_strip = sym("META_COL_STRIP");
+        vp.row_strip = sym("META_ROW_STRIP");
+        vp.col_blocks = (int)sym("META_COL_BLOCKS");
+        vp.row_blocks = (int)sym("META_ROW_BLOCKS");
+    }
+    vp.tile_flip = (int)sym_or("TILE_FLIP", 0);
+    vp.tile_attrs = (int)sym_or("TILE_ATTRS", 0);
+    vp.multicolour = (int)sym_or("MULTICOLOUR", 0);
+    vp.sound = (int)sym_or("SOUND", 0);
+    vp.step_max = (int)sym("SCROLL_STEP_MAX");
+    vp.lut_lo = vp.sound ? sym("_scr_addr_table_guard") : sym("_scr_addr_table_direct");
+    vp.lut_hi = sym("_scr_addr_table_direct") + vp.height * 2;
+
+    vp.mc_bands = HOST_ADDR;
+    vp.col_strip_host = vp.mc_bands + (long)vp.rows * 8 * vp.cols + 2;
+    vp.row_strip_host = vp.col_strip_host + vp.height;
+    if (vp.row_strip_host + 8 * vp.cols > STACK_LOW || code_hi > MC_SRC_ADDR)
+        die("Error: program image or viewport too large for the check's memory map");
+
+    if (vp.multicolour) {
+        line_t = (int)sym("MC_LINE_T");
+        vp.sentinel_col = (int)sym("SENTINEL_COL");
+        vp.sentinel_attr = (uint8_t)sym("SENTINEL_ATTR");
+        vp.sentinel_end = (uint8_t)sym("SENTINEL_END_ATTR");
+        if (line_t != ZX_LINE_TSTATES) {
+            frame_len = 70908;              // 128K: 311 lines of 228 T
+            first_fetch = 14364;
+        }
+    }
+    if (vp.sound) {
+        static const char *names[] = { "_snd_song_a", "_snd_song_b", "_snd_song_c", "_snd_env",
+                                       "_snd_periods", "_snd_sfx_table", "_snd_sfx_none", "_snd_pending" };
+        for (int i = 0; i < 8; i++) snd_sym[i] = sym(names[i]);
+    }
+}
+
+int main(int argc, char **argv) {
+    const char *levels_tap = NULL;
+    const char *files[16];
+    int nfiles = 0;
+    char defines[256] = "";
+
+    as = z80_asm_new();
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-D", 2) == 0 && argv[i][2]) {
+            char name[64];
+            const char *eq = strchr(argv[i] + 2, '=');
+            size_t n = eq ? (size_t)(eq - argv[i] - 2) : strlen(argv[i] + 2);
+            if (n >= sizeof(name)) die("Error: -D name too long");
+            memcpy(name, argv[i] + 2, n);
+            name[n] = 0;
+            z80_asm_define(as, name, eq ? strtol(eq + 1, NULL, 0) : 1);
+            if (strlen(defines) + strlen(argv[i]) + 2 < sizeof(defines)) {
+                strcat(defines, " ");
+                strcat(defines, argv[i] + 2);
+            }
+        } else if (strcmp(argv[i], "-I") == 0 && i + 1 < argc) {
+            z80_asm_include(as, argv[++i]);
+        } else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc) {
+            levels_tap = argv[++i];
+        } else if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            rng_state = strtoul(argv[++i], NULL, 0) | 1;
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+            return 1;
+        } else if (nfiles < 16) {
+            files[nfiles++] = argv[i];
+        }
+    }
+    if (!nfiles || rounds < 2) die("Usage: ./asm_check [-DNAME[=N]] [-I dir] [--levels levels.tap] [--rounds n] [--seed n] [--verbose] <file.asm> ...");
+
+    // EXTERNs the C side defines
+    z80_asm_define(as, "_mc_src", MC_SRC_ADDR);
+    z80_asm_define(as, "_tiles", TILES_ADDR);
+    z80_asm_define(as, "_map_row_occ", OCC_ADDR);
+    for (int i = 0; i < nfiles; i++) z80_asm_source(as, files[i]);
+    if (z80_asm_build(as, image, CODE_ORG, &code_lo, &code_hi)) die("Error: assembly failed");
+    read_config();
+
+    // The main loop's HALT for the interrupt checks
+    image[IDLE_ADDR] = 0x76;                    // HALT
+    image[IDLE_ADDR + 1] = 0x18;                // JR $-1
+    image[IDLE_ADDR + 2] = 0xFD;
+
+    z80_reset(&cpu);
+    if (line_t != ZX_LINE_TSTATES) {
+        cpu.screen_t = ZX128_FIRST_SCREEN_T;
+        cpu.line_t = ZX128_LINE_TSTATES;
+    }
+    cpu.mem = mem;
+    cpu.port_in = io_in;
+    cpu.port_out = io_out;
+
+    printf("asm_check:");
+    for (int i = 0; i < nfiles; i++) printf(" %s", files[i]);
+    printf("%s%s (0x%04lX-0x%04lX)\n", defines[0] ? " -D" : "", defines, code_lo, code_hi);
+
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        const routine_check *rc = &checks[i];
+        if ((rc->need & NEED_ATTRS) && !vp.tile_attrs) continue;
+        if ((rc->need & NEED_MC) && !vp.multicolour) continue;
+        if ((rc->need & NEED_META) && !vp.metatile) continue;
+        if ((rc->need & NEED_CELLS) && vp.metatile) continue;
+        check_routine(rc);
+    }
+    if (vp.multicolour) check_mc_raster();
+    if (vp.sound) check_song();
+    if (levels_tap) {
+        load_tap(levels_tap);
+        check_levels();
+    }
+
+    printf("asm_check: %d cases, %d failure%s\n", total_cases, failures, failures == 1 ? "" : "s");
+    z80_asm_free(as);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,1380 @@
+// Static T-state analyser for the z88dk assembly routines.
+// Parses z88dk-z80asm source (EQU/DEFC, IF/ELSE/ENDIF, REPT/ENDR, INCLUDE),
+// builds the control flow of every PUBLIC entry point and reports its
+// best-case and worst-case T-states.
+//
+// Usage: ./asm_timing [--contended] [--model <out.txt>] [-DNAME[=N]] <file.asm> [...]
+//   --contended      also report worst case with ULA contention: every
+//                    register-indirect data access (and absolute accesses to
+//                    0x4000-0x7FFF) pays the maximum 6T delay
+//   --model <file>   write "<routine> <best> <worst> <worst_contended>" lines
+//   -DNAME[=N]       define a symbol before parsing (as z88dk-z80asm -D)
+//
+// Loops:
+//   Loop counts are inferred from the usual idioms:
+//     ld b,N ... djnz head
+//     ld r,N ... dec r / jp nz,head
+//     ld a,N / ld (cnt),a ... ld a,(cnt) / dec a / ld (cnt),a / jp nz,head
+//     ld bc,N / ldir (lddr, cpir, ...)
+//   Anything else needs an annotation on the loop's back-branch (or on the
+//   LDIR line): "; @loop N" or "; @loop MIN..MAX" (times the head is entered).
+//   "; @taken N" on a back-branch means it is taken at most N times per
+//   execution of the loop (e.g. a mid-frame beam sync between two phases, or
+//   the outer counter of two loops sharing one head), so its path is not
+//   multiplied by the full loop count.
+//
+// Budgets:
+//   "; @budget N" (and optionally "; @budget-contended N") in the comment
+//   block above a PUBLIC label declares the maximum worst-case T-states.
+//   The exit status is non-zero if any routine exceeds its budget, if a loop
+//   count cannot be determined, or if the source cannot be parsed.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LINE      512
+#define MAX_SYMS      4096
+#define MAX_INSNS     65536
+#define MAX_REGIONS   1024
+#define MAX_DEPTH     8
+#define MAX_LEVELS    (2 * MAX_DEPTH)   // per depth: normal and "@once" back-branches
+#define MAX_INCLUDE   8
+#define NO_COST       (-1L)
+#define CONTENTION_T  6
+#define MAX_DEFINES   32
+
+typedef struct {
+    char name[64];
+    long value;
+    int is_label;       // labels have no known address (value = insn index)
+} symbol;
+
+typedef enum {
+    K_NORMAL, K_JUMP, K_CALL, K_RET, K_EXIT, K_DATA
+} insn_kind;
+
+typedef struct {
+    char mn[8];
+    char op[2][48];
+    int nops;
+    const char *file;
+    int line;
+
+    insn_kind kind;
+    int cond;               // conditional branch / ret
+    char target[64];
+    int target_idx;         // resolved instruction index, -1 if external
+    long t_base;            // not-taken (or unconditional) cost
+    long t_taken;           // taken cost for conditional branches
+    int mem;                // data memory accesses (for contention)
+    int block_repeat;       // LDIR/LDDR/CPIR/...: cost scales with BC
+
+    long loop_min, loop_max;    // "@loop" annotation, 0 if none
+    long taken_max;             // "@taken N": back-branch taken at most N times, 0 if unlimited
+} insn;
+
+typedef struct {
+    long mn[MAX_LEVELS];
+    long mx[MAX_LEVELS];
+} vals;
+
+typedef struct {
+    int head, end;
+    int depth;
+    int parent;
+    int annotated;          // "@loop" on a back-branch overrides inference
+    int conflict;           // back-branches infer different counts
+    long kmin, kmax;
+    long limited;           // total "@taken" allowance of limited back-branches
+} region;
+
+typedef struct {
+    char name[64];
+    const char *file;
+    long budget;
+    long budget_contended;
+} entry;
+
+static symbol syms[MAX_SYMS];
+static int sym_count;
+static insn insns[MAX_INSNS];
+static int insn_count;
+static region regions[MAX_REGIONS];
+static int region_count;
+static int region_of_head[MAX_INSNS];
+static int inner_region[MAX_INSNS];
+static entry entries[MAX_SYMS];
+static int entry_count;
+static vals V[MAX_INSNS];
+static int errors;
+
+static long pending_budget = 0;
+static long pending_budget_contended = 0;
+
+static void fail(const char *file, int line, const char *msg, const char *detail) {
+    fprintf(stderr, "%s:%d: %s%s%s\n", file, line, msg, detail ? " " : "", detail ? detail : "");
+    errors++;
+}
+
+// --- Symbols ---
+
+static symbol *find_sym(const char *name) {
+    for (int i = 0; i < sym_count; i++)
+        if (strcmp(syms[i].name, name) == 0) return &syms[i];
+    return NULL;
+}
+
+static void set_sym(const char *name, long value, int is_label) {
+    symbol *s = find_sym(name);
+    if (!s) {
+        if (sym_count == MAX_SYMS) {
+            fprintf(stderr, "Error: too many symbols\n");
+            exit(1);
+        }
+        s = &syms[sym_count++];
+        snprintf(s->name, sizeof(s->name), "%s", name);
+    }
+    s->value = value;
+    s->is_label = is_label;
+}
+
+// --- Expression evaluation ---
+
+typedef struct {
+    const char *p;
+    int ok;
+} expr_state;
+
+static long parse_or(expr_state *e);
+
+static void skip_ws(expr_state *e) {
+    while (*e->p == ' ' || *e->p == '\t') e->p++;
+}
+
+static long parse_number(expr_state *e) {
+    const char *s = e->p;
+    char buf[64];
+    int n = 0;
+    long v;
+
+    if (*s == '$' || (*s == '0' && (s[1] == 'x' || s[1] == 'X'))) {
+        s += (*s == '$') ? 1 : 2;
+        v = strtol(s, (char **)&e->p, 16);
+        if (e->p == s) e->ok = 0;
+        return v;
+    }
+    if (*s == '%') {
+        s++;
+        v = strtol(s, (char **)&e->p, 2);
+        if (e->p == s) e->ok = 0;
+        return v;
+    }
+    while (isalnum((unsigned char)s[n]) && n < 63) {
+        buf[n] = s[n];
+        n++;
+    }
+    buf[n] = 0;
+    e->p = s + n;
+    if (n > 1 && (buf[n - 1] == 'h' || buf[n - 1] == 'H')) {
+        buf[n - 1] = 0;
+        return strtol(buf, NULL, 16);
+    }
+    if (n > 1 && (buf[n - 1] == 'b' || buf[n - 1] == 'B') && strspn(buf, "01") == (size_t)(n - 1)) {
+        buf[n - 1] = 0;
+        return strtol(buf, NULL, 2);
+    }
+    return strtol(buf, NULL, 10);
+}
+
+static long parse_primary(expr_state *e) {
+    skip_ws(e);
+    if (*e->p == '(') {
+        e->p++;
+        long v = parse_or(e);
+        skip_ws(e);
+        if (*e->p == ')') e->p++;
+        else e->ok = 0;
+        return v;
+    }
+    if (*e->p == '-') { e->p++; return -parse_primary(e); }
+    if (*e->p == '+') { e->p++; return parse_primary(e); }
+    if (*e->p == '~') { e->p++; return ~parse_primary(e); }
+    if (*e->p == '!') { e->p++; return !parse_primary(e); }
+    if (*e->p == '\'' && e->p[1] && e->p[2] == '\'') {
+        long v = (unsigned char)e->p[1];
+        e->p += 3;
+        return v;
+    }
+    if (isdigit((unsigned char)*e->p) || *e->p == '$' || *e->p == '%') return parse_number(e);
+    if (isalpha((unsigned char)*e->p) || *e->p == '_') {
+        char name[64];
+        int n = 0;
+        while ((isalnum((unsigned char)*e->p) || *e->p == '_') && n < 63) name[n++] = *e->p++;
+        name[n] = 0;
+        symbol *s = find_sym(name);
+        if (!s || s->is_label) {
+            e->ok = 0;
+            return 0;
+        }
+        return s->value;
+    }
+    e->ok = 0;
+    return 0;
+}
+
+static long parse_mul(expr_state *e) {
+    long v = parse_primary(e);
+    for (;;) {
+        skip_ws(e);
+        char c = *e->p;
+        if (c != '*' && c != '/' && c != '%') return v;
+        e->p++;
+        long r = parse_primary(e);
+        if (c == '*') v *= r;
+        else if (r == 0) e->ok = 0;
+        else if (c == '/') v /= r;
+        else v %= r;
+    }
+}
+
+static long parse_add(expr_state *e) {
+    long v = parse_mul(e);
+    for (;;) {
+        skip_ws(e);
+        char c = *e->p;
+        if (c != '+' && c != '-') return v;
+        e->p++;
+        long r = parse_mul(e);
+        v = c == '+' ? v + r : v - r;
+    }
+}
+
+static long parse_shift(expr_state *e) {
+    long v = parse_add(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '<' && e->p[1] == '<') { e->p += 2; v <<= parse_add(e); }
+        else if (e->p[0] == '>' && e->p[1] == '>') { e->p += 2; v >>= parse_add(e); }
+        else return v;
+    }
+}
+
+static long parse_cmp(expr_state *e) {
+    long v = parse_shift(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '=' && e->p[1] == '=') { e->p += 2; v = v == parse_shift(e); }
+        else if (e->p[0] == '!' && e->p[1] == '=') { e->p += 2; v = v != parse_shift(e); }
+        else if (e->p[0] == '<' && e->p[1] == '>') { e->p += 2; v = v != parse_shift(e); }
+        else if (e->p[0] == '<' && e->p[1] == '=') { e->p += 2; v = v <= parse_shift(e); }
+        else if (e->p[0] == '>' && e->p[1] == '=') { e->p += 2; v = v >= parse_shift(e); }
+        else if (e->p[0] == '<') { e->p++; v = v < parse_shift(e); }
+        else if (e->p[0] == '>') { e->p++; v = v > parse_shift(e); }
+        else if (e->p[0] == '=') { e->p++; v = v == parse_shift(e); }
+        else return v;
+    }
+}
+
+static long parse_and(expr_state *e) {
+    long v = parse_cmp(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '&' && e->p[1] == '&') { e->p += 2; v = parse_cmp(e) && v; }
+        else if (e->p[0] == '&') { e->p++; v &= parse_cmp(e); }
+        else return v;
+    }
+}
+
+static long parse_or(expr_state *e) {
+    long v = parse_and(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '|' && e->p[1] == '|') { e->p += 2; v = parse_and(e) || v; }
+        else if (e->p[0] == '|') { e->p++; v |= parse_and(e); }
+        else if (e->p[0] == '^') { e->p++; v ^= parse_and(e); }
+        else return v;
+    }
+}
+
+static int eval(const char *s, long *out) {
+    expr_state e = { s, 1 };
+    long v = parse_or(&e);
+    skip_ws(&e);
+    if (*e.p) e.ok = 0;
+    *out = v;
+    return e.ok;
+}
+
+// --- Text helpers ---
+
+static char *trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    size_t n = strlen(s);
+    while (n && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r' || s[n - 1] == '\n')) s[--n] = 0;
+    return s;
+}
+
+static void lower(char *dst, const char *src, size_t cap) {
+    size_t i = 0;
+    for (; src[i] && i + 1 < cap; i++) dst[i] = (char)tolower((unsigned char)src[i]);
+    dst[i] = 0;
+}
+
+static int is_ident_start(char c) {
+    return isalpha((unsigned char)c) || c == '_' || c == '.';
+}
+
+// Parse "@loop N" / "@loop MIN..MAX", "@taken N" and "@budget" from a comment
+static void parse_annotations(const char *comment, insn *in, long *loop_min, long *loop_max) {
+    const char *p;
+    if (in && (p = strstr(comment, "@taken")) != NULL) {
+        long v;
+        char buf[64];
+        if (sscanf(p + 6, "%63s", buf) == 1 && eval(buf, &v)) in->taken_max = v;
+    }
+    if ((p = strstr(comment, "@loop")) != NULL) {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s", p + 5);
+        char *dots = strstr(buf, "..");
+        long a, b;
+        if (dots) {
+            *dots = 0;
+            char *rest = trim(dots + 2);
+            char *end = rest;
+            while (*end && *end != ' ' && *end != '\t') end++;
+            *end = 0;
+            if (eval(trim(buf), &a) && eval(rest, &b)) {
+                *loop_min = a;
+                *loop_max = b;
+            }
+        } else {
+            char *s = trim(buf);
+            char *end = s;
+            while (*end && *end != ' ' && *end != '\t') end++;
+            *end = 0;
+            if (eval(s, &a)) *loop_min = *loop_max = a;
+        }
+    }
+    if ((p = strstr(comment, "@budget-contended")) != NULL) {
+        long v;
+        char buf[64];
+        if (sscanf(p + 17, "%63s", buf) == 1 && eval(buf, &v)) pending_budget_contended = v;
+    } else if ((p = strstr(comment, "@budget")) != NULL) {
+        long v;
+        char buf[64];
+        if (sscanf(p + 7, "%63s", buf) == 1 && eval(buf, &v)) pending_budget = v;
+    }
+}
+
+// --- Instruction timing ---
+
+static int is_reg8(const char *o) {
+    static const char *r[] = { "a", "b", "c", "d", "e", "h", "l", "ixh", "ixl", "iyh", "iyl", "xh", "xl", "yh", "yl", NULL };
+    for (int i = 0; r[i]; i++) if (strcmp(o, r[i]) == 0) return 1;
+    return 0;
+}
+
+static int is_index8(const char *o) {
+    return o[0] == 'i' && (o[1] == 'x' || o[1] == 'y') && (o[2] == 'h' || o[2] == 'l') && !o[3];
+}
+
+static int is_reg16(const char *o) {
+    return !strcmp(o, "bc") || !strcmp(o, "de") || !strcmp(o, "hl") || !strcmp(o, "sp")
+        || !strcmp(o, "af") || !strcmp(o, "af'");
+}
+
+static int is_ixy(const char *o) {
+    return !strcmp(o, "ix") || !strcmp(o, "iy");
+}
+
+static int is_mem_hl(const char *o) { return !strcmp(o, "(hl)"); }
+
+static int is_mem_rr(const char *o) {
+    return !strcmp(o, "(bc)") || !strcmp(o, "(de)");
+}
+
+static int is_mem_ixy(const char *o) {
+    return !strncmp(o, "(ix", 3) || !strncmp(o, "(iy", 3);
+}
+
+static int is_mem_abs(const char *o) {
+    return o[0] == '(' && !is_mem_hl(o) && !is_mem_rr(o) && !is_mem_ixy(o)
+        && strcmp(o, "(sp)") && strcmp(o, "(c)");
+}
+
+static int is_cc(const char *o) {
+    static const char *cc[] = { "nz", "z", "nc", "c", "po", "pe", "p", "m", NULL };
+    for (int i = 0; cc[i]; i++) if (strcmp(o, cc[i]) == 0) return 1;
+    return 0;
+}
+
+// Absolute address operand: count as contended only if it evaluates into 0x4000-0x7FFF
+static int abs_contended(const char *orig) {
+    char buf[64];
+    long v;
+    size_t n = strlen(orig);
+    if (n < 3) return 0;
+    snprintf(buf, sizeof(buf), "%.*s", (int)(n - 2), orig + 1);
+    return eval(buf, &v) && v >= 0x4000 && v < 0x8000;
+}
+
+// Branch target: the label operand as written. The operand and the target
+// live in the same insn, so copy with memmove (op[] is shorter than target[]).
+static void set_target(insn *in, int op) {
+    memmove(in->target, in->op[op], strlen(in->op[op]) + 1);
+}
+
+// Fill timing fields. `o` are lower-cased operands, `orig` original case.
+static int time_insn(insn *in, char o[2][48]) {
+    const char *m = in->mn;
+    const char *a = in->nops > 0 ? o[0] : "";
+    const char *b = in->nops > 1 ? o[1] : "";
+    int n = in->nops;
+    long t = -1;
+
+    in->kind = K_NORMAL;
+    in->mem = 0;
+
+    #define MEMCOUNT(op, orig) (is_mem_hl(op) || is_mem_rr(op) || is_mem_ixy(op) ? 1 : \
+        (is_mem_abs(op) && abs_contended(orig)) ? 1 : 0)
+
+    if (!strcmp(m, "ld")) {
+        if (is_reg8(a) && is_reg8(b)) t = (is_index8(a) || is_index8(b)) ? 8 : 4;
+        else if ((!strcmp(a, "a") && (!strcmp(b, "i") || !strcmp(b, "r")))
+              || ((!strcmp(a, "i") || !strcmp(a, "r")) && !strcmp(b, "a"))) t = 9;
+        else if (is_reg8(a) && is_mem_hl(b)) t = 7;
+        else if (is_reg8(a) && is_mem_ixy(b)) t = 19;
+        else if (is_reg8(a) && is_mem_rr(b)) t = 7;
+        else if (!strcmp(a, "a") && is_mem_abs(b)) t = 13;
+        else if (is_reg8(a)) t = is_index8(a) ? 11 : 7;
+        else if (is_mem_hl(a)) t = is_reg8(b) ? 7 : 10;
+        else if (is_mem_ixy(a)) t = 19;
+        else if (is_mem_rr(a)) t = 7;
+        else if (is_mem_abs(a) && !strcmp(b, "a")) t = 13;
+        else if (is_mem_abs(a) && !strcmp(b, "hl")) t = 16;
+        else if (is_mem_abs(a) && (is_reg16(b) || is_ixy(b))) t = 20;
+        else if (!strcmp(a, "sp") && !strcmp(b, "hl")) t = 6;
+        else if (!strcmp(a, "sp") && is_ixy(b)) t = 10;
+        else if (!strcmp(a, "hl") && is_mem_abs(b)) t = 16;
+        else if ((is_reg16(a) || is_ixy(a)) && is_mem_abs(b)) t = 20;
+        else if (is_ixy(a)) t = 14;
+        else if (is_reg16(a)) t = 10;
+        in->mem = MEMCOUNT(a, in->op[0]) + MEMCOUNT(b, in->op[1]);
+        if (is_mem_abs(a) && abs_contended(in->op[0])) in->mem = (!strcmp(b, "a")) ? 1 : 2;
+        if (is_mem_abs(b) && abs_contended(in->op[1])) in->mem = (!strcmp(a, "a")) ? 1 : 2;
+    } else if (!strcmp(m, "push")) {
+        t = is_ixy(a) ? 15 : 11;
+    } else if (!strcmp(m, "pop")) {
+        t = is_ixy(a) ? 14 : 10;
+    } else if (!strcmp(m, "ex")) {
+        if (!strcmp(a, "(sp)")) t = is_ixy(b) ? 23 : 19;
+        else t = 4;
+    } else if (!strcmp(m, "exx") || !strcmp(m, "nop") || !strcmp(m, "daa") || !strcmp(m, "cpl")
+            || !strcmp(m, "ccf") || !strcmp(m, "scf") || !strcmp(m, "di") || !strcmp(m, "ei")
+            || !strcmp(m, "rlca") || !strcmp(m, "rrca") || !strcmp(m, "rla") || !strcmp(m, "rra")
+            || !strcmp(m, "halt")) {
+        t = 4;
+    } else if (!strcmp(m, "neg") || !strcmp(m, "im")) {
+        t = 8;
+    } else if (!strcmp(m, "ldi") || !strcmp(m, "ldd") || !strcmp(m, "cpi") || !strcmp(m, "cpd")
+            || !strcmp(m, "ini") || !strcmp(m, "ind") || !strcmp(m, "outi") || !strcmp(m, "outd")) {
+        t = 16;
+        in->mem = (m[0] == 'l') ? 2 : 1;
+    } else if (!strcmp(m, "ldir") || !strcmp(m, "lddr") || !strcmp(m, "cpir") || !strcmp(m, "cpdr")
+            || !strcmp(m, "inir") || !strcmp(m, "indr") || !strcmp(m, "otir") || !strcmp(m, "otdr")) {
+        t = 16;                 // last iteration; others 21
+        in->block_repeat = 1;
+        in->mem = (m[0] == 'l') ? 2 : 1;
+    } else if (!strcmp(m, "add") || !strcmp(m, "adc") || !strcmp(m, "sub") || !strcmp(m, "sbc")
+            || !strcmp(m, "and") || !strcmp(m, "xor") || !strcmp(m, "or") || !strcmp(m, "cp")) {
+        const char *src = n == 2 ? b : a;
+        if (n == 2 && !strcmp(a, "hl") && is_reg16(b)) t = !strcmp(m, "add") ? 11 : 15;
+        else if (n == 2 && is_ixy(a)) t = 15;
+        else if (is_reg8(src)) t = is_index8(src) ? 8 : 4;
+        else if (is_mem_hl(src)) t = 7;
+        else if (is_mem_ixy(src)) t = 19;
+        else t = 7;
+        in->mem = MEMCOUNT(src, n == 2 ? in->op[1] : in->op[0]);
+    } else if (!strcmp(m, "inc") || !strcmp(m, "dec")) {
+        if (is_reg8(a)) t = is_index8(a) ? 8 : 4;
+        else if (is_mem_hl(a)) { t = 11; in->mem = 2; }
+        else if (is_mem_ixy(a)) { t = 23; in->mem = 2; }
+        else if (is_ixy(a)) t = 10;
+        else t = 6;
+    } else if (!strcmp(m, "rlc") || !strcmp(m, "rl") || !strcmp(m, "rrc") || !strcmp(m, "rr")
+            || !strcmp(m, "sla") || !strcmp(m, "sra") || !strcmp(m, "sll") || !strcmp(m, "sli")
+            || !strcmp(m, "srl")) {
+        if (is_mem_hl(a)) { t = 15; in->mem = 2; }
+        else if (is_mem_ixy(a)) { t = 23; in->mem = 2; }
+        else t = 8;
+    } else if (!strcmp(m, "rld") || !strcmp(m, "rrd")) {
+        t = 18;
+        in->mem = 2;
+    } else if (!strcmp(m, "bit")) {
+        if (is_mem_hl(b)) { t = 12; in->mem = 1; }
+        else if (is_mem_ixy(b)) { t = 20; in->mem = 1; }
+        else t = 8;
+    } else if (!strcmp(m, "set") || !strcmp(m, "res")) {
+        if (is_mem_hl(b)) { t = 15; in->mem = 2; }
+        else if (is_mem_ixy(b)) { t = 23; in->mem = 2; }
+        else t = 8;
+    } else if (!strcmp(m, "jp")) {
+        if (n == 1 && (is_mem_hl(a) || !strcmp(a, "(ix)") || !strcmp(a, "(iy)") || !strcmp(a, "hl"))) {
+            t = is_mem_hl(a) || !strcmp(a, "hl") ? 4 : 8;
+            in->kind = K_EXIT;
+        } else {
+            t = 10;
+            in->t_taken = 10;
+            in->kind = K_JUMP;
+            in->cond = n == 2;
+            set_target(in, n - 1);
+        }
+    } else if (!strcmp(m, "jr")) {
+        in->kind = K_JUMP;
+        in->cond = n == 2;
+        t = in->cond ? 7 : 12;
+        in->t_taken = 12;
+        set_target(in, n - 1);
+    } else if (!strcmp(m, "djnz")) {
+        in->kind = K_JUMP;
+        in->cond = 1;
+        t = 8;
+        in->t_taken = 13;
+        set_target(in, 0);
+    } else if (!strcmp(m, "call")) {
+        in->kind = K_CALL;
+        in->cond = n == 2;
+        t = in->cond ? 10 : 17;
+        in->t_taken = 17;
+        set_target(in, n - 1);
+    } else if (!strcmp(m, "ret")) {
+        in->kind = K_RET;
+        in->cond = n == 1 && is_cc(a);
+        t = in->cond ? 5 : 10;
+        in->t_taken = 11;
+    } else if (!strcmp(m, "reti") || !strcmp(m, "retn")) {
+        in->kind = K_RET;
+        t = 14;
+    } else if (!strcmp(m, "rst")) {
+        t = 11;
+    } else if (!strcmp(m, "in")) {
+        t = (!strcmp(b, "(c)") || n == 1) ? 12 : 11;
+    } else if (!strcmp(m, "out")) {
+        t = !strcmp(a, "(c)") ? 12 : 11;
+    }
+    #undef MEMCOUNT
+
+    if (t < 0) return 0;
+    in->t_base = t;
+    if (in->kind != K_JUMP && in->kind != K_CALL && in->kind != K_RET) in->t_taken = t;
+    return 1;
+}
+
+// --- Source processing ---
+
+typedef struct {
+    char **lines;
+    int count;
+    char *path;
+} source;
+
+static int load_source(source *src, const char *path) {
+    FILE *f = fopen(path, "r");
+    char buf[MAX_LINE];
+    int cap = 0;
+    if (!f) return 0;
+    src->lines = NULL;
+    src->count = 0;
+    src->path = strdup(path);
+    while (fgets(buf, sizeof(buf), f)) {
+        if (src->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            src->lines = (char **)realloc(src->lines, (size_t)cap * sizeof(char *));
+        }
+        src->lines[src->count++] = strdup(buf);
+    }
+    fclose(f);
+    return 1;
+}
+
+static void process_range(source *src, int start, int end, int depth);
+
+// Conditional-assembly state for one source range
+typedef struct {
+    int active[32];
+    int taken[32];
+    int sp;
+} cond_stack;
+
+static int cond_active(const cond_stack *cs) {
+    for (int i = 0; i <= cs->sp; i++) if (!cs->active[i]) return 0;
+    return 1;
+}
+
+static void emit_statement(source *src, int lineno, char *stmt, const char *comment) {
+    char *s = trim(stmt);
+    char word[64], lw[64];
+    long loop_min = 0, loop_max = 0;
+
+    // Label: "name:" possibly followed by an instruction
+    {
+        int n = 0;
+        while ((isalnum((unsigned char)s[n]) || s[n] == '_' || s[n] == '.') && n < 63) n++;
+        if (n > 0 && s[n] == ':' && is_ident_start(s[0])) {
+            char name[64];
+            snprintf(name, sizeof(name), "%.*s", n, s);
+            set_sym(name, insn_count, 1);
+            s = trim(s + n + 1);
+        }
+    }
+    if (!*s) return;
+
+    // First word
+    {
+        int n = 0;
+        while (s[n] && s[n] != ' ' && s[n] != '\t' && n < 63) n++;
+        snprintf(word, sizeof(word), "%.*s", n, s);
+        lower(lw, word, sizeof(lw));
+        s = trim(s + n);
+    }
+
+    // "NAME EQU expr" / "NAME = expr"
+    {
+        char second[64], ls[64];
+        int n = 0;
+        while (s[n] && s[n] != ' ' && s[n] != '\t' && n < 63) n++;
+        snprintf(second, sizeof(second), "%.*s", n, s);
+        lower(ls, second, sizeof(ls));
+        if (!strcmp(ls, "equ") || !strcmp(ls, "=")) {
+            long v;
+            if (eval(trim(s + n), &v)) set_sym(word, v, 0);
+            return;
+        }
+    }
+
+    if (!strcmp(lw, "defc")) {
+        char *eq = strchr(s, '=');
+        long v;
+        if (eq) {
+            *eq = 0;
+            char *name = trim(s);
+            if (eval(trim(eq + 1), &v)) set_sym(name, v, 0);
+            else set_sym(name, 0, 1);
+        }
+        return;
+    }
+    if (!strcmp(lw, "public") || !strcmp(lw, "global")) {
+        char *tok = strtok(s, ", \t");
+        while (tok) {
+            if (entry_count < MAX_SYMS) {
+                entry *e = &entries[entry_count++];
+                snprintf(e->name, sizeof(e->name), "%s", tok);
+                e->file = src->path;
+                e->budget = 0;
+                e->budget_contended = 0;
+            }
+            tok = strtok(NULL, ", \t");
+        }
+        return;
+    }
+    if (!strcmp(lw, "section") || !strcmp(lw, "extern") || !strcmp(lw, "org") || !strcmp(lw, "align")
+        || !strcmp(lw, "module")) {
+        return;
+    }
+    if (!strcmp(lw, "defb") || !strcmp(lw, "defw") || !strcmp(lw, "defs") || !strcmp(lw, "defm")
+        || !strcmp(lw, "db") || !strcmp(lw, "dw") || !strcmp(lw, "ds") || !strcmp(lw, "binary")
+        || !strcmp(lw, "incbin")) {
+        insn *in = &insns[insn_count++];
+        memset(in, 0, sizeof(*in));
+        snprintf(in->mn, sizeof(in->mn), "%s", "data");
+        in->kind = K_DATA;
+        in->file = src->path;
+        in->line = lineno;
+        in->target_idx = -1;
+        return;
+    }
+
+    // Instruction
+    if (insn_count == MAX_INSNS) {
+        fprintf(stderr, "Error: too many instructions\n");
+        exit(1);
+    }
+    insn *in = &insns[insn_count];
+    char lops[2][48];
+    memset(in, 0, sizeof(*in));
+    lower(in->mn, word, sizeof(in->mn));
+    in->file = src->path;
+    in->line = lineno;
+    in->target_idx = -1;
+
+    if (*s) {
+        // Split operands on the top-level comma
+        int depth = 0, split = -1;
+        for (int i = 0; s[i]; i++) {
+            if (s[i] == '(') depth++;
+            else if (s[i] == ')') depth--;
+            else if (s[i] == ',' && depth == 0) { split = i; break; }
+        }
+        if (split >= 0) {
+            s[split] = 0;
+            snprintf(in->op[0], sizeof(in->op[0]), "%s", trim(s));
+            snprintf(in->op[1], sizeof(in->op[1]), "%s", trim(s + split + 1));
+            in->nops = 2;
+        } else {
+            snprintf(in->op[0], sizeof(in->op[0]), "%s", trim(s));
+            in->nops = 1;
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        // Normalise "( hl )" -> "(hl)"; lower-case for matching
+        char tmp[48];
+        int k = 0;
+        for (int j = 0; in->op[i][j] && k < 47; j++)
+            if (in->op[i][j] != ' ' && in->op[i][j] != '\t') tmp[k++] = (char)tolower((unsigned char)in->op[i][j]);
+        tmp[k] = 0;
+        snprintf(lops[i], sizeof(lops[i]), "%s", tmp);
+    }
+
+    if (!time_insn(in, lops)) {
+        fail(src->path, lineno, "unknown instruction:", word);
+        return;
+    }
+    if (comment) parse_annotations(comment, in, &loop_min, &loop_max);
+    in->loop_min = loop_min;
+    in->loop_max = loop_max;
+    insn_count++;
+}
+
+static void process_line(source *src, int idx, cond_stack *cs, int depth) {
+    char buf[MAX_LINE];
+    char *comment = NULL;
+    snprintf(buf, sizeof(buf), "%s", src->lines[idx]);
+
+    // Strip comment (';' outside double quotes)
+    {
+        int inq = 0;
+        for (char *p = buf; *p; p++) {
+            if (*p == '"') inq = !inq;
+            else if (*p == ';' && !inq) {
+                *p = 0;
+                comment = p + 1;
+                break;
+            }
+        }
+    }
+    // Comment-only lines may carry a budget for the next PUBLIC label
+    if (comment && cond_active(cs)) {
+        long dummy_min = 0, dummy_max = 0;
+        char *t = trim(buf);
+        if (!*t) {
+            parse_annotations(comment, NULL, &dummy_min, &dummy_max);
+            return;
+        }
+    }
+
+    char *line = trim(buf);
+    char lw[16];
+    {
+        int n = 0;
+        while (line[n] && line[n] != ' ' && line[n] != '\t' && n < 15) n++;
+        snprintf(lw, sizeof(lw), "%.*s", n, line);
+        for (int i = 0; lw[i]; i++) lw[i] = (char)tolower((unsigned char)lw[i]);
+    }
+
+    if (!strcmp(lw, "if") || !strcmp(lw, "ifdef") || !strcmp(lw, "ifndef")) {
+        long v = 0;
+        const char *expr = trim(line + strlen(lw));
+        if (!strcmp(lw, "if")) {
+            if (cond_active(cs) && !eval(expr, &v)) fail(src->path, idx + 1, "cannot evaluate IF", expr);
+        } else {
+            symbol *s = find_sym(expr);
+            v = (s != NULL) == (lw[2] == 'd');
+        }
+        cs->sp++;
+        cs->active[cs->sp] = v != 0;
+        cs->taken[cs->sp] = v != 0;
+        return;
+    }
+    if (!strcmp(lw, "else")) {
+        cs->active[cs->sp] = !cs->taken[cs->sp];
+        return;
+    }
+    if (!strcmp(lw, "endif")) {
+        if (cs->sp > 0) cs->sp--;
+        return;
+    }
+    if (!cond_active(cs)) return;
+
+    if (!strcmp(lw, "include")) {
+        char path[512], name[256];
+        const char *q1 = strchr(line, '"');
+        const char *q2 = q1 ? strchr(q1 + 1, '"') : NULL;
+        if (!q1 || !q2 || depth >= MAX_INCLUDE) {
+            fail(src->path, idx + 1, "bad INCLUDE", NULL);
+            return;
+        }
+        snprintf(name, sizeof(name), "%.*s", (int)(q2 - q1 - 1), q1 + 1);
+        const char *slash = strrchr(src->path, '/');
+        if (slash && name[0] != '/')
+            snprintf(path, sizeof(path), "%.*s/%s", (int)(slash - src->path), src->path, name);
+        else
+            snprintf(path, sizeof(path), "%s", name);
+        source inc;
+        if (!load_source(&inc, path)) {
+            fail(src->path, idx + 1, "cannot open INCLUDE", path);
+            return;
+        }
+        process_range(&inc, 0, inc.count, depth + 1);
+        return;
+    }
+
+    // Split multiple statements separated by backslash
+    char *stmt = line;
+    for (;;) {
+        char *bs = strchr(stmt, '\\');
+        if (bs) *bs = 0;
+        emit_statement(src, idx + 1, stmt, comment);
+        if (!bs) break;
+        stmt = bs + 1;
+    }
+}
+
+static void process_range(source *src, int start, int end, int depth) {
+    cond_stack cs;
+    memset(&cs, 0, sizeof(cs));
+    cs.active[0] = 1;
+
+    for (int i = start; i < end; i++) {
+        char tmp[MAX_LINE], lw[16];
+        snprintf(tmp, sizeof(tmp), "%s", src->lines[i]);
+        char *semi = strchr(tmp, ';');
+        if (semi) *semi = 0;
+        char *line = trim(tmp);
+        int n = 0;
+        while (line[n] && line[n] != ' ' && line[n] != '\t' && n < 15) n++;
+        snprintf(lw, sizeof(lw), "%.*s", n, line);
+        for (int k = 0; lw[k]; k++) lw[k] = (char)tolower((unsigned char)lw[k]);
+
+        if (!strcmp(lw, "rept") && cond_active(&cs)) {
+            long count;
+            int nest = 1, j;
+            if (!eval(trim(line + 4), &count)) {
+                fail(src->path, i + 1, "cannot evaluate REPT count", trim(line + 4));
+                count = 0;
+            }
+            for (j = i + 1; j < end; j++) {
+                char t2[MAX_LINE], w2[16];
+                snprintf(t2, sizeof(t2), "%s", src->lines[j]);
+                char *s2 = strchr(t2, ';');
+                if (s2) *s2 = 0;
+                char *l2 = trim(t2);
+                int m = 0;
+                while (l2[m] && l2[m] != ' ' && l2[m] != '\t' && m < 15) m++;
+                snprintf(w2, sizeof(w2), "%.*s", m, l2);
+                for (int k = 0; w2[k]; k++) w2[k] = (char)tolower((unsigned char)w2[k]);
+                if (!strcmp(w2, "rept")) nest++;
+                else if (!strcmp(w2, "endr") && --nest == 0) break;
+            }
+            for (long r = 0; r < count; r++) process_range(src, i + 1, j, depth);
+            i = j;
+            continue;
+        }
+        process_line(src, i, &cs, depth);
+
+        // A PUBLIC label picks up the budget declared in the comment block above it
+        if (pending_budget || pending_budget_contended) {
+            for (int e = 0; e < entry_count; e++) {
+                symbol *s = find_sym(entries[e].name);
+                if (s && s->is_label && s->value == insn_count && entries[e].file == src->path
+                    && strstr(src->lines[i], entries[e].name) && strchr(src->lines[i], ':')) {
+                    if (pending_budget) entries[e].budget = pending_budget;
+                    if (pending_budget_contended) entries[e].budget_contended = pending_budget_contended;
+                    pending_budget = pending_budget_contended = 0;
+                }
+            }
+        }
+    }
+}
+
+// --- Control flow ---
+
+static void resolve_targets(void) {
+    for (int i = 0; i < insn_count; i++) {
+        insn *in = &insns[i];
+        if (in->kind != K_JUMP && in->kind != K_CALL) continue;
+        symbol *s = find_sym(in->target);
+        in->target_idx = (s && s->is_label) ? (int)s->value : -1;
+        if (in->kind == K_JUMP && in->target_idx < 0)
+            in->kind = K_EXIT;  // tail jump to an external routine
+    }
+}
+
+static long value_of_b_before(int head, const char *reg, int *ok) {
+    // Scan backwards from the loop head for "ld <reg>, const" (or "ld <pair>, const")
+    for (int i = head - 1; i >= 0 && i >= head - 64; i--) {
+        insn *in = &insns[i];
+        char a[48], b[48];
+        long v;
+        if (in->kind == K_RET || in->kind == K_DATA) break;
+        lower(a, in->op[0], sizeof(a));
+        if (strcmp(in->mn, "ld") || in->nops != 2) continue;
+        snprintf(b, sizeof(b), "%s", in->op[1]);
+        if (!strcmp(a, reg)) {
+            if (eval(b, &v)) { *ok = 1; return v & 0xFF; }
+            *ok = 0;
+            return 0;
+        }
+        // "ld bc, N" sets B to N >> 8; "ld de, N" sets D, etc.
+        if (strlen(reg) == 1 && strlen(a) == 2 && is_reg16(a) && (a[0] == reg[0] || a[1] == reg[0])) {
+            if (eval(b, &v)) { *ok = 1; return a[0] == reg[0] ? (v >> 8) & 0xFF : v & 0xFF; }
+            *ok = 0;
+            return 0;
+        }
+    }
+    *ok = 0;
+    return 0;
+}
+
+// Infer how many times a loop head is entered from its back-branch at `tail`
+static int infer_loop(int head, int tail, long *count) {
+    insn *br = &insns[tail];
+    int ok = 0;
+
+    if (!strcmp(br->mn, "djnz")) {
+        long v = value_of_b_before(head, "b", &ok);
+        if (ok) { *count = v ? v : 256; return 1; }
+        return 0;
+    }
+    if (br->cond && tail > 0) {
+        char cc[48];
+        lower(cc, br->op[0], sizeof(cc));
+        if (strcmp(cc, "nz")) return 0;
+        // dec r / jp nz
+        insn *p = &insns[tail - 1];
+        if (!strcmp(p->mn, "dec") && p->nops == 1) {
+            char r[48];
+            lower(r, p->op[0], sizeof(r));
+            if (strlen(r) == 1 && strcmp(r, "a")) {
+                long v = value_of_b_before(head, r, &ok);
+                if (ok) { *count = v ? v : 256; return 1; }
+            }
+            return 0;
+        }
+        // ld a,(cnt) / dec a / ld (cnt),a / jp nz
+        if (tail >= 2 && !strcmp(p->mn, "ld") && !strcmp(insns[tail - 2].mn, "dec")) {
+            char dst[48];
+            lower(dst, p->op[0], sizeof(dst));
+            if (dst[0] != '(') return 0;
+            for (int i = head - 1; i >= 1 && i >= head - 64; i--) {
+                insn *st = &insns[i];
+                char d2[48];
+                long v;
+                lower(d2, st->op[0], sizeof(d2));
+                if (!strcmp(st->mn, "ld") && !strcmp(d2, dst)) {
+                    insn *ld = &insns[i - 1];
+                    char la[48];
+                    lower(la, ld->op[0], sizeof(la));
+                    if (!strcmp(ld->mn, "ld") && !strcmp(la, "a") && eval(ld->op[1], &v)) {
+                        *count = (v & 0xFF) ? (v & 0xFF) : 256;
+                        return 1;
+                    }
+                    return 0;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+static void build_regions(void) {
+    region_count = 0;
+    for (int i = 0; i < insn_count; i++) region_of_head[i] = -1;
+
+    for (int j = 0; j < insn_count; j++) {
+        insn *in = &insns[j];
+        if (in->kind != K_JUMP || in->target_idx < 0 || in->target_idx > j) continue;
+        int h = in->target_idx;
+        int r = region_of_head[h];
+        if (r < 0) {
+            if (region_count == MAX_REGIONS) {
+                fprintf(stderr, "Error: too many loops\n");
+                exit(1);
+            }
+            r = region_count++;
+            regions[r].head = h;
+            regions[r].end = j;
+            regions[r].kmin = regions[r].kmax = 0;
+            regions[r].annotated = 0;
+            regions[r].conflict = 0;
+            regions[r].limited = 0;
+            region_of_head[h] = r;
+        }
+        if (j > regions[r].end) regions[r].end = j;
+
+        long kmin = 0, kmax = 0;
+        regions[r].limited += in->taken_max;
+        if (in->loop_min || in->loop_max) {
+            regions[r].kmin = in->loop_min;
+            regions[r].kmax = in->loop_max;
+            regions[r].annotated = 1;
+            continue;
+        }
+        if (regions[r].annotated) continue;
+        if (infer_loop(h, j, &kmin)) kmax = kmin;
+        if (kmax && regions[r].kmax && kmax != regions[r].kmax) regions[r].conflict = 1;
+        if (kmax) {
+            if (!regions[r].kmax || kmin < regions[r].kmin) regions[r].kmin = kmin;
+            if (kmax > regions[r].kmax) regions[r].kmax = kmax;
+        }
+    }
+
+    // Nesting: parent = smallest enclosing region
+    for (int r = 0; r < region_count; r++) {
+        regions[r].parent = -1;
+        for (int q = 0; q < region_count; q++) {
+            if (q == r) continue;
+            region *a = &regions[r], *b = &regions[q];
+            if (b->head <= a->head && a->end <= b->end && (b->head < a->head || a->end < b->end)) {
+                if (regions[r].parent < 0
+                    || (b->end - b->head) < (regions[regions[r].parent].end - regions[regions[r].parent].head))
+                    regions[r].parent = q;
+            } else if (b->head < a->head && a->head <= b->end && b->end < a->end) {
+                fail(insns[a->head].file, insns[a->head].line, "overlapping loops", NULL);
+            }
+        }
+    }
+    for (int r = 0; r < region_count; r++) {
+        int d = 1;
+        for (int p = regions[r].parent; p >= 0; p = regions[p].parent) d++;
+        regions[r].depth = d;
+        if (d >= MAX_DEPTH) fail(insns[regions[r].head].file, insns[regions[r].head].line, "loops nested too deeply", NULL);
+        if (regions[r].conflict && !regions[r].annotated) {
+            insn *h = &insns[regions[r].end];
+            fail(h->file, h->line, "back-branches to one head infer different counts; add '; @loop N'", NULL);
+        }
+        if (!regions[r].kmax) {
+            insn *h = &insns[regions[r].end];
+            fail(h->file, h->line, "cannot determine loop count; add '; @loop N'", NULL);
+            regions[r].kmin = regions[r].kmax = 1;
+        }
+    }
+    // Innermost region containing each instruction
+    for (int i = 0; i < insn_count; i++) {
+        inner_region[i] = -1;
+        for (int r = 0; r < region_count; r++) {
+            if (regions[r].head <= i && i <= regions[r].end
+                && (inner_region[i] < 0 || regions[r].depth > regions[inner_region[i]].depth))
+                inner_region[i] = r;
+        }
+    }
+}
+
+static void vals_clear(vals *v) {
+    for (int l = 0; l < MAX_LEVELS; l++) {
+        v->mn[l] = NO_COST;
+        v->mx[l] = NO_COST;
+    }
+}
+
+// dst = best/worst of (dst, src + cost)
+static void vals_merge(vals *dst, const vals *src, long cmin, long cmax) {
+    for (int l = 0; l < MAX_LEVELS; l++) {
+        if (src->mn[l] == NO_COST) continue;
+        long a = src->mn[l] + cmin, b = src->mx[l] + cmax;
+        if (dst->mn[l] == NO_COST || a < dst->mn[l]) dst->mn[l] = a;
+        if (dst->mx[l] == NO_COST || b > dst->mx[l]) dst->mx[l] = b;
+    }
+}
+
+static int contended_mode;
+
+static void insn_cost(int i, long *base_min, long *base_max, long *taken_min, long *taken_max) {
+    insn *in = &insns[i];
+    long pen = contended_mode ? (long)in->mem * CONTENTION_T : 0;
+    long bmin = in->t_base, bmax = in->t_base;
+
+    if (in->block_repeat) {
+        long kmin = in->loop_min, kmax = in->loop_max;
+        if (!kmax) {
+            // ld bc, N in the same straight-line block
+            for (int k = i - 1; k >= 0 && k >= i - 16; k--) {
+                insn *p = &insns[k];
+                char a[48];
+                long v;
+                if (p->kind != K_NORMAL) break;
+                lower(a, p->op[0], sizeof(a));
+                if (!strcmp(p->mn, "ld") && !strcmp(a, "bc") && eval(p->op[1], &v)) {
+                    kmin = kmax = (v & 0xFFFF) ? (v & 0xFFFF) : 65536;
+                    break;
+                }
+                if (strstr(a, "b") || strstr(a, "c")) break;
+            }
+        }
+        if (!kmax) {
+            static int warned[MAX_INSNS];
+            if (!warned[i]) {
+                warned[i] = 1;
+                fail(in->file, in->line, "cannot determine block repeat count; add '; @loop N'", NULL);
+            }
+            kmin = kmax = 1;
+        }
+        bmin = 21 * (kmin - 1) + 16;
+        bmax = 21 * (kmax - 1) + 16 + pen * kmax;
+        pen = 0;
+    }
+    *base_min = bmin;
+    *base_max = bmax + pen;
+    *taken_min = in->t_taken;
+    *taken_max = in->t_taken + pen;
+    if (in->kind == K_CALL && in->target_idx >= 0) {
+        long cmin = V[in->target_idx].mn[0] == NO_COST ? 0 : V[in->target_idx].mn[0];
+        long cmax = V[in->target_idx].mx[0] == NO_COST ? 0 : V[in->target_idx].mx[0];
+        *taken_min += cmin;
+        *taken_max += cmax;
+        if (!in->cond) {
+            *base_min += cmin;
+            *base_max += cmax;
+        }
+    }
+}
+
+static void solve_region(int r, int head, int end, int depth);
+
+static void solve_insn(int i, int head, int end, int depth) {
+    insn *in = &insns[i];
+    long bmin, bmax, tmin, tmax;
+    vals v, tmp;
+    vals_clear(&v);
+
+    if (in->kind == K_DATA) {
+        V[i] = v;
+        return;
+    }
+    insn_cost(i, &bmin, &bmax, &tmin, &tmax);
+
+    switch (in->kind) {
+    case K_RET:
+        vals_clear(&tmp);
+        tmp.mn[0] = tmp.mx[0] = 0;
+        if (in->cond) {
+            vals_merge(&v, &tmp, in->t_taken, in->t_taken);
+            if (i + 1 < insn_count) vals_merge(&v, &V[i + 1], bmin, bmax);
+        } else {
+            vals_merge(&v, &tmp, bmin, bmax);
+        }
+        break;
+    case K_EXIT:
+        vals_clear(&tmp);
+        tmp.mn[0] = tmp.mx[0] = 0;
+        vals_merge(&v, &tmp, bmin, bmax);
+        if (in->cond && i + 1 < insn_count) vals_merge(&v, &V[i + 1], bmin, bmax);
+        break;
+    case K_JUMP: {
+        int t = in->target_idx;
+        if (head >= 0 && t == head && i >= head) {
+            int l = in->taken_max ? MAX_DEPTH + depth : depth;
+            vals_clear(&tmp);
+            tmp.mn[l] = tmp.mx[l] = 0;
+            vals_merge(&v, &tmp, tmin, tmax);
+        } else if (t > i || (head >= 0 && (t < head || t > end))) {
+            vals_merge(&v, &V[t], tmin, tmax);
+        } else {
+            fail(in->file, in->line, "unstructured backward jump", in->target);
+        }
+        if (in->cond && i + 1 < insn_count) vals_merge(&v, &V[i + 1], bmin, bmax);
+        break;
+    }
+    case K_CALL:
+        if (in->target_idx < 0) fail(in->file, in->line, "call to unknown routine (cost not included):", in->target);
+        if (i + 1 < insn_count) {
+            vals_merge(&v, &V[i + 1], in->cond ? bmin : tmin, in->cond ? bmax : tmax);
+            if (in->cond) vals_merge(&v, &V[i + 1], tmin, tmax);
+        }
+        break;
+    default:
+        if (i + 1 < insn_count) vals_merge(&v, &V[i + 1], bmin, bmax);
+        break;
+    }
+    (void)end;
+    V[i] = v;
+}
+
+// Solve loop region r: fill V for its instructions, then collapse the head
+static void solve_region(int r, int head, int end, int depth) {
+    for (int i = end; i >= head; i--) {
+        int ir = inner_region[i];
+        if (ir != r) {
+            // Inside a nested loop: solve it when we reach its head
+            if (ir >= 0 && regions[ir].head == i && regions[ir].parent == r) {
+                solve_region(ir, regions[ir].head, regions[ir].end, regions[ir].depth);
+            }
+            continue;
+        }
+        solve_insn(i, head, end, depth);
+    }
+    // Collapse: K entries of the head = (K-1) iterations + 1 exit path.
+    // Up to `limited` of the K-1 iterations may end in an "@taken" branch.
+    {
+        region *rg = &regions[r];
+        vals it = V[head];
+        vals out;
+        int own = depth, own_lim = MAX_DEPTH + depth;
+        long nmin = it.mn[own], nmax = it.mx[own];
+        long lmin = it.mn[own_lim], lmax = it.mx[own_lim];
+        long add_min, add_max;
+
+        if (nmin == NO_COST && lmin == NO_COST) {
+            add_min = add_max = 0;
+        } else if (lmin == NO_COST) {
+            add_min = (rg->kmin - 1) * nmin;
+            add_max = (rg->kmax - 1) * nmax;
+        } else if (nmin == NO_COST) {
+            add_min = (rg->kmin - 1) * lmin;
+            add_max = (rg->kmax - 1) * lmax;
+        } else {
+            long mmin = rg->limited < rg->kmin - 1 ? rg->limited : rg->kmin - 1;
+            long mmax = rg->limited < rg->kmax - 1 ? rg->limited : rg->kmax - 1;
+            add_min = (rg->kmin - 1) * nmin + (lmin < nmin ? mmin * (lmin - nmin) : 0);
+            add_max = (rg->kmax - 1) * nmax + (lmax > nmax ? mmax * (lmax - nmax) : 0);
+        }
+        vals_clear(&out);
+        for (int l = 0; l < MAX_LEVELS; l++) {
+            if (l == own || l == own_lim || it.mn[l] == NO_COST) continue;
+            out.mn[l] = add_min + it.mn[l];
+            out.mx[l] = add_max + it.mx[l];
+        }
+        V[head] = out;
+    }
+}
+
+static void solve_all(void) {
+    for (int pass = 0; pass < 8; pass++) {
+        for (int i = insn_count - 1; i >= 0; i--) {
+            int ir = inner_region[i];
+            if (ir >= 0) {
+                // Outermost region heads are solved from top level
+                int top = ir;
+                while (regions[top].parent >= 0) top = regions[top].parent;
+                if (regions[top].head == i) solve_region(top, regions[top].head, regions[top].end, regions[top].depth);
+                continue;
+            }
+            solve_insn(i, -1, insn_count - 1, 0);
+        }
+    }
+}
+
+static void fmt_t(char *buf, size_t n, long v) {
+    if (v == NO_COST) snprintf(buf, n, "-");
+    else snprintf(buf, n, "%ld", v);
+}
+
+int main(int argc, char **argv) {
+    int want_contended = 0;
+    const char *model_path = NULL;
+    int over = 0;
+    FILE *model = NULL;
+    int files = 0;
+    const char *defines[MAX_DEFINES];
+    int define_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--contended")) { want_contended = 1; continue; }
+        if (!strcmp(argv[i], "--model") && i + 1 < argc) { model_path = argv[++i]; continue; }
+        if (!strncmp(argv[i], "-D", 2) && argv[i][2]) {
+            if (define_count == MAX_DEFINES) {
+                fprintf(stderr, "Error: too many -D options\n");
+                return 1;
+            }
+            defines[define_count++] = argv[i] + 2;
+            continue;
+        }
+        if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+        files++;
+    }
+    if (!files) {
+        fprintf(stderr, "Usage: %s [--contended] [--model <out.txt>] [-DNAME[=N]] <file.asm> [...]\n", argv[0]);
+        return 1;
+    }
+    if (model_path && !(model = fopen(model_path, "w"))) {
+        fprintf(stderr, "Error: cannot write %s\n", model_path);
+        return 1;
+    }
+    if (model) fprintf(model, "# routine best worst worst_contended - generated by asm_timing\n");
+
+    for (int a = 1; a < argc; a++) {
+        if (argv[a][0] == '-') {
+            if (!strcmp(argv[a], "--model")) a++;
+            continue;
+        }
+        source src;
+        sym_count = insn_count = entry_count = 0;
+        pending_budget = pending_budget_contended = 0;
+        for (int d = 0; d < define_count; d++) {
+            char name[64];
+            const char *eq = strchr(defines[d], '=');
+            size_t len = eq ? (size_t)(eq - defines[d]) : strlen(defines[d]);
+            if (len >= sizeof(name)) len = sizeof(name) - 1;
+            memcpy(name, defines[d], len);
+            name[len] = '\0';
+            set_sym(name, eq ? strtol(eq + 1, NULL, 0) : 1, 0);
+        }
+        if (!load_source(&src, argv[a])) {
+            fprintf(stderr, "Error: cannot open %s\n", argv[a]);
+            return 1;
+        }
+        process_range(&src, 0, src.count, 0);
+        resolve_targets();
+        build_regions();
+
+        vals uncontended[MAX_SYMS], contended[MAX_SYMS];
+        contended_mode = 0;
+        solve_all();
+        for (int e = 0; e < entry_count; e++) {
+            symbol *s = find_sym(entries[e].name);
+            vals_clear(&uncontended[e]);
+            if (s && s->is_label && s->value < insn_count) uncontended[e] = V[s->value];
+        }
+        contended_mode = 1;
+        solve_all();
+        for (int e = 0; e < entry_count; e++) {
+            symbol *s = find_sym(entries[e].name);
+            vals_clear(&contended[e]);
+            if (s && s->is_label && s->value < insn_count) contended[e] = V[s->value];
+        }
+
+        printf("%s\n", argv[a]);
+        printf("  %-38s %9s %9s", "routine", "best", "worst");
+        if (want_contended) printf(" %11s", "contended");
+        printf(" %9s\n", "budget");
+        for (int e = 0; e < entry_count; e++) {
+            symbol *s = find_sym(entries[e].name);
+            char b1[32], b2[32], b3[32], b4[32];
+            const char *status = "";
+            if (!s || !s->is_label || s->value >= insn_count || insns[s->value].kind == K_DATA) continue;
+            long best = uncontended[e].mn[0], worst = uncontended[e].mx[0], cworst = contended[e].mx[0];
+            fmt_t(b1, sizeof(b1), best);
+            fmt_t(b2, sizeof(b2), worst);
+            fmt_t(b3, sizeof(b3), cworst);
+            if (entries[e].budget) snprintf(b4, sizeof(b4), "%ld", entries[e].budget);
+            else snprintf(b4, sizeof(b4), "-");
+            if (entries[e].budget && worst > entries[e].budget) { status = "  OVER BUDGET"; over++; }
+            if (entries[e].budget_contended && cworst > entries[e].budget_contended) {
+                status = "  OVER CONTENDED BUDGET";
+                over++;
+            }
+            printf("  %-38s %9s %9s", entries[e].name, b1, b2);
+            if (want_contended) printf(" %11s", b3);
+            printf(" %9s%s\n", b4, status);
+            if (model) fprintf(model, "%s %ld %ld %ld\n", entries[e].name, best, worst, cworst);
+        }
+    }
+    if (model) fclose(model);
+    if (errors) fprintf(stderr, "%d error(s)\n", errors);
+    if (over) fprintf(stderr, "%d routine(s) over budget\n", over);
+    return (errors || over) ? 1 : 0;
+}
@@ -5,9 +5,36 @@ TILES_ZXP := assets/basic_tiles16x16.zxp
 
 MAP_WIDTH_TILES := 96
 MAP_HEIGHT_TILES := 48
+# Bytes per map row (width, 128 or 256); a power of two turns row stepping
+# into shifts, at the cost of padding map.bin
+MAP_STRIDE := 128
 
+# 16 or 32 builds a metatile map (2x2 / 4x4 blocks of 8x8 cells from the
+# sheet); MAP_*_TILES and MAP_STRIDE then count metatiles
 TILE_WIDTH_PX := 8
 TILE_HEIGHT_PX := 8
 
+# Viewport (tiles) and screen position (chars); generate_viewport unrolls the
+# renderers, shifts and screen tables for this size
+VIEWPORT_COLS := 20
+VIEWPORT_CHAR_ROWS := 16
+VIEWPORT_COL_OFFSET := 6
+VIEWPORT_START_CHAR_ROW := 8
+
+# Tileset optimiser: gameplay tiles kept at fixed indices (1 = wall, 3 = trigger)
+TILE_KEEP := 1,3
+TILE_FOLD_MIRRORS := 0
+# Animated tiles: base=frame,frame,...[@frames per step], sheet cells, e.g.
+# TILE_ANIM := 2=2,4@6
+TILE_ANIM :=
+# Per-tile colour from the .zxp attributes (1 = on, ~7,300 T more per shift)
+TILE_ATTRS := 0
+# 8x2 colour by a beam-synced attribute raster (1 = on; ~29 kT per frame,
+# steps spread over 3-6 frames; excludes TILE_ATTRS)
+MULTICOLOUR := 0
+# AY music and sound effects from the frame interrupt (1 = on; ~1.9 kT per
+# frame, 128K; see readme "AY music and SFX")
+SOUND := 0
+
 # Note: Original 128x128 buffer stays at 0xD000 (default)
 # The 32x16 dirty-edge buffer is at 0xF000
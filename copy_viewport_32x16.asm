@@ -1,8 +1,8 @@
 ; copy_viewport_32x16.asm - Blit viewport to screen
 ; Uses 2D ring-buffer: head_row (vertical) + head_col/fine_x (horizontal)
 ;
-; IMPORTANT: These constants must match draw_dirty_edge.h
-; Change VIEWPORT_COLS and VIEWPORT_CHAR_ROWS to resize the viewport.
+; Viewport size comes from viewport.inc (generate_viewport, config/*.mk);
+; draw_dirty_edge.h picks up the same values from viewport.h.
 
     SECTION code_user
 
@@ -10,14 +10,11 @@
     PUBLIC scr_addr_table_32x16
     EXTERN _offscreen_buffer_32x16
 
-; Master viewport parameters (must match draw_dirty_edge.h)
-VIEWPORT_COLS       EQU 20       ; visible columns
-VIEWPORT_CHAR_ROWS  EQU 16       ; visible character rows
-VIEWPORT_COL_OFFSET EQU 6        ; screen byte offset from left edge
+; Viewport parameters, generated from config/*.mk by generate_viewport
+    INCLUDE "viewport.inc"
 
 ; Derived constants
 BUF_WIDTH       EQU VIEWPORT_COLS + 1    ; buffer bytes per row (visible + 1 lookahead)
-VIEWPORT_HEIGHT EQU VIEWPORT_CHAR_ROWS * 8  ; height in pixels / scanlines
 BUF_SIZE        EQU BUF_WIDTH * VIEWPORT_HEIGHT  ; total buffer size
 
 ; Screen constants
@@ -34,6 +31,11 @@ SCREEN_BASE     EQU 0x4000
 ; Reads BUF_WIDTH bytes per row from head_col with column wrapping.
 ; When fine_x==0: direct copy (fast path)
 ; When fine_x>0:  output[i] = (src[i] << fine_x) | (src[i+1] >> (8-fine_x))
+;
+; The segment and wrap counts come from the arguments, so the loops carry
+; "@loop" ranges for asm_timing. Each range is bounded on its own (segment
+; rows A + B = VIEWPORT_HEIGHT, first + second = VIEWPORT_COLS), so the
+; reported worst case is an upper bound, not a reachable path.
 ;------------------------------------------------------------------------------
 _copy_viewport_32x16_to_screen_ring_2d:
     di
@@ -79,7 +81,7 @@ _r2d_mul:
     jr z, _r2d_mul_done
     add hl, de
     dec a
-    jr _r2d_mul
+    jr _r2d_mul               ; @loop 1..VIEWPORT_HEIGHT
 _r2d_mul_done:
     ld d, 0
     ld e, (ix+7)
@@ -123,7 +125,7 @@ _r2d_c1a:
     ld (de), a
     inc hl
     inc de
-    djnz _r2d_c1a
+    djnz _r2d_c1a             ; @loop 1..VIEWPORT_COLS
 
     ld a, (_r2d_second)
     or a
@@ -139,7 +141,7 @@ _r2d_c2a:
     ld (de), a
     inc hl
     inc de
-    djnz _r2d_c2a
+    djnz _r2d_c2a             ; @loop 1..VIEWPORT_COLS-1
 
     push de
     ld a, (_r2d_first)
@@ -158,7 +160,7 @@ _r2d_nwa:
 
 _r2d_na:
     pop bc
-    djnz _r2d_la
+    djnz _r2d_la              ; @loop 1..VIEWPORT_HEIGHT
 
 _r2d_segb:
     pop hl
@@ -194,7 +196,7 @@ _r2d_c1b:
     ld (de), a
     inc hl
     inc de
-    djnz _r2d_c1b
+    djnz _r2d_c1b             ; @loop 1..VIEWPORT_COLS
 
     ld a, (_r2d_second)
     or a
@@ -210,7 +212,7 @@ _r2d_c2b:
     ld (de), a
     inc hl
     inc de
-    djnz _r2d_c2b
+    djnz _r2d_c2b             ; @loop 1..VIEWPORT_COLS-1
 
     push de
     ld a, (_r2d_first)
@@ -229,7 +231,7 @@ _r2d_nwb:
 
 _r2d_nb:
     pop bc
-    djnz _r2d_lb
+    djnz _r2d_lb              ; @loop 1..VIEWPORT_HEIGHT-1
 
 _r2d_done:
     pop ix
@@ -298,7 +300,7 @@ _r2df_mul:
     jr z, _r2df_mul_done
     add hl, de
     dec a
-    jr _r2df_mul
+    jr _r2df_mul              ; @loop 1..VIEWPORT_HEIGHT
 _r2df_mul_done:
     ld d, 0
     ld e, (ix+7)
@@ -356,7 +358,7 @@ ENDIF
     pop de
 
     pop bc
-    djnz _r2df_la
+    djnz _r2df_la             ; @loop 1..VIEWPORT_HEIGHT
 
 _r2df_segb:
     pop hl                    ; HL = base buffer
@@ -401,7 +403,7 @@ ENDIF
     pop de
 
     pop bc
-    djnz _r2df_lb
+    djnz _r2df_lb             ; @loop 1..VIEWPORT_HEIGHT-1
 
 _r2df_done:
     pop ix
@@ -435,12 +437,12 @@ _gen_shl_shift:
     jr z, _gen_shl_done_shift
     sla a
     dec e
-    jr nz, _gen_shl_shift
+    jr nz, _gen_shl_shift     ; @loop 1..7
 _gen_shl_done_shift:
     ld (hl), a                ; store shifted value
     inc hl
     inc d
-    jr nz, _gen_shl_loop      ; loop until D wraps to 0
+    jr nz, _gen_shl_loop      ; loop until D wraps to 0  @loop 256
     
     ; Generate shr_table: for i=0 to 255, table[i] = i >> comp_x
     ld hl, (_r2df_shr_addr)
@@ -453,12 +455,12 @@ _gen_shr_shift:
     jr z, _gen_shr_done_shift
     srl a
     dec e
-    jr nz, _gen_shr_shift
+    jr nz, _gen_shr_shift     ; @loop 1..7
 _gen_shr_done_shift:
     ld (hl), a                ; store shifted value
     inc hl
     inc d
-    jr nz, _gen_shr_loop      ; loop until D wraps to 0
+    jr nz, _gen_shr_loop      ; loop until D wraps to 0  @loop 256
     
     pop hl
     pop de
@@ -489,7 +491,7 @@ _r2df_emit_row:
     ld de, _r2df_temp
     ld c, b
     ld b, 0                   ; BC = first count
-    ldir                      ; copy first segment (16T/byte)
+    ldir                      ; copy first segment (16T/byte)  @loop 1..BUF_WIDTH-1
 
     ; Wrap: HL is now past end of row, go back to column 0
     push de                   ; save temp dest position
@@ -503,7 +505,7 @@ _r2df_emit_row:
     jr z, _r2df_lin_done
     ld c, a
     ld b, 0                   ; BC = second count
-    ldir                      ; copy second segment (16T/byte)
+    ldir                      ; copy second segment (16T/byte)  @loop 1..BUF_WIDTH-1
 
 _r2df_lin_done:
     pop de                    ; restore screen address
@@ -605,44 +607,13 @@ _r2df_second:
     DEFB 0
 
 ;------------------------------------------------------------------------------
-; Screen address lookup table for VIEWPORT_HEIGHT lines starting at Y=32
+; Screen address lookup table, one entry per viewport scanline
 ; ZX Spectrum screen layout:
 ;   Address = 0x4000 + (Y/64)*0x800 + ((Y%64)/8)*0x20 + (Y%8)*0x100
-; MUST be regenerated if VIEWPORT_START_CHAR_ROW or VIEWPORT_CHAR_ROWS changes
+; Generated for DIRTY_START_CHAR_ROW (char row 4) / VIEWPORT_CHAR_ROWS
 ;------------------------------------------------------------------------------
 scr_addr_table_32x16:
-    ; Y=32-39 (third 0, char row 4)
-    DEFW 0x4080, 0x4180, 0x4280, 0x4380, 0x4480, 0x4580, 0x4680, 0x4780
-    ; Y=40-47 (third 0, char row 5)
-    DEFW 0x40A0, 0x41A0, 0x42A0, 0x43A0, 0x44A0, 0x45A0, 0x46A0, 0x47A0
-    ; Y=48-55 (third 0, char row 6)
-    DEFW 0x40C0, 0x41C0, 0x42C0, 0x43C0, 0x44C0, 0x45C0, 0x46C0, 0x47C0
-    ; Y=56-63 (third 0, char row 7)
-    DEFW 0x40E0, 0x41E0, 0x42E0, 0x43E0, 0x44E0, 0x45E0, 0x46E0, 0x47E0
-    ; Y=64-71 (third 1, char row 0)
-    DEFW 0x4800, 0x4900, 0x4A00, 0x4B00, 0x4C00, 0x4D00, 0x4E00, 0x4F00
-    ; Y=72-79 (third 1, char row 1)
-    DEFW 0x4820, 0x4920, 0x4A20, 0x4B20, 0x4C20, 0x4D20, 0x4E20, 0x4F20
-    ; Y=80-87 (third 1, char row 2)
-    DEFW 0x4840, 0x4940, 0x4A40, 0x4B40, 0x4C40, 0x4D40, 0x4E40, 0x4F40
-    ; Y=88-95 (third 1, char row 3)
-    DEFW 0x4860, 0x4960, 0x4A60, 0x4B60, 0x4C60, 0x4D60, 0x4E60, 0x4F60
-    ; Y=96-103 (third 1, char row 4)
-    DEFW 0x4880, 0x4980, 0x4A80, 0x4B80, 0x4C80, 0x4D80, 0x4E80, 0x4F80
-    ; Y=104-111 (third 1, char row 5)
-    DEFW 0x48A0, 0x49A0, 0x4AA0, 0x4BA0, 0x4CA0, 0x4DA0, 0x4EA0, 0x4FA0
-    ; Y=112-119 (third 1, char row 6)
-    DEFW 0x48C0, 0x49C0, 0x4AC0, 0x4BC0, 0x4CC0, 0x4DC0, 0x4EC0, 0x4FC0
-    ; Y=120-127 (third 1, char row 7)
-    DEFW 0x48E0, 0x49E0, 0x4AE0, 0x4BE0, 0x4CE0, 0x4DE0, 0x4EE0, 0x4FE0
-    ; Y=128-135 (third 2, char row 0)
-    DEFW 0x5000, 0x5100, 0x5200, 0x5300, 0x5400, 0x5500, 0x5600, 0x5700
-    ; Y=136-143 (third 2, char row 1)
-    DEFW 0x5020, 0x5120, 0x5220, 0x5320, 0x5420, 0x5520, 0x5620, 0x5720
-    ; Y=144-151 (third 2, char row 2)
-    DEFW 0x5040, 0x5140, 0x5240, 0x5340, 0x5440, 0x5540, 0x5640, 0x5740
-    ; Y=152-159 (third 2, char row 3)
-    DEFW 0x5060, 0x5160, 0x5260, 0x5360, 0x5460, 0x5560, 0x5660, 0x5760
+    INCLUDE "dirty_scr_addr_table.inc"
 
 ;------------------------------------------------------------------------------
 ; Offscreen buffer for viewport (BUF_WIDTH * VIEWPORT_HEIGHT bytes)
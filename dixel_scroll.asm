@@ -24,12 +24,8 @@
 
     EXTERN scr_addr_table_32x16
 
-; Viewport parameters (must match draw_dirty_edge.h)
-VIEWPORT_COLS           EQU 20
-VIEWPORT_CHAR_ROWS      EQU 16
-VIEWPORT_COL_OFFSET     EQU 6
-VIEWPORT_START_CHAR_ROW EQU 4
-VIEWPORT_HEIGHT         EQU VIEWPORT_CHAR_ROWS * 8  ; 128 scanlines
+; Viewport parameters, generated from config/*.mk by generate_viewport
+    INCLUDE "viewport.inc"
 
 ; 128K-safe floating bus port.  IN A,(0xFF) is BROKEN on 128K because the
 ; current value of A bleeds onto A15; if bit 7 is set you read the AY chip
@@ -42,7 +38,7 @@ FLOAT_PORT              EQU 0x40FF
 ; to detect the exact moment the beam exits the viewport.
 ; FLASH+BRIGHT on black = visually invisible (both ink & paper are black).
 SENTINEL_ATTR           EQU 0xC0
-SENTINEL_ROW            EQU VIEWPORT_START_CHAR_ROW + VIEWPORT_CHAR_ROWS
+SENTINEL_ROW            EQU DIRTY_START_CHAR_ROW + VIEWPORT_CHAR_ROWS
 SENTINEL_ADDR           EQU 0x5800 + SENTINEL_ROW * 32 + VIEWPORT_COL_OFFSET
 
 ; Tear-free mode: split work across 2 frames with attribute-based beam sync.
@@ -83,7 +79,7 @@ _dixel_wait_vblank:
 _dwv_wait:
     in a, (c)
     inc a                   ; A+1=0 if A was 0xFF
-    jr nz, _dwv_wait
+    jr nz, _dwv_wait        ; @loop 1..3000 (one frame of polling)
     in a, (c)
     inc a
     jr nz, _dwv_wait
@@ -232,11 +228,11 @@ _dsr_no_hit:
     dec hl                          ;  6T
     ld a, h                         ;  4T
     or l                            ;  4T
-    jr nz, _dsr_mid_sync            ; 12T
+    jr nz, _dsr_mid_sync            ; 12T  @loop 1..4000
     ; Timeout: proceed with phase 2 anyway (may tear)
 _dsr_synced:
     ld b, PHASE2_LINES              ;  7T
-    jp _dsr_scanline                ; 10T
+    jp _dsr_scanline                ; 10T  @loop PHASE1_LINES+PHASE2_LINES @taken 1
 
 _dsr_done:
 ENDIF
@@ -374,11 +370,11 @@ _dsl_no_hit:
     dec hl                          ;  6T
     ld a, h                         ;  4T
     or l                            ;  4T
-    jr nz, _dsl_mid_sync            ; 12T
+    jr nz, _dsl_mid_sync            ; 12T  @loop 1..4000
     ; Timeout: proceed with phase 2 anyway (may tear)
 _dsl_synced:
     ld b, PHASE2_LINES              ;  7T
-    jp _dsl_scanline                ; 10T
+    jp _dsl_scanline                ; 10T  @loop PHASE1_LINES+PHASE2_LINES @taken 1
 
 _dsl_done:
 ENDIF
@@ -1,17 +1,18 @@
 #include "draw_dirty_edge.h"
+#include "tile_render.h"   // MAP_ROW_OFFSET
 
 static void scroll_x_plus_ring(unsigned char *buffer, unsigned char head_row, unsigned char *head_col,
                                unsigned char *fine_x, const unsigned char *map_data,
-                               const unsigned char *tiles, int camera_x, int camera_y, int map_width);
+                               const unsigned char *tiles, int camera_x, int camera_y);
 static void scroll_x_minus_ring(unsigned char *buffer, unsigned char head_row, unsigned char *head_col,
                                 unsigned char *fine_x, const unsigned char *map_data,
-                                const unsigned char *tiles, int camera_x, int camera_y, int map_width);
+                                const unsigned char *tiles, int camera_x, int camera_y);
 static void scroll_y_plus_ring(unsigned char *buffer, unsigned char *head_row, unsigned char head_col,
                                unsigned char fine_x, const unsigned char *map_data,
-                               const unsigned char *tiles, int camera_x, int camera_y, int map_width);
+                               const unsigned char *tiles, int camera_x, int camera_y);
 static void scroll_y_minus_ring(unsigned char *buffer, unsigned char *head_row, unsigned char head_col,
                                 unsigned char fine_x, const unsigned char *map_data,
-                                const unsigned char *tiles, int camera_x, int camera_y, int map_width);
+                                const unsigned char *tiles, int camera_x, int camera_y);
 
 // Unified scroll handler with stride support
 unsigned char dirty_edge_scroll(
@@ -24,8 +25,6 @@ unsigned char dirty_edge_scroll(
     unsigned char *fine_x,
     int *camera_x,
     int *camera_y,
-    int map_width,
-    int map_height,
     unsigned char stride_x,
     unsigned char stride_y
 ) {
@@ -66,14 +65,14 @@ unsigned char dirty_edge_scroll(
         int ty = cy;
         for (i = 0; i < max_stride; i++) {
             if (direction & SCROLL_Y_PLUS) {
-                if (ty >= (map_height * 8) - DIRTY_VIEWPORT_HEIGHT_PX) break;
+                if (ty >= (MAP_HEIGHT * 8) - DIRTY_VIEWPORT_HEIGHT_PX) break;
                 ty++;
-                scroll_y_plus_ring(buffer, &h_row, h_col, f_x, map_data, tiles, cx, ty, map_width);
+                scroll_y_plus_ring(buffer, &h_row, h_col, f_x, map_data, tiles, cx, ty);
             }
             if (direction & SCROLL_Y_MINUS) {
                 if (ty <= 0) break;
                 ty--;
-                scroll_y_minus_ring(buffer, &h_row, h_col, f_x, map_data, tiles, cx, ty, map_width);
+                scroll_y_minus_ring(buffer, &h_row, h_col, f_x, map_data, tiles, cx, ty);
             }
         }
         cy = ty;
@@ -84,14 +83,14 @@ unsigned char dirty_edge_scroll(
         int tx = cx;
         for (i = 0; i < max_stride; i++) {
             if (direction & SCROLL_X_PLUS) {
-                if (tx >= (map_width * 8) - DIRTY_VIEWPORT_WIDTH_PX) break;
+                if (tx >= (MAP_WIDTH * 8) - DIRTY_VIEWPORT_WIDTH_PX) break;
                 tx++;
-                scroll_x_plus_ring(buffer, h_row, &h_col, &f_x, map_data, tiles, tx, cy, map_width);
+                scroll_x_plus_ring(buffer, h_row, &h_col, &f_x, map_data, tiles, tx, cy);
             }
             if (direction & SCROLL_X_MINUS) {
                 if (tx <= 0) break;
                 tx--;
-                scroll_x_minus_ring(buffer, h_row, &h_col, &f_x, map_data, tiles, tx, cy, map_width);
+                scroll_x_minus_ring(buffer, h_row, &h_col, &f_x, map_data, tiles, tx, cy);
             }
         }
         cx = tx;
@@ -110,7 +109,7 @@ unsigned char dirty_edge_scroll(
 // Draw a full byte column at a specific buffer column for a given pixel X position.
 // Used by horizontal ring-buffer to fill edge bytes and lookahead bytes.
 static void draw_byte_column(unsigned char *buffer, const unsigned char *map_data,
-                             const unsigned char *tiles, int pixel_x, int camera_y, int map_width,
+                             const unsigned char *tiles, int pixel_x, int camera_y,
                              unsigned char head_row, unsigned char buf_col) {
     int tile_x = pixel_x >> 3;
     unsigned char in_tile_x = pixel_x & 7;
@@ -120,8 +119,8 @@ static void draw_byte_column(unsigned char *buffer, const unsigned char *map_dat
         tile_x = 0;
         in_tile_x = 0;
     }
-    if (tile_x >= map_width) {
-        tile_x = map_width - 1;
+    if (tile_x >= MAP_WIDTH) {
+        tile_x = MAP_WIDTH - 1;
         in_tile_x = 0;  // At map edge, use byte-aligned position
     }
     
@@ -131,7 +130,7 @@ static void draw_byte_column(unsigned char *buffer, const unsigned char *map_dat
     
     unsigned char row_index = head_row;
     unsigned char *row_ptr = buffer + ((unsigned int)row_index * DIRTY_VIEWPORT_WIDTH_BYTES) + buf_col;
-    const unsigned char *map_ptr = &map_data[tile_y * map_width + tile_x];
+    const unsigned char *map_ptr = &map_data[MAP_ROW_OFFSET(tile_y) + tile_x];
     
     int current_tile_y = tile_y;
     for (int py = 0; py < DIRTY_VIEWPORT_HEIGHT_PX; py++) {
@@ -140,7 +139,7 @@ static void draw_byte_column(unsigned char *buffer, const unsigned char *map_dat
             *row_ptr = tiles[tile_idx * 8 + in_tile_y];
         } else {
             unsigned char left_tile = *map_ptr;
-            unsigned char right_tile = (tile_x + 1 < map_width) ? map_ptr[1] : left_tile;
+            unsigned char right_tile = (tile_x + 1 < MAP_WIDTH) ? map_ptr[1] : left_tile;
             unsigned char left_byte = tiles[left_tile * 8 + in_tile_y];
             unsigned char right_byte = tiles[right_tile * 8 + in_tile_y];
             *row_ptr = (left_byte << in_tile_x) | (right_byte >> (8 - in_tile_x));
@@ -149,8 +148,8 @@ static void draw_byte_column(unsigned char *buffer, const unsigned char *map_dat
         if (++in_tile_y == 8) {
             in_tile_y = 0;
             current_tile_y++;
-            if (current_tile_y < 48) {
-                map_ptr += map_width;
+            if (current_tile_y < MAP_HEIGHT) {
+                map_ptr += MAP_STRIDE;
             }
         }
 
@@ -166,7 +165,7 @@ static void draw_byte_column(unsigned char *buffer, const unsigned char *map_dat
 // Draw bottom edge: bottom scanline (31 bytes: 30 visible + 1 lookahead)
 // Buffer stores byte-aligned tile data; the blitter handles fine_x sub-pixel shifting.
 static void draw_edge_bottom_c(unsigned char *buffer, const unsigned char *map_data,
-                               const unsigned char *tiles, int camera_x, int camera_y, int map_width,
+                               const unsigned char *tiles, int camera_x, int camera_y,
                                unsigned char head_row, unsigned char head_col, unsigned char fine_x) {
     // Bottom pixel Y = camera_y + (DIRTY_VIEWPORT_HEIGHT_PX - 1)
     int bottom_y = camera_y + (DIRTY_VIEWPORT_HEIGHT_PX - 1);
@@ -182,7 +181,7 @@ static void draw_edge_bottom_c(unsigned char *buffer, const unsigned char *map_d
     unsigned char bottom_row = head_row + (DIRTY_VIEWPORT_HEIGHT_PX - 1);
     if (bottom_row >= DIRTY_VIEWPORT_HEIGHT_PX) bottom_row -= DIRTY_VIEWPORT_HEIGHT_PX;
     unsigned char *row_ptr = buffer + ((unsigned int)bottom_row * DIRTY_VIEWPORT_WIDTH_BYTES);
-    const unsigned char *map_ptr = &map_data[tile_y * map_width + tile_x];
+    const unsigned char *map_ptr = &map_data[MAP_ROW_OFFSET(tile_y) + tile_x];
     
     // Draw 31 bytes (30 visible + 1 lookahead) with column wrapping via head_col
     for (unsigned char col = 0; col < DIRTY_VIEWPORT_WIDTH_BYTES; col++) {
@@ -190,8 +189,8 @@ static void draw_edge_bottom_c(unsigned char *buffer, const unsigned char *map_d
         if (buf_col >= DIRTY_VIEWPORT_WIDTH_BYTES) buf_col -= DIRTY_VIEWPORT_WIDTH_BYTES;
         
         int src_tile = tile_x + col;
-        if (src_tile >= map_width) src_tile = map_width - 1;
-        unsigned char tile_idx = map_data[tile_y * map_width + src_tile];
+        if (src_tile >= MAP_WIDTH) src_tile = MAP_WIDTH - 1;
+        unsigned char tile_idx = map_ptr[src_tile - tile_x];
         row_ptr[buf_col] = tiles[tile_idx * 8 + in_tile_y];
     }
 }
@@ -199,7 +198,7 @@ static void draw_edge_bottom_c(unsigned char *buffer, const unsigned char *map_d
 // Draw top edge: top scanline (31 bytes: 30 visible + 1 lookahead)
 // Buffer stores byte-aligned tile data; the blitter handles fine_x sub-pixel shifting.
 static void draw_edge_top_c(unsigned char *buffer, const unsigned char *map_data,
-                            const unsigned char *tiles, int camera_x, int camera_y, int map_width,
+                            const unsigned char *tiles, int camera_x, int camera_y,
                             unsigned char head_row, unsigned char head_col, unsigned char fine_x) {
     int tile_y = camera_y >> 3;
     if (tile_y < 0) tile_y = 0;
@@ -211,6 +210,7 @@ static void draw_edge_top_c(unsigned char *buffer, const unsigned char *map_data
     if (tile_x < 0) tile_x = 0;
     
     unsigned char *row_ptr = buffer + ((unsigned int)head_row * DIRTY_VIEWPORT_WIDTH_BYTES);
+    const unsigned char *map_ptr = &map_data[MAP_ROW_OFFSET(tile_y) + tile_x];
     
     // Draw 31 bytes (30 visible + 1 lookahead) with column wrapping via head_col
     for (unsigned char col = 0; col < DIRTY_VIEWPORT_WIDTH_BYTES; col++) {
@@ -218,15 +218,15 @@ static void draw_edge_top_c(unsigned char *buffer, const unsigned char *map_data
         if (buf_col >= DIRTY_VIEWPORT_WIDTH_BYTES) buf_col -= DIRTY_VIEWPORT_WIDTH_BYTES;
         
         int src_tile = tile_x + col;
-        if (src_tile >= map_width) src_tile = map_width - 1;
-        unsigned char tile_idx = map_data[tile_y * map_width + src_tile];
+        if (src_tile >= MAP_WIDTH) src_tile = MAP_WIDTH - 1;
+        unsigned char tile_idx = map_ptr[src_tile - tile_x];
         row_ptr[buf_col] = tiles[tile_idx * 8 + in_tile_y];
     }
 }
 
 static void scroll_x_plus_ring(unsigned char *buffer, unsigned char head_row, unsigned char *head_col,
                                unsigned char *fine_x, const unsigned char *map_data,
-                               const unsigned char *tiles, int camera_x, int camera_y, int map_width) {
+                               const unsigned char *tiles, int camera_x, int camera_y) {
     // Hybrid: increment fine_x. When it wraps past 7, advance head_col and draw new edge bytes.
     // No buffer changes needed per-pixel - the blitter handles fine_x shifting on output.
     unsigned char fx = *fine_x;
@@ -245,19 +245,19 @@ static void scroll_x_plus_ring(unsigned char *buffer, unsigned char head_row, un
         // Draw the new rightmost visible byte (column 29 from head_col)
         unsigned char col29 = h + (DIRTY_VIEWPORT_WIDTH - 1);
         if (col29 >= DIRTY_VIEWPORT_WIDTH_BYTES) col29 -= DIRTY_VIEWPORT_WIDTH_BYTES;
-        draw_byte_column(buffer, map_data, tiles, base_x + (DIRTY_VIEWPORT_WIDTH - 1)*8, camera_y, map_width, head_row, col29);
+        draw_byte_column(buffer, map_data, tiles, base_x + (DIRTY_VIEWPORT_WIDTH - 1)*8, camera_y, head_row, col29);
 
         // Draw the lookahead byte (column 30 from head_col) for fine_x blending
         unsigned char col30 = h + DIRTY_VIEWPORT_WIDTH;
         if (col30 >= DIRTY_VIEWPORT_WIDTH_BYTES) col30 -= DIRTY_VIEWPORT_WIDTH_BYTES;
-        draw_byte_column(buffer, map_data, tiles, base_x + DIRTY_VIEWPORT_WIDTH*8, camera_y, map_width, head_row, col30);
+        draw_byte_column(buffer, map_data, tiles, base_x + DIRTY_VIEWPORT_WIDTH*8, camera_y, head_row, col30);
     }
     *fine_x = fx;
 }
 
 static void scroll_x_minus_ring(unsigned char *buffer, unsigned char head_row, unsigned char *head_col,
                                 unsigned char *fine_x, const unsigned char *map_data,
-                                const unsigned char *tiles, int camera_x, int camera_y, int map_width) {
+                                const unsigned char *tiles, int camera_x, int camera_y) {
     // Hybrid: decrement fine_x. When it wraps below 0, retreat head_col and draw new edge byte.
     unsigned char fx = *fine_x;
     if (fx == 0) {
@@ -276,7 +276,7 @@ static void scroll_x_minus_ring(unsigned char *buffer, unsigned char head_row, u
         int base_x = camera_x & ~7;
 
         // Draw the new leftmost visible byte (column head_col)
-        draw_byte_column(buffer, map_data, tiles, base_x, camera_y, map_width, head_row, h);
+        draw_byte_column(buffer, map_data, tiles, base_x, camera_y, head_row, h);
     } else {
         fx--;
     }
@@ -285,20 +285,20 @@ static void scroll_x_minus_ring(unsigned char *buffer, unsigned char head_row, u
 
 static void scroll_y_plus_ring(unsigned char *buffer, unsigned char *head_row, unsigned char head_col,
                                unsigned char fine_x, const unsigned char *map_data,
-                               const unsigned char *tiles, int camera_x, int camera_y, int map_width) {
+                               const unsigned char *tiles, int camera_x, int camera_y) {
     unsigned char h = *head_row;
     h++;
     if (h == DIRTY_VIEWPORT_HEIGHT_PX) h = 0;
     *head_row = h;
-    draw_edge_bottom_c(buffer, map_data, tiles, camera_x, camera_y, map_width, h, head_col, fine_x);
+    draw_edge_bottom_c(buffer, map_data, tiles, camera_x, camera_y, h, head_col, fine_x);
 }
 
 static void scroll_y_minus_ring(unsigned char *buffer, unsigned char *head_row, unsigned char head_col,
                                 unsigned char fine_x, const unsigned char *map_data,
-                                const unsigned char *tiles, int camera_x, int camera_y, int map_width) {
+                                const unsigned char *tiles, int camera_x, int camera_y) {
     unsigned char h = *head_row;
     if (h == 0) h = DIRTY_VIEWPORT_HEIGHT_PX;
     h--;
     *head_row = h;
-    draw_edge_top_c(buffer, map_data, tiles, camera_x, camera_y, map_width, h, head_col, fine_x);
+    draw_edge_top_c(buffer, map_data, tiles, camera_x, camera_y, h, head_col, fine_x);
 }
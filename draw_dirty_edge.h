@@ -3,7 +3,7 @@
 
 // Dirty-edge scrolling system for 30x8 character viewport (240x64 pixels)
 // Uses hybrid 2D ring-buffer: vertical (head_row) + horizontal (head_col + fine_x)
-// Centered on ZX Spectrum screen at row 8 (Y=64 to Y=127)
+// On the ZX Spectrum screen from char row DIRTY_START_CHAR_ROW (4, Y=32)
 
 // Direction flags for scroll operations
 #define SCROLL_NONE     0x00
@@ -18,11 +18,8 @@
 #define SCROLL_X_PLUS_Y_MINUS   (SCROLL_X_PLUS | SCROLL_Y_MINUS)   // Right-Up
 #define SCROLL_X_MINUS_Y_PLUS   (SCROLL_X_MINUS | SCROLL_Y_PLUS)   // Left-Down
 
-// Master viewport parameters - change these to resize the viewport
-#define VIEWPORT_COLS           20   // visible columns (must be <= 32)
-#define VIEWPORT_CHAR_ROWS      16   // visible character rows (height in 8-pixel rows)
-#define VIEWPORT_START_CHAR_ROW 8    // screen char row where viewport starts
-#define VIEWPORT_COL_OFFSET     6    // screen byte offset from left edge
+// Master viewport parameters - set in config/*.mk to resize the viewport
+#include "viewport.h"   // VIEWPORT_* from config/*.mk (generate_viewport)
 
 // Derived viewport dimensions (do not change these directly)
 #define DIRTY_VIEWPORT_WIDTH    VIEWPORT_COLS
@@ -35,6 +32,8 @@
 // Returns 1 if scroll was applied, 0 if blocked (e.g., at map edge)
 // stride_x: horizontal scroll speed (pixels per frame)
 // stride_y: vertical scroll speed (pixels per frame)
+// map_data is laid out as tile_render.c reads it: MAP_WIDTH x MAP_HEIGHT
+// tiles, rows MAP_STRIDE bytes apart (viewport.h), addressed by shift
 unsigned char dirty_edge_scroll(
     unsigned char direction,
     const unsigned char *map_data,
@@ -45,8 +44,6 @@ unsigned char dirty_edge_scroll(
     unsigned char *fine_x,
     int *camera_x,
     int *camera_y,
-    int map_width,
-    int map_height,
     unsigned char stride_x,
     unsigned char stride_y
 );
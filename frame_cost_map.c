@@ -0,0 +1,770 @@
+// Frame cost heat map: predict the T-state cost of every scroll step the
+// game can take on a map, so expensive spots can be fixed in the level data.
+//
+// Usage: ./frame_cost_map [options] map.bin width height
+//   --model <file>     cost model: "<name> <value> [...]" lines. Routine lines
+//                      from "asm_timing --model" give best/worst T-states of the
+//                      asm renderers; the C-side constants below can be
+//                      overridden by name. Defaults match the shipped build.
+//   --tiles <file>     tiles_data.bin: warn about non-zero tiles with blank
+//                      graphics (they pay full price; tile 0 takes the shortcut)
+//   --ppm <file>       write a colour heat map, one cell per man map position
+//   --scale <n>        pixels per map cell in the heat map (default 4)
+//   --budget <T>       step budget (default SCROLL_INTERVAL frames)
+//   --top <n>          number of worst steps to list (default 10)
+//   --start <x> <y>    starting camera position (default 10 10)
+//   --stride <n>       bytes per row in map.bin (generate_map --stride;
+//                      default width)
+//   --metatile <m>     map.bin holds 2x2 or 4x4 metatiles (generate_map
+//                      --metatile): width, height and stride count metatiles
+//                      and --tiles is required for the dictionary at 0x6300
+//   --flip             TILE_FLIP build (generate_tiles --fold-mirrors): map
+//                      bytes carry flip bits, and the model's worst edge
+//                      costs are the every-tile-flipped ones
+//   --edge-cache       EDGE_CACHE build: straight steps blit the edges the
+//                      idle frames pre-rendered (see below)
+//
+// The simulation mirrors tile_render.c: update_camera() with man_can_move()
+// collision per axis, shifts, redraw_sprite_tiles() + draw_man(), then the
+// dirty row/column: zero fill when the on-map part of the span is blank
+// (occupancy bitmaps), else the asm renderers when in bounds or the C fallback
+// (safe_render_row / safe_render_column) near map edges. Only camera positions
+// reachable from the start are evaluated, each in 8 directions walking and
+// dashing (DASH_STEP tiles, stopped early by walls as in update_camera()).
+// A dash uses the _n shifts and draw_rows()/draw_columns(): one n-wide
+// render when the whole strip is on the map, not blank and not cached,
+// else edge by edge. With the AY player in the model (SOUND builds), every
+// frame a step spans also pays one player tick.
+//
+// With --edge-cache, the idle frames before a step are assumed to have
+// pre-rendered the four edges of its start position (held input leaves
+// SCROLL_INTERVAL - 1 idle frames; edge_service() needs at most ~27kT). An
+// edge hits when it was cacheable there (on the map, not blank) and the
+// step did not move along it: the first row/column of a straight step. A
+// straight step also pays edge_save(). Hits that only edge_save() provides
+// (reversing at the map border) depend on the path and are not counted,
+// nor are strips dropped by an animation step.
+// With --flip, each flipped tile on an edge pays its decode: per tile in the
+// row renderer (model worst - best over the row), and a fixed cost in the
+// column renderer and the C fallback.
+//
+// Costs are uncontended T-states. The asm defaults are asm_timing figures of
+// this tree. The C-side defaults were fitted against replay_trace
+// --no-contention on the baseline build (RMS error ~210T), before the
+// occupancy, edge cache and dash code went into draw_row()/draw_column();
+// refit them on a current build by overriding them in the model file.
+// replay_trace remains the reference for contended timing.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tile_render.h"
+
+// Mirrors tile_render.c
+#define MAN_VIEWPORT_COL (VIEWPORT_COLS / 2 - 1)
+#define MAN_VIEWPORT_ROW (VIEWPORT_CHAR_ROWS / 2 - 1)
+#define SCROLL_INTERVAL  3
+#define DASH_STEP        2
+#define INPUT_DASH       0x10
+#define SOLID_TILE       1
+#define START_CAMERA_X   10
+#define START_CAMERA_Y   10
+
+#define FRAME_TSTATES    69888
+#define TILE_BYTES       8
+#define MAX_TILES        256
+
+typedef struct {
+    // asm renderers (asm_timing --model: best, worst)
+    long shift_h;               // _shift_viewport_left / _right
+    long shift_up;              // _shift_viewport_up
+    long shift_down;            // _shift_viewport_down
+    long column_best;           // _render_dirty_column, all tiles blank
+    long column_worst;          // _render_dirty_column, no tiles blank
+    long row_best;              // _render_dirty_row, no tiles flipped
+    long row;                   // _render_dirty_row (no blank shortcut; every
+                                // tile flipped under --flip)
+    long clear_column;          // _clear_dirty_column
+    long clear_row;             // _clear_dirty_row
+
+    // Dash steps: the _n shifts cost most at n = 1 (asm_timing), then less
+    // per extra tile; the n-wide edges are costed per tile from their loops
+    long shift_h_n;             // _shift_viewport_left_n / _right_n, n = 1
+    long shift_up_n;            // _shift_viewport_up_n, n = 1
+    long shift_down_n;          // _shift_viewport_down_n, n = 1
+    long shift_h_step;          // saved per extra column (128 scanlines x 16T)
+    long shift_up_step;         // saved per extra char row
+    long shift_down_step;
+    long wide_tile;             // _render_dirty_columns / _rows per non-blank tile
+    long wide_tile_blank;       // per blank tile
+    long wide_line;             // per char row (columns) or row (rows)
+    long wide_column_setup;
+    long wide_row_setup;
+    long wide_flip;             // per flipped tile (_tile_flip_tile), --flip only
+
+    // Edge cache (only with --edge-cache)
+    long blit_column;           // _blit_edge_column
+    long blit_row;              // _blit_edge_row
+    long save_column;           // _save_edge_column (edge_save, straight steps)
+    long save_row;              // _save_edge_row
+
+    // C side (fitted against replay_trace on the baseline build)
+    long step_base;             // read_input + update_camera + draw_man + fixed overhead
+    long c_tile;                // render_tile_at(safe_tile()) for tile 0
+    long c_tile_solid;          // extra for a non-zero tile
+    long c_tile_oob;            // render_tile_at(safe_tile()) off the map
+    long draw_column_asm;       // draw_column() wrapper around render_dirty_column
+    long draw_row_asm;          // draw_row() wrapper around render_dirty_row
+    long safe_render_column;    // fallback loop overhead (on top of per-tile costs)
+    long safe_render_row;
+    long occ_check;             // span clamp + occ_span_blank() (estimated, not fitted)
+
+    // TILE_FLIP decode of a flipped tile (only with --flip)
+    long flip_column;           // _render_dirty_column: _tile_flip_tile + stack swap
+    long c_tile_flip;           // render_tile_at() flip loop (estimated, not fitted)
+
+    // TILE_ATTRS edge colours (only in the model when built with them)
+    long attr_column;           // _attr_dirty_column
+    long attr_row;              // _attr_dirty_row
+
+    // METATILE edge expansion into the strips (only with --metatile)
+    long meta_column;           // _meta_expand_column
+    long meta_row;              // _meta_expand_row
+
+    // SOUND: one player tick per frame (only in the model when built with it)
+    long snd_frame;             // _snd_frame (fixed cost)
+    long snd_isr;               // _snd_isr best case: entry, LUT check, exit
+} cost_model;
+
+static const cost_model default_model = {
+    .shift_h = 48846, .shift_up = 67681, .shift_down = 71001,
+    .column_best = 5278, .column_worst = 6408, .row_best = 10768, .row = 10768,
+    .clear_column = 2431, .clear_row = 2059,
+    .shift_h_n = 50639, .shift_up_n = 67773, .shift_down_n = 71155,
+    .shift_h_step = 2048, .shift_up_step = 4500, .shift_down_step = 4700,
+    .wide_tile = 261, .wide_tile_blank = 159, .wide_line = 150,
+    .wide_column_setup = 80, .wide_row_setup = 250, .wide_flip = 1792,
+    .blit_column = 3610, .blit_row = 2900, .save_column = 3867, .save_row = 2896,
+    .step_base = 18554, .c_tile = 3157, .c_tile_solid = 809, .c_tile_oob = 2930,
+    .draw_column_asm = 1311, .draw_row_asm = 1466,
+    .safe_render_column = -1368, .safe_render_row = -1388, .occ_check = 600,
+    .flip_column = 1821, .c_tile_flip = 480,
+};
+
+// asm_timing -DTILE_FLIP=1 worst cases (every tile flipped), used with
+// --flip when no model file is given
+#define FLIP_ROW_BEST     13488
+#define FLIP_ROW_WORST    38928
+#define FLIP_COLUMN_WORST 35848
+
+typedef struct {
+    int cx, cy;                 // camera before the step
+    int input;                  // 0x08 up, 0x04 down, 0x02 left, 0x01 right
+    int dx, dy;                 // actual movement after collision
+    long cost;
+    long shifts;
+    long edges;
+    long sound;
+    int row_fallback;
+    int column_fallback;
+    int row_blank;
+    int column_blank;
+    int flipped;                // flipped tiles drawn by the edges (--flip)
+    int cached;                 // edges blitted from the cache (--edge-cache)
+    int wide;                   // edges drawn by one n-wide render
+} step;
+
+static unsigned char *map;
+static int map_w, map_h;
+static int flip, edge_cache, meta;
+
+// Map byte of a flipped tile (flip bits above the tile index)
+static int is_flipped(int t) {
+    return flip && (t & (TILE_FLIP_H | TILE_FLIP_V));
+}
+
+static int tile_at(int x, int y, int *in_map) {
+    if (x < 0 || y < 0 || x >= map_w || y >= map_h) {
+        *in_map = 0;
+        return 0;
+    }
+    *in_map = 1;
+    return map[y * map_w + x];
+}
+
+static int man_can_move(int cam_x, int cam_y) {
+    int mx = cam_x + MAN_VIEWPORT_COL;
+    int my = cam_y + MAN_VIEWPORT_ROW;
+    int off;
+
+    if (mx < 0 || mx + 1 >= map_w || my < 0 || my + 1 >= map_h)
+        return 1;
+    off = my * map_w + mx;
+    return map[off] != SOLID_TILE && map[off + 1] != SOLID_TILE
+        && map[off + map_w] != SOLID_TILE && map[off + map_w + 1] != SOLID_TILE;
+}
+
+// Mirrors occ_span_blank() over the on-map part of a row or column span
+static int span_blank(int x, int y, int dx, int dy, int count) {
+    for (int i = 0; i < count; i++, x += dx, y += dy)
+        if (x >= 0 && y >= 0 && x < map_w && y < map_h && map[y * map_w + x]) return 0;
+    return 1;
+}
+
+static long c_tile_cost(const cost_model *m, int x, int y) {
+    int in_map;
+    int t = tile_at(x, y, &in_map);
+    if (!in_map) return m->c_tile_oob;
+    return m->c_tile + (t ? m->c_tile_solid : 0) + (is_flipped(t) ? m->c_tile_flip : 0);
+}
+
+// 1 if edge_service() at camera (cx, cy) cached the edge whose first tile
+// is map (x, y): one beyond the viewport, on the map and not blank
+static int edge_cached(int cx, int cy, int x, int y, int horizontal) {
+    if (!edge_cache) return 0;
+    if (horizontal) {
+        if (x != cx || (y != cy - 1 && y != cy + VIEWPORT_CHAR_ROWS)) return 0;
+        return y >= 0 && y < map_h && x >= 0 && x + VIEWPORT_COLS <= map_w
+            && !span_blank(x, y, 1, 0, VIEWPORT_COLS);
+    }
+    if (y != cy || (x != cx - 1 && x != cx + VIEWPORT_COLS)) return 0;
+    return x >= 0 && x < map_w && y >= 0 && y + VIEWPORT_CHAR_ROWS <= map_h
+        && !span_blank(x, y, 0, 1, VIEWPORT_CHAR_ROWS);
+}
+
+// draw_row() of map row map_y at camera x nx
+static long row_cost(const cost_model *m, step *s, int nx, int map_y) {
+    long t = m->occ_check;
+    if (span_blank(nx, map_y, 1, 0, VIEWPORT_COLS)) {
+        s->row_blank = 1;
+        t += m->draw_row_asm + m->clear_row;
+    } else if (edge_cached(s->cx, s->cy, nx, map_y, 1)) {
+        s->cached++;
+        t += m->draw_row_asm + m->blit_row;
+    } else if (map_y >= 0 && map_y < map_h && nx >= 0 && nx + VIEWPORT_COLS <= map_w) {
+        int flipped = 0;
+        for (int c = 0; c < VIEWPORT_COLS; c++)
+            if (is_flipped(map[map_y * map_w + nx + c])) flipped++;
+        s->flipped += flipped;
+        t += m->meta_row + m->draw_row_asm + m->row_best
+            + (m->row - m->row_best) * flipped / VIEWPORT_COLS;
+    } else {
+        s->row_fallback = 1;
+        t += m->safe_render_row;
+        for (int c = 0; c < VIEWPORT_COLS; c++) t += c_tile_cost(m, nx + c, map_y);
+    }
+    return t + m->attr_row;
+}
+
+// draw_column() of map column map_x at camera y ny: blank tiles take the
+// _rdc_blank_tile shortcut
+static long column_cost(const cost_model *m, step *s, int map_x, int ny) {
+    long t = m->occ_check;
+    if (span_blank(map_x, ny, 0, 1, VIEWPORT_CHAR_ROWS)) {
+        s->column_blank = 1;
+        t += m->draw_column_asm + m->clear_column;
+    } else if (edge_cached(s->cx, s->cy, map_x, ny, 0)) {
+        s->cached++;
+        t += m->draw_column_asm + m->blit_column;
+    } else if (map_x >= 0 && map_x < map_w && ny >= 0 && ny + VIEWPORT_CHAR_ROWS <= map_h) {
+        int solid = 0, flipped = 0;
+        long worst = m->column_worst;
+        for (int r = 0; r < VIEWPORT_CHAR_ROWS; r++) {
+            int tile = map[(ny + r) * map_w + map_x];
+            if (tile) solid++;
+            if (is_flipped(tile)) flipped++;
+        }
+        // Under --flip the model's worst has every tile flipped
+        if (flip) worst -= VIEWPORT_CHAR_ROWS * m->flip_column;
+        s->flipped += flipped;
+        t += m->meta_column + m->draw_column_asm + m->column_best
+            + (worst - m->column_best) * solid / VIEWPORT_CHAR_ROWS
+            + flipped * m->flip_column;
+    } else {
+        s->column_fallback = 1;
+        t += m->safe_render_column;
+        for (int r = 0; r < VIEWPORT_CHAR_ROWS; r++) t += c_tile_cost(m, map_x, ny + r);
+    }
+    return t + m->attr_column;
+}
+
+// One tile of an n-wide render
+static long wide_tile_cost(const cost_model *m, step *s, int x, int y) {
+    int tile = map[y * map_w + x];
+    if (!tile) return m->wide_tile_blank;
+    if (is_flipped(tile)) {
+        s->flipped++;
+        return m->wide_tile + m->wide_flip;
+    }
+    return m->wide_tile;
+}
+
+// draw_rows(): n rows from map row map_y
+static long rows_cost(const cost_model *m, step *s, int nx, int map_y, int n) {
+    long t = 0;
+    int i;
+    if (n > 1 && !meta && map_y >= 0 && map_y + n <= map_h && nx >= 0 && nx + VIEWPORT_COLS <= map_w) {
+        for (i = 0; i < n; i++) {
+            t += m->occ_check;
+            if (span_blank(nx, map_y + i, 1, 0, VIEWPORT_COLS) || edge_cached(s->cx, s->cy, nx, map_y + i, 1))
+                break;
+        }
+        if (i == n) {
+            s->wide++;
+            t += m->draw_row_asm + m->wide_row_setup;
+            for (i = 0; i < n; i++) {
+                t += m->wide_line + m->attr_row;
+                for (int c = 0; c < VIEWPORT_COLS; c++) t += wide_tile_cost(m, s, nx + c, map_y + i);
+            }
+            return t;
+        }
+    }
+    for (i = 0; i < n; i++) t += row_cost(m, s, nx, map_y + i);
+    return t;
+}
+
+// draw_columns(): n columns from map column map_x
+static long columns_cost(const cost_model *m, step *s, int map_x, int ny, int n) {
+    long t = 0;
+    int i;
+    if (n > 1 && !meta && map_x >= 0 && map_x + n <= map_w && ny >= 0 && ny + VIEWPORT_CHAR_ROWS <= map_h) {
+        for (i = 0; i < n; i++) {
+            t += m->occ_check;
+            if (span_blank(map_x + i, ny, 0, 1, VIEWPORT_CHAR_ROWS) || edge_cached(s->cx, s->cy, map_x + i, ny, 0))
+                break;
+        }
+        if (i == n) {
+            s->wide++;
+            t += m->draw_column_asm + m->wide_column_setup + (long)n * m->attr_column;
+            for (int r = 0; r < VIEWPORT_CHAR_ROWS; r++) {
+                t += m->wide_line;
+                for (i = 0; i < n; i++) t += wide_tile_cost(m, s, map_x + i, ny + r);
+            }
+            return t;
+        }
+    }
+    for (i = 0; i < n; i++) t += column_cost(m, s, map_x + i, ny);
+    return t;
+}
+
+static void simulate(const cost_model *m, int cx, int cy, int input, step *s) {
+    int nx = cx, ny = cy;
+    int c0 = MAN_VIEWPORT_COL, c1 = MAN_VIEWPORT_COL + 2;
+    int r0 = MAN_VIEWPORT_ROW, r1 = MAN_VIEWPORT_ROW + 2;
+    int adx, ady;
+
+    memset(s, 0, sizeof(*s));
+    s->cx = cx;
+    s->cy = cy;
+    s->input = input;
+
+    // update_camera(): a tile at a time, horizontal then vertical, each
+    // checked separately; a dash stops when neither axis moves
+    for (int n = (input & INPUT_DASH) ? DASH_STEP : 1; n; n--) {
+        int x = nx, y = ny;
+        if (input & 0x01) x++;
+        if (input & 0x02) x--;
+        if (!man_can_move(x, y)) x = nx;
+        if (input & 0x04) y++;
+        if (input & 0x08) y--;
+        if (!man_can_move(x, y)) y = ny;
+        if (x == nx && y == ny) break;
+        nx = x;
+        ny = y;
+    }
+    s->dx = nx - cx;
+    s->dy = ny - cy;
+    if (!s->dx && !s->dy) return;
+    adx = s->dx < 0 ? -s->dx : s->dx;
+    ady = s->dy < 0 ? -s->dy : s->dy;
+
+    s->cost = m->step_base;
+
+    // edge_save(): straight steps keep the edge that scrolls out
+    if (edge_cache && !(s->dx && s->dy))
+        s->edges += s->dx ? m->save_column : m->save_row;
+
+    if (adx == 1) s->shifts += m->shift_h;
+    else if (adx) s->shifts += m->shift_h_n - (adx - 1) * m->shift_h_step;
+    if (ady == 1) s->shifts += s->dy > 0 ? m->shift_up : m->shift_down;
+    else if (s->dy > 0) s->shifts += m->shift_up_n - (ady - 1) * m->shift_up_step;
+    else if (s->dy < 0) s->shifts += m->shift_down_n - (ady - 1) * m->shift_down_step;
+
+    // redraw_sprite_tiles(): 2x2 under the man plus the ghost side
+    if (s->dx > 0) c0 -= s->dx;
+    else if (s->dx < 0) c1 -= s->dx;
+    if (s->dy > 0) r0 -= s->dy;
+    else if (s->dy < 0) r1 -= s->dy;
+    for (int r = r0; r < r1; r++)
+        for (int c = c0; c < c1; c++)
+            s->cost += c_tile_cost(m, nx + c, ny + r);
+
+    // draw_rows(), then draw_columns()
+    if (s->dy > 0) s->edges += rows_cost(m, s, nx, ny + VIEWPORT_CHAR_ROWS - ady, ady);
+    else if (s->dy < 0) s->edges += rows_cost(m, s, nx, ny, ady);
+    if (s->dx > 0) s->edges += columns_cost(m, s, nx + VIEWPORT_COLS - adx, ny, adx);
+    else if (s->dx < 0) s->edges += columns_cost(m, s, nx, ny, adx);
+    s->cost += s->shifts + s->edges;
+
+    // AY ticks: one per frame until the step (ticks included) is done
+    if (m->snd_frame) {
+        long tick = m->snd_frame + m->snd_isr;
+        long frames = 1;
+        while (s->cost + frames * tick > frames * FRAME_TSTATES) frames++;
+        s->sound = frames * tick;
+        s->cost += s->sound;
+    }
+}
+
+static int load_model(const char *path, cost_model *m) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    if (!f) return 0;
+    while (fgets(line, sizeof(line), f)) {
+        char name[64];
+        long a, b;
+        int n = sscanf(line, "%63s %ld %ld", name, &a, &b);
+        if (n < 2 || name[0] == '#') continue;
+        if (n < 3) b = a;
+        if (!strcmp(name, "_shift_viewport_left")) m->shift_h = b;
+        else if (!strcmp(name, "_shift_viewport_right")) { if (b > m->shift_h) m->shift_h = b; }
+        else if (!strcmp(name, "_shift_viewport_up")) m->shift_up = b;
+        else if (!strcmp(name, "_shift_viewport_down")) m->shift_down = b;
+        else if (!strcmp(name, "_render_dirty_column")) { m->column_best = a; m->column_worst = b; }
+        else if (!strcmp(name, "_render_dirty_row")) { m->row_best = a; m->row = b; }
+        else if (!strcmp(name, "_clear_dirty_column")) m->clear_column = b;
+        else if (!strcmp(name, "_clear_dirty_row")) m->clear_row = b;
+        else if (!strcmp(name, "_attr_dirty_column")) m->attr_column = b;
+        else if (!strcmp(name, "_attr_dirty_row")) m->attr_row = b;
+        else if (!strcmp(name, "_meta_expand_column")) m->meta_column = b;
+        else if (!strcmp(name, "_meta_expand_row")) m->meta_row = b;
+        else if (!strcmp(name, "_shift_viewport_left_n")) m->shift_h_n = b;
+        else if (!strcmp(name, "_shift_viewport_right_n")) { if (b > m->shift_h_n) m->shift_h_n = b; }
+        else if (!strcmp(name, "_shift_viewport_up_n")) m->shift_up_n = b;
+        else if (!strcmp(name, "_shift_viewport_down_n")) m->shift_down_n = b;
+        else if (!strcmp(name, "_blit_edge_column")) m->blit_column = b;
+        else if (!strcmp(name, "_blit_edge_row")) m->blit_row = b;
+        else if (!strcmp(name, "_save_edge_column")) m->save_column = b;
+        else if (!strcmp(name, "_save_edge_row")) m->save_row = b;
+        else if (!strcmp(name, "_snd_frame")) m->snd_frame = b;
+        else if (!strcmp(name, "_snd_isr")) m->snd_isr = a;
+        else if (!strcmp(name, "step_base")) m->step_base = a;
+        else if (!strcmp(name, "c_tile")) m->c_tile = a;
+        else if (!strcmp(name, "c_tile_solid")) m->c_tile_solid = a;
+        else if (!strcmp(name, "c_tile_oob")) m->c_tile_oob = a;
+        else if (!strcmp(name, "draw_column_asm")) m->draw_column_asm = a;
+        else if (!strcmp(name, "draw_row_asm")) m->draw_row_asm = a;
+        else if (!strcmp(name, "safe_render_column")) m->safe_render_column = a;
+        else if (!strcmp(name, "safe_render_row")) m->safe_render_row = a;
+        else if (!strcmp(name, "occ_check")) m->occ_check = a;
+        else if (!strcmp(name, "flip_column")) m->flip_column = a;
+        else if (!strcmp(name, "c_tile_flip")) m->c_tile_flip = a;
+        else if (!strcmp(name, "shift_h_step")) m->shift_h_step = a;
+        else if (!strcmp(name, "shift_up_step")) m->shift_up_step = a;
+        else if (!strcmp(name, "shift_down_step")) m->shift_down_step = a;
+        else if (!strcmp(name, "wide_tile")) m->wide_tile = a;
+        else if (!strcmp(name, "wide_tile_blank")) m->wide_tile_blank = a;
+        else if (!strcmp(name, "wide_line")) m->wide_line = a;
+        else if (!strcmp(name, "wide_column_setup")) m->wide_column_setup = a;
+        else if (!strcmp(name, "wide_row_setup")) m->wide_row_setup = a;
+        else if (!strcmp(name, "wide_flip")) m->wide_flip = a;
+    }
+    fclose(f);
+    return 1;
+}
+
+static void check_tiles(const char *path) {
+    FILE *f = fopen(path, "rb");
+    unsigned char data[MAX_TILES * TILE_BYTES];
+    long uses[MAX_TILES] = { 0 };
+    size_t n;
+
+    if (!f) {
+        printf("Warning: cannot open %s\n", path);
+        return;
+    }
+    n = fread(data, 1, sizeof(data), f) / TILE_BYTES;
+    fclose(f);
+    for (int i = 0; i < map_w * map_h; i++) uses[flip ? map[i] & TILE_INDEX_MASK : map[i]]++;
+    for (size_t t = 1; t < n; t++) {
+        int blank = 1;
+        for (int b = 0; b < TILE_BYTES; b++) if (data[t * TILE_BYTES + b]) blank = 0;
+        if (blank && uses[t])
+            printf("Tile %zu has blank graphics but is not tile 0: %ld map cells pay full draw cost\n", t, uses[t]);
+    }
+}
+
+static void dir_name(int input, char *out) {
+    int n = 0;
+    if (input & 0x08) out[n++] = 'U';
+    if (input & 0x04) out[n++] = 'D';
+    if (input & 0x02) out[n++] = 'L';
+    if (input & 0x01) out[n++] = 'R';
+    if (input & INPUT_DASH) out[n++] = '+';
+    out[n] = 0;
+}
+
+static int cmp_step(const void *a, const void *b) {
+    long ca = ((const step *)a)->cost, cb = ((const step *)b)->cost;
+    return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+// Heat colour: green (cheap) -> yellow -> red at budget, magenta over budget
+static void heat_rgb(long cost, long lo, long budget, unsigned char rgb[3]) {
+    long span = budget - lo;
+    int v;
+    if (cost > budget) {
+        rgb[0] = 255; rgb[1] = 0; rgb[2] = 255;
+        return;
+    }
+    v = span > 0 ? (int)((cost - lo) * 510 / span) : 0;
+    if (v < 0) v = 0;
+    if (v > 510) v = 510;
+    rgb[0] = (unsigned char)(v < 255 ? v : 255);
+    rgb[1] = (unsigned char)(v < 255 ? 255 : 510 - v);
+    rgb[2] = 0;
+}
+
+int main(int argc, char *argv[]) {
+    static const int inputs[8] = { 0x08, 0x04, 0x02, 0x01, 0x09, 0x0A, 0x05, 0x06 };
+    cost_model model = default_model;
+    const char *tiles_path = NULL, *ppm_path = NULL;
+    long budget = SCROLL_INTERVAL * (long)FRAME_TSTATES;
+    int scale = 4, top = 10;
+    int start_x = START_CAMERA_X, start_y = START_CAMERA_Y;
+    int stride = 0, have_model = 0;
+    const char *pos[3];
+    int npos = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--model") && i + 1 < argc) {
+            if (!load_model(argv[++i], &model)) {
+                printf("Error: Cannot open %s\n", argv[i]);
+                return 1;
+            }
+            have_model = 1;
+        } else if (!strcmp(argv[i], "--tiles") && i + 1 < argc) tiles_path = argv[++i];
+        else if (!strcmp(argv[i], "--ppm") && i + 1 < argc) ppm_path = argv[++i];
+        else if (!strcmp(argv[i], "--scale") && i + 1 < argc) scale = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc) budget = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--top") && i + 1 < argc) top = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--start") && i + 2 < argc) {
+            start_x = atoi(argv[++i]);
+            start_y = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--stride") && i + 1 < argc) stride = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--metatile") && i + 1 < argc) meta = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--flip")) flip = 1;
+        else if (!strcmp(argv[i], "--edge-cache")) edge_cache = 1;
+        else if (argv[i][0] != '-' && npos < 3) pos[npos++] = argv[i];
+        else {
+            printf("Error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (npos != 3) {
+        printf("Usage: %s [--model f] [--tiles f] [--ppm f] [--scale n] [--budget T] [--top n] [--start x y] [--stride n] [--metatile m] [--flip] [--edge-cache] map.bin width height\n", argv[0]);
+        return 1;
+    }
+    map_w = atoi(pos[1]);
+    map_h = atoi(pos[2]);
+    if (map_w <= 0 || map_h <= 0 || scale <= 0) {
+        printf("Error: invalid width/height/scale (must be > 0)\n");
+        return 1;
+    }
+    if (stride == 0) stride = map_w;
+    if (stride < map_w) {
+        printf("Error: stride %d is narrower than the map (%d)\n", stride, map_w);
+        return 1;
+    }
+    if (meta && meta != 2 && meta != 4) {
+        printf("Error: metatile size must be 2 or 4\n");
+        return 1;
+    }
+    if (meta && !tiles_path) {
+        printf("Error: --metatile needs --tiles for the dictionary\n");
+        return 1;
+    }
+    if (flip && !have_model) {
+        model.row_best = FLIP_ROW_BEST;
+        model.row = FLIP_ROW_WORST;
+        model.column_worst = FLIP_COLUMN_WORST;
+    }
+    // Measured expander costs (asm_timing), unless the model has them
+    if (meta && !model.meta_column) model.meta_column = meta == 2 ? 805 : 858;
+    if (meta && !model.meta_row) model.meta_row = meta == 2 ? 764 : 651;
+
+    map = (unsigned char *)calloc((size_t)map_w * map_h, 1);
+    {
+        FILE *f = fopen(pos[0], "rb");
+        if (!f) {
+            printf("Error: Cannot open %s\n", pos[0]);
+            return 1;
+        }
+        // Repack padded rows so the simulation indexes by width
+        int short_read = 0;
+        for (int y = 0; y < map_h && !short_read; y++) {
+            if (fread(map + (size_t)y * map_w, 1, (size_t)map_w, f) != (size_t)map_w
+                || (y + 1 < map_h && fseek(f, stride - map_w, SEEK_CUR) != 0))
+                short_read = 1;
+        }
+        if (short_read)
+            printf("Warning: %s is shorter than %dx%d, padding with tile 0\n", pos[0], map_w, map_h);
+        fclose(f);
+    }
+    if (meta) {
+        // Expand metatiles through the dictionary; the simulation works in cells
+        unsigned char dict[256] = { 0 };
+        unsigned char *cells = (unsigned char *)malloc((size_t)map_w * map_h * meta * meta);
+        FILE *f = fopen(tiles_path, "rb");
+        if (!f || fseek(f, META_DICT_OFFSET, SEEK_SET) != 0 || fread(dict, 1, sizeof(dict), f) != sizeof(dict)) {
+            printf("Error: Cannot read the metatile dictionary from %s\n", tiles_path);
+            return 1;
+        }
+        fclose(f);
+        for (int y = 0; y < map_h * meta; y++)
+            for (int x = 0; x < map_w * meta; x++)
+                cells[(size_t)y * map_w * meta + x] = dict[(unsigned char)(map[(y / meta) * map_w + x / meta]
+                                                          + (y % meta) * meta + x % meta)];
+        free(map);
+        map = cells;
+        map_w *= meta;
+        map_h *= meta;
+    }
+    if (tiles_path) check_tiles(tiles_path);
+
+    // Camera positions keep the man on the map: camera = man - (9,7)
+    int cam_x0 = -MAN_VIEWPORT_COL, cam_y0 = -MAN_VIEWPORT_ROW;
+    int cam_w = map_w - 1, cam_h = map_h - 1;
+    int ncells = cam_w * cam_h;
+    unsigned char *seen = (unsigned char *)calloc((size_t)ncells, 1);
+    long *heat = (long *)calloc((size_t)ncells, sizeof(long));
+    int *queue = (int *)malloc((size_t)ncells * sizeof(int));
+    step *steps = (step *)malloc((size_t)ncells * 16 * sizeof(step));
+    int head = 0, tail = 0, nsteps = 0;
+
+    if (start_x < cam_x0 || start_y < cam_y0 || start_x - cam_x0 >= cam_w || start_y - cam_y0 >= cam_h) {
+        printf("Error: start camera (%d,%d) puts the man off the map\n", start_x, start_y);
+        return 1;
+    }
+
+    // Breadth-first over reachable camera positions, costing every step
+    queue[tail++] = (start_y - cam_y0) * cam_w + (start_x - cam_x0);
+    seen[queue[0]] = 1;
+    while (head < tail) {
+        int cell = queue[head++];
+        int cx = cell % cam_w + cam_x0, cy = cell / cam_w + cam_y0;
+        for (int d = 0; d < 16; d++) {       // 8 directions, walking then dashing
+            step s;
+            simulate(&model, cx, cy, inputs[d & 7] | (d < 8 ? 0 : INPUT_DASH), &s);
+            if (!s.dx && !s.dy) continue;
+            steps[nsteps++] = s;
+            if (s.cost > heat[cell]) heat[cell] = s.cost;
+
+            int nx = cx + s.dx - cam_x0, ny = cy + s.dy - cam_y0;
+            if (nx < 0 || ny < 0 || nx >= cam_w || ny >= cam_h) continue;
+            int next = ny * cam_w + nx;
+            if (!seen[next]) {
+                seen[next] = 1;
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    if (!nsteps) {
+        printf("No moves possible from camera (%d,%d)\n", start_x, start_y);
+        return 1;
+    }
+    qsort(steps, (size_t)nsteps, sizeof(step), cmp_step);
+    {
+        long total = 0, lo = steps[nsteps - 1].cost;
+        int over = 0;
+        for (int i = 0; i < nsteps; i++) {
+            total += steps[i].cost;
+            if (steps[i].cost > budget) over++;
+        }
+        printf("%d reachable positions, %d steps: min %ld T, mean %ld T, max %ld T\n",
+               tail, nsteps, lo, total / nsteps, steps[0].cost);
+        printf("Budget %ld T: %d step(s) over\n", budget, over);
+        {
+            int rows = 0, row_blank = 0, cols = 0, col_blank = 0;
+            for (int i = 0; i < nsteps; i++) {
+                rows += steps[i].dy != 0;
+                row_blank += steps[i].row_blank;
+                cols += steps[i].dx != 0;
+                col_blank += steps[i].column_blank;
+            }
+            printf("Blank edges (zero fill): %d/%d rows, %d/%d columns\n",
+                   row_blank, rows, col_blank, cols);
+        }
+        {
+            int dashes = 0, wide = 0, cached = 0, edges = 0;
+            long dash_max = 0;
+            for (int i = 0; i < nsteps; i++) {
+                edges += steps[i].dx != 0;
+                edges += steps[i].dy != 0;
+                cached += steps[i].cached;
+                if (!(steps[i].input & INPUT_DASH)) continue;
+                dashes++;
+                wide += steps[i].wide;
+                if (steps[i].cost > dash_max) dash_max = steps[i].cost;
+            }
+            printf("Dash steps (DASH_STEP %d): %d, max %ld T; %d n-wide edge(s)\n",
+                   DASH_STEP, dashes, dash_max, wide);
+            if (edge_cache)
+                printf("Edge cache: %d edge(s) blitted over %d step edge(s)\n", cached, edges);
+        }
+        if (model.snd_frame)
+            printf("AY player: %ld T per frame (tick %ld + interrupt %ld)\n",
+                   model.snd_frame + model.snd_isr, model.snd_frame, model.snd_isr);
+
+        printf("Worst steps (camera, man map position, direction):\n");
+        for (int i = 0; i < nsteps && i < top; i++) {
+            step *s = &steps[i];
+            char dir[6], sound[24] = "", flips[24] = "";
+            dir_name(s->input, dir);
+            if (s->sound) snprintf(sound, sizeof(sound), "  sound %5ld", s->sound);
+            if (s->flipped) snprintf(flips, sizeof(flips), "  %d flipped", s->flipped);
+            printf("  camera (%3d,%3d)  man (%3d,%3d)  %-3s  %7ld T  shifts %6ld  edges %6ld%s%s%s%s%s%s%s%s\n",
+                   s->cx, s->cy, s->cx + MAN_VIEWPORT_COL, s->cy + MAN_VIEWPORT_ROW, dir,
+                   s->cost, s->shifts, s->edges, sound, flips,
+                   s->row_fallback ? "  row C fallback" : "",
+                   s->column_fallback ? "  column C fallback" : "",
+                   s->row_blank ? "  row blank" : "",
+                   s->column_blank ? "  column blank" : "",
+                   s->wide ? "  n-wide" : "",
+                   s->cached ? "  cached" : "");
+        }
+
+        if (ppm_path) {
+            FILE *f = fopen(ppm_path, "wb");
+            if (!f) {
+                printf("Error: Cannot create %s\n", ppm_path);
+                return 1;
+            }
+            // One cell per man map position, so the image overlays the map
+            fprintf(f, "P6\n%d %d\n255\n", map_w * scale, map_h * scale);
+            for (int y = 0; y < map_h * scale; y++) {
+                for (int x = 0; x < map_w * scale; x++) {
+                    int mx = x / scale, my = y / scale;
+                    int cell = my * cam_w + mx;
+                    unsigned char rgb[3] = { 0, 0, 0 };
+                    if (mx < cam_w && my < cam_h && seen[cell] && heat[cell]) {
+                        heat_rgb(heat[cell], lo, budget, rgb);
+                    } else if (map[my * map_w + mx] == SOLID_TILE) {
+                        rgb[0] = rgb[1] = rgb[2] = 64;
+                    }
+                    fwrite(rgb, 1, 3, f);
+                }
+            }
+            fclose(f);
+            printf("Wrote %s (%dx%d)\n", ppm_path, map_w * scale, map_h * scale);
+        }
+    }
+
+    free(steps);
+    free(queue);
+    free(heat);
+    free(seen);
+    free(map);
+    return 0;
+}
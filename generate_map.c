@@ -1,23 +1,77 @@
 // Convert TileEd CSV export to ZX Spectrum binary map format
 // TileEd exports CSV with tile indices (0-based)
-// Usage: ./generate_map tilemap.csv width height
+// Usage: ./generate_map [--stride N] [--metatile M] tilemap.csv width height [remap.bin]
+//   remap.bin: 256-byte sheet-cell -> tile index table from
+//              "generate_tiles --optimise"; applied to every map cell
+//   --stride:  pad each row of map.bin to N bytes (128 or 256) with tile 0 so
+//              the renderers step rows with shifts/inc h (see MAP_STRIDE)
+//   --metatile: the CSV holds M x M metatiles (M = 2 or 4, from 16x16 / 32x32
+//              generate_tiles): width/height count metatiles, map.bin holds
+//              one byte per metatile, and remap.bin (512 bytes) is followed by
+//              the dictionary that expands them into cells
+//
+// Also writes map_occ.bin, occupancy bitmaps for skipping blank spans:
+//   row bitmaps:    height × ceil(width/8) bytes, bit set = non-blank tile
+//   column bitmaps: width × ceil(height/8) bytes
+// Bit 7 of a bitmap's first byte is column (or row) 0. They always count
+// 8x8 cells, so a metatile map's bitmaps are M times wider and taller.
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 int main(int argc, char *argv[]) {
-    if (argc != 4) {
-        printf("Usage: %s tilemap.csv width height\n", argv[0]);
+    int map_stride = 0;
+    int meta = 1;
+    while (argc > 2 && (strcmp(argv[1], "--stride") == 0 || strcmp(argv[1], "--metatile") == 0)) {
+        if (strcmp(argv[1], "--stride") == 0) map_stride = atoi(argv[2]);
+        else meta = atoi(argv[2]);
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 4 && argc != 5) {
+        printf("Usage: %s [--stride N] [--metatile M] tilemap.csv width height [remap.bin]\n", argv[0]);
+        return 1;
+    }
+    if (meta != 1 && meta != 2 && meta != 4) {
+        printf("Error: --metatile must be 2 or 4\n");
+        return 1;
+    }
+    if (meta > 1 && argc != 5) {
+        printf("Error: --metatile needs the remap.bin and dictionary from generate_tiles\n");
         return 1;
     }
 
+    // Metatile maps: remap gives the map byte (dictionary offset) of each
+    // sheet block and dict[byte + sy * meta + sx] its cells
+    unsigned char remap[256];
+    unsigned char dict[256] = { 0 };
+    for (int i = 0; i < 256; i++) {
+        remap[i] = (unsigned char)i;
+        if (meta == 1) dict[i] = (unsigned char)i;
+    }
+    if (argc == 5) {
+        FILE *rf = fopen(argv[4], "rb");
+        if (!rf || fread(remap, 1, sizeof(remap), rf) != sizeof(remap)
+            || (meta > 1 && fread(dict, 1, sizeof(dict), rf) != sizeof(dict))) {
+            printf("Error: Cannot read %d-byte remap table %s\n", meta > 1 ? 512 : 256, argv[4]);
+            if (rf) fclose(rf);
+            return 1;
+        }
+        fclose(rf);
+    }
+
     int map_width = atoi(argv[2]);
     int map_height = atoi(argv[3]);
     if (map_width <= 0 || map_height <= 0) {
         printf("Error: invalid width/height (must be > 0)\n");
         return 1;
     }
+    if (map_stride == 0) map_stride = map_width;
+    if (map_stride < map_width) {
+        printf("Error: stride %d is narrower than the map (%d)\n", map_stride, map_width);
+        return 1;
+    }
     
     FILE *csv = fopen(argv[1], "r");
     if (!csv) {
@@ -25,13 +79,14 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    FILE *bin = fopen("map.bin", "wb");
-    if (!bin) {
+    // Zero-filled, so short CSV rows and missing rows pad with tile 0
+    unsigned char *map = calloc((size_t)map_width * map_height, 1);
+    if (!map) {
         fclose(csv);
-        printf("Error: Cannot create map.bin\n");
+        printf("Error: Out of memory\n");
         return 1;
     }
-    
+
     char line[1024];
     int y = 0;
     
@@ -45,31 +100,86 @@ int main(int argc, char *argv[]) {
             if (tile < 0) tile = 0;
             if (tile > 255) tile = 255;
             
-            fputc((unsigned char)tile, bin);
+            map[y * map_width + x] = remap[tile];
             x++;
             token = strtok(NULL, ",\n");
         }
         
-        // Pad remaining columns if CSV is shorter
-        while (x < map_width) {
-            fputc(0, bin);
-            x++;
-        }
-        
         y++;
     }
     
-    // Pad remaining rows if CSV is shorter
-    while (y < map_height) {
-        for (int x = 0; x < map_width; x++) {
-            fputc(0, bin);
+    fclose(csv);
+
+    FILE *bin = fopen("map.bin", "wb");
+    if (!bin) {
+        free(map);
+        printf("Error: Cannot create map.bin\n");
+        return 1;
+    }
+    // Padding is tile 0, so a stray read past the right edge draws blank
+    static const unsigned char pad[256];
+    for (y = 0; y < map_height; y++) {
+        fwrite(map + (size_t)y * map_width, 1, (size_t)map_width, bin);
+        for (int p = map_width; p < map_stride; p += (int)sizeof(pad)) {
+            int n = map_stride - p < (int)sizeof(pad) ? map_stride - p : (int)sizeof(pad);
+            fwrite(pad, 1, (size_t)n, bin);
         }
-        y++;
     }
-    
-    fclose(csv);
     fclose(bin);
+
+    // Occupancy bitmaps: rows first, then columns, over the 8x8 cells
+    int cells_w = map_width * meta;
+    int cells_h = map_height * meta;
+    int row_bytes = (cells_w + 7) / 8;
+    int col_bytes = (cells_h + 7) / 8;
+    int occ_size = cells_h * row_bytes + cells_w * col_bytes;
+    unsigned char *occ = calloc((size_t)occ_size, 1);
+    if (!occ) {
+        free(map);
+        printf("Error: Out of memory\n");
+        return 1;
+    }
+    unsigned char *row_occ = occ;
+    unsigned char *col_occ = occ + map_height * row_bytes;
+    int blank_rows = 0, blank_cols = 0;
+    for (y = 0; y < cells_h; y++) {
+        for (int x = 0; x < cells_w; x++) {
+            unsigned char m = map[(y / meta) * map_width + x / meta];
+            if (dict[(unsigned char)(m + (y % meta) * meta + x % meta)]) {
+                row_occ[y * row_bytes + x / 8] |= (unsigned char)(0x80 >> (x & 7));
+                col_occ[x * col_bytes + y / 8] |= (unsigned char)(0x80 >> (y & 7));
+            }
+        }
+    }
+    for (y = 0; y < cells_h; y++) {
+        int b;
+        for (b = 0; b < row_bytes && !row_occ[y * row_bytes + b]; b++) ;
+        if (b == row_bytes) blank_rows++;
+    }
+    for (int x = 0; x < cells_w; x++) {
+        int b;
+        for (b = 0; b < col_bytes && !col_occ[x * col_bytes + b]; b++) ;
+        if (b == col_bytes) blank_cols++;
+    }
+
+    FILE *ob = fopen("map_occ.bin", "wb");
+    if (!ob) {
+        free(occ);
+        free(map);
+        printf("Error: Cannot create map_occ.bin\n");
+        return 1;
+    }
+    fwrite(occ, 1, (size_t)occ_size, ob);
+    fclose(ob);
+    free(occ);
+    free(map);
     
-    printf("Converted %s to map.bin (%dx%d tiles)\n", argv[1], map_width, map_height);
+    if (meta > 1)
+        printf("Converted %s to map.bin (%dx%d metatiles of %dx%d, %dx%d cells, stride %d)\n",
+               argv[1], map_width, map_height, meta, meta, cells_w, cells_h, map_stride);
+    else
+        printf("Converted %s to map.bin (%dx%d tiles, stride %d)\n", argv[1], map_width, map_height, map_stride);
+    printf("Occupancy: map_occ.bin (%d bytes), %d blank row(s), %d blank column(s)\n",
+           occ_size, blank_rows, blank_cols);
     return 0;
 }
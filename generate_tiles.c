@@ -1,5 +1,48 @@
 // Convert ZX-Paintbrush .zxp bitmap to ZX Spectrum 1bpp 8x8 tile bytes.
-// Usage: ./generate_tiles <input.zxp> <output_header.h> <tile_width_px> <tile_height_px>
+// Usage: ./generate_tiles <input.zxp> <output_header.h> <tile_width_px> <tile_height_px> [options]
+//   The output type follows the extension: .asm (DEFB image for 0x6000),
+//   .bin (the same bytes raw, for make_level_pack.py) or a C header.
+//   tile size: 8x8, or 16x16 / 32x32 metatiles (2x2 / 4x4 cells of 8x8)
+//   with --optimise: the map then indexes sheet blocks, and the tool writes
+//   a metatile dictionary page at 0x6300 (METATILE=2/4, generate_map
+//   --metatile)
+//
+// Optimising pass (all optional):
+//   --optimise <remap.bin>  drop duplicate tiles, put the blank tile at index 0
+//                           (the renderers' blank shortcut) and order the rest
+//                           by map frequency. Writes a 256-byte table mapping
+//                           each sheet cell to its new index for generate_map.
+//   --freq <map.csv>        count tile usage in the map; unused tiles are dropped
+//   --keep <i,j,...>        gameplay tiles (e.g. solid/trigger) keep their sheet
+//                           index and are never merged with look-alikes
+//   --fold-mirrors          store only one of each horizontal/vertical mirror
+//                           pair; the remap sets TILE_FLIP_H / TILE_FLIP_V and
+//                           the renderers must be built with TILE_FLIP=1
+//   --anim <base=f1,f2,...[@n]>
+//                           animate sheet cell <base> through frame cells f1..
+//                           every n frames (default 8). The base gets its own
+//                           slot (never merged) whose graphics the game swaps;
+//                           frames get read-only slots. Repeatable.
+//   --anim-out <tile_anim.h>
+//                           write the slot tables for the animations (always
+//                           written when given, TILE_ANIM_COUNT 0 if none)
+//   --attrs                 per-tile colour: read the .zxp attribute block (one
+//                           hex byte per 8x8 cell), keep cells that differ only
+//                           in colour apart, and write a 256-byte attribute
+//                           table indexed by map byte at 0x6200 (TILE_ATTRS=1).
+//                           An 8x2 block (four lines per cell row, as saved
+//                           for multicolour art) is also accepted; cells are
+//                           then merged only if all four bands match
+//   --multicolour           with --attrs: write four band tables (one per
+//                           2-scanline band of a tile) at 0x6400-0x67FF for
+//                           the multicolour viewport (MULTICOLOUR=1)
+//
+// Metatiles: the cells are optimised as above (--keep, --anim and --freq
+// still name sheet cells; --freq counts the metatile map and credits each
+// block's cells). Identical blocks share a dictionary entry of M*M slot
+// bytes, row-major; entry 0 is the blank block. The remap table then maps
+// sheet blocks to map bytes (the entry's offset in the dictionary page) and
+// is followed by the 256-byte dictionary, for generate_map --metatile.
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,25 +56,324 @@ static int is_bit_line(const char *s) {
     return 1;
 }
 
+// Attribute lines of a .zxp: hex bytes separated by spaces
+static int is_attr_line(const char *s) {
+    int digits = 0;
+    for (const char *p = s; *p; ++p) {
+        if (*p == ' ' || *p == '\t') continue;
+        if (!((*p >= '0' && *p <= '9') || (*p >= 'A' && *p <= 'F') || (*p >= 'a' && *p <= 'f'))) return 0;
+        digits++;
+    }
+    return digits > 0;
+}
+
 static void die(const char *msg) {
     fprintf(stderr, "%s\n", msg);
     exit(1);
 }
 
+// Must match tile_render.h / tile_render_direct.asm
+#define MAX_SHEET_TILES  256
+#define TILE_PAGE_TILES  32             // index * 8 must fit in one 256-byte page
+#define TILE_SCRATCH     31             // reserved for flipped tiles when folding
+#define TILE_FLIP_H      0x80
+#define TILE_FLIP_V      0x40
+#define TILE_AREA_BYTES  2048           // map_data follows at 0x6800 (tiles_extern.asm)
+#define REV_TABLE_OFFSET 256            // bit-reverse table at 0x6100 for TILE_FLIP
+#define ATTR_TABLE_OFFSET 512           // attribute per map byte at 0x6200 for TILE_ATTRS
+#define MC_TABLE_OFFSET  1024           // band k attribute per map byte at 0x6400 + k*256
+#define MC_BANDS         4              // 2-scanline attribute bands per tile
+#define META_DICT_OFFSET 768            // metatile dictionary page at 0x6300 for METATILE
+#define META_MAX         4              // cells per metatile side (32x32 art)
+#define TILE_INDEX_MASK  0x1F
+#define MAX_ANIMS        8
+#define MAX_ANIM_FRAMES  8
+#define ANIM_PERIOD      8              // default frames per animation step
+
+// Animation roles of sheet cells for the optimiser
+#define ANIM_BASE        1              // on the map, graphics swapped at runtime
+#define ANIM_FRAME       2              // source graphics, must have a plain slot
+
+typedef struct {
+    int base;                           // sheet cell
+    int frames[MAX_ANIM_FRAMES];        // sheet cells
+    int nframes;
+    int period;
+} tile_anim;
+
+static unsigned char reverse_bits(unsigned char b) {
+    unsigned char r = 0;
+    for (int i = 0; i < 8; i++) {
+        if (b & (1u << i)) r |= (unsigned char)(0x80u >> i);
+    }
+    return r;
+}
+
+// Apply flip bits to an 8-byte tile
+static void flip_tile(const unsigned char *src, unsigned char *dst, int flags) {
+    for (int y = 0; y < 8; y++) {
+        unsigned char b = src[(flags & TILE_FLIP_V) ? 7 - y : y];
+        dst[y] = (flags & TILE_FLIP_H) ? reverse_bits(b) : b;
+    }
+}
+
+static int is_blank(const unsigned char *t) {
+    for (int y = 0; y < 8; y++) {
+        if (t[y]) return 0;
+    }
+    return 1;
+}
+
+// Count tile indices in a TileEd CSV map (same format as generate_map)
+static void count_map_usage(const char *path, long *freq) {
+    FILE *f = fopen(path, "r");
+    char line[4096];
+    if (!f) {
+        perror("fopen map");
+        exit(1);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        char *token = strtok(line, ",\n\r");
+        while (token) {
+            int tile = atoi(token);
+            if (tile >= 0 && tile < MAX_SHEET_TILES) freq[tile]++;
+            token = strtok(NULL, ",\n\r");
+        }
+    }
+    fclose(f);
+}
+
+// Dedup, mirror-fold and reorder tiles. Returns the number of stored tiles;
+// out_bytes receives them in new index order, remap[cell] the new index.
+// With attrs (MC_BANDS per cell), only cells of the same colour are merged
+// and out_attrs receives the band attributes of each slot.
+static int optimise_tiles(const unsigned char *tile_bytes, int tile_count, const long *freq,
+                          int *keep, const int *anim_role, int fold, const unsigned char *attrs,
+                          unsigned char *out_bytes, unsigned char *out_attrs, unsigned char *remap) {
+    int canon[MAX_SHEET_TILES];         // cell -> representative cell
+    int flags[MAX_SHEET_TILES];         // flip bits from representative to cell
+    long weight[MAX_SHEET_TILES] = { 0 };
+    int needed[MAX_SHEET_TILES] = { 0 };  // animation cells stored even if unused
+    int slot_of[MAX_SHEET_TILES];
+    int slot_used[TILE_PAGE_TILES] = { 0 };
+    int slots = fold ? TILE_SCRATCH : TILE_PAGE_TILES;
+    int blank = -1, stored = 0;
+
+    // Cell 0 may be listed as a gameplay tile only if it is the blank tile
+    if (keep[0]) {
+        if (!is_blank(tile_bytes)) die("Error: --keep 0 but sheet cell 0 is not blank");
+        keep[0] = 0;
+    }
+
+    // Representatives: first cell with the same graphics (optionally mirrored).
+    // Gameplay tiles and animation bases stand alone and never absorb other
+    // cells; animation frames are copied by slot, so they are never flipped.
+    for (int i = 0; i < tile_count; i++) {
+        const unsigned char *t = &tile_bytes[i * 8];
+        int max_flip = (fold && !(anim_role[i] & ANIM_FRAME)) ? (TILE_FLIP_H | TILE_FLIP_V) : 0;
+        canon[i] = i;
+        flags[i] = 0;
+        if (keep[i] || (anim_role[i] & ANIM_BASE)) continue;
+        for (int j = 0; j < i && canon[i] == i; j++) {
+            if (canon[j] != j || keep[j] || (anim_role[j] & ANIM_BASE)) continue;
+            if (attrs && memcmp(&attrs[j * MC_BANDS], &attrs[i * MC_BANDS], MC_BANDS) != 0) continue;
+            for (int f = 0; f <= max_flip; f += TILE_FLIP_V) {
+                unsigned char m[8];
+                flip_tile(&tile_bytes[j * 8], m, f);
+                if (memcmp(m, t, 8) == 0) {
+                    canon[i] = j;
+                    flags[i] = f;
+                    break;
+                }
+            }
+        }
+        if (blank < 0 && canon[i] == i && is_blank(t) && !(anim_role[i] & ANIM_BASE)) blank = i;
+    }
+    for (int i = 0; i < tile_count; i++) {
+        weight[canon[i]] += freq ? freq[i] : 1;
+        if (anim_role[i]) needed[canon[i]] = 1;
+        slot_of[i] = -1;
+    }
+
+    // Index 0 is drawn as blank by the renderers, so it must hold the blank tile
+    if (blank < 0) die("Error: tile sheet has no blank tile for index 0");
+    slot_of[blank] = 0;
+    slot_used[0] = 1;
+    for (int i = 0; i < tile_count; i++) {
+        if (!keep[i]) continue;
+        if (i >= slots) die("Error: --keep index does not fit in the tile page");
+        if (slot_used[i] && slot_of[blank] != i) die("Error: --keep index collides with the blank tile");
+        slot_of[i] = i;
+        slot_used[i] = 1;
+    }
+
+    // Remaining representatives by descending usage (ties: sheet order)
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i < tile_count; i++) {
+            if (canon[i] != i || slot_of[i] >= 0) continue;
+            if (freq && weight[i] == 0 && !needed[i]) continue;
+            if (best < 0 || weight[i] > weight[best]) best = i;
+        }
+        if (best < 0) break;
+        int s = 1;
+        while (s < slots && slot_used[s]) s++;
+        if (s >= slots) die("Error: too many unique tiles for one tile page");
+        slot_of[best] = s;
+        slot_used[s] = 1;
+    }
+
+    memset(out_bytes, 0, TILE_PAGE_TILES * 8);
+    for (int i = 0; i < tile_count; i++) {
+        if (canon[i] == i && slot_of[i] >= 0) {
+            memcpy(&out_bytes[slot_of[i] * 8], &tile_bytes[i * 8], 8);
+            if (attrs) memcpy(&out_attrs[slot_of[i] * MC_BANDS], &attrs[i * MC_BANDS], MC_BANDS);
+            if (slot_of[i] + 1 > stored) stored = slot_of[i] + 1;
+        }
+    }
+    memset(remap, 0, MAX_SHEET_TILES);
+    for (int i = 0; i < tile_count; i++) {
+        int s = slot_of[canon[i]];
+        remap[i] = s < 0 ? 0 : (unsigned char)(s | flags[i]);
+    }
+    return stored;
+}
+
+// Metatile dictionary: each sheet block of meta x meta cells becomes meta*meta
+// remapped cell bytes. Identical blocks share an entry; entry 0 is the blank
+// block (so map byte 0 and the stride padding stay blank) and the rest follow
+// by map frequency, unused blocks dropped when freq is given. meta_remap[block]
+// receives the block's map byte: its entry's offset in the dictionary page.
+// Returns the number of entries.
+static int build_metatiles(const unsigned char *remap, int tiles_x, int tiles_y, int meta,
+                           const long *freq, unsigned char *dict, unsigned char *meta_remap) {
+    static const unsigned char blank[META_MAX * META_MAX];
+    unsigned char cells[MAX_SHEET_TILES][META_MAX * META_MAX];
+    int canon[MAX_SHEET_TILES];
+    int entry_of[MAX_SHEET_TILES];
+    long weight[MAX_SHEET_TILES] = { 0 };
+    int size = meta * meta;
+    int blocks_x = tiles_x / meta;
+    int count = blocks_x * (tiles_y / meta);
+    int entries = 1;
+
+    for (int b = 0; b < count; b++) {
+        int bx = b % blocks_x, by = b / blocks_x;
+        for (int sy = 0; sy < meta; sy++)
+            for (int sx = 0; sx < meta; sx++)
+                cells[b][sy * meta + sx] = remap[(by * meta + sy) * tiles_x + bx * meta + sx];
+        canon[b] = b;
+        for (int j = 0; j < b && canon[b] == b; j++)
+            if (canon[j] == j && memcmp(cells[j], cells[b], (size_t)size) == 0) canon[b] = j;
+        weight[canon[b]] += freq ? freq[b] : 1;
+        entry_of[b] = -1;
+    }
+
+    memset(dict, 0, 256);
+    for (;;) {
+        int best = -1;
+        for (int b = 0; b < count; b++) {
+            if (canon[b] != b || entry_of[b] >= 0 || memcmp(cells[b], blank, (size_t)size) == 0) continue;
+            if (freq && weight[b] == 0) continue;
+            if (best < 0 || weight[b] > weight[best]) best = b;
+        }
+        if (best < 0) break;
+        if (entries == 256 / size) die("Error: too many unique metatiles for one dictionary page");
+        entry_of[best] = entries;
+        memcpy(&dict[entries * size], cells[best], (size_t)size);
+        entries++;
+    }
+
+    memset(meta_remap, 0, MAX_SHEET_TILES);
+    for (int b = 0; b < count; b++) {
+        int e = entry_of[canon[b]];
+        meta_remap[b] = e < 0 ? 0 : (unsigned char)(e * size);
+    }
+    return entries;
+}
+
 int main(int argc, char **argv) {
-    if (argc != 5) {
-        fprintf(stderr, "Usage: %s <input.zxp> <output_header.h> <tile_width_px> <tile_height_px>\n", argv[0]);
+    if (argc < 5) {
+        fprintf(stderr, "Usage: %s <input.zxp> <output_header.h> <tile_width_px> <tile_height_px>"
+                " [--optimise remap.bin] [--freq map.csv] [--keep i,j] [--fold-mirrors]"
+                " [--anim base=f1,f2[@n]]... [--anim-out tile_anim.h] [--attrs [--multicolour]]\n", argv[0]);
         return 1;
     }
 
+    const char *remap_path = NULL;
+    const char *freq_path = NULL;
+    const char *anim_out = NULL;
+    int keep[MAX_SHEET_TILES] = { 0 };
+    int anim_role[MAX_SHEET_TILES] = { 0 };
+    tile_anim anims[MAX_ANIMS];
+    int anim_count = 0;
+    int fold = 0;
+    int use_attrs = 0;
+    int multicolour = 0;
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--optimise") == 0 && i + 1 < argc) {
+            remap_path = argv[++i];
+        } else if (strcmp(argv[i], "--freq") == 0 && i + 1 < argc) {
+            freq_path = argv[++i];
+        } else if (strcmp(argv[i], "--keep") == 0 && i + 1 < argc) {
+            char *list = argv[++i];
+            for (char *tok = strtok(list, ","); tok; tok = strtok(NULL, ",")) {
+                int k = atoi(tok);
+                if (k < 0 || k >= MAX_SHEET_TILES) die("Error: --keep index out of range");
+                keep[k] = 1;
+            }
+        } else if (strcmp(argv[i], "--fold-mirrors") == 0) {
+            fold = 1;
+        } else if (strcmp(argv[i], "--anim") == 0 && i + 1 < argc) {
+            tile_anim *a = &anims[anim_count];
+            char *spec = argv[++i];
+            char *eq = strchr(spec, '=');
+            char *at = strchr(spec, '@');
+            if (anim_count == MAX_ANIMS) die("Error: too many --anim sequences");
+            if (!eq) die("Error: --anim expects base=f1,f2,...[@n]");
+            a->base = atoi(spec);
+            a->period = at ? atoi(at + 1) : ANIM_PERIOD;
+            if (at) *at = 0;
+            a->nframes = 0;
+            for (char *tok = strtok(eq + 1, ","); tok; tok = strtok(NULL, ",")) {
+                int f = atoi(tok);
+                if (a->nframes == MAX_ANIM_FRAMES) die("Error: too many frames in --anim");
+                if (f < 0 || f >= MAX_SHEET_TILES) die("Error: --anim frame out of range");
+                a->frames[a->nframes++] = f;
+                anim_role[f] |= ANIM_FRAME;
+            }
+            if (a->base <= 0 || a->base >= MAX_SHEET_TILES) die("Error: --anim base out of range");
+            if (a->nframes < 2) die("Error: --anim needs at least two frames");
+            if (a->period < 1 || a->period > 127) die("Error: --anim period must be 1-127 frames");
+            anim_role[a->base] |= ANIM_BASE;
+            anim_count++;
+        } else if (strcmp(argv[i], "--anim-out") == 0 && i + 1 < argc) {
+            anim_out = argv[++i];
+        } else if (strcmp(argv[i], "--attrs") == 0) {
+            use_attrs = 1;
+        } else if (strcmp(argv[i], "--multicolour") == 0) {
+            multicolour = 1;
+        } else {
+            fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if ((freq_path || fold || anim_count || use_attrs) && !remap_path)
+        die("Error: --freq, --fold-mirrors, --anim and --attrs need --optimise");
+    if (multicolour && !use_attrs)
+        die("Error: --multicolour needs --attrs");
+
     const char *in_path = argv[1];
     const char *out_path = argv[2];
 
     int tile_w = atoi(argv[3]);
     int tile_h = atoi(argv[4]);
-    if (tile_w != 8 || tile_h != 8) {
-        die("Error: only 8x8 tiles are supported by this generator/output format");
+    int meta = tile_w / 8;              // cells per metatile side, 1 for 8x8 tiles
+    if (tile_w != tile_h || tile_w % 8 || (meta != 1 && meta != 2 && meta != META_MAX)) {
+        die("Error: tiles must be 8x8, or 16x16 / 32x32 metatiles of 8x8 cells");
     }
+    // The tile page always holds 8x8 cells; metatiles are built from them
+    tile_w = tile_h = 8;
 
     FILE *in = fopen(in_path, "r");
     if (!in) {
@@ -43,6 +385,9 @@ int main(int argc, char **argv) {
     size_t rows_cap = 0;
     size_t rows_len = 0;
     int width = -1;
+    unsigned char attr_bytes[MAX_SHEET_TILES * MC_BANDS];   // .zxp attribute block, in file order
+    unsigned char cell_attrs[MAX_SHEET_TILES * MC_BANDS];   // MC_BANDS per sheet cell
+    int attr_count = 0;
 
     char line[2048];
     while (fgets(line, sizeof(line), in)) {
@@ -51,6 +396,12 @@ int main(int argc, char **argv) {
             line[--n] = 0;
         }
         if (!is_bit_line(line)) {
+            if (use_attrs && is_attr_line(line)) {
+                for (char *tok = strtok(line, " \t"); tok; tok = strtok(NULL, " \t")) {
+                    if (attr_count == MAX_SHEET_TILES * MC_BANDS) die("Error: too many attribute cells in .zxp");
+                    attr_bytes[attr_count++] = (unsigned char)strtol(tok, NULL, 16);
+                }
+            }
             continue;
         }
         if (width < 0) {
@@ -89,12 +440,31 @@ int main(int argc, char **argv) {
     int tiles_x = width / tile_w;
     int tiles_y = height / tile_h;
     int tile_count = tiles_x * tiles_y;
+    if (remap_path && meta > 1 && (tiles_x % meta || tiles_y % meta)) {
+        die("Error: bitmap width/height must be multiples of the metatile size");
+    }
+
+    // 8x8 attributes: one line per cell row; 8x2: MC_BANDS lines per cell row
+    if (use_attrs) {
+        if (attr_count != tile_count && attr_count != tile_count * MC_BANDS) {
+            fprintf(stderr, "Error: --attrs: .zxp has %d attribute cells, expected %d (8x8) or %d (8x2)\n",
+                    attr_count, tile_count, tile_count * MC_BANDS);
+            return 1;
+        }
+        for (int i = 0; i < tile_count; i++) {
+            int tx = i % tiles_x, ty = i / tiles_x;
+            for (int k = 0; k < MC_BANDS; k++)
+                cell_attrs[i * MC_BANDS + k] = attr_count == tile_count ? attr_bytes[i]
+                                                : attr_bytes[(ty * MC_BANDS + k) * tiles_x + tx];
+        }
+    }
 
     // Determine output mode from file extension
     size_t out_len = strlen(out_path);
     int asm_mode = (out_len >= 4 && strcmp(out_path + out_len - 4, ".asm") == 0);
+    int bin_mode = (out_len >= 4 && strcmp(out_path + out_len - 4, ".bin") == 0);
 
-    FILE *out = fopen(out_path, "w");
+    FILE *out = fopen(out_path, bin_mode ? "wb" : "w");
     if (!out) {
         perror("fopen output");
         return 1;
@@ -122,10 +492,165 @@ int main(int argc, char **argv) {
         }
     }
 
-    if (asm_mode) {
+    if (remap_path) {
+        long freq[MAX_SHEET_TILES] = { 0 };
+        long meta_freq[MAX_SHEET_TILES] = { 0 };
+        unsigned char remap[MAX_SHEET_TILES];
+        unsigned char meta_remap[MAX_SHEET_TILES];
+        unsigned char slot_attrs[TILE_PAGE_TILES * MC_BANDS] = { 0 };
+        unsigned char *opt = (unsigned char *)calloc(TILE_AREA_BYTES, 1);
+        if (!opt) die("Error: out of memory");
+        if (tile_count > MAX_SHEET_TILES) die("Error: --optimise supports at most 256 sheet tiles");
+        if (freq_path && meta > 1) {
+            // The map counts blocks; every cell of a block is drawn as often
+            count_map_usage(freq_path, meta_freq);
+            for (int i = 0; i < tile_count; i++)
+                freq[i] = meta_freq[(i / tiles_x / meta) * (tiles_x / meta) + (i % tiles_x) / meta];
+        } else if (freq_path) {
+            count_map_usage(freq_path, freq);
+        }
+
+        int stored = optimise_tiles(tile_bytes, tile_count, freq_path ? freq : NULL, keep, anim_role,
+                                    fold, use_attrs ? cell_attrs : NULL, opt, slot_attrs, remap);
+        unsigned char anim_slots[MAX_ANIMS][MAX_ANIM_FRAMES];
+        for (int a = 0; a < anim_count; a++) {
+            if (anims[a].base >= tile_count || remap[anims[a].base] == 0)
+                die("Error: --anim base must be a non-blank sheet cell");
+        }
+        // Frame slots are copied into the base slot at runtime. A frame whose
+        // graphics only exist in a base slot (e.g. the base's own first frame)
+        // gets a read-only copy, since the base slot changes.
+        for (int a = 0; a < anim_count; a++) {
+            for (int k = 0; k < anims[a].nframes; k++) {
+                int f = anims[a].frames[k];
+                int s;
+                int in_base = 0;
+                if (f >= tile_count) die("Error: --anim frame is not in the sheet");
+                s = remap[f];
+                for (int b = 0; b < anim_count; b++)
+                    if (remap[anims[b].base] == s) in_base = 1;
+                if (in_base) {
+                    int fs, copy = 0;
+                    for (fs = 1; fs < stored && !copy; fs++) {
+                        int used_by_base = 0;
+                        for (int b = 0; b < anim_count; b++)
+                            if (remap[anims[b].base] == fs) used_by_base = 1;
+                        if (!used_by_base && memcmp(&opt[fs * 8], &tile_bytes[f * 8], 8) == 0) copy = fs;
+                    }
+                    if (!copy) {
+                        if (stored >= (fold ? TILE_SCRATCH : TILE_PAGE_TILES))
+                            die("Error: too many unique tiles for one tile page");
+                        copy = stored++;
+                        memcpy(&opt[copy * 8], &tile_bytes[f * 8], 8);
+                        if (use_attrs) memcpy(&slot_attrs[copy * MC_BANDS], &cell_attrs[f * MC_BANDS], MC_BANDS);
+                    }
+                    s = copy;
+                }
+                anim_slots[a][k] = (unsigned char)s;
+            }
+        }
+        if (anim_out) {
+            FILE *af = fopen(anim_out, "w");
+            if (!af) {
+                perror("fopen anim");
+                return 1;
+            }
+            fprintf(af, "// Generated by generate_tiles --anim - do not edit\n");
+            fprintf(af, "#ifndef TILE_ANIM_H\n#define TILE_ANIM_H\n\n");
+            fprintf(af, "#define TILE_ANIM_COUNT %d\n", anim_count);
+            if (anim_count) {
+                int max_frames = 0;
+                for (int a = 0; a < anim_count; a++)
+                    if (anims[a].nframes > max_frames) max_frames = anims[a].nframes;
+                fprintf(af, "#define TILE_ANIM_MAX_FRAMES %d\n\n", max_frames);
+                fprintf(af, "// Tile slot on the map whose graphics are swapped\n");
+                fprintf(af, "static const unsigned char tile_anim_slot[TILE_ANIM_COUNT] = {");
+                for (int a = 0; a < anim_count; a++)
+                    fprintf(af, "%s %d", a ? "," : "", remap[anims[a].base]);
+                fprintf(af, " };\n\n// Frames per step\n");
+                fprintf(af, "static const unsigned char tile_anim_period[TILE_ANIM_COUNT] = {");
+                for (int a = 0; a < anim_count; a++)
+                    fprintf(af, "%s %d", a ? "," : "", anims[a].period);
+                fprintf(af, " };\n\n");
+                fprintf(af, "static const unsigned char tile_anim_nframes[TILE_ANIM_COUNT] = {");
+                for (int a = 0; a < anim_count; a++)
+                    fprintf(af, "%s %d", a ? "," : "", anims[a].nframes);
+                fprintf(af, " };\n\n// Read-only source slot of each frame\n");
+                fprintf(af, "static const unsigned char tile_anim_frames[TILE_ANIM_COUNT][TILE_ANIM_MAX_FRAMES] = {\n");
+                for (int a = 0; a < anim_count; a++) {
+                    fprintf(af, "    {");
+                    for (int k = 0; k < anims[a].nframes; k++)
+                        fprintf(af, "%s %d", k ? "," : "", anim_slots[a][k]);
+                    fprintf(af, " },    // sheet cell %d\n", anims[a].base);
+                }
+                fprintf(af, "};\n");
+            }
+            fprintf(af, "\n#endif // TILE_ANIM_H\n");
+            fclose(af);
+        }
+        int folded = 0;
+        for (int i = 0; i < tile_count; i++) {
+            if (remap[i] & (TILE_FLIP_H | TILE_FLIP_V)) folded++;
+        }
+        if (fold) {
+            for (int b = 0; b < 256; b++) opt[REV_TABLE_OFFSET + b] = reverse_bits((unsigned char)b);
+        }
+        // Flip bits do not change the colour: every map byte of a slot shares it
+        // (the 8x8 table takes a tile's top band)
+        if (use_attrs) {
+            for (int b = 0; b < 256; b++) opt[ATTR_TABLE_OFFSET + b] = slot_attrs[(b & TILE_INDEX_MASK) * MC_BANDS];
+        }
+        // Band tables: a vertically flipped tile shows its bands bottom-up
+        if (multicolour) {
+            for (int k = 0; k < MC_BANDS; k++)
+                for (int b = 0; b < 256; b++)
+                    opt[MC_TABLE_OFFSET + k * 256 + b] =
+                        slot_attrs[(b & TILE_INDEX_MASK) * MC_BANDS + ((b & TILE_FLIP_V) ? MC_BANDS - 1 - k : k)];
+        }
+
+        int meta_entries = 0;
+        if (meta > 1)
+            meta_entries = build_metatiles(remap, tiles_x, tiles_y, meta, freq_path ? meta_freq : NULL,
+                                           &opt[META_DICT_OFFSET], meta_remap);
+
+        FILE *rf = fopen(remap_path, "wb");
+        if (!rf) {
+            perror("fopen remap");
+            return 1;
+        }
+        if (meta > 1) {
+            fwrite(meta_remap, 1, MAX_SHEET_TILES, rf);
+            fwrite(&opt[META_DICT_OFFSET], 1, 256, rf);
+        } else {
+            fwrite(remap, 1, MAX_SHEET_TILES, rf);
+        }
+        fclose(rf);
+        printf("Tiles: %d sheet cells -> %d tile slots (%d bytes), %d cells mirror-folded\n",
+               tile_count, stored, stored * 8, folded);
+        if (meta > 1)
+            printf("Metatiles: %d sheet blocks of %dx%d -> %d dictionary entries (%d bytes)\n",
+                   tile_count / (meta * meta), meta, meta, meta_entries, meta_entries * meta * meta);
+
+        // The asm image keeps the fixed 0x6000-0x67FF layout so map_data stays at 0x6800
+        free(tile_bytes);
+        tile_bytes = opt;
+        tile_count = stored;
+        total_bytes = (asm_mode || bin_mode) ? TILE_AREA_BYTES : stored * 8;
+    }
+
+    if (bin_mode) {
+        fwrite(tile_bytes, 1, (size_t)total_bytes, out);
+    } else if (asm_mode) {
         // Assembly output: raw DEFB data (no section/public - standalone binary)
         fprintf(out, "; tiles_data.asm - Generated tile data\n");
         fprintf(out, "; %d tiles, %d bytes total\n", tile_count, total_bytes);
+        if (remap_path) {
+            fprintf(out, "; Optimised: blank tile at index 0, padded to the 0x6000-0x67FF tile area\n");
+            if (fold) fprintf(out, "; Bit-reverse table for TILE_FLIP at $%04X\n", 0x6000 + REV_TABLE_OFFSET);
+            if (use_attrs) fprintf(out, "; Attribute table for TILE_ATTRS at $%04X\n", 0x6000 + ATTR_TABLE_OFFSET);
+            if (multicolour) fprintf(out, "; Band tables for MULTICOLOUR at $%04X\n", 0x6000 + MC_TABLE_OFFSET);
+            if (meta > 1) fprintf(out, "; Metatile dictionary (%dx%d cells) at $%04X\n", meta, meta, 0x6000 + META_DICT_OFFSET);
+        }
         fprintf(out, "; Assembled standalone, loaded to contended RAM by BASIC loader\n\n");
         fprintf(out, "    ORG $6000\n\n");
         fprintf(out, "_tiles:\n");
@@ -0,0 +1,188 @@
+// Generate the viewport/map parameters and screen address tables shared by
+// the C code and the unrolled asm renderers, from the config/*.mk settings.
+// Usage: ./generate_viewport cols char_rows col_offset start_char_row map_width map_height [map_stride [metatile]]
+//   map_stride: bytes per map row in map.bin (default map_width). 128 or 256
+//               (generate_map --stride) turns row stepping into shifts/inc h
+//   metatile:   2 or 4 for a metatile map (generate_map --metatile; default
+//               0, one byte per cell). map_width/height count metatiles;
+//               MAP_WIDTH/MAP_HEIGHT are emitted in cells
+//
+// Writes:
+//   viewport.inc       - EQUs included by the asm (REPT counts, strides, data addresses)
+//   viewport.h         - matching #defines for the C code
+//   scr_addr_table.inc - DEFW screen address per viewport scanline, included
+//                        under each module's table label
+//   dirty_scr_addr_table.inc - the same for the dirty-edge/dixel modules,
+//                        which keep their own start row (DIRTY_START_CHAR_ROW)
+//
+// The renderers and shifts unroll with REPT over these EQUs, so a different
+// viewport or map size is re-specialised at assembly time with no asm edits.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SCREEN_COLS       32
+#define SCREEN_CHAR_ROWS  24
+#define MAP_ADDR          0x6800    // after the 2048-byte tile area at 0x6000
+#define CODE_ADDR         0x8000    // the map must end below the program
+#define META_STRIP_BYTES  256       // metatile edge strips: one page after the map
+#define META_ROW_STRIP    64        // row strip offset in that page
+#define DIRTY_START_CHAR_ROW 4      // copy_viewport_32x16 / dixel_scroll screen row
+
+static unsigned int scr_addr(int y) {
+    return 0x4000 | ((y & 0xC0) << 5) | ((y & 0x07) << 8) | ((y & 0x38) << 2);
+}
+
+static int write_scr_table(const char *path, int start_row, int rows) {
+    FILE *t = fopen(path, "w");
+    if (!t) {
+        printf("Error: Cannot create %s\n", path);
+        return 1;
+    }
+    fprintf(t, "; Generated by generate_viewport - do not edit\n");
+    fprintf(t, "; Screen address of each viewport scanline (column 0), %d entries\n", rows * 8);
+    for (int r = 0; r < rows; r++) {
+        int y = (start_row + r) * 8;
+        fprintf(t, "    ; Y=%d-%d (third %d, char row %d)\n    DEFW ", y, y + 7, y / 64, (y % 64) / 8);
+        for (int s = 0; s < 8; s++)
+            fprintf(t, "0x%04X%s", scr_addr(y + s), s < 7 ? ", " : "\n");
+    }
+    fclose(t);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 7 || argc > 9) {
+        printf("Usage: %s cols char_rows col_offset start_char_row map_width map_height [map_stride [metatile]]\n", argv[0]);
+        return 1;
+    }
+
+    int cols = atoi(argv[1]);
+    int rows = atoi(argv[2]);
+    int col_offset = atoi(argv[3]);
+    int start_row = atoi(argv[4]);
+    int map_width = atoi(argv[5]);
+    int map_height = atoi(argv[6]);
+    int map_stride = argc >= 8 ? atoi(argv[7]) : map_width;
+    int metatile = argc == 9 ? atoi(argv[8]) : 0;
+
+    if (cols < 2 || col_offset < 0 || cols + col_offset > SCREEN_COLS) {
+        printf("Error: viewport columns %d + offset %d must fit in %d (min 2 columns)\n",
+               cols, col_offset, SCREEN_COLS);
+        return 1;
+    }
+    if (rows < 2 || start_row < 0 || rows + start_row > SCREEN_CHAR_ROWS) {
+        printf("Error: viewport rows %d from char row %d must fit in %d (min 2 rows)\n",
+               rows, start_row, SCREEN_CHAR_ROWS);
+        return 1;
+    }
+    // The dirty-edge modules stay at their row; a taller viewport moves up
+    int dirty_row = rows + DIRTY_START_CHAR_ROW > SCREEN_CHAR_ROWS ? SCREEN_CHAR_ROWS - rows : DIRTY_START_CHAR_ROW;
+    if (metatile != 0 && metatile != 2 && metatile != 4) {
+        printf("Error: metatile size %d must be 0 (cells), 2 or 4\n", metatile);
+        return 1;
+    }
+    int meta_shift = metatile == 4 ? 2 : metatile == 2 ? 1 : 0;
+    int cells_w = map_width << meta_shift;
+    int cells_h = map_height << meta_shift;
+    if (map_width <= 0 || map_height <= 0 || cells_w > 255 || cells_h > 255) {
+        printf("Error: invalid map size %dx%d cells (1-255 per side)\n", cells_w, cells_h);
+        return 1;
+    }
+
+    if (map_stride != map_width && map_stride != 128 && map_stride != 256) {
+        printf("Error: map stride %d must be the map width, 128 or 256\n", map_stride);
+        return 1;
+    }
+    if (map_stride < map_width) {
+        printf("Error: map stride %d is narrower than the map (%d)\n", map_stride, map_width);
+        return 1;
+    }
+    int stride_shift = map_stride == 256 ? 8 : map_stride == 128 ? 7 : 0;
+
+    // Contended data layout: 2048 bytes of tiles, then the map, then (for a
+    // metatile map) the page holding the expanded edge strips, so neither
+    // strip crosses a page and the renderers step them with inc l
+    long map_end = MAP_ADDR + (long)map_stride * map_height;
+    long strip_addr = (map_end + 255) & ~255L;
+    long data_end = metatile ? strip_addr + META_STRIP_BYTES : map_end;
+    if (data_end > CODE_ADDR) {
+        printf("Error: map %d rows x stride %d%s ends at 0x%04lX, past 0x%04X\n",
+               map_height, map_stride, metatile ? " + edge strips" : "", data_end, CODE_ADDR);
+        return 1;
+    }
+    if (metatile && (rows + metatile > META_ROW_STRIP || cols + metatile > META_STRIP_BYTES - META_ROW_STRIP)) {
+        printf("Error: viewport %dx%d does not fit the metatile strips\n", cols, rows);
+        return 1;
+    }
+
+    FILE *inc = fopen("viewport.inc", "w");
+    if (!inc) {
+        printf("Error: Cannot create viewport.inc\n");
+        return 1;
+    }
+    fprintf(inc, "; Generated by generate_viewport - do not edit\n");
+    fprintf(inc, "; Viewport %dx%d tiles at char (%d,%d), map %dx%d tiles, stride %d\n\n",
+            cols, rows, col_offset, start_row, cells_w, cells_h, map_stride);
+    fprintf(inc, "VIEWPORT_COLS           EQU %d\n", cols);
+    fprintf(inc, "VIEWPORT_CHAR_ROWS      EQU %d\n", rows);
+    fprintf(inc, "VIEWPORT_COL_OFFSET     EQU %d\n", col_offset);
+    fprintf(inc, "VIEWPORT_START_CHAR_ROW EQU %d\n", start_row);
+    fprintf(inc, "VIEWPORT_HEIGHT         EQU %d    ; scanlines\n", rows * 8);
+    fprintf(inc, "DIRTY_START_CHAR_ROW    EQU %d    ; dirty-edge/dixel viewport\n", dirty_row);
+    fprintf(inc, "MAP_WIDTH               EQU %d    ; cells\n", cells_w);
+    fprintf(inc, "MAP_HEIGHT              EQU %d\n", cells_h);
+    fprintf(inc, "MAP_STRIDE              EQU %d    ; bytes per map row\n", map_stride);
+    fprintf(inc, "MAP_STRIDE_SHIFT        EQU %d    ; log2(MAP_STRIDE), 0 if not a power of two\n", stride_shift);
+    fprintf(inc, "MAP_ADDR                EQU 0x%04X\n", MAP_ADDR);
+    fprintf(inc, "METATILE                EQU %d    ; cells per metatile side, 0 = cell map\n", metatile);
+    fprintf(inc, "META_SHIFT              EQU %d\n", meta_shift);
+    // Edge pointers: map rows/columns, or the page-safe metatile strips
+    fprintf(inc, "MAP_COL_STEP            EQU %d    ; map pointer step down an edge column\n",
+            metatile ? 1 : map_stride);
+    fprintf(inc, "MAP_ROW_IN_PAGE         EQU %d    ; 1: an edge row never crosses a page (inc l)\n",
+            metatile || stride_shift ? 1 : 0);
+    if (metatile) {
+        fprintf(inc, "META_COL_STRIP          EQU 0x%04lX\n", strip_addr);
+        fprintf(inc, "META_ROW_STRIP          EQU 0x%04lX\n", strip_addr + META_ROW_STRIP);
+        fprintf(inc, "META_COL_BLOCKS         EQU %d    ; metatiles expanded per edge\n",
+                (rows + 2 * metatile - 2) / metatile);
+        fprintf(inc, "META_ROW_BLOCKS         EQU %d\n", (cols + 2 * metatile - 2) / metatile);
+    }
+    fclose(inc);
+
+    FILE *h = fopen("viewport.h", "w");
+    if (!h) {
+        printf("Error: Cannot create viewport.h\n");
+        return 1;
+    }
+    fprintf(h, "// Generated by generate_viewport - do not edit\n");
+    fprintf(h, "#ifndef VIEWPORT_H\n#define VIEWPORT_H\n\n");
+    fprintf(h, "#define VIEWPORT_COLS           %d\n", cols);
+    fprintf(h, "#define VIEWPORT_CHAR_ROWS      %d\n", rows);
+    fprintf(h, "#define VIEWPORT_START_CHAR_ROW %d\n", start_row);
+    fprintf(h, "#define VIEWPORT_COL_OFFSET     %d\n", col_offset);
+    fprintf(h, "#define DIRTY_START_CHAR_ROW    %d\n\n", dirty_row);
+    fprintf(h, "#define MAP_WIDTH  %d\n", cells_w);
+    fprintf(h, "#define MAP_HEIGHT %d\n", cells_h);
+    fprintf(h, "#define MAP_STRIDE %d        // bytes per map row\n", map_stride);
+    fprintf(h, "#define MAP_STRIDE_SHIFT %d  // log2(MAP_STRIDE), 0 if not a power of two\n\n", stride_shift);
+    fprintf(h, "#define METATILE   %d        // cells per metatile side, 0 = cell map\n", metatile);
+    fprintf(h, "#define META_SHIFT %d\n", meta_shift);
+    if (metatile) {
+        fprintf(h, "#define META_COL_STRIP ((unsigned char *)0x%04lX)\n", strip_addr);
+        fprintf(h, "#define META_ROW_STRIP ((unsigned char *)0x%04lX)\n", strip_addr + META_ROW_STRIP);
+    }
+    fprintf(h, "\n");
+    fprintf(h, "#endif // VIEWPORT_H\n");
+    fclose(h);
+
+    if (write_scr_table("scr_addr_table.inc", start_row, rows)
+        || write_scr_table("dirty_scr_addr_table.inc", dirty_row, rows))
+        return 1;
+
+    printf("Viewport %dx%d at char (%d,%d), map %dx%d stride %d%s: data ends at 0x%04lX\n",
+           cols, rows, col_offset, start_row, cells_w, cells_h, map_stride,
+           metatile == 4 ? " (4x4 metatiles)" : metatile == 2 ? " (2x2 metatiles)" : "", data_end);
+    return 0;
+}
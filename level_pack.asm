@@ -0,0 +1,199 @@
+; level_pack.asm - 128K level pack: bank loader, level switcher, unpacker
+; Levels built by make_level_pack.py from config/*_game.json sit compressed
+; in RAM banks 1/3/4/6/7. A level is paged in at 0xC000 and unpacked into
+; the fixed working addresses the renderers use, so no tape access is needed
+; between levels.
+;
+; Public routines:
+;   _level_pack_load - load the level banks from tape (once, at startup)
+;   _level_unpack    - page in and unpack one level (~400,000 T, ~6 frames)
+;
+; Bank 0 (and the C stack at the top of memory) is paged out while another
+; bank is at 0xC000, so both routines switch to a small stack in the program
+; image with interrupts disabled. The program image must end below 0xC000.
+; Paging keeps the 48K ROM selected (bit 4): ROM LD-BYTES and IM 1 need it.
+
+    SECTION code_user
+
+    PUBLIC _level_pack_load
+    PUBLIC _level_unpack
+
+    EXTERN _tiles
+    EXTERN _map_row_occ
+
+    INCLUDE "viewport.inc"
+
+BANK_PORT       EQU 0x7FFD
+BANKM           EQU 0x5B5C      ; 128K ROM's copy of the last 0x7FFD write
+BANK_ROM48      EQU 0x10        ; bit 4: 48K BASIC ROM at 0x0000
+BANK_ORG        EQU 0xC000
+LD_BYTES        EQU 0x0556      ; ROM tape loader: IX=addr, DE=len, A=flag, CF=load
+HUD_ADDR        EQU 0x4000      ; .scr image: pixels + attributes
+
+;----------------------------------------------------------------------
+; _level_pack_load
+; Load every bank of levels.tap from tape: one headerless block per bank,
+; straight to 0xC000 with the bank paged in. A block that fails its
+; checksum is retried (rewind the tape to the start of the block).
+;
+; void level_pack_load(void)
+;----------------------------------------------------------------------
+_level_pack_load:
+    push ix                 ; save SDCC frame pointer
+    di
+    ld (_lpl_save_sp+1), sp ; save SP (self-modifying)
+    ld sp, _level_stack_top
+
+    ld hl, _level_bank_table
+    ld b, LEVEL_BANK_COUNT
+
+_lpl_bank:
+    push bc
+    ld a, (hl)              ; A = RAM bank
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = block length
+    inc hl
+    push hl
+    call _level_page
+
+_lpl_retry:
+    push de
+    ld ix, BANK_ORG
+    ld a, 0xFF              ; data block flag
+    scf                     ; load, not verify
+    call LD_BYTES           ; returns with interrupts enabled
+    di
+    pop de
+    jr nc, _lpl_retry       ; tape error: wait for the block again
+
+    pop hl
+    pop bc
+    djnz _lpl_bank
+
+    xor a                   ; bank 0 back at 0xC000
+    call _level_page
+_lpl_save_sp:
+    ld sp, 0                ; self-mod: restored SP
+    ei
+    pop ix
+    ret
+
+;----------------------------------------------------------------------
+; _level_unpack
+; Page in a level's bank and unpack its four streams: tiles, map,
+; occupancy bitmaps and HUD screen. The caller redraws the viewport.
+;
+; void level_unpack(unsigned char level)
+;   level: 0 .. LEVEL_COUNT-1 (level_pack.h)
+;
+; T-states: ~21 per unpacked byte plus per-token overhead; about 400,000
+; for a 96×48 map at stride 128 (make_level_pack.py reports each level)
+;----------------------------------------------------------------------
+_level_unpack:
+    ; Read param from stack (SDCC sdcc_iy: char is 1 byte on stack)
+    ld hl, 2
+    add hl, sp
+    ld l, (hl)
+    ld h, 0                 ; HL = level
+    ld e, l
+    ld d, h
+    add hl, hl
+    add hl, de              ; ×3 (bank byte + address word)
+    ld de, _level_dir
+    add hl, de
+    ld a, (hl)              ; A = RAM bank
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = packed streams at 0xC000+
+
+    di
+    ld (_lu_save_sp+1), sp  ; save SP (self-modifying)
+    ld sp, _level_stack_top
+    call _level_page
+
+    ex de, hl               ; HL = packed streams
+    ld de, _tiles
+    call _lz_unpack
+    ld de, MAP_ADDR
+    call _lz_unpack
+    ld de, _map_row_occ
+    call _lz_unpack
+    ld de, HUD_ADDR
+    call _lz_unpack
+
+    xor a                   ; bank 0 back at 0xC000
+    call _level_page
+_lu_save_sp:
+    ld sp, 0                ; self-mod: restored SP
+    ei
+    ret
+
+;----------------------------------------------------------------------
+; _level_page: page RAM bank A in at 0xC000, 48K ROM selected.
+; Clobbers A, BC.
+;----------------------------------------------------------------------
+_level_page:
+    or BANK_ROM48
+    ld (BANKM), a
+    ld bc, BANK_PORT
+    out (c), a
+    ret
+
+;----------------------------------------------------------------------
+; _lz_unpack: decode one stream (format in make_level_pack.py)
+;   HL = packed stream, DE = destination
+;   Returns HL past the end marker, DE past the output. Clobbers A, BC.
+;
+; Literal run: 48T + 21T/byte. Match: 137T + 21T/byte.
+;----------------------------------------------------------------------
+_lz_unpack:
+    ld a, (hl)              ;  7T - token
+    inc hl                  ;  6T
+    or a                    ;  4T
+    ret z                   ;  5T - 0x00: end of stream
+    jp m, _lz_match         ; 10T - bit 7: back-reference
+
+    ld c, a                 ;  4T - 1..127 literal bytes
+    ld b, 0                 ;  7T
+    ldir                    ; 21T/byte
+    jp _lz_unpack           ; 10T
+
+_lz_match:
+    and 0x7F                ;  7T
+    add a, 3                ;  7T - length 3..130
+    ld c, a                 ;  4T
+    ld b, 0                 ;  7T
+    ld a, (hl)              ;  7T - offset low
+    inc hl                  ;  6T
+    push hl                 ; 11T
+    ld h, (hl)              ;  7T - offset high
+    ld l, a                 ;  4T
+    ld a, e                 ;  4T - HL = DE - offset
+    sub l                   ;  4T
+    ld l, a                 ;  4T
+    ld a, d                 ;  4T
+    sbc a, h                ;  4T
+    ld h, a                 ;  4T
+    ldir                    ; 21T/byte (overlap repeats, RLE-style)
+    pop hl                  ; 10T
+    inc hl                  ;  6T
+    jp _lz_unpack           ; 10T
+
+;----------------------------------------------------------------------
+; Level directory and tape bank table (make_level_pack.py)
+;----------------------------------------------------------------------
+    SECTION rodata_user
+
+    INCLUDE "level_pack.inc"
+
+;----------------------------------------------------------------------
+; Private stack while bank 0 is paged out (LD-BYTES and IM 1 included)
+;----------------------------------------------------------------------
+    SECTION bss_user
+
+_level_stack:
+    DEFS 64
+_level_stack_top:
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""Build a 128K level pack from a game manifest (config/*_game.json).
+
+Every level's tileset, map, occupancy bitmaps and HUD screen are built with
+generate_tiles / generate_map, compressed, and packed into the spare 128K RAM
+banks (1, 3, 4, 6, 7). At runtime level_pack.asm loads the banks from tape
+once (_level_pack_load) and _level_unpack pages a bank in at 0xC000 and
+unpacks one level into the fixed working addresses:
+
+  tiles      -> 0x6000 (2048 bytes, metatile dictionary at 0x6300)
+  map        -> MAP_ADDR (MAP_STRIDE x MAP_HEIGHT, in metatiles with --metatile)
+  occupancy  -> _map_row_occ (program image)
+  HUD        -> 0x4000 (6912-byte .scr)
+
+Usage:
+  make_level_pack.py game.json --size W H [--stride S] [--keep 1,3]
+                     [--fold-mirrors] [--attrs [--multicolour]] [--hud hud.scr]
+                     [--metatile N]
+
+All levels share the build's map size (MAP_WIDTH_TILES x MAP_HEIGHT_TILES);
+smaller levels are padded with tile 0. With --metatile N (2 or 4) every
+tileset must have N*8-pixel tiles and the sizes count metatiles. Writes level_pack.inc (directory for
+level_pack.asm), level_pack.h (LEVEL_COUNT) and levels.tap (one headerless
+block per bank).
+
+Compressed stream format (decoded by _lz_unpack):
+  0x00           end of stream
+  0x01-0x7F n    n literal bytes follow
+  0x80-0xFF      copy (t & 0x7F) + 3 bytes from 16-bit little-endian
+                 backward offset (overlapping copies repeat, as with LDIR)
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+from make_loader_tap import make_tap_block
+
+BANKS = [1, 3, 4, 6, 7]       # 2 and 5 are fixed at 0x8000/0x4000, 0 holds the stack
+BANK_ORG = 0xC000
+BANK_SIZE = 16384
+TILE_AREA_BYTES = 2048
+HUD_BYTES = 6912
+MATCH_MIN = 3
+MATCH_MAX = 0x7F + MATCH_MIN
+LITERAL_MAX = 0x7F
+CHAIN_LIMIT = 64
+
+# _lz_unpack cost per token (T-states, uncontended): fixed part + 21 per byte
+LITERAL_T = 48
+MATCH_T = 137
+BYTE_T = 21
+FRAME_T = 69888
+
+
+def lz_pack(data):
+    """Greedy LZ77 into the _lz_unpack format; returns (packed, est. T-states)."""
+    out = bytearray()
+    lits = bytearray()
+    chains = {}
+    tstates = 11                        # end marker (ret z taken)
+    i, n = 0, len(data)
+
+    def flush():
+        nonlocal tstates
+        for s in range(0, len(lits), LITERAL_MAX):
+            chunk = lits[s:s + LITERAL_MAX]
+            out.append(len(chunk))
+            out.extend(chunk)
+            tstates += LITERAL_T + BYTE_T * len(chunk)
+        lits.clear()
+
+    def insert(pos):
+        if pos + MATCH_MIN <= n:
+            chains.setdefault(bytes(data[pos:pos + MATCH_MIN]), []).append(pos)
+
+    while i < n:
+        best_len, best_off = 0, 0
+        if i + MATCH_MIN <= n:
+            for p in reversed(chains.get(bytes(data[i:i + MATCH_MIN]), [])[-CHAIN_LIMIT:]):
+                off = i - p
+                if off > 0xFFFF:
+                    break
+                l = 0
+                while i + l < n and l < MATCH_MAX and data[p + l] == data[i + l]:
+                    l += 1
+                if l > best_len:
+                    best_len, best_off = l, off
+                    if l == MATCH_MAX:
+                        break
+        # A 3-byte match costs as much as 3 literals; only take longer ones
+        if best_len > MATCH_MIN:
+            flush()
+            out.append(0x80 | (best_len - MATCH_MIN))
+            out.append(best_off & 0xFF)
+            out.append(best_off >> 8)
+            tstates += MATCH_T + BYTE_T * best_len
+            for k in range(best_len):
+                insert(i + k)
+            i += best_len
+        else:
+            lits.append(data[i])
+            insert(i)
+            i += 1
+    flush()
+    out.append(0)
+    return bytes(out), tstates
+
+
+def lz_unpack(packed):
+    """Reference decoder, used to check every stream before it is packed."""
+    out = bytearray()
+    i = 0
+    while packed[i]:
+        t = packed[i]
+        i += 1
+        if t < 0x80:
+            out.extend(packed[i:i + t])
+            i += t
+        else:
+            off = packed[i] | (packed[i + 1] << 8)
+            i += 2
+            for _ in range((t & 0x7F) + MATCH_MIN):
+                out.append(out[-off])
+    return bytes(out)
+
+
+def run(cmd, cwd):
+    r = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if r.returncode != 0:
+        sys.exit(f"Error: {' '.join(cmd)} failed:\n{r.stdout}")
+
+
+def read_file(path, size=None):
+    with open(path, 'rb') as f:
+        data = f.read()
+    if size is not None and len(data) != size:
+        sys.exit(f"Error: {path} is {len(data)} bytes, expected {size}")
+    return data
+
+
+def build_level(key, level, tilesets, args, tmp):
+    """Run the asset tools for one level; returns its four raw streams."""
+    w, h = level.get('width', args.size[0]), level.get('height', args.size[1])
+    if w > args.size[0] or h > args.size[1]:
+        sys.exit(f"Error: level {key} is {w}x{h}, larger than the {args.size[0]}x{args.size[1]} build map")
+    ts = tilesets.get(level.get('tileset'))
+    if not ts:
+        sys.exit(f"Error: level {key} uses unknown tileset {level.get('tileset')!r}")
+    tile_px = 8 * (args.metatile or 1)
+    if ts.get('tile_width', 8) != tile_px or ts.get('tile_height', 8) != tile_px:
+        sys.exit(f"Error: level {key} tileset is not {tile_px}x{tile_px}, as the build's map format needs")
+
+    here = os.getcwd()
+    tools = os.path.dirname(os.path.abspath(__file__))
+    csv = os.path.join(here, level['path'])
+    tiles_cmd = [os.path.join(tools, 'generate_tiles'), os.path.join(here, ts['path']), 'tiles.bin',
+                 str(ts.get('tile_width', 8)), str(ts.get('tile_height', 8)),
+                 '--optimise', 'remap.bin', '--freq', csv, '--keep', args.keep]
+    if args.fold_mirrors:
+        tiles_cmd.append('--fold-mirrors')
+    if args.attrs:
+        tiles_cmd.append('--attrs')
+    if args.multicolour:
+        tiles_cmd.append('--multicolour')
+    run(tiles_cmd, tmp)
+    map_cmd = [os.path.join(tools, 'generate_map'), '--stride', str(args.stride)]
+    if args.metatile:
+        map_cmd += ['--metatile', str(args.metatile)]
+    run(map_cmd + [csv, str(args.size[0]), str(args.size[1]), 'remap.bin'], tmp)
+
+    # Occupancy bitmaps count 8x8 cells
+    width, height = (n * (args.metatile or 1) for n in args.size)
+    occ_size = height * ((width + 7) // 8) + width * ((height + 7) // 8)
+    hud = os.path.join(here, level.get('hud', args.hud))
+    return [
+        ('tiles', read_file(os.path.join(tmp, 'tiles.bin'), TILE_AREA_BYTES)),
+        ('map', read_file(os.path.join(tmp, 'map.bin'), args.stride * args.size[1])),
+        ('occ', read_file(os.path.join(tmp, 'map_occ.bin'), occ_size)),
+        ('hud', read_file(hud, HUD_BYTES)),
+    ]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    ap.add_argument('game')
+    ap.add_argument('--size', nargs=2, type=int, required=True, metavar=('W', 'H'))
+    ap.add_argument('--stride', type=int, default=0)
+    ap.add_argument('--keep', default='1,3')
+    ap.add_argument('--fold-mirrors', action='store_true')
+    ap.add_argument('--attrs', action='store_true')
+    ap.add_argument('--multicolour', action='store_true')
+    ap.add_argument('--hud', default='hud.scr')
+    ap.add_argument('--metatile', type=int, default=0, choices=[0, 2, 4])
+    args = ap.parse_args()
+    if args.stride == 0:
+        args.stride = args.size[0]
+
+    with open(args.game) as f:
+        game = json.load(f)
+    levels = list(game.get('levels', {}).items())
+    if not levels:
+        sys.exit(f"Error: {args.game} has no levels")
+    if len(levels) > 255:
+        sys.exit("Error: at most 255 levels")
+    args.hud = game.get('hud', args.hud)
+
+    banks = []                  # [bank number, bytearray]
+    directory = []              # (key, name, bank, addr, packed size, raw size, est. T)
+    for key, level in levels:
+        with tempfile.TemporaryDirectory() as tmp:
+            streams = build_level(key, level, game.get('tilesets', {}), args, tmp)
+        blob = bytearray()
+        tstates = 0
+        for name, raw in streams:
+            packed, t = lz_pack(raw)
+            if lz_unpack(packed) != raw:
+                sys.exit(f"Error: level {key} {name} stream failed to round-trip")
+            blob += packed
+            tstates += t
+        if len(blob) > BANK_SIZE:
+            sys.exit(f"Error: level {key} packs to {len(blob)} bytes, more than one bank")
+        slot = next((b for b in banks if len(b[1]) + len(blob) <= BANK_SIZE), None)
+        if slot is None:
+            if len(banks) == len(BANKS):
+                sys.exit(f"Error: level {key} does not fit in banks {BANKS}")
+            slot = [BANKS[len(banks)], bytearray()]
+            banks.append(slot)
+        raw_size = sum(len(raw) for _, raw in streams)
+        directory.append((key, level.get('name', key), slot[0], BANK_ORG + len(slot[1]),
+                          len(blob), raw_size, tstates))
+        slot[1] += blob
+
+    with open('level_pack.inc', 'w') as f:
+        f.write("; Generated by make_level_pack.py - do not edit\n")
+        f.write(f"; {args.game}: {len(directory)} level(s) in {len(banks)} bank(s)\n\n")
+        f.write(f"LEVEL_COUNT      EQU {len(directory)}\n")
+        f.write(f"LEVEL_BANK_COUNT EQU {len(banks)}\n\n")
+        f.write("; Level directory: RAM bank, address of the packed streams at 0xC000\n")
+        f.write("_level_dir:\n")
+        for key, name, bank, addr, size, raw_size, t in directory:
+            f.write(f"    DEFB {bank}\n    DEFW 0x{addr:04X}    ; {key}: {name} ({size} bytes)\n")
+        f.write("\n; Tape blocks in levels.tap: RAM bank, block length\n")
+        f.write("_level_bank_table:\n")
+        for bank, data in banks:
+            f.write(f"    DEFB {bank}\n    DEFW {len(data)}\n")
+
+    with open('level_pack.h', 'w') as f:
+        f.write("// Generated by make_level_pack.py - do not edit\n")
+        f.write("#ifndef LEVEL_PACK_H\n#define LEVEL_PACK_H\n\n")
+        f.write(f"#define LEVEL_COUNT {len(directory)}\n\n")
+        f.write("#endif // LEVEL_PACK_H\n")
+
+    with open('levels.tap', 'wb') as f:
+        for bank, data in banks:
+            f.write(make_tap_block(0xFF, bytes(data)))
+
+    print(f"Level pack: {len(directory)} level(s), {len(banks)} bank(s), "
+          f"{sum(len(d) for _, d in banks)} bytes")
+    for key, name, bank, addr, size, raw_size, t in directory:
+        print(f"  {key:<12} bank {bank} @0x{addr:04X}  {size:5d} of {raw_size} bytes  "
+              f"unpack ~{t} T ({t / FRAME_T:.1f} frames)")
+
+
+if __name__ == '__main__':
+    main()
@@ -7,10 +7,15 @@ The loader does:
   30 LOAD "" CODE
   40 RANDOMIZE USR 32768
 
-This loads tile data (at 0x5B00) and main code (at 0x8000) as separate
+This loads tile data (at 0x6000) and main code (at 0x8000) as separate
 CODE blocks, then executes the main program.
+
+Usage: make_loader_tap.py [--blocks N] [--out loader.tap]
+  --blocks: number of LOAD "" CODE lines (1 for the level-pack build, whose
+            program loads its own data from tape)
 """
 
+import argparse
 import struct
 
 def make_tap_block(flag, data):
@@ -42,32 +47,38 @@ TK_RAND  = b'\xf9'    # RANDOMIZE
 TK_USR   = b'\xc0'    # USR
 TK_QUOTE = b'"'
 
-# Line 10: CLEAR 24575 (protects 0x6000 upward from BASIC)
-line10 = make_basic_line(10, TK_CLEAR + num_token(24575))
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('--blocks', type=int, default=2)
+    ap.add_argument('--out', default='loader.tap')
+    args = ap.parse_args()
+
+    # Line 10: CLEAR 24575 (protects 0x6000 upward from BASIC)
+    basic_data = make_basic_line(10, TK_CLEAR + num_token(24575))
 
-# Line 20: LOAD "" CODE
-line20 = make_basic_line(20, TK_LOAD + TK_QUOTE + TK_QUOTE + TK_CODE)
+    # Lines 20, 30, ...: LOAD "" CODE
+    for i in range(args.blocks):
+        basic_data += make_basic_line(20 + 10 * i, TK_LOAD + TK_QUOTE + TK_QUOTE + TK_CODE)
 
-# Line 30: LOAD "" CODE
-line30 = make_basic_line(30, TK_LOAD + TK_QUOTE + TK_QUOTE + TK_CODE)
+    # Last line: RANDOMIZE USR 32768
+    basic_data += make_basic_line(20 + 10 * args.blocks, TK_RAND + TK_USR + num_token(32768))
 
-# Line 40: RANDOMIZE USR 32768
-line40 = make_basic_line(40, TK_RAND + TK_USR + num_token(32768))
+    # Header block: type 0 = Program
+    # Filename: 10 chars padded with spaces
+    filename = b'loader    '
+    # param1 = autostart line (10), param2 = start of variable area (= length of program)
+    header_data = bytes([0x00]) + filename + struct.pack('<H', len(basic_data)) + struct.pack('<H', 10) + struct.pack('<H', len(basic_data))
 
-basic_data = line10 + line20 + line30 + line40
+    # Data block
+    header_block = make_tap_block(0x00, header_data)
+    data_block = make_tap_block(0xFF, basic_data)
 
-# Header block: type 0 = Program
-# Filename: 10 chars padded with spaces
-filename = b'loader    '
-# param1 = autostart line (10), param2 = start of variable area (= length of program)
-header_data = bytes([0x00]) + filename + struct.pack('<H', len(basic_data)) + struct.pack('<H', 10) + struct.pack('<H', len(basic_data))
+    with open(args.out, 'wb') as f:
+        f.write(header_block)
+        f.write(data_block)
 
-# Data block
-header_block = make_tap_block(0x00, header_data)
-data_block = make_tap_block(0xFF, basic_data)
+    print(f"Created {args.out} ({len(basic_data)} bytes of BASIC)")
 
-with open('loader.tap', 'wb') as f:
-    f.write(header_block)
-    f.write(data_block)
 
-print(f"Created loader.tap ({len(basic_data)} bytes of BASIC)")
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,592 @@
+; multicolour.asm - Multicolour viewport: 8x2 attributes by beam-synced raster
+; Each 2-scanline band of a viewport char row gets its own attribute row.
+; The colours live in a band buffer (mc_bands, tile_render.c); once per frame
+; _mc_raster syncs to the beam above the viewport and rewrites the char row's
+; attributes for every band just after the beam has used the previous band's,
+; 64 times down the viewport, in a loop with a fixed period of 2 lines.
+;
+; Public routines:
+;   _mc_raster     - sync on the floating bus and write the 64 bands
+;                    (returns below the viewport, ~32,100 T from the sentinel)
+;   _mc_init_sync  - write the floating-bus sentinel rows above the viewport
+;   _mc_colour_row - band colours of one viewport row from the map (~5,400 T)
+;
+; Timing (48K, 224 T per line; MC_LINE_T=228 for the 128K machines):
+;   one band = 2 lines = 448 T: fetch 192 T, push 153 T,
+;   pad 103 T - MC_CONTENTION_T
+; The band window for each attribute column is one line long. Columns 15-0
+; are pushed first, right to left, so column 0 lands well before its fetch;
+; columns 19-16 follow, a line behind the beam. Some push writes always land
+; while the ULA fetches, and contention stretches the band: the pads leave
+; MC_CONTENTION_T for it. On asm_check's contention model the loop locks to
+; the beam for MC_CONTENTION_T 13-19 and MC_PUSH_PHASE 50-90 (burst start
+; after the column 0 fetch on the line before), with a band margin of 24 T
+; at 224 and at 228 T per line; the defaults are the middle of both ranges.
+;
+; 128K safe: the floating bus is read with IN A,(C), BC = 0xBFFF. A0 and A1
+; are set, so neither the ULA, the 128K paging port nor the AY decodes it,
+; and the high byte is outside 0x40-0x7F and 0xC0-0xFF, so the read is
+; uncontended whatever bank is paged: a sample lands at the same T-state of
+; the line on every frame. Without a floating bus (+2A/+3)
+; the first sync times out (~88,000 T, ~74,000 T at 228) and the raster
+; stays off: the viewport keeps its plain attributes.
+
+    SECTION code_user
+
+    PUBLIC _mc_raster
+    PUBLIC _mc_init_sync
+    PUBLIC _mc_colour_row
+
+    EXTERN _mc_src
+
+    INCLUDE "viewport.inc"
+
+; Beam-sync sentinel: FLASH white on white in 16 columns of the char row
+; two above the viewport, from the first even column past the viewport's
+; left HUD frame, then white on white in the row between, which marks the
+; sentinel's last line. The pixels of both rows are cleared there so only
+; the attribute fetches show 0xBF / 0x3F on the bus; on the HUD's blank
+; white paper (0x38) the strip looks unchanged. The HUD must leave those
+; cells blank, and must not use either attribute elsewhere in the two rows
+; nor in the cell two columns left of the sentinel (it ends the fine sync).
+; The sentinel must have FLASH and the row between not: the sync tells
+; them apart by the carry of CP SENTINEL_ATTR.
+SENTINEL_ATTR           EQU 0xBF
+SENTINEL_END_ATTR       EQU 0x3F
+SENTINEL_ROW            EQU VIEWPORT_START_CHAR_ROW - 2
+SENTINEL_COL            EQU (VIEWPORT_COL_OFFSET + 3) / 2 * 2
+SENTINEL_COLS           EQU 16      ; of the 20 viewport columns
+SENTINEL_ADDR           EQU 0x5800 + SENTINEL_ROW * 32 + SENTINEL_COL
+SENTINEL_SCR            EQU 0x4000 + (SENTINEL_ROW / 8) * 2048 + (SENTINEL_ROW % 8) * 32 + SENTINEL_COL
+SENTINEL_END_SCR        EQU 0x4000 + ((SENTINEL_ROW + 1) / 8) * 2048 + ((SENTINEL_ROW + 1) % 8) * 32 + SENTINEL_COL
+FLOAT_PORT              EQU SENTINEL_ATTR * 256 + 0xFF  ; B = SENTINEL_ATTR for CP B
+MC_SYNC_TIMEOUT         EQU 900     ; coarse poll counts: a frame and a bit
+
+; Band buffer layout (tile_render.h MC_BAND_BYTES / MC_ROW_BYTES) and the
+; band tables from generate_tiles --multicolour at 0x6400 + band * 256
+MC_PAGE                 EQU 0x64
+MC_BAND_BYTES           EQU 2 * VIEWPORT_COLS
+MC_ATTR_ROW0_MID        EQU 0x5800 + VIEWPORT_START_CHAR_ROW * 32 + VIEWPORT_COL_OFFSET + 16
+
+    IFNDEF MC_LINE_T
+MC_LINE_T               EQU 224     ; 228 on the 128K machines
+    ENDIF
+    IFNDEF MC_PUSH_PHASE
+MC_PUSH_PHASE           EQU 70      ; burst start after the column 0 fetch
+    ENDIF
+    IFNDEF MC_CONTENTION_T
+MC_CONTENTION_T         EQU 15      ; contention per band (asm_check)
+    ENDIF
+MC_BAND_T               EQU 2 * MC_LINE_T
+MC_PUSH_AT              EQU 192     ; band start to first push
+MC_BAND_WORK            EQU 345     ; band fetch + push
+MC_ROW_END_WORK         EQU 84      ; next attribute row, row count
+
+; Coarse poll: two samples per count (PAD_POLL apart), and PAD_FAIL after a
+; failed double-check. The pair depends on the line length: these are the
+; values for which every start phase hits the 16-column sentinel by its
+; sixth line and ends the fine sync by the second line of the row between
+; (simulated; asm_check runs the raster from random starts).
+    IF MC_LINE_T == 224
+PAD_POLL                EQU 23      ; samples 49 T apart, 75 T after a fail
+PAD_FAIL                EQU 13
+    ELSE
+PAD_POLL                EQU 7       ; 33 T then 49 T, 70 T after a fail
+PAD_FAIL                EQU 8
+    ENDIF
+MC_POLL_T               EQU 75 + PAD_POLL   ; one count
+
+; Pads: P T-states as "ld a, 0" (7) if P mod 4 is odd, "inc hl" (6) if it
+; is 1 or 2, then nops. A and HL are free at every pad (in the coarse poll
+; HL is the timeout count: an inc only shortens it); neither touches the
+; flags. P must be 0, 4, 6, 7, 8 or at least 10. The phase pad assumes the
+; ULA's byte is latched at T 11 of IN A,(C).
+PAD_PRE                 EQU MC_LINE_T - 67          ; hit -> first fine sample
+PAD_FINE                EQU MC_LINE_T - 71          ; fine loop: 8 T earlier per line
+PAD_EDGE                EQU 11                      ; edge sample -> sync point
+PAD_DOWN                EQU MC_LINE_T - 44          ; edge sample -> first end sample
+PAD_END                 EQU MC_LINE_T - 39          ; end loop: one line
+PAD_LINE                EQU MC_LINE_T - 14          ; wait loop: one line
+PAD_PHASE               EQU 2 * MC_LINE_T + MC_PUSH_PHASE - 300 + (MC_LINE_T - 224) / 2 - 4 * (SENTINEL_COL - VIEWPORT_COL_OFFSET) - 2 * (VIEWPORT_COL_OFFSET % 2)
+PAD_BAND                EQU MC_BAND_T - MC_BAND_WORK - MC_CONTENTION_T
+PAD_ROW                 EQU PAD_BAND - MC_ROW_END_WORK
+
+PAD_POLL_A  EQU (PAD_POLL % 4 == 1) || (PAD_POLL % 4 == 3)
+PAD_POLL_H  EQU (PAD_POLL % 4 == 1) || (PAD_POLL % 4 == 2)
+PAD_POLL_N  EQU (PAD_POLL - 7 * PAD_POLL_A - 6 * PAD_POLL_H) / 4
+PAD_FAIL_A  EQU (PAD_FAIL % 4 == 1) || (PAD_FAIL % 4 == 3)
+PAD_FAIL_H  EQU (PAD_FAIL % 4 == 1) || (PAD_FAIL % 4 == 2)
+PAD_FAIL_N  EQU (PAD_FAIL - 7 * PAD_FAIL_A - 6 * PAD_FAIL_H) / 4
+PAD_PRE_A   EQU (PAD_PRE % 4 == 1) || (PAD_PRE % 4 == 3)
+PAD_PRE_H   EQU (PAD_PRE % 4 == 1) || (PAD_PRE % 4 == 2)
+PAD_PRE_N   EQU (PAD_PRE - 7 * PAD_PRE_A - 6 * PAD_PRE_H) / 4
+PAD_FINE_A  EQU (PAD_FINE % 4 == 1) || (PAD_FINE % 4 == 3)
+PAD_FINE_H  EQU (PAD_FINE % 4 == 1) || (PAD_FINE % 4 == 2)
+PAD_FINE_N  EQU (PAD_FINE - 7 * PAD_FINE_A - 6 * PAD_FINE_H) / 4
+PAD_EDGE_A  EQU (PAD_EDGE % 4 == 1) || (PAD_EDGE % 4 == 3)
+PAD_EDGE_H  EQU (PAD_EDGE % 4 == 1) || (PAD_EDGE % 4 == 2)
+PAD_EDGE_N  EQU (PAD_EDGE - 7 * PAD_EDGE_A - 6 * PAD_EDGE_H) / 4
+PAD_DOWN_A  EQU (PAD_DOWN % 4 == 1) || (PAD_DOWN % 4 == 3)
+PAD_DOWN_H  EQU (PAD_DOWN % 4 == 1) || (PAD_DOWN % 4 == 2)
+PAD_DOWN_N  EQU (PAD_DOWN - 7 * PAD_DOWN_A - 6 * PAD_DOWN_H) / 4
+PAD_END_A   EQU (PAD_END % 4 == 1) || (PAD_END % 4 == 3)
+PAD_END_H   EQU (PAD_END % 4 == 1) || (PAD_END % 4 == 2)
+PAD_END_N   EQU (PAD_END - 7 * PAD_END_A - 6 * PAD_END_H) / 4
+PAD_LINE_A  EQU (PAD_LINE % 4 == 1) || (PAD_LINE % 4 == 3)
+PAD_LINE_H  EQU (PAD_LINE % 4 == 1) || (PAD_LINE % 4 == 2)
+PAD_LINE_N  EQU (PAD_LINE - 7 * PAD_LINE_A - 6 * PAD_LINE_H) / 4
+PAD_PHASE_A EQU (PAD_PHASE % 4 == 1) || (PAD_PHASE % 4 == 3)
+PAD_PHASE_H EQU (PAD_PHASE % 4 == 1) || (PAD_PHASE % 4 == 2)
+PAD_PHASE_N EQU (PAD_PHASE - 7 * PAD_PHASE_A - 6 * PAD_PHASE_H) / 4
+PAD_BAND_A  EQU (PAD_BAND % 4 == 1) || (PAD_BAND % 4 == 3)
+PAD_BAND_H  EQU (PAD_BAND % 4 == 1) || (PAD_BAND % 4 == 2)
+PAD_BAND_N  EQU (PAD_BAND - 7 * PAD_BAND_A - 6 * PAD_BAND_H) / 4
+PAD_ROW_A   EQU (PAD_ROW % 4 == 1) || (PAD_ROW % 4 == 3)
+PAD_ROW_H   EQU (PAD_ROW % 4 == 1) || (PAD_ROW % 4 == 2)
+PAD_ROW_N   EQU (PAD_ROW - 7 * PAD_ROW_A - 6 * PAD_ROW_H) / 4
+
+; Worst cases for asm_timing: the raster includes a full coarse timeout, and
+; 24 lines for the fine sync, the wait and up to 16 failed double-checks
+BUDGET_MCR      EQU MC_SYNC_TIMEOUT * MC_POLL_T + VIEWPORT_CHAR_ROWS * 4 * MC_BAND_T + 24 * MC_LINE_T
+BUDGET_MCCR     EQU 4 * (VIEWPORT_COLS * 75 + 300) + 150
+
+;----------------------------------------------------------------------
+; _mc_init_sync
+; Write the sentinel rows (attributes and cleared pixels) above the
+; viewport: SENTINEL_COLS cells from SENTINEL_COL, SENTINEL_ATTR on row
+; VIEWPORT_START_CHAR_ROW - 2 and SENTINEL_END_ATTR on the row between.
+; Call after loading the HUD (see the sentinel's HUD rules above).
+;----------------------------------------------------------------------
+_mc_init_sync:
+    ld hl, SENTINEL_ADDR
+    ld a, SENTINEL_ATTR
+    call _mcis_attr
+    ld a, SENTINEL_END_ATTR
+    call _mcis_attr         ; the row between, contiguous in the attributes
+    ld de, SENTINEL_SCR
+    call _mcis_row
+    ld de, SENTINEL_END_SCR
+
+_mcis_row:
+    ld c, 8                 ; scanlines of the char row
+_mcis_line:
+    ld h, d
+    ld l, e
+    xor a
+    ld b, SENTINEL_COLS
+_mcis_byte:
+    ld (hl), a
+    inc hl
+    djnz _mcis_byte
+    inc d                   ; next scanline of the char row
+    dec c
+    jr nz, _mcis_line
+    ret
+
+_mcis_attr:
+    ld b, SENTINEL_COLS
+_mcis_cell:
+    ld (hl), a
+    inc hl
+    djnz _mcis_cell
+    ld de, 32 - SENTINEL_COLS
+    add hl, de              ; next attribute row
+    ret
+
+;----------------------------------------------------------------------
+; _mc_raster
+; Wait for the beam to reach the sentinel row, find the sentinel's left
+; edge to 8 T, count down to the line above the viewport and write each
+; band's attribute row from _mc_src (64 entries, band-major per char row:
+; the address of the band's VIEWPORT_COLS colours in the band buffer).
+;
+; Sync: the sentinel shows on the bus only at the attribute fetches, two
+; T-states of each 8. The coarse poll takes two samples per count, spaced
+; for the line length (PAD_POLL), so one of them lands on an attribute
+; fetch by the sentinel's sixth line; a hit must still be the sentinel 26 T
+; later, at the next column's attribute. The fine loop then samples once
+; per line, 8 T earlier each time, until the sample falls off the
+; sentinel's left edge: that fixes the beam phase to the T-state. Every
+; sample in the window also tells the two sentinel rows apart; the lines
+; of the row between seen so far (D, 1 or 2) fix the line. The wait loop
+; counts the lines left so band 0 starts at the same point every frame.
+;
+; Per band: SP walks _mc_src (pop the band's address), then the band's 20
+; bytes are popped into AF, BC, DE, HL, AF', BC', DE', HL', IX, IY. The
+; eight pairs are pushed into the attribute row from column 16 down, then
+; IY and IX from its end. 448 T per band with MC_CONTENTION_T.
+;
+; void mc_raster(void)
+;
+; T-states: ~28,700 for the bands + the wait for the sentinel (call it in
+;           the top border, before char row VIEWPORT_START_CHAR_ROW - 2)
+; @budget BUDGET_MCR
+;----------------------------------------------------------------------
+_mc_raster:
+    ld a, (_mcr_off)        ; 13T
+    or a                    ;  4T
+    ret nz                  ;  5T - no floating bus: raster off
+    push ix                 ; save SDCC frame pointer
+    push iy
+    di
+    ld (_mcr_save_sp+1), sp ; save SP (self-modifying)
+    ld hl, _mc_src
+    ld (_mcr_tbl), hl
+    ld hl, MC_ATTR_ROW0_MID
+    ld (_mcr_dst), hl
+    ld a, VIEWPORT_CHAR_ROWS
+    ld (_mcr_rows), a
+
+    ; Coarse sync: poll for the sentinel, double-checked
+    ld bc, FLOAT_PORT       ; B = SENTINEL_ATTR
+    ld hl, -MC_SYNC_TIMEOUT
+    ld de, 1
+_mcr_poll:
+    in a, (c)               ; 12T
+    cp b                    ;  4T
+    jp z, _mcr_check        ; 10T
+    IF PAD_POLL_A
+    ld a, 0
+    ENDIF
+    IF PAD_POLL_H
+    inc hl
+    ENDIF
+    REPT PAD_POLL_N
+    nop
+    ENDR
+    in a, (c)               ; 12T
+    cp b                    ;  4T
+    jp z, _mcr_check        ; 10T
+    add hl, de              ; 11T
+    jr nc, _mcr_poll        ; 12T  @loop 1..MC_SYNC_TIMEOUT
+    ld a, 1                 ; no floating bus: leave the attributes alone,
+    ld (_mcr_off), a        ; and do not wait a frame for them again
+    jp _mcr_save_sp
+_mcr_check:
+    in a, (c)               ; 12T - double-check: the next attribute fetch
+    cp b                    ;  4T
+    jp z, _mcr_hit          ; 10T
+    IF PAD_FAIL_A
+    ld a, 0
+    ENDIF
+    IF PAD_FAIL_H
+    inc hl
+    ENDIF
+    REPT PAD_FAIL_N
+    nop
+    ENDR
+    jp _mcr_poll            ; 10T  @taken 16 (once a line on the sentinel's end)
+
+_mcr_hit:
+    ; Fine sync: one sample per line, 8 T earlier each time
+    ld d, 0                 ;  7T - D = lines of the row between seen
+    IF PAD_PRE_A
+    ld a, 0
+    ENDIF
+    IF PAD_PRE_H
+    inc hl
+    ENDIF
+    REPT PAD_PRE_N
+    nop
+    ENDR
+_mcr_fine:
+    in a, (c)               ; 12T
+    cp b                    ;  4T - the sentinel row
+    jr z, _mcr_fine_a       ;  7T
+    cp SENTINEL_END_ATTR    ;  7T - the row between
+    jr nz, _mcr_edge        ;  7T - anything else: left of the window
+    inc d                   ;  4T
+    jr _mcr_fine_b          ; 12T
+_mcr_fine_a:
+    ld a, 0                 ;  7T - as long as the row between's path
+    inc hl                  ;  6T
+    nop                     ;  4T
+    nop                     ;  4T
+    nop                     ;  4T
+_mcr_fine_b:
+    IF PAD_FINE_A
+    ld a, 0
+    ENDIF
+    IF PAD_FINE_H
+    inc hl
+    ENDIF
+    REPT PAD_FINE_N
+    nop
+    ENDR
+    jp _mcr_fine            ; 10T  @loop 1..7
+
+_mcr_edge:
+    ; The phase is known: sample this line's row 48 T on, in the window
+    inc hl                  ;  6T
+    in a, (c)               ; 12T
+    cp SENTINEL_ATTR        ;  7T - C: the row between
+    ld a, d                 ;  4T
+    adc a, 0                ;  7T
+    ld d, a                 ;  4T
+    jp z, _mcr_down         ; 10T - still on the sentinel row
+    IF PAD_EDGE_A
+    ld a, 0
+    ENDIF
+    IF PAD_EDGE_H
+    inc hl
+    ENDIF
+    REPT PAD_EDGE_N
+    nop
+    ENDR
+    jp _mcr_sync            ; 10T
+
+_mcr_down:
+    ; Sample once per line, same phase, until the row between shows
+    IF PAD_DOWN_A
+    ld a, 0
+    ENDIF
+    IF PAD_DOWN_H
+    inc hl
+    ENDIF
+    REPT PAD_DOWN_N
+    nop
+    ENDR
+_mcr_end:
+    in a, (c)               ; 12T
+    cp SENTINEL_ATTR        ;  7T - C: the row between
+    jp c, _mcr_end_hit      ; 10T
+    IF PAD_END_A
+    ld a, 0
+    ENDIF
+    IF PAD_END_H
+    inc hl
+    ENDIF
+    REPT PAD_END_N
+    nop
+    ENDR
+    jp _mcr_end             ; 10T  @loop 1..5
+_mcr_end_hit:
+    ld d, 1                 ;  7T - first line of the row between
+    ld a, 0                 ;  7T - as far from the sample as the edge path
+    inc hl                  ;  6T
+    nop                     ;  4T
+    nop                     ;  4T
+    nop                     ;  4T
+    nop                     ;  4T
+
+_mcr_sync:
+    ; D = lines of the row between up to the last sample: wait 6 - D lines
+    ; (D is 1 or 2)
+    ld a, 6                 ;  7T
+    sub d                   ;  4T
+    ld e, a                 ;  4T
+_mcr_line:
+    IF PAD_LINE_A
+    ld a, 0
+    ENDIF
+    IF PAD_LINE_H
+    inc hl
+    ENDIF
+    REPT PAD_LINE_N
+    nop
+    ENDR
+    dec e                   ;  4T
+    jp nz, _mcr_line        ; 10T  @loop 4..5
+    IF PAD_PHASE_A
+    ld a, 0
+    ENDIF
+    IF PAD_PHASE_H
+    inc hl
+    ENDIF
+    REPT PAD_PHASE_N
+    nop
+    ENDR
+
+_mcr_row:
+    REPT 3
+    ld sp, (_mcr_tbl)       ; 20T - next _mc_src entry
+    pop hl                  ; 10T - HL = this band's colours
+    ld (_mcr_tbl), sp       ; 20T
+    ld sp, hl               ;  6T
+    pop af                  ; 10T - columns 0-7
+    pop bc                  ; 10T
+    pop de                  ; 10T
+    pop hl                  ; 10T
+    exx                     ;  4T
+    ex af, af'              ;  4T
+    pop af                  ; 10T - columns 8-15
+    pop bc                  ; 10T
+    pop de                  ; 10T
+    pop hl                  ; 10T
+    pop ix                  ; 14T - columns 16-17
+    pop iy                  ; 14T - columns 18-19
+    ld sp, (_mcr_dst)       ; 20T - column 16 of the char row's attributes
+    push hl                 ; 11T - columns 15-0, right to left
+    push de                 ; 11T
+    push bc                 ; 11T
+    push af                 ; 11T
+    exx                     ;  4T
+    ex af, af'              ;  4T
+    push hl                 ; 11T
+    push de                 ; 11T
+    push bc                 ; 11T
+    push af                 ; 11T
+    ld hl, VIEWPORT_COLS    ; 10T
+    add hl, sp              ; 11T
+    ld sp, hl               ;  6T - end of the char row's attributes
+    push iy                 ; 15T - columns 19-16, a line behind the rest
+    push ix                 ; 15T
+    IF PAD_BAND_A
+    ld a, 0
+    ENDIF
+    IF PAD_BAND_H
+    inc hl
+    ENDIF
+    REPT PAD_BAND_N
+    nop
+    ENDR
+    ENDR
+    ld sp, (_mcr_tbl)       ; 20T - fourth band: same as above
+    pop hl
+    ld (_mcr_tbl), sp
+    ld sp, hl
+    pop af
+    pop bc
+    pop de
+    pop hl
+    exx
+    ex af, af'
+    pop af
+    pop bc
+    pop de
+    pop hl
+    pop ix
+    pop iy
+    ld sp, (_mcr_dst)
+    push hl
+    push de
+    push bc
+    push af
+    exx
+    ex af, af'
+    push hl
+    push de
+    push bc
+    push af
+    ld hl, VIEWPORT_COLS
+    add hl, sp
+    ld sp, hl
+    push iy
+    push ix
+    IF PAD_ROW_A
+    ld a, 0
+    ENDIF
+    IF PAD_ROW_H
+    inc hl
+    ENDIF
+    REPT PAD_ROW_N
+    nop
+    ENDR
+    ld hl, (_mcr_dst)       ; 16T
+    ld de, 32               ; 10T
+    add hl, de              ; 11T
+    ld (_mcr_dst), hl       ; 16T - next char row's attributes
+    ld hl, _mcr_rows        ; 10T
+    dec (hl)                ; 11T
+    jp nz, _mcr_row         ; 10T  @loop VIEWPORT_CHAR_ROWS
+
+_mcr_save_sp:
+    ld sp, 0                ; self-mod: restored SP
+    pop iy
+    pop ix
+    ei
+    ret
+
+_mcr_tbl:
+    DEFW 0                  ; next _mc_src entry
+_mcr_dst:
+    DEFW 0                  ; column 16 of the current attribute row
+_mcr_rows:
+    DEFB 0
+_mcr_off:
+    DEFB 0                  ; 1 once the coarse sync has timed out
+
+;----------------------------------------------------------------------
+; _mc_colour_row
+; Write the band colours of one viewport row into its band buffer row:
+; four band rows, each holding the row's colours twice so that any window
+; of VIEWPORT_COLS bytes is the row scrolled (a horizontal step moves the
+; window start h instead of the colours). The window [h, h + COLS) is
+; written from the map through the band tables, then wrapped into the
+; other copy with two LDIRs.
+;
+; void mc_colour_row(unsigned char h, unsigned char *ring_row, const unsigned char *map_row_ptr)
+;   h:           window start of the row, 0..VIEWPORT_COLS-1
+;   ring_row:    band 0 of the row in the band buffer (MC_BAND_BYTES per band)
+;   map_row_ptr: &map_data[map_y * MAP_STRIDE + camera_tile_x]
+;
+; T-states: ~5,400 (4 bands × (20 tiles × 33T + ~690))
+; @budget BUDGET_MCCR
+;----------------------------------------------------------------------
+_mc_colour_row:
+    ; SP+2 = h, SP+3,4 = ring_row, SP+5,6 = map_row_ptr
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    ld (_mccr_h+1), a       ; window start (self-mod)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = band 0 row
+    inc hl
+    ld a, (hl)
+    inc hl
+    ld h, (hl)
+    ld l, a
+    ld (_mccr_map+1), hl    ; map row (self-mod)
+    ld b, MC_PAGE           ; B = band 0 table
+
+_mccr_band:
+    push de                 ; 11T - band row
+    push bc                 ; 11T - band table page
+_mccr_h:
+    ld hl, 0                ; 10T - h (self-mod low byte)
+    add hl, de              ; 11T
+    ex de, hl               ;  4T - DE = window start
+_mccr_map:
+    ld hl, 0                ; 10T - map row (self-mod)
+    REPT VIEWPORT_COLS
+    ld c, (hl)              ;  7T - map byte
+    ld a, (bc)              ;  7T - its colour in this band
+    ld (de), a              ;  7T
+    inc hl                  ;  6T
+    inc de                  ;  6T
+    ENDR
+
+    ; Wrap: [0, h) <- [COLS, COLS + h), then [COLS + h, 2 COLS) <- [h, COLS)
+    pop bc                  ; 10T
+    pop de                  ; 10T - band row
+    push bc                 ; 11T
+    push de                 ; 11T
+    ld hl, VIEWPORT_COLS    ; 10T
+    add hl, de              ; 11T - HL = row + COLS
+    ld a, (_mccr_h+1)       ; 13T
+    or a                    ;  4T
+    jr z, _mccr_tail        ; 12T - h = 0: the window is the first copy
+    ld c, a
+    ld b, 0
+    ldir                    ; 21T/byte  @loop 1..VIEWPORT_COLS-1
+_mccr_tail:
+    ex de, hl               ;  4T - HL = row + h, DE = row + COLS + h
+    ld a, (_mccr_h+1)       ; 13T
+    neg                     ;  8T
+    add a, VIEWPORT_COLS    ;  7T
+    ld c, a
+    ld b, 0
+    ldir                    ; 21T/byte  @loop 1..VIEWPORT_COLS
+
+    pop de                  ; 10T
+    ld hl, MC_BAND_BYTES    ; 10T
+    add hl, de              ; 11T
+    ex de, hl               ;  4T - DE = next band row
+    pop bc                  ; 10T
+    inc b                   ;  4T - next band table
+    ld a, b                 ;  4T
+    cp MC_PAGE + 4          ;  7T
+    jp nz, _mccr_band       ; 10T  @loop 4
+    ret
@@ -0,0 +1,515 @@
+// Headless input-trace replay for the scroller.
+// Runs scroll_CODE.bin + contended_data.bin on the host Z80 core, feeding
+// keyboard input from a recorded trace. Every 69888 T frame is timed: a
+// step that runs through interrupts must HALT within the trace's frame
+// limit, and a frame in which the loop HALTs (idle service, redraw row, or
+// the last frame of a step at the limit) must fit the trace's T-state budget.
+// The sequence of distinct screen states (screen CRC + border) is compared
+// against a golden capture; the frame a state appears in is not, so a
+// timing change alone does not fail it.
+//
+// Usage: ./replay_trace [options] <trace> [<trace> ...]
+//   --code <file>      main program image loaded at 0x8000 (scroll_CODE.bin)
+//   --data <file>      contended data image loaded at 0x6000 (contended_data.bin)
+//   --rom <file>       16K ROM image (default: IM1 stub, EI/RET at 0x0038)
+//   --golden <dir>     golden capture directory (default traces/golden)
+//   --record           write golden captures instead of checking them
+//   --budget <T>       override the trace's per-frame budget
+//   --frames <n>       override the trace's frame limit per step
+//   --dump <dir>       write .scr snapshots of mismatching frames
+//   --no-contention    disable the 48K memory contention model
+//   --verbose          print every frame's busy T-states
+//
+// Trace format (text, one directive per line, '#' starts a comment):
+//   budget <T>         max busy T-states in an idle frame and in the last
+//                      frame of a step that takes the whole frame limit
+//                      (default a whole frame)
+//   frames <n>         max frames from a step's wake-up to its HALT; with
+//                      budget, a step must fit in n - 1 frames + budget T
+//   <frames> <keys>    hold <keys> for <frames> frames; keys are any of
+//                      U D L R (Q/A/O/P), S (SPACE: dash), H (camera jump),
+//                      N (next level), or '-' for no input
+//   tap <keys> <n>     press <keys> for 1 frame, then release until the loop
+//                      has idled SCROLL_INTERVAL frames, n times: exactly
+//                      one scroll step per tap, however long the step takes
+//
+// A hold is frame-based, so how far it moves depends on the step timing;
+// traces use taps where a golden should survive a timing change.
+//
+// Exit status is non-zero if any frame exceeds its budget, any step its
+// frame limit, or any screen state differs from (or is missing from) the
+// golden capture.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "z80_core.h"
+
+#define SCREEN_ADDR      0x4000
+#define SCREEN_BYTES     6912
+#define CODE_ORG         0x8000
+#define DATA_ORG         0x6000
+#define START_SP         0x5FFE
+#define MAX_STEPS        4096
+#define MAX_STATES       65536
+#define STARTUP_FRAMES   8      // boot-time full render is reported but not gated
+#define TAP_IDLE_FRAMES  3      // SCROLL_INTERVAL: idle frames before a press is seen
+#define TAP_MAX_FRAMES   100    // a tap whose step never ends fails the trace
+
+// Direction bits (match read_input() in tile_render.c), then the keys the
+// main loop reads itself
+#define KEY_RIGHT  0x01
+#define KEY_LEFT   0x02
+#define KEY_DOWN   0x04
+#define KEY_UP     0x08
+#define KEY_DASH   0x10     // SPACE
+#define KEY_JUMP   0x20     // H
+#define KEY_NEXT   0x40     // N
+
+typedef struct {
+    int frames;             // 0: a tap
+    unsigned char keys;
+} trace_step;
+
+typedef struct {
+    char path[512];
+    char name[128];
+    long budget;
+    int max_frames;
+    trace_step steps[MAX_STEPS];
+    int step_count;
+} trace;
+
+typedef struct {
+    int frame;              // informational: where the state first appeared
+    unsigned long crc;
+    unsigned char border;
+} screen_state;
+
+typedef struct {
+    unsigned char keys;
+    unsigned char border;
+} machine_io;
+
+static void die(const char *msg) {
+    fprintf(stderr, "%s\n", msg);
+    exit(1);
+}
+
+static unsigned long crc32_buf(const unsigned char *p, size_t n) {
+    unsigned long crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < n; i++) {
+        crc ^= p[i];
+        for (int b = 0; b < 8; b++)
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1)));
+    }
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static long load_file(const char *path, unsigned char *dst, long max) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        exit(1);
+    }
+    long n = (long)fread(dst, 1, (size_t)max, f);
+    fclose(f);
+    return n;
+}
+
+// Keyboard half-rows: Q = 0xFB bit 0, A = 0xFD bit 0, P/O = 0xDF bits 0/1,
+// H = 0xBF bit 4, SPACE/N = 0x7F bits 0/3.
+// Kempston (port 0x1F) reads 0; floating bus (0xFF) reads idle border.
+static uint8_t io_in(void *ctx, uint16_t port) {
+    machine_io *io = (machine_io *)ctx;
+    if ((port & 0x01) == 0) {
+        uint8_t rows = (uint8_t)(port >> 8);
+        uint8_t v = 0xFF;
+        if (!(rows & 0x04) && (io->keys & KEY_UP))    v &= (uint8_t)~0x01;
+        if (!(rows & 0x02) && (io->keys & KEY_DOWN))  v &= (uint8_t)~0x01;
+        if (!(rows & 0x20) && (io->keys & KEY_RIGHT)) v &= (uint8_t)~0x01;
+        if (!(rows & 0x20) && (io->keys & KEY_LEFT))  v &= (uint8_t)~0x02;
+        if (!(rows & 0x40) && (io->keys & KEY_JUMP))  v &= (uint8_t)~0x10;
+        if (!(rows & 0x80) && (io->keys & KEY_DASH))  v &= (uint8_t)~0x01;
+        if (!(rows & 0x80) && (io->keys & KEY_NEXT))  v &= (uint8_t)~0x08;
+        return v;
+    }
+    if ((port & 0xFF) == 0x1F) return 0x00;
+    return 0xFF;
+}
+
+static void io_out(void *ctx, uint16_t port, uint8_t value) {
+    machine_io *io = (machine_io *)ctx;
+    if ((port & 0x01) == 0) io->border = value & 0x07;
+}
+
+static unsigned char parse_keys(const char *s, int line) {
+    unsigned char k = 0;
+    if (strcmp(s, "-") == 0) return 0;
+    for (; *s; s++) {
+        switch (*s) {
+            case 'U': case 'u': k |= KEY_UP; break;
+            case 'D': case 'd': k |= KEY_DOWN; break;
+            case 'L': case 'l': k |= KEY_LEFT; break;
+            case 'R': case 'r': k |= KEY_RIGHT; break;
+            case 'S': case 's': k |= KEY_DASH; break;
+            case 'H': case 'h': k |= KEY_JUMP; break;
+            case 'N': case 'n': k |= KEY_NEXT; break;
+            default:
+                fprintf(stderr, "Error: line %d: bad key '%c' (use U/D/L/R/S/H/N or -)\n", line, *s);
+                exit(1);
+        }
+    }
+    return k;
+}
+
+static void add_step(trace *t, int frames, unsigned char keys) {
+    if (t->step_count == MAX_STEPS) die("Error: too many trace steps");
+    t->steps[t->step_count].frames = frames;
+    t->steps[t->step_count].keys = keys;
+    t->step_count++;
+}
+
+static void load_trace(trace *t, const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int n = 0;
+
+    if (!f) {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        exit(1);
+    }
+    memset(t, 0, sizeof(*t));
+    snprintf(t->path, sizeof(t->path), "%s", path);
+    {
+        const char *base = strrchr(path, '/');
+        base = base ? base + 1 : path;
+        snprintf(t->name, sizeof(t->name), "%s", base);
+        char *dot = strrchr(t->name, '.');
+        if (dot) *dot = 0;
+    }
+    t->budget = ZX_FRAME_TSTATES;
+    t->max_frames = 0;          // no limit
+
+    while (fgets(line, sizeof(line), f)) {
+        char a[64], b[64], c[64];
+        char *hash = strchr(line, '#');
+        n++;
+        if (hash) *hash = 0;
+        int fields = sscanf(line, "%63s %63s %63s", a, b, c);
+        if (fields <= 0) continue;
+        if (strcmp(a, "budget") == 0 && fields == 2) {
+            t->budget = atol(b);
+        } else if (strcmp(a, "frames") == 0 && fields == 2) {
+            t->max_frames = atoi(b);
+        } else if (strcmp(a, "tap") == 0 && fields == 3) {
+            unsigned char keys = parse_keys(b, n);
+            int count = atoi(c);
+            for (int i = 0; i < count; i++) add_step(t, 0, keys);
+        } else if (fields == 2 && atoi(a) > 0) {
+            add_step(t, atoi(a), parse_keys(b, n));
+        } else {
+            fprintf(stderr, "Error: %s:%d: expected '<frames> <keys>', 'tap <keys> <n>', 'budget <T>' or 'frames <n>'\n", path, n);
+            exit(1);
+        }
+    }
+    fclose(f);
+}
+
+static int read_golden(const char *path, screen_state *states, int max) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int n = 0;
+    if (!f) return -1;
+    while (n < max && fgets(line, sizeof(line), f)) {
+        int frame = -1, border;
+        unsigned long crc;
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%lx %d # frame %d", &crc, &border, &frame) < 2) continue;
+        states[n].frame = frame;
+        states[n].crc = crc;
+        states[n].border = (unsigned char)border;
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static void dump_screen(const char *dir, const char *name, int frame, const unsigned char *mem) {
+    char path[768];
+    snprintf(path, sizeof(path), "%s/%s_f%05d.scr", dir, name, frame);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "Warning: cannot write %s\n", path);
+        return;
+    }
+    fwrite(mem + SCREEN_ADDR, 1, SCREEN_BYTES, f);
+    fclose(f);
+}
+
+typedef struct {
+    const char *code_path;
+    const char *data_path;
+    const char *rom_path;
+    const char *golden_dir;
+    const char *dump_dir;
+    long budget_override;
+    int frames_override;
+    int record;
+    int contended;
+    int verbose;
+} options;
+
+// Input cursor: hold steps count frames down; a tap presses for one frame,
+// then waits for TAP_IDLE_FRAMES frames in which the loop's work fit
+typedef struct {
+    int step;
+    int left;               // hold: frames left; tap: 1 while pressed
+    int idle;               // tap: idle frames seen since the press
+    int waited;             // tap: frames since the press
+} input_cursor;
+
+static void cursor_start(const trace *t, input_cursor *c) {
+    c->idle = c->waited = 0;
+    c->left = c->step < t->step_count ? (t->steps[c->step].frames ? t->steps[c->step].frames : 1) : 0;
+}
+
+static unsigned char cursor_keys(const trace *t, const input_cursor *c) {
+    if (c->step >= t->step_count) return 0;
+    return c->left ? t->steps[c->step].keys : 0;
+}
+
+// After a frame: idle is 1 if the loop woke and HALTed again within it.
+// Returns 0 if a tap waited TAP_MAX_FRAMES for its step to end.
+static int cursor_advance(const trace *t, input_cursor *c, int idle) {
+    const trace_step *st;
+    if (c->step >= t->step_count) return 1;
+    st = &t->steps[c->step];
+    if (st->frames) {
+        if (--c->left) return 1;
+    } else if (c->left) {
+        c->left = 0;
+        return 1;
+    } else {
+        c->idle = idle ? c->idle + 1 : 0;
+        if (++c->waited > TAP_MAX_FRAMES) return 0;
+        if (c->idle < TAP_IDLE_FRAMES) return 1;
+    }
+    c->step++;
+    cursor_start(t, c);
+    return 1;
+}
+
+static int run_trace(const options *opt, const trace *t) {
+    static unsigned char mem[65536];
+    static screen_state states[MAX_STATES];
+    static screen_state golden[MAX_STATES];
+    machine_io io = { 0, 0 };
+    input_cursor in = { 0, 0, 0, 0 };
+    z80 cpu;
+    int state_count = 0;
+    int failures = 0;
+    long budget = opt->budget_override > 0 ? opt->budget_override : t->budget;
+    int max_frames = opt->frames_override > 0 ? opt->frames_override : t->max_frames;
+    long worst = 0;             // busiest frame the loop's work fit in
+    int worst_frame = -1;
+    int longest = 0;            // most frames from a wake-up to its HALT
+    int longest_frame = -1;
+    long busy = 0;              // busy T-states of the current frame
+    int iter_frame = 0;         // frame in which the current iteration began
+    int was_halted = 0;
+    int golden_count = 0;
+    int mismatches = 0;
+    int frame;
+    char golden_path[768];
+
+    snprintf(golden_path, sizeof(golden_path), "%s/%s.golden", opt->golden_dir, t->name);
+    if (!opt->record) {
+        golden_count = read_golden(golden_path, golden, MAX_STATES);
+        if (golden_count < 0) {
+            printf("%s: no golden capture at %s (make replay-record)\n", t->name, golden_path);
+            failures++;
+        }
+    }
+
+    memset(mem, 0, sizeof(mem));
+    if (opt->rom_path) {
+        load_file(opt->rom_path, mem, 0x4000);
+    } else {
+        memset(mem, 0xFF, 0x4000);
+        mem[0x0038] = 0xFB;     // ei
+        mem[0x0039] = 0xC9;     // ret
+    }
+    load_file(opt->data_path, mem + DATA_ORG, CODE_ORG - DATA_ORG);
+    load_file(opt->code_path, mem + CODE_ORG, 0x10000 - CODE_ORG);
+
+    memset(&cpu, 0, sizeof(cpu));
+    cpu.mem = mem;
+    cpu.port_in = io_in;
+    cpu.port_out = io_out;
+    cpu.ctx = &io;
+    z80_reset(&cpu);
+    cpu.contended = opt->contended;
+    cpu.pc = CODE_ORG;
+    cpu.sp = START_SP;
+    cpu.iy = 0x5C3A;            // ROM ISR expects IY = ERR_NR
+    cpu.im = 1;
+    cpu.iff1 = cpu.iff2 = 1;
+
+    // Startup frames take no input, so the first step is not lost to the boot render
+    cursor_start(t, &in);
+    for (frame = 0; in.step < t->step_count || frame < STARTUP_FRAMES; frame++) {
+        int gated = frame >= STARTUP_FRAMES;
+        int idle = 0;           // the loop woke and HALTed within this frame
+        int ran_through;        // the loop was still busy at the next interrupt
+        int ended = 0;          // frames taken by the step that HALTed in this frame
+        int last_busy = 0;
+
+        io.keys = gated ? cursor_keys(t, &in) : 0;
+        if (frame > 0) z80_interrupt(&cpu);
+
+        while (cpu.frame_t < ZX_FRAME_TSTATES) {
+            int halted_before = cpu.halted;
+            if (!opt->rom_path && cpu.pc < 0x4000 && cpu.pc != 0x0038 && cpu.pc != 0x0039) {
+                fprintf(stderr, "%s: frame %d: ROM call to 0x%04X needs --rom\n", t->name, frame, cpu.pc);
+                return 1;
+            }
+            int used = z80_step(&cpu);
+            last_busy = !halted_before;
+            if (last_busy) busy += used;
+
+            // Iteration ends when the main loop HALTs: time it and capture the screen
+            if (cpu.halted && !was_halted) {
+                unsigned long crc = crc32_buf(mem + SCREEN_ADDR, SCREEN_BYTES);
+                int span = frame - iter_frame + 1;
+
+                if (span == 1) idle = 1;
+                ended = span;
+                if (iter_frame >= STARTUP_FRAMES && span > longest) {
+                    longest = span;
+                    longest_frame = iter_frame;
+                }
+                if (iter_frame >= STARTUP_FRAMES && max_frames > 0 && span > max_frames) {
+                    printf("%s: frame %d: step takes %d frames, limit %d\n", t->name, iter_frame, span, max_frames);
+                    failures++;
+                }
+                if (state_count == 0 || states[state_count - 1].crc != crc
+                    || states[state_count - 1].border != io.border) {
+                    screen_state *st = &states[state_count];
+                    if (state_count == MAX_STATES) die("Error: too many screen states");
+                    st->frame = iter_frame;
+                    st->crc = crc;
+                    st->border = io.border;
+                    if (golden_count > 0 && state_count < golden_count) {
+                        const screen_state *g = &golden[state_count];
+                        if (g->crc != st->crc || g->border != st->border) {
+                            if (mismatches < 8)
+                                printf("%s: state %d (frame %d): screen %08lx border %d, golden screen %08lx border %d (frame %d)\n",
+                                       t->name, state_count, st->frame, st->crc, st->border, g->crc, g->border, g->frame);
+                            if (opt->dump_dir) dump_screen(opt->dump_dir, t->name, st->frame, mem);
+                            mismatches++;
+                        }
+                    }
+                    state_count++;
+                }
+            }
+            if (!cpu.halted && was_halted) iter_frame = frame;
+            was_halted = cpu.halted;
+        }
+
+        // An instruction running over the interrupt belongs to the next frame
+        long carry = last_busy ? (long)(cpu.frame_t - ZX_FRAME_TSTATES) : 0;
+        busy -= carry;
+        ran_through = last_busy;
+        if (opt->verbose)
+            printf("%s: frame %5d: %6ld T%s\n", t->name, frame, busy,
+                   !gated ? " (startup)" : ran_through ? " (step)" : "");
+        // A frame the loop runs straight through is covered by the frame limit.
+        // The budget applies to idle frames and to the last frame of a step
+        // that takes the whole limit: a step must fit in (limit - 1) frames
+        // plus the budget, and one that fits in fewer frames passes whatever
+        // its last frame costs.
+        if (gated && !ran_through && (ended <= 1 || max_frames == 0 || ended >= max_frames)) {
+            if (busy > worst) {
+                worst = busy;
+                worst_frame = frame;
+            }
+            if (busy > budget) {
+                printf("%s: frame %d: %ld T exceeds budget %ld T\n", t->name, frame, busy, budget);
+                failures++;
+            }
+        }
+        busy = carry;
+        cpu.frame_t -= ZX_FRAME_TSTATES;
+
+        if (gated && !cursor_advance(t, &in, idle)) {
+            printf("%s: frame %d: the loop did not idle within %d frames of a tap\n", t->name, frame, TAP_MAX_FRAMES);
+            failures++;
+            break;
+        }
+    }
+
+    if (opt->record) {
+        FILE *f = fopen(golden_path, "w");
+        if (!f) {
+            fprintf(stderr, "Error: cannot write %s\n", golden_path);
+            return 1;
+        }
+        fprintf(f, "# crc32 border - distinct screen states recorded by replay_trace from %s\n", t->path);
+        for (int i = 0; i < state_count; i++)
+            fprintf(f, "%08lx %d # frame %d\n", states[i].crc, states[i].border, states[i].frame);
+        fclose(f);
+        printf("%s: recorded %d screen states to %s\n", t->name, state_count, golden_path);
+    } else if (golden_count >= 0) {
+        if (state_count != golden_count) {
+            printf("%s: %d screen states, golden has %d\n", t->name, state_count, golden_count);
+            mismatches++;
+        }
+        if (mismatches) failures++;
+    }
+
+    printf("%s: %d frames, %d screen states, busiest frame %ld T at frame %d (budget %ld T), "
+           "longest step %d frames at frame %d (limit %d)\n",
+           t->name, frame, state_count, worst, worst_frame, budget, longest, longest_frame, max_frames);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    options opt = {
+        "scroll_CODE.bin", "contended_data.bin", NULL, "traces/golden", NULL, 0, 0, 0, 1, 0
+    };
+    int first_trace = argc;
+    int failed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--code") == 0 && i + 1 < argc) opt.code_path = argv[++i];
+        else if (strcmp(argv[i], "--data") == 0 && i + 1 < argc) opt.data_path = argv[++i];
+        else if (strcmp(argv[i], "--rom") == 0 && i + 1 < argc) opt.rom_path = argv[++i];
+        else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) opt.golden_dir = argv[++i];
+        else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) opt.dump_dir = argv[++i];
+        else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) opt.budget_override = atol(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) opt.frames_override = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--record") == 0) opt.record = 1;
+        else if (strcmp(argv[i], "--no-contention") == 0) opt.contended = 0;
+        else if (strcmp(argv[i], "--verbose") == 0) opt.verbose = 1;
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Error: unknown option %s\n", argv[i]);
+            return 1;
+        } else {
+            first_trace = i;
+            break;
+        }
+    }
+    if (first_trace >= argc) {
+        fprintf(stderr, "Usage: %s [--record] [--budget T] [--frames n] [--golden dir] <trace> [<trace> ...]\n", argv[0]);
+        return 1;
+    }
+
+    for (int i = first_trace; i < argc; i++) {
+        static trace t;
+        load_trace(&t, argv[i]);
+        failed |= run_trace(&opt, &t);
+    }
+    return failed;
+}
@@ -0,0 +1,505 @@
+; sound.asm - AY music and sound effects, one fixed-cost tick per frame
+; An IM 2 interrupt plays the song (three channels, one row every
+; SND_ROW_FRAMES frames) and overlays a sound effect on channel C. Every
+; tick costs the same T-states whatever the song does: the sequencer has
+; no branches, and all eleven tone/mixer/volume registers are written
+; every frame.
+;
+; Public routines:
+;   _snd_init    - silence the AY, install the IM 2 handler, start the song
+;   _snd_sfx     - start a sound effect on channel C
+;   _snd_silence - zero the AY volumes now (before a long DI section)
+;   _snd_isr     - the frame interrupt (not called from C)
+;   _snd_frame   - one tick: sequencer + AY write (the ISR's fixed cost)
+;
+; SP-hijack sections: in SOUND builds the shifts and column renderers run
+; with interrupts on while SP walks the screen-address LUT. The interrupt's
+; return address then lands on a LUT word (or the guard word in front of
+; it); the ISR reads it, restores the word from _snd_lut_shadow and defers
+; the tick, so the renderer is delayed by ~430 T and not a whole tick.
+; Deferred ticks are caught up by the next interrupt outside a renderer
+; (the main loop's HALT at the latest): the song keeps its tempo, only the
+; AY writes of the skipped frames are lost. The edge-strip blit/save walk
+; strips with guard bytes (tile_render.c), so the tick plays there.
+;
+; 128K safe: the AY is addressed with OUT (C) and a full 16-bit port
+; (0xFFFD select, 0xBFFD data), as the floating-bus reads use IN A,(C).
+; On a 48K machine the writes go nowhere and the song is silent.
+
+    SECTION code_user
+
+    PUBLIC _snd_init
+    PUBLIC _snd_sfx
+    PUBLIC _snd_silence
+    PUBLIC _snd_isr
+    PUBLIC _snd_frame
+
+    EXTERN _scr_addr_table_guard
+
+    INCLUDE "viewport.inc"
+
+AY_SELECT               EQU 0xFFFD
+AY_DATA_OUTI            EQU 0xC0    ; B for OUTI: decremented to 0xBF first
+AY_REGS                 EQU 11      ; R0-R10: tone periods, noise, mixer, volumes
+AY_MIXER                EQU 0x38    ; tone on A, B, C; noise off
+AY_VOLUME_A             EQU 8
+
+; Song shape (data at the end)
+SND_ROW_FRAMES          EQU 6       ; 8.3 rows a second
+SND_SONG_ROWS           EQU 32
+
+; The LUT words an interrupt can hit: guard word + one per scanline
+SND_LUT_BYTES           EQU VIEWPORT_HEIGHT * 2 + 2
+; Ticks a run of renderers can defer; more are dropped (the song slips).
+; A step spans at most ~4.5 frames and its HALT always plays.
+SND_PENDING_MAX         EQU 4
+
+; IM 2: a 257-byte vector table on a page boundary, every byte V, and a
+; JP at 0xVVVV. V is the page after the table, so the JP sits in that page
+; at offset V (<= 0xC0 for a program below 0xC000).
+SND_IM2_BYTES           EQU 255 + 257 + 0xC0 + 3
+
+; Worst-case budgets for asm_timing
+BUDGET_SND_FRAME        EQU 1550
+BUDGET_SND_ISR          EQU BUDGET_SND_FRAME + 400 + SND_PENDING_MAX * 1050
+
+;----------------------------------------------------------------------
+; _snd_init
+; Silence the AY, build the IM 2 table in _snd_im2 and switch to IM 2.
+; The song starts on the next interrupt. Call after any tape loading.
+;
+; void snd_init(void)
+;----------------------------------------------------------------------
+_snd_init:
+    di
+    ld hl, _snd_regs
+    ld de, _snd_regs + 1
+    ld bc, AY_REGS - 1
+    ld (hl), 0
+    ldir                    ; all volumes 0
+    ld a, AY_MIXER
+    ld (_snd_regs + 7), a
+    call _snd_write
+    ld a, SND_ROW_FRAMES - 1
+    ld (_snd_t), a          ; the first tick starts row 0
+    ld a, SND_SONG_ROWS - 1
+    ld (_snd_row), a
+    xor a
+    ld (_snd_pending), a
+    ld hl, _snd_sfx_none
+    ld (_snd_sfx_ptr), hl
+    ld (_snd_sfx_start), hl
+
+    ld hl, _snd_im2 + 255
+    ld l, 0                 ; HL = first page boundary in the area
+    ld a, h
+    inc a                   ; A = V
+    ld d, h
+    ld e, 1
+    ld (hl), a
+    ld bc, 256
+    ldir                    ; 257 bytes of V
+    ld h, a
+    ld l, a                 ; HL = 0xVVVV
+    ld (hl), 0xC3           ; jp _snd_isr
+    inc hl
+    ld bc, _snd_isr
+    ld (hl), c
+    inc hl
+    ld (hl), b
+    dec a                   ; A = table page
+    ld i, a
+    im 2
+    ei
+    ret
+
+;----------------------------------------------------------------------
+; _snd_sfx
+; Start sound effect id on channel C (SFX_* in tile_render.h). A request
+; for the effect already playing is ignored, so callers can repeat it
+; every frame a condition holds.
+;
+; void snd_sfx(unsigned char id)
+;----------------------------------------------------------------------
+_snd_sfx:
+    ; SP+2 = id (1 byte)
+    ld hl, 2
+    add hl, sp
+    ld l, (hl)
+    ld h, 0
+    add hl, hl
+    ld de, _snd_sfx_table
+    add hl, de
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = effect
+    ld hl, (_snd_sfx_start)
+    or a
+    sbc hl, de
+    jr nz, _ssfx_start      ; another effect: replace it
+    ld hl, (_snd_sfx_ptr)
+    inc hl
+    inc hl
+    ld a, (hl)
+    inc a
+    ret nz                  ; still playing
+_ssfx_start:
+    ld (_snd_sfx_start), de
+    ld (_snd_sfx_ptr), de   ; one store: the ISR sees old or new
+    ret
+
+;----------------------------------------------------------------------
+; _snd_silence
+; Zero the three volumes on the AY now. _level_unpack runs ~6 frames with
+; interrupts off; without this the last note would hold through it.
+;
+; void snd_silence(void)
+;----------------------------------------------------------------------
+_snd_silence:
+    di                      ; the ISR selects registers too
+    ld a, AY_VOLUME_A
+    ld d, 3
+_ssil_reg:
+    ld bc, AY_SELECT
+    out (c), a
+    ld b, AY_DATA_OUTI - 1
+    ld e, 0
+    out (c), e
+    inc a
+    dec d
+    jr nz, _ssil_reg
+    ei
+    ret
+
+;----------------------------------------------------------------------
+; _snd_isr
+; IM 2 handler. Runs on its own stack; only a tick's registers are saved.
+; Interrupted in an SP-hijack section (SP inside the screen-address LUT):
+; repair the word the return address overwrote, defer the tick, return.
+; Otherwise: the deferred ticks' sequencer steps, then one full tick.
+;
+; T-states: ~430 deferred; ~1,860 played (_snd_frame + ~350), plus ~980
+; per deferred tick caught up (at most SND_PENDING_MAX)
+; @budget BUDGET_SND_ISR
+;----------------------------------------------------------------------
+_snd_isr:
+    ld (_snd_isr_sp), sp    ; 20T - the interrupted SP - 2
+    ld sp, _snd_stack_top   ; 10T
+    push af                 ; 11T
+    push bc                 ; 11T
+    push de                 ; 11T
+    push hl                 ; 11T
+    push ix                 ; 15T
+    ld hl, (_snd_isr_sp)    ; 16T
+    ld e, (hl)              ;  7T
+    inc hl                  ;  6T
+    ld d, (hl)              ;  7T
+    ld (_snd_isr_ret+1), de ; 20T - interrupted PC (self-modifying)
+
+    ld de, _scr_addr_table_guard + 1
+    or a                    ;  4T
+    sbc hl, de              ; 15T - HL = offset of the word from the guard
+    ex de, hl               ;  4T
+    ld hl, -SND_LUT_BYTES   ; 10T
+    add hl, de              ; 11T - CF: offset >= SND_LUT_BYTES
+    jp c, _snd_isr_play     ; 10T
+
+    ; SP-hijack: restore the LUT word, defer the tick
+    ld hl, _snd_lut_shadow  ; 10T
+    add hl, de              ; 11T
+    ld c, (hl)              ;  7T
+    inc hl                  ;  6T
+    ld b, (hl)              ;  7T
+    ld hl, (_snd_isr_sp)    ; 16T
+    ld (hl), c              ;  7T
+    inc hl                  ;  6T
+    ld (hl), b              ;  7T
+    ld hl, _snd_pending     ; 10T
+    ld a, (hl)              ;  7T
+    cp SND_PENDING_MAX      ;  7T
+    adc a, 0                ;  7T - +1 up to the limit
+    ld (hl), a              ;  7T
+    jp _snd_isr_done        ; 10T
+
+_snd_isr_play:
+    ld a, (_snd_pending)    ; 13T
+    or a                    ;  4T
+    jr z, _snd_isr_frame    ; 12T
+    ld b, a
+    xor a
+    ld (_snd_pending), a
+_snd_isr_catch_up:
+    push bc
+    call _snd_step          ; the deferred ticks' song position only
+    pop bc
+    djnz _snd_isr_catch_up  ; @loop 1..SND_PENDING_MAX
+_snd_isr_frame:
+    call _snd_frame
+
+_snd_isr_done:
+    pop ix                  ; 14T
+    pop hl                  ; 10T
+    pop de                  ; 10T
+    pop bc                  ; 10T
+    pop af                  ; 10T
+    ld sp, (_snd_isr_sp)    ; 20T
+    inc sp                  ;  6T
+    inc sp                  ;  6T - drop the return address
+    ei                      ;  4T - taken after the jump
+_snd_isr_ret:
+    jp 0                    ; 10T - back to the interrupted code (self-mod)
+
+;----------------------------------------------------------------------
+; _snd_frame
+; One tick: advance the song and the sound effect, then write R0-R10.
+; No branches: best and worst case are the same.
+; Clobbers AF, BC, DE, HL, IX.
+;
+; T-states: 1,501 (sequencer ~920, AY write ~560)
+; @budget BUDGET_SND_FRAME
+;----------------------------------------------------------------------
+_snd_frame:
+    call _snd_step          ; 17T
+_snd_write:
+    ld hl, _snd_regs        ; 10T
+    xor a                   ;  4T - register 0
+    REPT AY_REGS
+    ld bc, AY_SELECT        ; 10T
+    out (c), a              ; 12T - select
+    ld b, AY_DATA_OUTI      ;  7T
+    outi                    ; 16T - shadow byte to 0xBFFD
+    inc a                   ;  4T
+    ENDR
+    ret                     ; 10T
+
+;----------------------------------------------------------------------
+; _snd_step: advance the song one frame into _snd_regs.
+; The frame counter wraps to 0 on a new row and the row counter then
+; advances (wrapping at the song end), all with carry masks, no branches.
+;----------------------------------------------------------------------
+_snd_step:
+    ld a, (_snd_t)          ; 13T
+    inc a                   ;  4T
+    ld b, a                 ;  4T
+    cp SND_ROW_FRAMES       ;  7T
+    sbc a, a                ;  4T - 0xFF: same row, 0: new row
+    ld c, a                 ;  4T
+    and b                   ;  4T
+    ld (_snd_t), a          ; 13T - frame within the row
+    ld e, a                 ;  4T
+    ld a, c                 ;  4T
+    inc a                   ;  4T - 1 on a new row
+    ld hl, _snd_row         ; 10T
+    add a, (hl)             ;  7T
+    ld b, a                 ;  4T
+    cp SND_SONG_ROWS        ;  7T
+    sbc a, a                ;  4T
+    and b                   ;  4T - wrap at the song end
+    ld (hl), a              ;  7T
+    ld b, 0                 ;  7T
+    ld c, e                 ;  4T
+    ld ix, _snd_env         ; 14T
+    add ix, bc              ; 15T
+    add ix, bc              ; 15T
+    add ix, bc              ; 15T - IX = this frame's volumes (A, B, C)
+    ld e, a                 ;  4T
+    ld d, b                 ;  7T - DE = row
+
+    ; Channel A
+    ld hl, _snd_song_a      ; 10T
+    add hl, de              ; 11T
+    ld a, (hl)              ;  7T - note, 0 = rest
+    add a, a                ;  4T
+    ld c, a                 ;  4T - BC = period table offset
+    cp 1                    ;  7T
+    sbc a, a                ;  4T
+    cpl                     ;  4T - 0xFF for a note, 0 for a rest
+    and (ix+0)              ; 19T
+    ld (_snd_regs + 8), a   ; 13T
+    ld hl, _snd_periods     ; 10T
+    add hl, bc              ; 11T
+    ld a, (hl)              ;  7T
+    ld (_snd_regs + 0), a   ; 13T
+    inc hl                  ;  6T
+    ld a, (hl)              ;  7T
+    ld (_snd_regs + 1), a   ; 13T
+
+    ; Channel B
+    ld hl, _snd_song_b
+    add hl, de
+    ld a, (hl)
+    add a, a
+    ld c, a
+    cp 1
+    sbc a, a
+    cpl
+    and (ix+1)
+    ld (_snd_regs + 9), a
+    ld hl, _snd_periods
+    add hl, bc
+    ld a, (hl)
+    ld (_snd_regs + 2), a
+    inc hl
+    ld a, (hl)
+    ld (_snd_regs + 3), a
+
+    ; Channel C
+    ld hl, _snd_song_c
+    add hl, de
+    ld a, (hl)
+    add a, a
+    ld c, a
+    cp 1
+    sbc a, a
+    cpl
+    and (ix+2)
+    ld (_snd_regs + 10), a
+    ld hl, _snd_periods
+    add hl, bc
+    ld a, (hl)
+    ld (_snd_regs + 4), a
+    inc hl
+    ld a, (hl)
+    ld (_snd_regs + 5), a
+
+    ; Sound effect frame (period, volume) over channel C while it plays:
+    ; reg = music ^ ((music ^ sfx) & mask)
+    ld hl, (_snd_sfx_ptr)   ; 16T
+    inc hl                  ;  6T
+    inc hl                  ;  6T
+    ld a, (hl)              ;  7T - volume, 0xFF = end
+    add a, 1                ;  7T
+    sbc a, a                ;  4T
+    cpl                     ;  4T
+    ld c, a                 ;  4T - C = 0xFF while playing
+    dec hl                  ;  6T
+    dec hl                  ;  6T
+    ld a, (_snd_regs + 4)   ; 13T
+    ld e, a                 ;  4T
+    xor (hl)                ;  7T
+    and c                   ;  4T
+    xor e                   ;  4T
+    ld (_snd_regs + 4), a   ; 13T
+    inc hl                  ;  6T
+    ld a, (_snd_regs + 5)
+    ld e, a
+    xor (hl)
+    and c
+    xor e
+    ld (_snd_regs + 5), a
+    inc hl
+    ld a, (_snd_regs + 10)
+    ld e, a
+    xor (hl)
+    and c
+    xor e
+    ld (_snd_regs + 10), a
+    ld a, c                 ;  4T
+    and 3                   ;  7T - next frame while playing
+    ld e, a                 ;  4T
+    ld d, b                 ;  4T
+    ld hl, (_snd_sfx_ptr)   ; 16T
+    add hl, de              ; 11T
+    ld (_snd_sfx_ptr), hl   ; 16T
+    ret                     ; 10T
+
+;----------------------------------------------------------------------
+; Song: one note byte per row and channel, 0 = rest, n = C2 + n - 1
+; (_snd_periods). Every row restarts its channel's volume envelope.
+;----------------------------------------------------------------------
+    SECTION rodata_user
+
+; Am - F - C - G, a bar of 8 rows each
+_snd_song_a:                        ; lead
+    DEFB 41, 0, 37, 0, 34, 0, 37, 41
+    DEFB 42, 0, 41, 0, 37, 0, 34, 0
+    DEFB 41, 0, 44, 0, 41, 0, 37, 0
+    DEFB 39, 0, 36, 0, 32, 0, 39, 36
+_snd_song_b:                        ; bass
+    DEFB 10, 0, 10, 0, 10, 0, 22, 0
+    DEFB  6, 0,  6, 0,  6, 0, 18, 0
+    DEFB 13, 0, 13, 0, 13, 0, 25, 0
+    DEFB  8, 0,  8, 0,  8, 0, 20, 0
+_snd_song_c:                        ; arpeggio (sound effects play over it)
+    DEFB 22, 25, 29, 25, 22, 25, 29, 25
+    DEFB 18, 22, 25, 22, 18, 22, 25, 22
+    DEFB 25, 29, 32, 29, 25, 29, 32, 29
+    DEFB 20, 24, 27, 24, 20, 24, 27, 24
+
+; Volume of channels A, B, C in frame 0..SND_ROW_FRAMES-1 of a row
+_snd_env:
+    DEFB 13, 15, 9
+    DEFB 12, 13, 7
+    DEFB 11, 11, 5
+    DEFB 10,  9, 4
+    DEFB  9,  7, 3
+    DEFB  8,  5, 2
+
+; Tone periods for the 128K's 1.7734 MHz AY clock, C2..B5 (entry 0: rest)
+_snd_periods:
+    DEFW 0
+    DEFW 1695, 1599, 1510, 1425, 1345, 1270, 1198, 1131, 1068, 1008, 951, 898
+    DEFW 847, 800, 755, 712, 673, 635, 599, 566, 534, 504, 476, 449
+    DEFW 424, 400, 377, 356, 336, 317, 300, 283, 267, 252, 238, 224
+    DEFW 212, 200, 189, 178, 168, 159, 150, 141, 133, 126, 119, 112
+
+;----------------------------------------------------------------------
+; Sound effects: frames of (tone period, volume), ended by volume 0xFF.
+; Ids (SFX_* in tile_render.h) index _snd_sfx_table.
+;----------------------------------------------------------------------
+_snd_sfx_table:
+    DEFW _snd_sfx_trigger
+    DEFW _snd_sfx_bump
+
+_snd_sfx_trigger:                   ; rising chirp
+    DEFW 200
+    DEFB 15
+    DEFW 170
+    DEFB 14
+    DEFW 140
+    DEFB 13
+    DEFW 110
+    DEFB 12
+    DEFW 90
+    DEFB 11
+    DEFW 70
+    DEFB 10
+    DEFW 55
+    DEFB 8
+_snd_sfx_none:
+    DEFW 0
+    DEFB 0xFF
+
+_snd_sfx_bump:                      ; low thud
+    DEFW 1400
+    DEFB 14
+    DEFW 1700
+    DEFB 11
+    DEFW 2000
+    DEFB 8
+    DEFW 2400
+    DEFB 5
+    DEFW 0
+    DEFB 0xFF
+
+; Copy of the LUT and its guard word: the ISR restores the word an
+; interrupt overwrote in an SP-hijack section from here
+_snd_lut_shadow:
+    DEFW 0
+    INCLUDE "scr_addr_table.inc"
+
+;----------------------------------------------------------------------
+; Player state, AY register shadow, IM 2 table and the ISR's stack
+;----------------------------------------------------------------------
+    SECTION bss_user
+
+_snd_t:         DEFB 0      ; frame within the row
+_snd_row:       DEFB 0
+_snd_pending:   DEFB 0      ; ticks deferred by SP-hijack sections
+_snd_isr_sp:    DEFW 0      ; interrupted SP - 2
+_snd_sfx_ptr:   DEFW 0      ; current sound effect frame
+_snd_sfx_start: DEFW 0      ; first frame of the current effect
+_snd_regs:      DEFS AY_REGS
+_snd_stack:     DEFS 24
+_snd_stack_top:
+_snd_im2:       DEFS SND_IM2_BYTES
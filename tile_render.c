@@ -3,32 +3,175 @@
 #include <intrinsic.h>
 #include <string.h>
 #include "tile_render.h"
+#include "tile_anim.h"
 #include "assets/man_sprite.h"
 
 extern const unsigned char tiles[];
 extern unsigned char map_data[];
+extern const unsigned char map_row_occ[];
+extern const unsigned char map_col_occ[];
 extern const unsigned char hud_scr[];
 extern unsigned int scr_addr_table_direct[];
 
+// Map reads. A metatile map (METATILE in viewport.h) holds one byte per
+// block: the offset of its cells in the dictionary page. Single cells are
+// looked up through it; a full edge is expanded into its strip first
+// (~0.8kT) and the renderers read the strip in place of map_data.
+#if METATILE
+#define MAP_CELL(x, y) tiles[META_DICT_OFFSET \
+    + (unsigned char)(map_data[MAP_ROW_OFFSET((y) >> META_SHIFT) + ((x) >> META_SHIFT)] \
+    + ((((y) & (METATILE - 1)) << META_SHIFT) | ((x) & (METATILE - 1))))]
+#define MAP_COL(x, y) map_col(x, y)
+#define MAP_ROW(x, y) map_row(x, y)
+
+// Cells (x, y)..(x, y + VIEWPORT_CHAR_ROWS - 1), stepped by MAP_COL_STEP
+static const unsigned char *map_col(int x, int y) {
+    meta_expand_column(&map_data[MAP_ROW_OFFSET(y >> META_SHIFT) + (x >> META_SHIFT)],
+                       x & (METATILE - 1));
+    return META_COL_STRIP + (y & (METATILE - 1));
+}
+
+// Cells (x, y)..(x + VIEWPORT_COLS - 1, y)
+static const unsigned char *map_row(int x, int y) {
+    meta_expand_row(&map_data[MAP_ROW_OFFSET(y >> META_SHIFT) + (x >> META_SHIFT)],
+                    (y & (METATILE - 1)) << META_SHIFT);
+    return META_ROW_STRIP + (x & (METATILE - 1));
+}
+#else
+#define MAP_CELL(x, y) map_data[MAP_ROW_OFFSET(y) + (x)]
+#define MAP_COL(x, y)  (&map_data[MAP_ROW_OFFSET(y) + (x)])
+#define MAP_ROW(x, y)  MAP_COL(x, y)
+#endif
+
 // Camera state (in tile units, 8px per tile)
 static int camera_tile_x = 10;
 static int camera_tile_y = 10;
 static int prev_tile_x = 0;
 static int prev_tile_y = 0;
 
-// Man sprite centred in viewport: col 9, char row 7
-#define MAN_VIEWPORT_COL 9
-#define MAN_VIEWPORT_ROW 7
+// Man sprite centred in viewport: col 9, char row 7 for the default 20×16
+#define MAN_VIEWPORT_COL (VIEWPORT_COLS / 2 - 1)
+#define MAN_VIEWPORT_ROW (VIEWPORT_CHAR_ROWS / 2 - 1)
 #define MAN_SCREEN_COL   (VIEWPORT_COL_OFFSET + MAN_VIEWPORT_COL)  // 15
 #define MAN_TABLE_OFFSET (MAN_VIEWPORT_ROW * 8)                    // 56
 
 // Scroll throttle: only scroll every N frames for smooth feel
 #define SCROLL_INTERVAL 3
+
+// Dash (SPACE / fire): tiles per step, shifted in one pass by the _n routines
+#define DASH_STEP  2
+#define INPUT_DASH 0x10
+#if DASH_STEP > SCROLL_STEP_MAX
+#error "DASH_STEP exceeds SCROLL_STEP_MAX"
+#endif
 static unsigned char frame_count = 0;
 
+// Animated tiles (generate_tiles --anim -> tile_anim.h). A step copies the
+// next frame into the base tile slot, so edges scrolled in are already
+// current; only base tiles already on screen need a redraw. They are indexed
+// in map coordinates: added as draw_row/draw_column bring them in, pruned on
+// the idle frame after they scroll out, and redrawn on idle frames with a
+// fixed budget so scroll frames never pay for animation.
+// Level packs carry per-level tile slots, so they do not animate.
+#define ANIM_TILES (TILE_ANIM_COUNT && !LEVEL_PACK)
+#if ANIM_TILES
+#define ANIM_SLOTS         32       // tile page slots (map bytes with no flip bits)
+#define ANIM_MAX_INSTANCES 48       // on-screen instances indexed per animation
+#define ANIM_REDRAW_BUDGET 16       // tile redraws per idle frame (~1kT each)
+static unsigned char anim_of_slot[ANIM_SLOTS];          // slot -> animation + 1
+static unsigned char anim_x[TILE_ANIM_COUNT][ANIM_MAX_INSTANCES];
+static unsigned char anim_y[TILE_ANIM_COUNT][ANIM_MAX_INSTANCES];
+static unsigned char anim_count[TILE_ANIM_COUNT];
+static unsigned char anim_pending[TILE_ANIM_COUNT];     // instances left to redraw
+static unsigned char anim_frame[TILE_ANIM_COUNT];
+static unsigned char anim_due[TILE_ANIM_COUNT];         // anim_clock of next step
+static unsigned char anim_clock = 0;
+static unsigned char anim_moved = 0;                    // camera moved: prune
+static unsigned char anim_overflow = 0;                 // bit a: instance of a dropped
+static int anim_skip_y0 = 0;                            // map rows [y0, y1) of the
+static int anim_skip_y1 = 0;                            // row edge drawn this step
+#endif
+
+// Edge cache: idle frames pre-render the strip each edge would draw on the
+// next step into uncontended RAM, so the step's edge phase is a blit. A step
+// also saves the strip that scrolls out, which is the opposite edge of the
+// new position, so reversing is a blit too. Strips are tagged with the map
+// position of their first tile; a diagonal step misses and renders as before.
+#if EDGE_CACHE
+#define EDGE_LEFT   0
+#define EDGE_RIGHT  1
+#define EDGE_TOP    2
+#define EDGE_BOTTOM 3
+// The man is clear of the outer columns/rows, so saved edges are pure tiles
+#define EDGE_SAVE (VIEWPORT_COLS >= 4 && VIEWPORT_CHAR_ROWS >= 4)
+#if SOUND
+// The AY interrupt can land while blit/save_edge_column have SP in a strip;
+// its return address goes in the word below SP: the spare bytes in front
+// of the strip, a word save will still write, or one blit has consumed
+// (a blitted strip is dropped)
+#define EDGE_COL_GUARD 2
+#else
+#define EDGE_COL_GUARD 0
+#endif
+static unsigned char edge_col_mem[2][EDGE_COL_GUARD + EDGE_COL_STRIP_BYTES];    // left, right
+#define EDGE_COL_STRIP(e) (edge_col_mem[e] + EDGE_COL_GUARD)
+static unsigned char edge_row_strip[2][EDGE_ROW_STRIP_BYTES];   // top, bottom
+static int edge_x[4], edge_y[4];        // map position of the strip's first tile
+static unsigned char edge_valid = 0;    // bit e: strip e holds (edge_x, edge_y)
+// Strip for an edge drawn at a viewport row / screen column (dash edges are
+// several rows/columns wide; the one next to the old viewport can hit)
+#define EDGE_OF_ROW(r) ((r) < VIEWPORT_CHAR_ROWS / 2 ? EDGE_TOP : EDGE_BOTTOM)
+#define EDGE_OF_COL(c) ((c) < VIEWPORT_COL_OFFSET + VIEWPORT_COLS / 2 ? EDGE_LEFT : EDGE_RIGHT)
+#endif
+
+#define START_CAMERA_X 10
+#define START_CAMERA_Y 10
+static unsigned char jump_key_down = 0;     // H / N act on press, not while held
+#if LEVEL_PACK
+static unsigned char current_level = 0;
+#endif
+
+// Camera jumps (respawn, level switch) redraw the viewport over several
+// frames instead of in one ~2.4-frame render: rows are drawn top to bottom,
+// REDRAW_ROWS_PER_FRAME per frame, under ink = paper attributes, and each
+// row is revealed once its pixels are complete, so a half-drawn viewport is
+// never seen. Input, animation clocks and the frame loop keep running.
+#if MULTICOLOUR
+#define REDRAW_ROWS_PER_FRAME 1     // ~17kT with the band colours, above the raster
+#elif TILE_FLIP
+#define REDRAW_ROWS_PER_FRAME 1     // up to ~39kT when every tile is flipped
+#else
+#define REDRAW_ROWS_PER_FRAME 3     // ~33kT with the asm row renderer
+#endif
+#define VIEWPORT_ATTR (PAPER_BLUE | BRIGHT | INK_BLACK)
+#define HIDDEN_ATTR   (PAPER_BLUE | BRIGHT | INK_BLUE)
+static unsigned char redraw_row = VIEWPORT_CHAR_ROWS;   // next row; ROWS: idle
+
+#if MULTICOLOUR
+// Band buffer (tile_render.h) and the step in progress. A step is done one
+// slice of char rows per window: above the raster (~24kT from the halt)
+// and, smaller, below it (~12kT less input). One axis per step.
+#define MC_SLICE_H      4       // ~14kT with the edge tiles
+#define MC_SLICE_H_MAN  3       // + ~7kT to take the man off and back on
+#define MC_SLICE_V      3       // ~14kT
+#define MC_SLICE_H_LOW  2
+#define MC_SLICE_V_LOW  1
+unsigned char mc_bands[VIEWPORT_CHAR_ROWS * MC_ROW_BYTES];
+unsigned char *mc_src[VIEWPORT_CHAR_ROWS * MC_BANDS];
+static unsigned char mc_ring[VIEWPORT_CHAR_ROWS];   // viewport row -> band buffer row
+static unsigned char mc_h[VIEWPORT_CHAR_ROWS];      // band buffer row -> window start
+static unsigned char mc_hidden[VIEWPORT_COLS];      // raster source while hidden
+static signed char mc_dx = 0;                       // step in progress
+static signed char mc_dy = 0;
+static unsigned char mc_next;                       // next row (shift down: end row)
+static unsigned char mc_free;                       // band buffer row scrolled out
+static unsigned char mc_diag = 0;                   // axis of a diagonal's next step
+#endif
+
 // Input reader (keyboard + Kempston joystick)
 static unsigned char read_input(void) {
     unsigned char dir = 0;
+    unsigned char dash = in_key_pressed(IN_KEY_SCANCODE_SPACE) ? INPUT_DASH : 0;
 
     // Keyboard
     if (in_key_pressed(IN_KEY_SCANCODE_q)) dir |= 0x08;  // up
@@ -36,7 +179,7 @@ static unsigned char read_input(void) {
     if (in_key_pressed(IN_KEY_SCANCODE_o)) dir |= 0x02;  // left
     if (in_key_pressed(IN_KEY_SCANCODE_p)) dir |= 0x01;  // right
 
-    if (dir) return dir;
+    if (dir) return dir | dash;
 
     // Kempston joystick fallback
     {
@@ -45,9 +188,11 @@ static unsigned char read_input(void) {
         if (joy & IN_STICK_DOWN)  dir |= 0x04;
         if (joy & IN_STICK_LEFT)  dir |= 0x02;
         if (joy & IN_STICK_RIGHT) dir |= 0x01;
+        if (joy & IN_STICK_FIRE)  dash = INPUT_DASH;
     }
 
-    return dir;
+    // Dash only with a direction, so an idle frame stays input == 0
+    return dir ? dir | dash : 0;
 }
 
 static void flash_border_red(void) {
@@ -67,8 +212,13 @@ static void reset_border(void) {
 // Handle a single tile under the man. Returns 1 if solid (blocks movement).
 static unsigned char handle_tile(unsigned char tile) {
     switch (tile) {
+#if SOUND
+        case 1: snd_sfx(SFX_BUMP); return 1;
+        case 3: flash_border_red(); snd_sfx(SFX_TRIGGER); return 0;
+#else
         case 1: return 1;  // solid wall
         case 3: flash_border_red(); return 0;
+#endif
         default: return 0;
     }
 }
@@ -78,41 +228,55 @@ static unsigned char handle_tile(unsigned char tile) {
 static unsigned char man_can_move(int cam_x, int cam_y) {
     int mx = cam_x + MAN_VIEWPORT_COL;
     int my = cam_y + MAN_VIEWPORT_ROW;
+#if !METATILE
     unsigned int off;
+#endif
 
     if (mx < 0 || mx + 1 >= MAP_WIDTH || my < 0 || my + 1 >= MAP_HEIGHT)
         return 1;
 
     reset_border();
-    off = (unsigned int)my * MAP_WIDTH + mx;
+#if METATILE
+    if (handle_tile(MAP_CELL(mx, my)) || handle_tile(MAP_CELL(mx + 1, my))
+      || handle_tile(MAP_CELL(mx, my + 1)) || handle_tile(MAP_CELL(mx + 1, my + 1)))
+        return 0;
+#else
+    off = MAP_ROW_OFFSET(my) + mx;
 
     if (handle_tile(map_data[off]) || handle_tile(map_data[off + 1])
-      || handle_tile(map_data[off + MAP_WIDTH]) || handle_tile(map_data[off + MAP_WIDTH + 1]))
+      || handle_tile(map_data[off + MAP_STRIDE]) || handle_tile(map_data[off + MAP_STRIDE + 1]))
         return 0;
+#endif
     return 1;
 }
 
-// Update camera based on input direction
+// Update camera based on input direction. A dash moves up to DASH_STEP
+// tiles, one tile at a time so walls still stop it.
 // Returns nonzero if camera moved
 static unsigned char update_camera(unsigned char input) {
-    int new_x = camera_tile_x;
-    int new_y = camera_tile_y;
+    unsigned char step = (input & INPUT_DASH) ? DASH_STEP : 1;
 
     prev_tile_x = camera_tile_x;
     prev_tile_y = camera_tile_y;
 
-    // Horizontal axis (no edge-of-map limits)
-    if (input & 0x01) new_x++;  // right
-    if (input & 0x02) new_x--;  // left
-    if (!man_can_move(new_x, new_y)) new_x = camera_tile_x;
+    for (; step; step--) {
+        int new_x = camera_tile_x;
+        int new_y = camera_tile_y;
+
+        // Horizontal axis (no edge-of-map limits)
+        if (input & 0x01) new_x++;  // right
+        if (input & 0x02) new_x--;  // left
+        if (!man_can_move(new_x, new_y)) new_x = camera_tile_x;
 
-    // Vertical axis (no edge-of-map limits)
-    if (input & 0x04) new_y++;  // down
-    if (input & 0x08) new_y--;  // up
-    if (!man_can_move(new_x, new_y)) new_y = camera_tile_y;
+        // Vertical axis (no edge-of-map limits)
+        if (input & 0x04) new_y++;  // down
+        if (input & 0x08) new_y--;  // up
+        if (!man_can_move(new_x, new_y)) new_y = camera_tile_y;
 
-    camera_tile_x = new_x;
-    camera_tile_y = new_y;
+        if (new_x == camera_tile_x && new_y == camera_tile_y) break;
+        camera_tile_x = new_x;
+        camera_tile_y = new_y;
+    }
 
     return (camera_tile_x != prev_tile_x) || (camera_tile_y != prev_tile_y);
 }
@@ -121,65 +285,584 @@ static unsigned char update_camera(unsigned char input) {
 static unsigned char safe_tile(int x, int y) {
     if ((unsigned int)x >= MAP_WIDTH || (unsigned int)y >= MAP_HEIGHT)
         return 0;
-    return map_data[y * MAP_WIDTH + x];
+    return MAP_CELL(x, y);
+}
+
+#if TILE_ATTRS
+// Attribute cell of a viewport char row / screen column
+#define VIEWPORT_ATTR_CELL(vp_row, screen_col) \
+    ((unsigned char *)(0x5800 + (VIEWPORT_START_CHAR_ROW + (vp_row)) * 32 + (screen_col)))
+#endif
+
+#if MULTICOLOUR
+// Band 0 of a viewport row in the band buffer
+#define MC_ROW(r) (&mc_bands[mc_ring[r] * MC_ROW_BYTES])
+
+// Point the raster at a viewport row's windows
+static void mc_row_set(unsigned char r) {
+    unsigned char *p = MC_ROW(r) + mc_h[mc_ring[r]];
+    unsigned char **src = &mc_src[r * MC_BANDS];
+    src[0] = p;
+    src[1] = p + MC_BAND_BYTES;
+    src[2] = p + 2 * MC_BAND_BYTES;
+    src[3] = p + 3 * MC_BAND_BYTES;
+}
+
+// Band 0 of viewport column c of row r (first copy; the second is
+// VIEWPORT_COLS on)
+static unsigned char *mc_cell(unsigned char r, unsigned char c) {
+    unsigned char p = mc_h[mc_ring[r]] + c;
+    if (p >= VIEWPORT_COLS) p -= VIEWPORT_COLS;
+    return MC_ROW(r) + p;
+}
+
+// Colour one tile in the band buffer from the band tables
+static void mc_colour_tile(unsigned char tile, unsigned char r, unsigned char c) {
+    unsigned char *p = mc_cell(r, c);
+    const unsigned char *t = &tiles[MC_TABLE_OFFSET + tile];
+    unsigned char k;
+    for (k = 0; k < MC_BANDS; k++, p += MC_BAND_BYTES, t += 256)
+        p[0] = p[VIEWPORT_COLS] = *t;
+}
+
+// Identity band buffer rows, the viewport hidden, no step in progress
+static void mc_reset(void) {
+    unsigned char i;
+    memset(mc_hidden, HIDDEN_ATTR, VIEWPORT_COLS);
+    for (i = 0; i < VIEWPORT_CHAR_ROWS; i++) mc_ring[i] = i;
+    for (i = 0; i < VIEWPORT_CHAR_ROWS * MC_BANDS; i++) mc_src[i] = mc_hidden;
+    mc_dx = mc_dy = 0;
 }
+#endif
 
-// Render a single tile to screen (0 = empty pixels)
+// Render a single tile to screen (0 = empty pixels), with its colour
+// under TILE_ATTRS / MULTICOLOUR
 static void render_tile_at(unsigned char tile, unsigned char vp_row, unsigned char screen_col) {
     unsigned char s;
     unsigned int base = (unsigned int)vp_row * 8;
+#if TILE_ATTRS
+    *VIEWPORT_ATTR_CELL(vp_row, screen_col) = tiles[TILE_ATTR_OFFSET + tile];
+#elif MULTICOLOUR
+    mc_colour_tile(tile, vp_row, screen_col - VIEWPORT_COL_OFFSET);
+#endif
+#if TILE_FLIP
+    if (tile & (TILE_FLIP_H | TILE_FLIP_V)) {
+        const unsigned char *src = &tiles[(tile & TILE_INDEX_MASK) * 8];
+        for (s = 0; s < 8; s++) {
+            unsigned char *p = (unsigned char *)(scr_addr_table_direct[base + s] + screen_col);
+            unsigned char b = src[(tile & TILE_FLIP_V) ? 7 - s : s];
+            *p = (tile & TILE_FLIP_H) ? tiles[TILE_REV_OFFSET + b] : b;
+        }
+        return;
+    }
+#endif
     for (s = 0; s < 8; s++) {
         unsigned char *p = (unsigned char *)(scr_addr_table_direct[base + s] + screen_col);
         *p = tile ? tiles[tile * 8 + s] : 0;
     }
 }
 
+#if !MULTICOLOUR
 // Render a column tile-by-tile with bounds checking (C fallback)
 static void safe_render_column(unsigned char screen_col, int map_x) {
     unsigned char row;
-    __asm di __endasm;
+#if !SOUND
+    __asm di __endasm;          // plain C stores: a SOUND build takes its tick
+#endif
     for (row = 0; row < VIEWPORT_CHAR_ROWS; row++)
         render_tile_at(safe_tile(map_x, camera_tile_y + row), row, screen_col);
+#if !SOUND
     __asm ei __endasm;
+#endif
 }
+#endif
 
 // Render a row tile-by-tile with bounds checking (C fallback)
 static void safe_render_row(unsigned char viewport_row, int map_y) {
     unsigned char col;
+#if !SOUND
     __asm di __endasm;
+#endif
     for (col = 0; col < VIEWPORT_COLS; col++)
         render_tile_at(safe_tile(camera_tile_x + col, map_y), viewport_row, VIEWPORT_COL_OFFSET + col);
+#if !SOUND
     __asm ei __endasm;
+#endif
+}
+
+#if TILE_ATTRS
+// Colour a dirty column from the attribute table: assembly when fully in
+// bounds, C per tile otherwise (off-map cells take tile 0's colour)
+static void attr_column(unsigned char screen_col, int map_x) {
+    unsigned char row;
+    if ((unsigned int)map_x < MAP_WIDTH && camera_tile_y >= 0
+        && camera_tile_y + VIEWPORT_CHAR_ROWS <= MAP_HEIGHT) {
+        attr_dirty_column(screen_col, MAP_COL(map_x, camera_tile_y));
+        return;
+    }
+    for (row = 0; row < VIEWPORT_CHAR_ROWS; row++)
+        *VIEWPORT_ATTR_CELL(row, screen_col) = tiles[TILE_ATTR_OFFSET + safe_tile(map_x, camera_tile_y + row)];
+}
+
+// Colour a dirty row, as attr_column
+static void attr_row(unsigned char viewport_row, int map_y) {
+    unsigned char col;
+    if ((unsigned int)map_y < MAP_HEIGHT && camera_tile_x >= 0
+        && camera_tile_x + VIEWPORT_COLS <= MAP_WIDTH) {
+        attr_dirty_row(viewport_row, MAP_ROW(camera_tile_x, map_y));
+        return;
+    }
+    for (col = 0; col < VIEWPORT_COLS; col++)
+        *VIEWPORT_ATTR_CELL(viewport_row, VIEWPORT_COL_OFFSET + col) =
+            tiles[TILE_ATTR_OFFSET + safe_tile(camera_tile_x + col, map_y)];
+}
+#elif MULTICOLOUR
+// Colour a dirty row in the band buffer: assembly when fully in bounds,
+// C per tile otherwise (edge columns are coloured by mc_edge_column)
+static void attr_row(unsigned char viewport_row, int map_y) {
+    unsigned char col;
+    if ((unsigned int)map_y < MAP_HEIGHT && camera_tile_x >= 0
+        && camera_tile_x + VIEWPORT_COLS <= MAP_WIDTH) {
+        mc_colour_row(mc_h[mc_ring[viewport_row]], MC_ROW(viewport_row),
+                      MAP_ROW(camera_tile_x, map_y));
+        return;
+    }
+    for (col = 0; col < VIEWPORT_COLS; col++)
+        mc_colour_tile(safe_tile(camera_tile_x + col, map_y), viewport_row, col);
+}
+#endif
+
+// Occupancy test: 1 if bits first..first+count-1 of a row/column bitmap are
+// all clear, i.e. every tile in the span is blank. Touches at most 4 bytes.
+static unsigned char occ_span_blank(const unsigned char *bits, unsigned char first, unsigned char count) {
+    unsigned char last = first + count - 1;
+    unsigned char i = first >> 3;
+    unsigned char end = last >> 3;
+    unsigned char mask = 0xFF >> (first & 7);
+    for (;;) {
+        unsigned char b = bits[i] & mask;
+        if (i == end)
+            return (b & (unsigned char)(0xFF << (7 - (last & 7)))) == 0;
+        if (b) return 0;
+        mask = 0xFF;
+        i++;
+    }
+}
+
+#if ANIM_TILES
+static void anim_add(unsigned char a, unsigned char x, unsigned char y) {
+    unsigned char n = anim_count[a];
+    if (n == ANIM_MAX_INSTANCES) {
+        anim_overflow |= 1 << a;
+        return;
+    }
+    anim_x[a][n] = x;
+    anim_y[a][n] = y;
+    anim_count[a] = n + 1;
+}
+
+// Record a row edge drawn this step (rows come in ascending order)
+static void anim_row_drawn(int map_y) {
+    if (map_y != anim_skip_y1) anim_skip_y0 = map_y;
+    anim_skip_y1 = map_y + 1;
+}
+
+// Index the animated tiles in an on-map edge span that has just been drawn.
+// The corner of a diagonal step is in both edges; the column skips it.
+static void anim_scan(int x, int y, unsigned char n, unsigned char horizontal) {
+    const unsigned char *p = horizontal ? MAP_ROW(x, y) : MAP_COL(x, y);
+    for (; n; n--) {
+        unsigned char t = *p;
+        if (t < ANIM_SLOTS && anim_of_slot[t] && (horizontal || y < anim_skip_y0 || y >= anim_skip_y1))
+            anim_add(anim_of_slot[t] - 1, x, y);
+        if (horizontal) {
+            p++;
+            x++;
+        } else {
+            p += MAP_COL_STEP;
+            y++;
+        }
+    }
+}
+
+// Drop instances outside the camera window. The compaction is stable, so
+// the entries still waiting for a redraw stay below anim_pending[a].
+static void anim_prune(void) {
+    unsigned char a, i, n, pending;
+    for (a = 0; a < TILE_ANIM_COUNT; a++) {
+        n = 0;
+        pending = 0;
+        for (i = 0; i < anim_count[a]; i++) {
+            if ((unsigned int)(anim_x[a][i] - camera_tile_x) >= VIEWPORT_COLS
+                || (unsigned int)(anim_y[a][i] - camera_tile_y) >= VIEWPORT_CHAR_ROWS)
+                continue;
+            if (i < anim_pending[a]) pending++;
+            anim_x[a][n] = anim_x[a][i];
+            anim_y[a][n] = anim_y[a][i];
+            n++;
+        }
+        anim_count[a] = n;
+        anim_pending[a] = pending;
+    }
+}
+
+// Rebuild the index from the on-map part of the viewport (~320 map reads)
+static void anim_rescan(void) {
+    int x0 = camera_tile_x < 0 ? 0 : camera_tile_x;
+    int x1 = camera_tile_x + VIEWPORT_COLS;
+    int y;
+    unsigned char a;
+    if (x1 > MAP_WIDTH) x1 = MAP_WIDTH;
+    for (a = 0; a < TILE_ANIM_COUNT; a++) anim_count[a] = 0;
+    anim_overflow = 0;
+    if (x0 >= x1) return;
+    for (y = camera_tile_y; y < camera_tile_y + VIEWPORT_CHAR_ROWS; y++)
+        if ((unsigned int)y < MAP_HEIGHT)
+            anim_scan(x0, y, x1 - x0, 1);
+}
+
+static void anim_init(void) {
+    unsigned char a;
+    for (a = 0; a < TILE_ANIM_COUNT; a++) {
+        anim_of_slot[tile_anim_slot[a]] = a + 1;
+        anim_due[a] = tile_anim_period[a];
+    }
+}
+
+// Idle-frame work: prune after a scroll, step due animations, then redraw
+// at most ANIM_REDRAW_BUDGET on-screen instances. The man's 2x2 cells are
+// left alone; redraw_sprite_tiles() repaints them from the current slots.
+// An animation that overflowed its index is rescanned once pruning has made
+// room, so the index catches up with the instances it had to drop.
+static void anim_service(void) {
+    unsigned char a, budget = ANIM_REDRAW_BUDGET;
+
+    if (anim_moved) {
+        anim_moved = 0;
+        anim_prune();
+        for (a = 0; a < TILE_ANIM_COUNT; a++) {
+            if ((anim_overflow & (1 << a)) && anim_count[a] < ANIM_MAX_INSTANCES) {
+                anim_rescan();
+                for (a = 0; a < TILE_ANIM_COUNT; a++) anim_pending[a] = anim_count[a];
+                break;
+            }
+        }
+    }
+    for (a = 0; a < TILE_ANIM_COUNT; a++) {
+        if ((signed char)(anim_clock - anim_due[a]) < 0) continue;
+        anim_due[a] += tile_anim_period[a];
+        if (++anim_frame[a] == tile_anim_nframes[a]) anim_frame[a] = 0;
+        memcpy((unsigned char *)&tiles[tile_anim_slot[a] * 8],
+               &tiles[tile_anim_frames[a][anim_frame[a]] * 8], 8);
+        anim_pending[a] = anim_count[a];
+#if EDGE_CACHE
+        edge_valid = 0;                 // strips hold the previous frame
+#endif
+    }
+    for (a = 0; a < TILE_ANIM_COUNT && budget; a++) {
+        while (anim_pending[a] && budget) {
+            unsigned char i = --anim_pending[a];
+            unsigned char c = anim_x[a][i] - camera_tile_x;
+            unsigned char r = anim_y[a][i] - camera_tile_y;
+            if ((unsigned char)(c - MAN_VIEWPORT_COL) < 2 && (unsigned char)(r - MAN_VIEWPORT_ROW) < 2)
+                continue;
+            render_tile_at(tile_anim_slot[a], r, VIEWPORT_COL_OFFSET + c);
+            budget--;
+        }
+    }
+}
+#endif
+
+#if EDGE_CACHE
+// 1 if strip e holds the edge whose first tile is map (x, y)
+static unsigned char edge_hit(unsigned char e, int x, int y) {
+    return (edge_valid & (1 << e)) && edge_x[e] == x && edge_y[e] == y;
+}
+
+static void edge_tag(unsigned char e, int x, int y) {
+    edge_x[e] = x;
+    edge_y[e] = y;
+    edge_valid |= 1 << e;
+}
+
+// Idle-frame work: pre-render every edge the next step could draw. Only
+// spans the asm renderers would draw (on the map, not blank) are cached;
+// blank spans clear in ~2kT anyway. ~27kT when all four strips are stale.
+static void edge_service(void) {
+    unsigned char e;
+    for (e = EDGE_LEFT; e <= EDGE_BOTTOM; e++) {
+        int x = camera_tile_x;
+        int y = camera_tile_y;
+        if (e == EDGE_LEFT) x--;
+        else if (e == EDGE_RIGHT) x += VIEWPORT_COLS;
+        else if (e == EDGE_TOP) y--;
+        else y += VIEWPORT_CHAR_ROWS;
+        if (edge_hit(e, x, y)) continue;
+
+        edge_valid &= ~(1 << e);
+        if (e <= EDGE_RIGHT) {
+            if ((unsigned int)x >= MAP_WIDTH || y < 0 || y + VIEWPORT_CHAR_ROWS > MAP_HEIGHT
+                || occ_span_blank(&map_col_occ[x * MAP_COL_OCC_BYTES], y, VIEWPORT_CHAR_ROWS))
+                continue;
+            prerender_edge_column(EDGE_COL_STRIP(e), MAP_COL(x, y));
+        } else {
+            if ((unsigned int)y >= MAP_HEIGHT || x < 0 || x + VIEWPORT_COLS > MAP_WIDTH
+                || occ_span_blank(&map_row_occ[y * MAP_ROW_OCC_BYTES], x, VIEWPORT_COLS))
+                continue;
+            prerender_edge_row(edge_row_strip[e - EDGE_TOP], MAP_ROW(x, y));
+        }
+        edge_tag(e, x, y);
+    }
+}
+
+// Before the shifts of a straight step: keep the last column/row to scroll
+// out (~3-4kT), the one next to the new viewport. Skipped while animation
+// redraws are pending, as the screen may still show a previous frame.
+static void edge_save(int dx, int dy) {
+#if ANIM_TILES
+    unsigned char a;
+    for (a = 0; a < TILE_ANIM_COUNT; a++)
+        if (anim_pending[a]) return;
+#endif
+    if (dy == 0) {
+        if (dx > 0) {
+            save_edge_column(VIEWPORT_COL_OFFSET + dx - 1, EDGE_COL_STRIP(EDGE_LEFT));
+            edge_tag(EDGE_LEFT, prev_tile_x + dx - 1, camera_tile_y);
+        } else {
+            save_edge_column(VIEWPORT_COL_OFFSET + VIEWPORT_COLS + dx, EDGE_COL_STRIP(EDGE_RIGHT));
+            edge_tag(EDGE_RIGHT, prev_tile_x + VIEWPORT_COLS + dx, camera_tile_y);
+        }
+    } else if (dx == 0) {
+        if (dy > 0) {
+            save_edge_row(dy - 1, edge_row_strip[0]);
+            edge_tag(EDGE_TOP, camera_tile_x, prev_tile_y + dy - 1);
+        } else {
+            save_edge_row(VIEWPORT_CHAR_ROWS + dy, edge_row_strip[1]);
+            edge_tag(EDGE_BOTTOM, camera_tile_x, prev_tile_y + VIEWPORT_CHAR_ROWS + dy);
+        }
+    }
 }
+#endif
 
-// Render a dirty column: assembly when fully in bounds, C per-tile otherwise
+#if !MULTICOLOUR
+// Render a dirty column: zero fill when the on-map part is blank, a blit
+// when the edge cache holds it, assembly when fully in bounds, C per-tile
+// otherwise. Under TILE_ATTRS / MULTICOLOUR the colours follow the pixels.
 static void draw_column(unsigned char screen_col, int map_x) {
-    if (map_x >= 0 && map_x < MAP_WIDTH
-        && camera_tile_y >= 0 && camera_tile_y + VIEWPORT_CHAR_ROWS <= MAP_HEIGHT)
-        render_dirty_column(screen_col, &map_data[camera_tile_y * MAP_WIDTH + map_x]);
+    int y0 = camera_tile_y < 0 ? 0 : camera_tile_y;
+    int y1 = camera_tile_y + VIEWPORT_CHAR_ROWS;
+#if EDGE_CACHE
+    unsigned char e = EDGE_OF_COL(screen_col);
+#endif
+    if (y1 > MAP_HEIGHT) y1 = MAP_HEIGHT;
+
+    if ((unsigned int)map_x >= MAP_WIDTH || y0 >= y1
+        || occ_span_blank(&map_col_occ[map_x * MAP_COL_OCC_BYTES], y0, y1 - y0)) {
+        clear_dirty_column(screen_col);
+#if TILE_ATTRS
+        attr_column(screen_col, map_x);
+#endif
+        return;
+    }
+#if EDGE_CACHE
+    if (edge_hit(e, map_x, camera_tile_y)) {
+        blit_edge_column(screen_col, EDGE_COL_STRIP(e));
+#if SOUND
+        edge_valid &= ~(1 << e);
+#endif
+    } else
+#endif
+    if (y0 == camera_tile_y && y1 == camera_tile_y + VIEWPORT_CHAR_ROWS)
+        render_dirty_column(screen_col, MAP_COL(map_x, camera_tile_y));
     else
         safe_render_column(screen_col, map_x);
+#if TILE_ATTRS
+    attr_column(screen_col, map_x);
+#endif
+#if ANIM_TILES
+    anim_scan(map_x, y0, y1 - y0, 0);
+#endif
 }
+#endif
 
-// Render a dirty row: assembly when fully in bounds, C per-tile otherwise
+// Render a dirty row: zero fill when the on-map part is blank, a blit
+// when the edge cache holds it, assembly when fully in bounds, C per-tile
+// otherwise. Under TILE_ATTRS / MULTICOLOUR the colours follow the pixels.
 static void draw_row(unsigned char viewport_row, int map_y) {
-    if (map_y >= 0 && map_y < MAP_HEIGHT
-        && camera_tile_x >= 0 && camera_tile_x + VIEWPORT_COLS <= MAP_WIDTH)
-        render_dirty_row(viewport_row, &map_data[map_y * MAP_WIDTH + camera_tile_x]);
+    int x0 = camera_tile_x < 0 ? 0 : camera_tile_x;
+    int x1 = camera_tile_x + VIEWPORT_COLS;
+#if EDGE_CACHE
+    unsigned char e = EDGE_OF_ROW(viewport_row);
+#endif
+    if (x1 > MAP_WIDTH) x1 = MAP_WIDTH;
+#if ANIM_TILES
+    anim_row_drawn(map_y);
+#endif
+
+    if ((unsigned int)map_y >= MAP_HEIGHT || x0 >= x1
+        || occ_span_blank(&map_row_occ[map_y * MAP_ROW_OCC_BYTES], x0, x1 - x0)) {
+        clear_dirty_row(viewport_row);
+#if TILE_ATTRS || MULTICOLOUR
+        attr_row(viewport_row, map_y);
+#endif
+        return;
+    }
+#if EDGE_CACHE
+    if (edge_hit(e, camera_tile_x, map_y))
+        blit_edge_row(viewport_row, edge_row_strip[e - EDGE_TOP]);
+    else
+#endif
+    if (x0 == camera_tile_x && x1 == camera_tile_x + VIEWPORT_COLS)
+        render_dirty_row(viewport_row, MAP_ROW(camera_tile_x, map_y));
     else
         safe_render_row(viewport_row, map_y);
+#if TILE_ATTRS || MULTICOLOUR
+    attr_row(viewport_row, map_y);
+#endif
+#if ANIM_TILES
+    anim_scan(x0, map_y, x1 - x0, 1);
+#endif
+}
+
+#if !MULTICOLOUR
+// Dash edge of n columns: one render_dirty_columns call when all of them
+// are on the map, none is blank and none is in the edge cache; otherwise
+// column by column through draw_column. A metatile map stages one edge at
+// a time, so it always goes column by column.
+static void draw_columns(unsigned char screen_col, int map_x, unsigned char n) {
+    unsigned char i;
+#if !METATILE
+    if (n > 1 && map_x >= 0 && map_x + n <= MAP_WIDTH
+        && camera_tile_y >= 0 && camera_tile_y + VIEWPORT_CHAR_ROWS <= MAP_HEIGHT) {
+        for (i = 0; i < n; i++) {
+            if (occ_span_blank(&map_col_occ[(map_x + i) * MAP_COL_OCC_BYTES], camera_tile_y, VIEWPORT_CHAR_ROWS))
+                break;
+#if EDGE_CACHE
+            if (edge_hit(EDGE_OF_COL(screen_col + i), map_x + i, camera_tile_y))
+                break;
+#endif
+        }
+        if (i == n) {
+            render_dirty_columns(screen_col, &map_data[MAP_ROW_OFFSET(camera_tile_y) + map_x], n);
+#if TILE_ATTRS
+            for (i = 0; i < n; i++) attr_column(screen_col + i, map_x + i);
+#endif
+#if ANIM_TILES
+            for (i = 0; i < n; i++) anim_scan(map_x + i, camera_tile_y, VIEWPORT_CHAR_ROWS, 0);
+#endif
+            return;
+        }
+    }
+#endif
+    for (i = 0; i < n; i++)
+        draw_column(screen_col + i, map_x + i);
+}
+
+// Dash edge of n rows, as draw_columns
+static void draw_rows(unsigned char viewport_row, int map_y, unsigned char n) {
+    unsigned char i;
+#if !METATILE
+    if (n > 1 && map_y >= 0 && map_y + n <= MAP_HEIGHT
+        && camera_tile_x >= 0 && camera_tile_x + VIEWPORT_COLS <= MAP_WIDTH) {
+        for (i = 0; i < n; i++) {
+            if (occ_span_blank(&map_row_occ[(map_y + i) * MAP_ROW_OCC_BYTES], camera_tile_x, VIEWPORT_COLS))
+                break;
+#if EDGE_CACHE
+            if (edge_hit(EDGE_OF_ROW(viewport_row + i), camera_tile_x, map_y + i))
+                break;
+#endif
+        }
+        if (i == n) {
+            render_dirty_rows(viewport_row, &map_data[MAP_ROW_OFFSET(map_y) + camera_tile_x], n);
+#if TILE_ATTRS
+            for (i = 0; i < n; i++) attr_row(viewport_row + i, map_y + i);
+#endif
+#if ANIM_TILES
+            for (i = 0; i < n; i++) {
+                anim_row_drawn(map_y + i);
+                anim_scan(camera_tile_x, map_y + i, VIEWPORT_COLS, 1);
+            }
+#endif
+            return;
+        }
+    }
+#endif
+    for (i = 0; i < n; i++)
+        draw_row(viewport_row + i, map_y + i);
+}
+#endif
+
+// Forget what the screen held: animation index and edge cache
+static void viewport_reset(void) {
+#if ANIM_TILES
+    unsigned char a;
+    for (a = 0; a < TILE_ANIM_COUNT; a++) anim_count[a] = anim_pending[a] = 0;
+    anim_overflow = 0;
+    anim_skip_y0 = anim_skip_y1 = 0;
+#endif
+#if EDGE_CACHE
+    edge_valid = 0;
+#endif
 }
 
+#if !LEVEL_PACK
+// Render the whole viewport row by row; blank rows are zero-filled
+static void draw_viewport(void) {
+    unsigned char row;
+    viewport_reset();
+    for (row = 0; row < VIEWPORT_CHAR_ROWS; row++)
+        draw_row(row, camera_tile_y + row);
+}
+#endif
+
+// Set the attributes of one viewport char row
+static void set_row_attrs(unsigned char row, unsigned char value) {
+    unsigned char *attr = (unsigned char *)(0x5800
+        + (VIEWPORT_START_CHAR_ROW + row) * 32
+        + VIEWPORT_COL_OFFSET);
+    memset(attr, value, VIEWPORT_COLS);
+}
 
 // Clear attributes in the viewport area (white paper, black ink)
 void clear_viewport_attrs(void) {
     unsigned char row;
-    for (row = 0; row < VIEWPORT_CHAR_ROWS; row++) {
-        unsigned char *attr = (unsigned char *)(0x5800
-            + (VIEWPORT_START_CHAR_ROW + row) * 32
-            + VIEWPORT_COL_OFFSET);
-        memset(attr, PAPER_BLUE | BRIGHT | INK_BLACK, VIEWPORT_COLS);
+    for (row = 0; row < VIEWPORT_CHAR_ROWS; row++)
+        set_row_attrs(row, VIEWPORT_ATTR);
+}
+
+// Start a progressive redraw at a new camera position: hide the viewport
+// (~8kT), then redraw_service draws it over the next frames
+static void camera_jump(int x, int y) {
+#if MULTICOLOUR
+    camera_tile_x = x;
+    camera_tile_y = y;
+    mc_reset();                 // also drops a step in progress
+#else
+    unsigned char row;
+    camera_tile_x = x;
+    camera_tile_y = y;
+    for (row = 0; row < VIEWPORT_CHAR_ROWS; row++)
+        set_row_attrs(row, HIDDEN_ATTR);
+#endif
+    viewport_reset();
+    redraw_row = 0;
+}
+
+// One frame of a progressive redraw, right after the halt so the rows are
+// written while the beam is still in the top border or above them. Bounded
+// by REDRAW_ROWS_PER_FRAME rows; the man goes on once the last row is shown.
+static void redraw_service(void) {
+    unsigned char n;
+    for (n = REDRAW_ROWS_PER_FRAME; n && redraw_row < VIEWPORT_CHAR_ROWS; n--, redraw_row++) {
+        draw_row(redraw_row, camera_tile_y + redraw_row);
+#if MULTICOLOUR
+        mc_row_set(redraw_row);                     // draw_row coloured it
+#elif !TILE_ATTRS
+        set_row_attrs(redraw_row, VIEWPORT_ATTR);   // else draw_row coloured it
+#endif
     }
+    if (redraw_row == VIEWPORT_CHAR_ROWS)
+        draw_man();
 }
 
 void load_scr_to_screen(const unsigned char *scr) {
@@ -193,13 +876,20 @@ void load_scr_to_screen(const unsigned char *scr) {
 }
 
 // Background save buffer: 16 scanlines x 2 bytes + 4 attribute bytes
+// (4 cells x 4 bands under MULTICOLOUR)
 static unsigned char man_bg[32];
+#if MULTICOLOUR
+static unsigned char man_bg_attr[4 * MC_BANDS];
+#else
 static unsigned char man_bg_attr[4];
+#endif
+
+#if !MULTICOLOUR
 
 // Redraw tiles under the sprite + shifted ghost from the map.
 // Race-the-beam: called AFTER shifts (~50-70KT), so the ULA beam
 // has already passed the sprite at Y=120 (~45KT from interrupt).
-// The redraw area extends 1 tile in the shift direction to cover
+// The redraw area extends the step (1 tile, more on a dash) to cover
 // the ghost left behind by the shifted composited sprite pixels.
 static void redraw_sprite_tiles(int dx, int dy) {
     unsigned char r, c;
@@ -207,27 +897,33 @@ static void redraw_sprite_tiles(int dx, int dy) {
     unsigned char row0 = MAN_VIEWPORT_ROW;
     unsigned char col1 = MAN_VIEWPORT_COL + 2;
     unsigned char row1 = MAN_VIEWPORT_ROW + 2;
+#if !TILE_ATTRS
     unsigned char *attr;
+#endif
 
-    // Extend 1 tile in shift direction to cover ghost
-    if (dx > 0) col0--;
-    else if (dx < 0) col1++;
-    if (dy > 0) row0--;
-    else if (dy < 0) row1++;
+    // Extend in shift direction (1 tile, DASH_STEP on a dash) to cover ghost
+    if (dx > 0) col0 -= dx;
+    else if (dx < 0) col1 -= dx;
+    if (dy > 0) row0 -= dy;
+    else if (dy < 0) row1 -= dy;
 
     for (r = row0; r < row1; r++)
         for (c = col0; c < col1; c++)
             render_tile_at(safe_tile(camera_tile_x + c, camera_tile_y + r),
                            r, VIEWPORT_COL_OFFSET + c);
 
-    // Restore sprite attributes to viewport default
+#if !TILE_ATTRS
+    // Restore sprite attributes to viewport default (render_tile_at restored
+    // the tile colours under TILE_ATTRS)
     attr = (unsigned char *)(0x5800 + (VIEWPORT_START_CHAR_ROW + MAN_VIEWPORT_ROW) * 32 + MAN_SCREEN_COL);
-    attr[0] = PAPER_BLUE | BRIGHT | INK_BLACK;
-    attr[1] = PAPER_BLUE | BRIGHT | INK_BLACK;
+    attr[0] = VIEWPORT_ATTR;
+    attr[1] = VIEWPORT_ATTR;
     attr = (unsigned char *)(0x5800 + (VIEWPORT_START_CHAR_ROW + MAN_VIEWPORT_ROW + 1) * 32 + MAN_SCREEN_COL);
-    attr[0] = PAPER_BLUE | BRIGHT | INK_BLACK;
-    attr[1] = PAPER_BLUE | BRIGHT | INK_BLACK;
+    attr[0] = VIEWPORT_ATTR;
+    attr[1] = VIEWPORT_ATTR;
+#endif
 }
+#endif
 
 // Draw man sprite with mask compositing: (background & mask) | graphic
 void draw_man(void) {
@@ -248,6 +944,22 @@ void draw_man(void) {
         p[1] = (p[1] & sp[2]) | sp[3];
     }
 
+#if MULTICOLOUR
+    // Save and set the 2x2 cells' ink in all four bands of the band buffer
+    {
+        unsigned char r, c, k;
+        unsigned char *q;
+        i = 0;
+        for (r = 0; r < 2; r++)
+            for (c = 0; c < 2; c++) {
+                q = mc_cell(MAN_VIEWPORT_ROW + r, MAN_VIEWPORT_COL + c);
+                for (k = 0; k < MC_BANDS; k++, q += MC_BAND_BYTES) {
+                    man_bg_attr[i++] = q[0];
+                    q[0] = q[VIEWPORT_COLS] = (q[0] & 0xF8) | (r ? INK_GREEN : INK_YELLOW);
+                }
+            }
+    }
+#else
     // Save and set 2x2 attribute cells
     {
         unsigned char *attr;
@@ -262,56 +974,345 @@ void draw_man(void) {
         attr[0] = (attr[0] & 0xF8) | INK_GREEN;
         attr[1] = (attr[1] & 0xF8) | INK_GREEN;
     }
+#endif
 }
 
+#if MULTICOLOUR
+// Take the man off: background pixels and band colours back as draw_man
+// found them (the slice holding his rows then shifts a clean background)
+static void man_erase(void) {
+    unsigned char i, r, c, k;
+    unsigned char *p;
+
+    for (i = 0; i < 16; i++) {
+        p = (unsigned char *)(scr_addr_table_direct[MAN_TABLE_OFFSET + i] + MAN_SCREEN_COL);
+        p[0] = man_bg[i * 2];
+        p[1] = man_bg[i * 2 + 1];
+    }
+    i = 0;
+    for (r = 0; r < 2; r++)
+        for (c = 0; c < 2; c++) {
+            p = mc_cell(MAN_VIEWPORT_ROW + r, MAN_VIEWPORT_COL + c);
+            for (k = 0; k < MC_BANDS; k++, p += MC_BAND_BYTES)
+                p[0] = p[VIEWPORT_COLS] = man_bg_attr[i++];
+        }
+}
+
+// A step shifts along one axis (a slice moves its rows one way): no dash,
+// and a diagonal alternates between its axes
+static unsigned char mc_one_axis(unsigned char input) {
+    input &= ~INPUT_DASH;
+    if ((input & 0x03) && (input & 0x0C)) {
+        mc_diag ^= 1;
+        input &= mc_diag ? 0x03 : 0x0C;
+    }
+    return input;
+}
+
+// New edge column of rows first..first+n-1 after a horizontal slice:
+// assembly when on the map, C per tile otherwise; colours per tile
+static void mc_edge_column(unsigned char first, unsigned char n) {
+    unsigned char c = mc_dx > 0 ? VIEWPORT_COLS - 1 : 0;
+    int map_x = camera_tile_x + c;
+    int y = camera_tile_y + first;
+    unsigned char r;
+
+    if ((unsigned int)map_x < MAP_WIDTH && y >= 0 && y + n <= MAP_HEIGHT) {
+        const unsigned char *m = MAP_COL(map_x, y);
+        render_dirty_column_rows(VIEWPORT_COL_OFFSET + c, m, first, n);
+        for (r = 0; r < n; r++, m += MAP_COL_STEP)
+            mc_colour_tile(*m, first + r, c);
+#if ANIM_TILES
+        anim_scan(map_x, y, n, 0);
+#endif
+        return;
+    }
+#if !SOUND
+    __asm di __endasm;
+#endif
+    for (r = 0; r < n; r++)
+        render_tile_at(safe_tile(map_x, y + r), first + r, VIEWPORT_COL_OFFSET + c);
+#if !SOUND
+    __asm ei __endasm;
+#endif
+#if ANIM_TILES
+    if ((unsigned int)map_x < MAP_WIDTH) {
+        int y0 = y < 0 ? 0 : y;
+        int y1 = y + n > MAP_HEIGHT ? MAP_HEIGHT : y + n;
+        if (y0 < y1) anim_scan(map_x, y0, y1 - y0, 0);
+    }
+#endif
+}
+
+// Shift rows first..first+n-1 of the step and move their colours with
+// them: the window start for a horizontal step (then the new edge column),
+// the band buffer row for a vertical one. The man's rows go with him off.
+static void mc_slice(unsigned char first, unsigned char n) {
+    unsigned char man = first <= MAN_VIEWPORT_ROW + 1 && first + n > MAN_VIEWPORT_ROW;
+    unsigned char r, h;
+
+    if (man) man_erase();
+    if (mc_dx) {
+        if (mc_dx > 0) shift_viewport_left_rows(first, n);
+        else shift_viewport_right_rows(first, n);
+        for (r = first; r < first + n; r++) {
+            h = mc_h[mc_ring[r]];
+            if (mc_dx > 0) h = h == VIEWPORT_COLS - 1 ? 0 : h + 1;
+            else h = h ? h - 1 : VIEWPORT_COLS - 1;
+            mc_h[mc_ring[r]] = h;
+        }
+        mc_edge_column(first, n);
+    } else if (mc_dy > 0) {
+        shift_viewport_up_rows(first, n);
+        for (r = first; r < first + n; r++) mc_ring[r] = mc_ring[r + 1];
+    } else {
+        shift_viewport_down_rows(first, n);
+        for (r = first + n; r-- > first; ) mc_ring[r] = mc_ring[r - 1];
+    }
+    for (r = first; r < first + n; r++) mc_row_set(r);
+    if (man) draw_man();
+}
+
+// The new edge row of a vertical step, into the band buffer row that
+// scrolled out (~17kT: a window above the raster to itself)
+static void mc_edge_row(unsigned char row) {
+    mc_ring[row] = mc_free;
+    draw_row(row, camera_tile_y + row);
+    mc_row_set(row);
+}
+
+// Start a step: its slices follow, one per window
+static void mc_step_start(int dx, int dy) {
+    mc_dx = dx;
+    mc_dy = dy;
+    mc_next = dx ? MAN_VIEWPORT_ROW : dy < 0 ? VIEWPORT_CHAR_ROWS : 0;
+    mc_free = mc_ring[dy < 0 ? VIEWPORT_CHAR_ROWS - 1 : 0];
+}
+
+// The next slice of the step in progress. top: the window above the raster;
+// the slice holding the man's rows (with the row a vertical step moves him
+// from or to) and the edge row are only done there, and other slices are
+// smaller below it. Horizontal steps take 3 frames, vertical ones 6.
+static void mc_step_service(unsigned char top) {
+    unsigned char r = mc_next;
+    unsigned char n, limit;
+
+    if (mc_dx) {                        // rows in any order: the man's first
+        if (r == MAN_VIEWPORT_ROW) {    // (the step's first slice is on top)
+            n = MC_SLICE_H_MAN;
+        } else {
+            n = top ? MC_SLICE_H : MC_SLICE_H_LOW;
+            limit = r < MAN_VIEWPORT_ROW ? MAN_VIEWPORT_ROW - r : VIEWPORT_CHAR_ROWS - r;
+            if (n > limit) n = limit;
+        }
+        mc_slice(r, n);
+        r += n;
+        if (r == VIEWPORT_CHAR_ROWS) r = 0;
+        mc_next = r;
+        if (r == MAN_VIEWPORT_ROW) mc_dx = 0;
+    } else if (mc_dy > 0) {             // rows 0..14 top-down, then edge row 15
+        if (r == VIEWPORT_CHAR_ROWS - 1) {
+            if (!top) return;
+            mc_edge_row(r);
+            mc_dy = 0;
+            return;
+        }
+        if (r == MAN_VIEWPORT_ROW - 1) {
+            if (!top) return;
+            n = 3;
+        } else {
+            n = top ? MC_SLICE_V : MC_SLICE_V_LOW;
+            limit = r < MAN_VIEWPORT_ROW - 1 ? MAN_VIEWPORT_ROW - 1 - r : VIEWPORT_CHAR_ROWS - 1 - r;
+            if (n > limit) n = limit;
+        }
+        mc_slice(r, n);
+        mc_next = r + n;
+    } else {                            // rows 15..1 bottom-up, then edge row 0
+        if (r == 1) {
+            if (!top) return;
+            mc_edge_row(0);
+            mc_dy = 0;
+            return;
+        }
+        if (r == MAN_VIEWPORT_ROW + 3) {
+            if (!top) return;
+            n = 3;
+        } else {
+            n = top ? MC_SLICE_V : MC_SLICE_V_LOW;
+            limit = r > MAN_VIEWPORT_ROW + 3 ? r - (MAN_VIEWPORT_ROW + 3) : r - 1;
+            if (n > limit) n = limit;
+        }
+        mc_slice(r - n, n);
+        mc_next = r - n;
+    }
+}
+#endif
+
+#if LEVEL_PACK
+// Unpack a level from its RAM bank (HUD included) and redraw from the start.
+// The unpack itself is ~6 frames with interrupts off; the viewport is then
+// drawn progressively.
+static void level_switch(unsigned char level) {
+    current_level = level;
+#if SOUND
+    snd_silence();              // no ticks during the unpack
+#endif
+    level_unpack(level);
+#if MULTICOLOUR
+    mc_init_sync();             // the new HUD covered the sentinel row
+#endif
+    camera_jump(START_CAMERA_X, START_CAMERA_Y);
+}
+#endif
+
 void tile_render_main(void) {
-    const unsigned char *map_start;
+    unsigned char input;
 
+#if LEVEL_PACK
+    // Levels come from the 128K banks; level 0 brings its own HUD
+    level_pack_load();
+    level_switch(0);
+#else
     // Load HUD and set up attributes
     load_scr_to_screen(hud_scr);
     clear_viewport_attrs();
+#if MULTICOLOUR
+    mc_init_sync();
+    mc_reset();
+#endif
+#if ANIM_TILES
+    anim_init();
+#endif
 
-    // Initial full viewport render
-    map_start = &map_data[camera_tile_y * MAP_WIDTH + camera_tile_x];
-    render_full_viewport(map_start);
+    // Initial full viewport render (blank rows skip the tile fetches)
+    draw_viewport();
+#if MULTICOLOUR
+    {
+        unsigned char row;
+        for (row = 0; row < VIEWPORT_CHAR_ROWS; row++) mc_row_set(row);
+    }
+#endif
     draw_man();
+#endif
+#if SOUND
+    snd_init();                 // after the tape load: IM 2 from here on
+#endif
 
     // Main loop
     frame_count = 0;
+    input = 0;
     while (1) {
-        unsigned char input;
         unsigned char moved;
 
         intrinsic_halt();
 
+#if !MULTICOLOUR
+        input = read_input();
+#endif
+
+#if ANIM_TILES
+        anim_clock++;
+#endif
+#if MULTICOLOUR
+        // Above the raster: the step in progress comes first
+        if (mc_dx | mc_dy)
+            mc_step_service(1);
+        else
+#endif
+        // Camera jump in progress: its rows are this frame's work
+        if (redraw_row < VIEWPORT_CHAR_ROWS)
+            redraw_service();
+#if ANIM_TILES || EDGE_CACHE
+        // Frames that do not scroll: animate, then pre-render the edges
+        else if (frame_count + 1 < SCROLL_INTERVAL || input == 0) {
+#if ANIM_TILES
+            anim_service();
+#endif
+#if EDGE_CACHE
+            edge_service();
+#endif
+        }
+#endif
+#if MULTICOLOUR
+        // The raster takes the viewport's lines (the idle test above used
+        // last frame's input); input and a smaller slice go below it
+        mc_raster();
         input = read_input();
+        if (mc_dx | mc_dy)
+            mc_step_service(0);
+#endif
+
+        // H: respawn at the start; N: next level (on key press, not while held)
+        if (in_key_pressed(IN_KEY_SCANCODE_h)) {
+            if (!jump_key_down) {
+                jump_key_down = 1;
+                camera_jump(START_CAMERA_X, START_CAMERA_Y);
+            }
+#if LEVEL_PACK
+        } else if (in_key_pressed(IN_KEY_SCANCODE_n)) {
+            if (!jump_key_down) {
+                jump_key_down = 1;
+                level_switch(current_level + 1 < LEVEL_COUNT ? current_level + 1 : 0);
+            }
+#endif
+        } else {
+            jump_key_down = 0;
+        }
+
+        // No scrolling until the redraw is complete
+        if (redraw_row < VIEWPORT_CHAR_ROWS) {
+            frame_count = 0;
+            continue;
+        }
 
         frame_count++;
         if (frame_count < SCROLL_INTERVAL) continue;
         if (input == 0) { frame_count = SCROLL_INTERVAL - 1; continue; }
+#if MULTICOLOUR
+        // One step at a time: a vertical one outlasts SCROLL_INTERVAL
+        if (mc_dx | mc_dy) { frame_count = SCROLL_INTERVAL - 1; continue; }
+        input = mc_one_axis(input);
+#endif
         frame_count = 0;
 
         moved = update_camera(input);
         if (moved) {
             int dx = camera_tile_x - prev_tile_x;
             int dy = camera_tile_y - prev_tile_y;
+#if ANIM_TILES
+            anim_moved = 1;
+            anim_skip_y0 = anim_skip_y1 = 0;
+#endif
+#if EDGE_CACHE && EDGE_SAVE
+            edge_save(dx, dy);
+#endif
+#if MULTICOLOUR
+            // Slices over the next frames do the shifts, man and edge
+            mc_step_start(dx, dy);
+#else
 
-            // Phase 1: shifts first (each has internal DI/EI)
-            // Takes ~50-70KT; ULA passes sprite Y=120 at ~45KT
-            if (dx > 0) shift_viewport_left();
-            else if (dx < 0) shift_viewport_right();
-            if (dy > 0) shift_viewport_up();
-            else if (dy < 0) shift_viewport_down();
+            // Phase 1: shifts first (each has internal DI/EI; not under SOUND)
+            // Takes ~50-70KT; ULA passes sprite Y=120 at ~45KT.
+            // A dash shifts n tiles in one pass, no slower than one tile
+            if (dx == 1) shift_viewport_left();
+            else if (dx == -1) shift_viewport_right();
+            else if (dx > 0) shift_viewport_left_n(dx);
+            else if (dx < 0) shift_viewport_right_n(-dx);
+            if (dy == 1) shift_viewport_up();
+            else if (dy == -1) shift_viewport_down();
+            else if (dy > 0) shift_viewport_up_n(dy);
+            else if (dy < 0) shift_viewport_down_n(-dy);
 
             // Phase 2: redraw tiles under sprite + ghost + composite (beam past sprite)
             redraw_sprite_tiles(dx, dy);
             draw_man();
 
-            // Phase 3: fill stale edges
-            if (dy > 0) draw_row(VIEWPORT_CHAR_ROWS - 1, camera_tile_y + VIEWPORT_CHAR_ROWS - 1);
-            else if (dy < 0) draw_row(0, camera_tile_y);
-            if (dx > 0) draw_column(VIEWPORT_COL_OFFSET + VIEWPORT_COLS - 1, camera_tile_x + VIEWPORT_COLS - 1);
-            else if (dx < 0) draw_column(VIEWPORT_COL_OFFSET, camera_tile_x);
+            // Phase 3: fill stale edges (n wide on a dash)
+            if (dy > 0) draw_rows(VIEWPORT_CHAR_ROWS - dy, camera_tile_y + VIEWPORT_CHAR_ROWS - dy, dy);
+            else if (dy < 0) draw_rows(0, camera_tile_y, -dy);
+            if (dx > 0) draw_columns(VIEWPORT_COL_OFFSET + VIEWPORT_COLS - dx, camera_tile_x + VIEWPORT_COLS - dx, dx);
+            else if (dx < 0) draw_columns(VIEWPORT_COL_OFFSET, camera_tile_x, -dx);
+#endif
         }
     }
 }
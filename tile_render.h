@@ -4,33 +4,102 @@
 // Direct-to-screen tile renderer — Race the Beam
 // LDIR shift + dirty edge: shift viewport, then draw 1 new column/row.
 //
-// Viewport: 20 cols × 16 char rows at Y=64..191 (char rows 8-23)
+// Viewport: 20 cols × 16 char rows at Y=64..191 (char rows 8-23) by default
 // Tiles: ≤32 unique, page-aligned at 0x6000
 
-// Viewport parameters
-#define VIEWPORT_COLS           20
-#define VIEWPORT_CHAR_ROWS      16
-#define VIEWPORT_START_CHAR_ROW 8
-#define VIEWPORT_COL_OFFSET     6
+// Viewport parameters and map dimensions, generated from config/*.mk
+// (VIEWPORT_COLS, VIEWPORT_CHAR_ROWS, VIEWPORT_START_CHAR_ROW,
+// VIEWPORT_COL_OFFSET, MAP_WIDTH, MAP_HEIGHT, MAP_STRIDE)
+#include "viewport.h"
+
+// Byte offset of map row y: a shift when MAP_STRIDE is 128 or 256, so
+// collision and edge lookups avoid the 16-bit multiply helper
+#if MAP_STRIDE_SHIFT
+#define MAP_ROW_OFFSET(y) ((unsigned int)(y) << MAP_STRIDE_SHIFT)
+#else
+#define MAP_ROW_OFFSET(y) ((unsigned int)(y) * MAP_STRIDE)
+#endif
 
 #define VIEWPORT_WIDTH_PX       (VIEWPORT_COLS * 8)
 #define VIEWPORT_HEIGHT_PX      (VIEWPORT_CHAR_ROWS * 8)
 
-// Map dimensions
-#define MAP_WIDTH  96
-#define MAP_HEIGHT 48
+// Mirror-folded tiles (generate_tiles --fold-mirrors, build with -DTILE_FLIP=1)
+// Map bytes carry flip bits above the tile index. A flipped tile is decoded
+// into a scratch slot first, so the worst case (every tile flipped) is far
+// above the unflipped cost: ~35.8kT per column and ~38.9kT per row edge
+// (6.4kT / 10.8kT unflipped), ~102kT / ~125kT for a 3-wide dash edge. A
+// diagonal step can then pass SCROLL_INTERVAL frames and a dash takes
+// several; the camera-jump redraw drops to one row per frame. Real maps
+// flip few tiles: make costmap (frame_cost_map --flip) costs the flipped
+// tiles each reachable step actually draws.
+#ifndef TILE_FLIP
+#define TILE_FLIP 0
+#endif
+#define TILE_FLIP_H      0x80
+#define TILE_FLIP_V      0x40
+#define TILE_INDEX_MASK  0x1F
+#define TILE_REV_OFFSET  256    // bit-reverse table at tiles + 256 (0x6100)
+
+// Metatile maps (16x16 / 32x32 art: generate_tiles, generate_map --metatile;
+// METATILE = 2 or 4 from viewport.h). map_data holds one byte per block of
+// METATILE x METATILE cells, the offset of its cells (row-major) in the
+// dictionary page at tiles + 768 (0x6300). MAP_WIDTH/MAP_HEIGHT still count
+// cells. An edge is expanded into META_COL_STRIP / META_ROW_STRIP and the
+// edge renderers read that strip in place of map_data: down a column the
+// strip steps by 1 (MAP_COL_STEP), not MAP_STRIDE.
+#define META_DICT_OFFSET 768
+#if METATILE
+#define MAP_COL_STEP 1
+#else
+#define MAP_COL_STEP MAP_STRIDE
+#endif
+
+// Map occupancy bitmaps (generate_map -> map_occ.bin), bit set = non-blank
+// cell (also for metatile maps)
+#define MAP_ROW_OCC_BYTES ((MAP_WIDTH + 7) / 8)    // per map row
+#define MAP_COL_OCC_BYTES ((MAP_HEIGHT + 7) / 8)   // per map column
 
 // Assembly routines (tile_render_direct.asm)
+// Edge map pointers are into map_data, or into the expanded strip of a
+// metatile map (MAP_COL / MAP_ROW in tile_render.c)
 // screen_col: physical screen byte offset (VIEWPORT_COL_OFFSET + physical_col)
-// map_col_ptr: &map_data[tile_row * MAP_WIDTH + tile_col]
+// map_col_ptr: &map_data[tile_row * MAP_STRIDE + tile_col]
 void render_dirty_column(unsigned char screen_col, const unsigned char *map_col_ptr);
 
 // viewport_char_row: 0-15 (row within viewport)
-// map_row_ptr: &map_data[tile_row * MAP_WIDTH + tile_col]
+// map_row_ptr: &map_data[tile_row * MAP_STRIDE + tile_col]
 void render_dirty_row(unsigned char viewport_char_row, const unsigned char *map_row_ptr);
 
-// map_top_left: &map_data[camera_tile_y * MAP_WIDTH + camera_tile_x]
-void render_full_viewport(const unsigned char *map_top_left);
+#if METATILE
+// Expand the blocks along an edge into its strip (~0.8kT): meta_ptr is the
+// map byte of the first block, sub the cell column (column) or cell row x
+// METATILE (row) within it. The edge's first cell is at strip offset
+// y & (METATILE - 1) (column) or x & (METATILE - 1) (row).
+void meta_expand_column(const unsigned char *meta_ptr, unsigned char sub);
+void meta_expand_row(const unsigned char *meta_ptr, unsigned char sub);
+#endif
+
+// Blank-span fills (~2.4kT column, ~2.1kT row): zero the edge, no map reads
+void clear_dirty_column(unsigned char screen_col);
+void clear_dirty_row(unsigned char viewport_char_row);
+
+// Edge cache strips: the bytes an edge render writes, in scanline order.
+// Column strip: VIEWPORT_HEIGHT_PX bytes; row strip: 8 * VIEWPORT_COLS bytes.
+// Pre-render ~3.1kT column, ~10.5kT row; blit/save ~3.6-3.9kT column, ~2.9kT row
+#define EDGE_COL_STRIP_BYTES  VIEWPORT_HEIGHT_PX
+#define EDGE_ROW_STRIP_BYTES  (8 * VIEWPORT_COLS)
+#ifndef MULTICOLOUR
+#define MULTICOLOUR 0
+#endif
+#ifndef EDGE_CACHE
+#define EDGE_CACHE (!MULTICOLOUR)   // -DEDGE_CACHE=0 renders every edge from the map
+#endif
+void prerender_edge_column(unsigned char *strip, const unsigned char *map_col_ptr);
+void prerender_edge_row(unsigned char *strip, const unsigned char *map_row_ptr);
+void blit_edge_column(unsigned char screen_col, const unsigned char *strip);
+void blit_edge_row(unsigned char viewport_char_row, const unsigned char *strip);
+void save_edge_column(unsigned char screen_col, unsigned char *strip);
+void save_edge_row(unsigned char viewport_char_row, unsigned char *strip);
 
 // LDIR-based viewport shift routines (~49kT horizontal, ~68-71kT vertical)
 void shift_viewport_left(void);   // for scroll right: cols 1..19 → 0..18
@@ -38,7 +107,99 @@ void shift_viewport_right(void);  // for scroll left:  cols 0..18 → 1..19
 void shift_viewport_up(void);     // for scroll down:  rows 1..15 → 0..14
 void shift_viewport_down(void);   // for scroll up:    rows 0..14 → 1..15
 
+// Multi-tile steps (dash): shift by n columns / char rows in one pass;
+// n = 1..SCROLL_STEP_MAX (asm budgets). A wider shift copies less: -2kT per
+// extra column, -4.5kT per extra row. The n-wide edge is one tile-major
+// pass: ~6.7kT / 10.8kT / 15.0kT for 1 / 2 / 3 columns, and ~5.6kT /
+// 11.0kT / 16.3kT for 1 / 2 / 3 rows (a 1-wide row costs 10.8kT).
+// The n-wide edges read map_data directly (cell maps only).
+#define SCROLL_STEP_MAX 3
+void shift_viewport_left_n(unsigned char n);
+void shift_viewport_right_n(unsigned char n);
+void shift_viewport_up_n(unsigned char n);
+void shift_viewport_down_n(unsigned char n);
+void render_dirty_columns(unsigned char screen_col, const unsigned char *map_col_ptr, unsigned char n);
+void render_dirty_rows(unsigned char viewport_char_row, const unsigned char *map_row_ptr, unsigned char n);
+
+// Per-tile colour (generate_tiles --attrs, build with -DTILE_ATTRS=1): the
+// shifts move the viewport attributes with the pixels (+~7.3kT per shift) and
+// these write the new edge's attributes from the table at tiles + 512
+// (0x6200, indexed by map byte). ~1.35kT column, ~0.8kT row
+#ifndef TILE_ATTRS
+#define TILE_ATTRS 0
+#endif
+#define TILE_ATTR_OFFSET 512
+void attr_dirty_column(unsigned char screen_col, const unsigned char *map_col_ptr);
+void attr_dirty_row(unsigned char viewport_char_row, const unsigned char *map_row_ptr);
+
+// Multicolour viewport (generate_tiles --attrs --multicolour, build with
+// -DMULTICOLOUR=1, multicolour.asm): 8x2 attributes. Each viewport row's
+// colours live in the band buffer, four band rows of MC_BAND_BYTES holding
+// the row twice so that a window of VIEWPORT_COLS bytes is the row scrolled.
+// mc_src[row * 4 + band] points at each band's window; mc_raster rewrites
+// the attributes from them in step with the beam (~29kT, frame-locked).
+// The raster leaves too little of the frame for a vertical step to keep to
+// SCROLL_INTERVAL: it takes 6 frames, so vertical scrolling runs at half
+// the rate of the other builds.
+#if MULTICOLOUR
+#if TILE_ATTRS
+#error "MULTICOLOUR and TILE_ATTRS are exclusive"
+#endif
+#if VIEWPORT_COLS != 20
+#error "MULTICOLOUR: the raster moves 20 attribute columns per band"
+#endif
+#if VIEWPORT_START_CHAR_ROW < 2
+#error "MULTICOLOUR: the sync sentinel needs char row VIEWPORT_START_CHAR_ROW - 2"
+#endif
+#define MC_BANDS         4
+#define MC_BAND_BYTES    (2 * VIEWPORT_COLS)
+#define MC_ROW_BYTES     (MC_BANDS * MC_BAND_BYTES)
+#define MC_TABLE_OFFSET  1024   // band k colour per map byte at tiles + 1024 + k * 256
+extern unsigned char mc_bands[VIEWPORT_CHAR_ROWS * MC_ROW_BYTES];
+extern unsigned char *mc_src[VIEWPORT_CHAR_ROWS * MC_BANDS];
+void mc_raster(void);
+void mc_init_sync(void);
+// ~5.4kT: h = window start, ring_row = band 0 of the row in mc_bands
+void mc_colour_row(unsigned char h, unsigned char *ring_row, const unsigned char *map_row_ptr);
+
+// A step's shifts and edge a few char rows at a time (tile_render_direct.asm):
+// ~3.05kT per row horizontal, ~4.5kT up, ~4.75kT down, ~0.4kT per edge tile
+void shift_viewport_left_rows(unsigned char first_row, unsigned char rows);
+void shift_viewport_right_rows(unsigned char first_row, unsigned char rows);
+void shift_viewport_up_rows(unsigned char first_row, unsigned char rows);
+void shift_viewport_down_rows(unsigned char first_row, unsigned char rows);
+void render_dirty_column_rows(unsigned char screen_col, const unsigned char *map_ptr,
+                              unsigned char first_row, unsigned char rows);
+#endif
+
 // Draw the man sprite at the centre of the viewport
 void draw_man(void);
 
+// 128K level pack (make pack, level_pack.asm): levels from config/*_game.json
+// compressed in RAM banks, unpacked into the tile/map/occupancy/HUD areas
+#ifndef LEVEL_PACK
+#define LEVEL_PACK 0
+#endif
+#if LEVEL_PACK
+#include "level_pack.h"                 // LEVEL_COUNT
+
+void level_pack_load(void);             // tape -> banks, once at startup
+void level_unpack(unsigned char level); // ~400kT (~6 frames)
+#endif
+
+// AY music and sound effects (sound.asm, build with SOUND=1): an IM 2
+// interrupt plays one fixed-cost tick per frame (~1.9kT), deferred while a
+// renderer has SP in the screen LUT. Effects play over channel C.
+#ifndef SOUND
+#define SOUND 0
+#endif
+#if SOUND
+#define SFX_TRIGGER 0
+#define SFX_BUMP    1
+
+void snd_init(void);                    // IM 2 on, song from the next frame
+void snd_sfx(unsigned char id);         // ignored while the same one plays
+void snd_silence(void);                 // zero the volumes (before long DIs)
+#endif
+
 #endif // TILE_RENDER_H
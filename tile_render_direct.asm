@@ -8,35 +8,214 @@
 ; Public routines:
 ;   _render_dirty_column  - render 1 column of 16 tiles (128 scanlines)
 ;   _render_dirty_row     - render 1 row of 20 tiles (8 scanlines)
-;   _render_full_viewport - render all 320 tiles (startup only)
+;   _clear_dirty_column   - zero 1 column (blank span, no map reads)
+;   _clear_dirty_row      - zero 1 row (blank span, no map reads)
+;   _prerender_edge_column / _prerender_edge_row - render an edge into a
+;                           cache strip (idle frames)
+;   _blit_edge_column / _blit_edge_row - copy a cache strip to the screen
+;   _save_edge_column / _save_edge_row - copy a screen edge into a strip
 ;   _shift_viewport_left  - LDIR shift 19 bytes left per scanline (scroll right)
 ;   _shift_viewport_right - LDD shift 19 bytes right per scanline (scroll left)
 ;   _shift_viewport_up    - LDIR copy 15 rows upward (scroll down)
 ;   _shift_viewport_down  - LDIR copy 15 rows downward (scroll up)
+;   _shift_viewport_*_n   - the four shifts by n tiles in one pass (dash)
+;   _render_dirty_columns / _render_dirty_rows - n-wide edge in one
+;                           tile-major pass (dash)
+;   _attr_dirty_column / _attr_dirty_row - edge attributes from the map
+;                           (TILE_ATTRS; the shifts then move attributes too)
+;   _shift_viewport_*_rows / _render_dirty_column_rows - the same over a
+;                           band of char rows (MULTICOLOUR step slices)
+;   _meta_expand_column / _meta_expand_row - a metatile map's edge into
+;                           its cell strip (METATILE)
 
     SECTION code_user
 
     PUBLIC _render_dirty_column
     PUBLIC _render_dirty_row
-    PUBLIC _render_full_viewport
+    PUBLIC _clear_dirty_column
+    PUBLIC _clear_dirty_row
+    PUBLIC _prerender_edge_column
+    PUBLIC _prerender_edge_row
+    PUBLIC _blit_edge_column
+    PUBLIC _blit_edge_row
+    PUBLIC _save_edge_column
+    PUBLIC _save_edge_row
     PUBLIC _scr_addr_table_direct
     PUBLIC _shift_viewport_left
     PUBLIC _shift_viewport_right
     PUBLIC _shift_viewport_up
     PUBLIC _shift_viewport_down
-
-; Viewport parameters (must match tile_render.h)
-VIEWPORT_COLS           EQU 20
-VIEWPORT_CHAR_ROWS      EQU 16
-VIEWPORT_COL_OFFSET     EQU 6
-VIEWPORT_START_CHAR_ROW EQU 8
-VIEWPORT_HEIGHT         EQU VIEWPORT_CHAR_ROWS * 8  ; 128 scanlines
+    PUBLIC _shift_viewport_left_n
+    PUBLIC _shift_viewport_right_n
+    PUBLIC _shift_viewport_up_n
+    PUBLIC _shift_viewport_down_n
+    PUBLIC _render_dirty_columns
+    PUBLIC _render_dirty_rows
+
+; Viewport and map parameters, generated from config/*.mk by generate_viewport.
+; All unrolls below are REPT over these, so any viewport size reassembles
+; without edits.
+    INCLUDE "viewport.inc"
 
 ; Tile data at 0x6000, page-aligned (≤32 tiles × 8 bytes = 256 bytes)
 TILE_PAGE               EQU 0x60
 
-; Map dimensions
-MAP_WIDTH               EQU 96
+; Mirror-folded tiles (generate_tiles --fold-mirrors): map bytes carry
+; H/V flip bits above the index. Decoded via a bit-reverse table at 0x6100
+; into the scratch tile 31. Off by default so the hot paths are unchanged.
+    IFNDEF TILE_FLIP
+TILE_FLIP               EQU 0
+    ENDIF
+TILE_FLIP_MIN           EQU 0x40    ; index bytes >= this carry flip bits
+TILE_INDEX_MASK         EQU 0x1F
+TILE_SCRATCH            EQU 31      ; reserved slot for the decoded tile
+REV_PAGE                EQU 0x61    ; 256-byte bit-reverse table
+
+; Per-tile attributes (generate_tiles --attrs): a 256-byte table at 0x6200,
+; indexed by map byte. Every shift moves the viewport's attributes with its
+; pixels, one attribute row per 8 scanlines in the same pass, and the edges
+; get theirs from _attr_dirty_column / _attr_dirty_row. Off by default.
+    IFNDEF TILE_ATTRS
+TILE_ATTRS              EQU 0
+    ENDIF
+ATTR_PAGE               EQU 0x62
+VIEWPORT_ATTR           EQU 0x5800 + VIEWPORT_START_CHAR_ROW * 32 + VIEWPORT_COL_OFFSET
+
+    IF TILE_ATTRS
+    PUBLIC _attr_dirty_column
+    PUBLIC _attr_dirty_row
+    ENDIF
+
+; Multicolour viewport (multicolour.asm): the raster owns the attributes and
+; most of the frame, so a step is done a few char rows per frame through
+; the ranged entries below. They jump into the full routines' loops.
+    IFNDEF MULTICOLOUR
+MULTICOLOUR             EQU 0
+    ENDIF
+
+    IF MULTICOLOUR
+    PUBLIC _render_dirty_column_rows
+    PUBLIC _shift_viewport_left_rows
+    PUBLIC _shift_viewport_right_rows
+    PUBLIC _shift_viewport_up_rows
+    PUBLIC _shift_viewport_down_rows
+    ENDIF
+
+; AY player (sound.asm): its frame interrupt must not be lost, so in SOUND
+; builds the SP-hijack sections below keep interrupts on. An interrupt that
+; lands while SP walks the LUT writes its return address into the word
+; below SP: the guard word in front of the table, or an entry already
+; popped. The ISR restores it from its copy of the table and defers the
+; tick. The edge strips have guard bytes in front (tile_render.c).
+    IFNDEF SOUND
+SOUND                   EQU 0
+    ENDIF
+
+    IF SOUND
+    PUBLIC _scr_addr_table_guard
+    ENDIF
+
+; Metatile maps (viewport.inc METATILE = 2 or 4): a map byte is the offset
+; of a block's cells in the dictionary page at 0x6300. The expanders write
+; an edge's cells into a strip that stays in one page, and the edge
+; routines read the strip as if it were the map (MAP_COL_STEP = 1, rows
+; stepped with inc l).
+META_PAGE               EQU 0x63
+
+    IF METATILE
+    PUBLIC _meta_expand_column
+    PUBLIC _meta_expand_row
+    ENDIF
+
+; Widest dash step the _n shifts and n-wide edges are budgeted for
+; (SCROLL_STEP_MAX in tile_render.h; _shift_viewport_down_n allows 7)
+SCROLL_STEP_MAX         EQU 3
+
+; Worst-case budgets for asm_timing, scaled with the viewport.
+; Flip decoding (TILE_FLIP) is costed as if every tile were flipped.
+BUDGET_RDC      EQU VIEWPORT_CHAR_ROWS * (400 + TILE_FLIP * 1825) + 400
+BUDGET_RDR      EQU 8 * (VIEWPORT_COLS * (64 + TILE_FLIP * 175) + 100) + 560
+BUDGET_CDC      EQU VIEWPORT_CHAR_ROWS * 150 + 200
+BUDGET_CDR      EQU 8 * (VIEWPORT_COLS * 11 + 25) + 240
+BUDGET_PEC      EQU VIEWPORT_CHAR_ROWS * (200 + TILE_FLIP * 1825) + 200
+BUDGET_PER      EQU 8 * (VIEWPORT_COLS * (70 + TILE_FLIP * 175) + 100) + 200
+BUDGET_BEC      EQU VIEWPORT_CHAR_ROWS * 220 + 200
+BUDGET_BER      EQU 8 * (VIEWPORT_COLS * 16 + 25) + 300
+BUDGET_SEC      EQU VIEWPORT_CHAR_ROWS * 235 + 200
+BUDGET_SER      EQU 8 * (VIEWPORT_COLS * 16 + 25) + 300
+BUDGET_SHIFT_ATTR EQU TILE_ATTRS * (VIEWPORT_CHAR_ROWS * (VIEWPORT_COLS * 16 + 120) + VIEWPORT_HEIGHT * 7 + 100)
+BUDGET_SHIFT_H  EQU VIEWPORT_HEIGHT * (VIEWPORT_COLS * 16 + 70) + 80 + BUDGET_SHIFT_ATTR
+BUDGET_SHIFT_UP EQU (VIEWPORT_HEIGHT - 8) * (VIEWPORT_COLS * 21 + 150) + 600 + BUDGET_SHIFT_ATTR
+BUDGET_SHIFT_DN EQU (VIEWPORT_HEIGHT - 8) * (VIEWPORT_COLS * 21 + 180) + 500 + BUDGET_SHIFT_ATTR
+BUDGET_SHIFT_H_N  EQU VIEWPORT_HEIGHT * (VIEWPORT_COLS * 16 + 90) + 200 + BUDGET_SHIFT_ATTR * 11 / 10
+BUDGET_SHIFT_UP_N EQU BUDGET_SHIFT_UP + 200 + TILE_ATTRS * 200
+BUDGET_SHIFT_DN_N EQU BUDGET_SHIFT_DN + 300 + TILE_ATTRS * 200
+BUDGET_ADC      EQU VIEWPORT_CHAR_ROWS * 90 + 150
+BUDGET_ADR      EQU VIEWPORT_COLS * 35 + 200
+BUDGET_RDCS     EQU VIEWPORT_CHAR_ROWS * (SCROLL_STEP_MAX * (265 + TILE_FLIP * 1870) + 160) + 200
+BUDGET_RDRS     EQU SCROLL_STEP_MAX * (VIEWPORT_COLS * (265 + TILE_FLIP * 1870) + 160) + 200
+; The ranged entries share the full loops, so they are costed at full height
+BUDGET_RDC_ROWS EQU BUDGET_RDC + 200
+BUDGET_SHIFT_H_ROWS  EQU BUDGET_SHIFT_H + 150
+BUDGET_SHIFT_UP_ROWS EQU BUDGET_SHIFT_UP + 200
+BUDGET_SHIFT_DN_ROWS EQU BUDGET_SHIFT_DN + 200
+    IF METATILE
+BUDGET_MEC      EQU META_COL_BLOCKS * (METATILE * 38 + 10) + 120
+BUDGET_MER      EQU META_ROW_BLOCKS * (METATILE * 16 + 38) + 120
+    ENDIF
+
+    IF MULTICOLOUR
+;----------------------------------------------------------------------
+; _render_dirty_column_rows
+; Render char rows first..first+rows-1 of one column (a multicolour step
+; slice): sets up as _render_dirty_column with the LUT and count offset,
+; then runs its tile loop.
+;
+; void render_dirty_column_rows(unsigned char screen_col, const unsigned char *map_ptr,
+;                               unsigned char first_row, unsigned char rows)
+;   map_ptr: &map_data[(camera_tile_y + first_row) * MAP_STRIDE + map_tile_col]
+;   rows:    1..VIEWPORT_CHAR_ROWS - first_row
+;
+; T-states: ~400 per tile + ~230
+; @budget BUDGET_RDC_ROWS
+;----------------------------------------------------------------------
+_render_dirty_column_rows:
+    ; SP+2 = screen_col, SP+3,4 = map_ptr, SP+5 = first_row, SP+6 = rows
+    ld hl, 2
+    add hl, sp
+    ld c, (hl)              ; C = screen_col byte offset
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_ptr
+    inc hl
+    ld a, (hl)              ; A = first_row
+    inc hl
+    ld b, (hl)              ; B = rows
+
+    push de
+    exx
+    pop hl                  ; HL' = map_ptr
+    IF MAP_COL_STEP <> 1 && MAP_COL_STEP <> 256
+    ld bc, MAP_STRIDE       ; BC' = stride to next map row
+    ENDIF
+    exx
+
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 8 LUT entries (16 bytes) per char row
+    ld de, _scr_addr_table_direct
+    add hl, de
+    IF !SOUND
+    di
+    ENDIF
+    ld (_rdc_save_sp+1), sp ; save SP (self-modifying)
+    ld sp, hl               ; SP = LUT entry of the first row
+    jp _rdc_tile_loop
+    ENDIF
 
 ;----------------------------------------------------------------------
 ; _render_dirty_column
@@ -45,9 +224,11 @@ MAP_WIDTH               EQU 96
 ;
 ; void render_dirty_column(unsigned char screen_col, const unsigned char *map_col_ptr)
 ;   screen_col:   physical screen byte offset (VIEWPORT_COL_OFFSET + ring_col)
-;   map_col_ptr:  &map_data[camera_tile_y * MAP_WIDTH + map_tile_col]
+;   map_col_ptr:  &map_data[camera_tile_y * MAP_STRIDE + map_tile_col]
 ;
 ; T-states: ~6,400 uncontended (16 tiles × ~400T)
+;   (~35,800 with TILE_FLIP if every tile is flipped)
+; @budget BUDGET_RDC
 ;----------------------------------------------------------------------
 _render_dirty_column:
     ; Read params from stack (SDCC sdcc_iy: char is 1 byte on stack)
@@ -62,14 +243,18 @@ _render_dirty_column:
     inc hl
     ld d, (hl)              ; DE = map_col_ptr
 
-    ; Setup alt regs: HL' = map pointer, BC' = MAP_WIDTH stride
+    ; Setup alt regs: HL' = map pointer, BC' = MAP_STRIDE
     push de
     exx
     pop hl                  ; HL' = map_col_ptr
-    ld bc, MAP_WIDTH        ; BC' = stride to next map row
+    IF MAP_COL_STEP <> 1 && MAP_COL_STEP <> 256
+    ld bc, MAP_STRIDE       ; BC' = stride to next map row
+    ENDIF
     exx
 
+    IF !SOUND
     di
+    ENDIF
     ld (_rdc_save_sp+1), sp ; save SP (self-modifying)
     ld sp, _scr_addr_table_direct  ; SP = screen address LUT
     ld b, VIEWPORT_CHAR_ROWS      ; B = 16 tile rows (D is clobbered by pop de)
@@ -78,7 +263,15 @@ _rdc_tile_loop:
     ; Read tile index from map (alt regs)
     exx                     ;  4T
     ld a, (hl)              ;  7T - tile index
-    add hl, bc              ; 11T - advance map ptr by MAP_WIDTH
+    IF MAP_COL_STEP = 1
+    inc l                   ;  4T - next cell of the metatile strip
+    ELSE
+    IF MAP_STRIDE = 256
+    inc h                   ;  4T - next map row is the next page
+    ELSE
+    add hl, bc              ; 11T - advance map ptr by MAP_STRIDE
+    ENDIF
+    ENDIF
     exx                     ;  4T
 
     ; Check for blank tile (index 0)
@@ -86,6 +279,22 @@ _rdc_tile_loop:
     jr z, _rdc_blank_tile   ;  7T (not taken) / 12T (taken)
 
     ; Compute tile data address: TILE_PAGE : (tile_index * 8)
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    jr c, _rdc_tile_draw    ; 12T (no flip bits)
+    ; Flipped tile: decode all 8 rows into the scratch tile on the real stack
+    ld (_rdc_flip_sp+1), sp
+    ld sp, (_rdc_save_sp+1)
+    push bc
+    ld d, TILE_PAGE
+    call _tile_flip_tile
+    pop bc
+_rdc_flip_sp:
+    ld sp, 0                ; back to the LUT (self-mod patched)
+    ld a, TILE_SCRATCH
+_rdc_tile_draw:
+    ENDIF
+
     add a, a                ;  4T - ×2
     add a, a                ;  4T - ×4
     add a, a                ;  4T - ×8
@@ -228,6 +437,44 @@ _rdc_save_sp:
     ei
     ret
 
+    IF MULTICOLOUR
+;----------------------------------------------------------------------
+; _shift_viewport_left_rows
+; As _shift_viewport_left, for char rows first..first+rows-1 only.
+;
+; void shift_viewport_left_rows(unsigned char first_row, unsigned char rows)
+;
+; T-states: ~3,050 per char row + ~150
+; @budget BUDGET_SHIFT_H_ROWS
+;----------------------------------------------------------------------
+_shift_viewport_left_rows:
+    ; SP+2 = first_row, SP+3 = rows
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    inc hl
+    ld e, (hl)              ; E = rows
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 16 LUT bytes per char row
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ld a, e
+    add a, a
+    add a, a
+    add a, a
+    ld (_svl_count), a       ; 8 scanlines per row
+    IF !SOUND
+    di
+    ENDIF
+    ld (_svl_save_sp+1), sp
+    ld sp, hl
+    jp _svl_scanline
+    ENDIF
+
 ;----------------------------------------------------------------------
 ; _shift_viewport_left
 ; Shift all 128 scanlines of viewport left by 1 byte (8 pixels).
@@ -238,13 +485,20 @@ _rdc_save_sp:
 ; void shift_viewport_left(void)
 ;
 ; T-states: ~49,000 (128 × ~381T)
+; @budget BUDGET_SHIFT_H
 ;----------------------------------------------------------------------
 _shift_viewport_left:
+    IF !SOUND
     di
+    ENDIF
     ld (_svl_save_sp+1), sp
     ld sp, _scr_addr_table_direct
     ld a, VIEWPORT_HEIGHT           ; 128 scanlines
     ld (_svl_count), a
+    IF TILE_ATTRS
+    ld hl, VIEWPORT_ATTR + 1
+    ld (_svl_attr+1), hl            ; attribute source = col 1 of char row 0
+    ENDIF
 
 _svl_scanline:
     pop hl                          ; 10T - screen addr from table
@@ -255,31 +509,36 @@ _svl_scanline:
     dec a                           ;  4T
     ld e, a                         ;  4T - dest = col 0
 
-    ; 19 × LDI (16T each = 304T) - copy cols 1..19 to cols 0..18
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
-    LDI
+    ; (VIEWPORT_COLS-1) × LDI (16T each) - copy cols 1..19 to cols 0..18
+    REPT VIEWPORT_COLS - 1
     LDI
+    ENDR
 
     ld a, (_svl_count)              ; 13T
     dec a                           ;  4T
     ld (_svl_count), a              ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svl_scanline            ; 10T  @loop VIEWPORT_HEIGHT
+
+    ; Char row done: shift its attributes the same way
+_svl_attr:
+    ld hl, 0                        ; 10T - attr source (self-mod patched)
+    ld d, h                         ;  4T
+    ld e, l                         ;  4T
+    dec e                           ;  4T - dest = col 0
+    REPT VIEWPORT_COLS - 1
+    LDI
+    ENDR
+    ld bc, 32 - VIEWPORT_COLS + 1   ; 10T
+    add hl, bc                      ; 11T - next attribute row
+    ld (_svl_attr+1), hl            ; 16T
+    ld a, (_svl_count)              ; 13T
+    or a                            ;  4T
+    jp nz, _svl_scanline            ; 10T  @taken VIEWPORT_CHAR_ROWS-1
+    ELSE
     jp nz, _svl_scanline            ; 10T
+    ENDIF
 
 _svl_save_sp:
     ld sp, 0                        ; self-mod patched
@@ -289,6 +548,44 @@ _svl_save_sp:
 _svl_count:
     DEFB 0
 
+    IF MULTICOLOUR
+;----------------------------------------------------------------------
+; _shift_viewport_right_rows
+; As _shift_viewport_right, for char rows first..first+rows-1 only.
+;
+; void shift_viewport_right_rows(unsigned char first_row, unsigned char rows)
+;
+; T-states: ~3,050 per char row + ~150
+; @budget BUDGET_SHIFT_H_ROWS
+;----------------------------------------------------------------------
+_shift_viewport_right_rows:
+    ; SP+2 = first_row, SP+3 = rows
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    inc hl
+    ld e, (hl)              ; E = rows
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 16 LUT bytes per char row
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ld a, e
+    add a, a
+    add a, a
+    add a, a
+    ld (_svr_count), a       ; 8 scanlines per row
+    IF !SOUND
+    di
+    ENDIF
+    ld (_svr_save_sp+1), sp
+    ld sp, hl
+    jp _svr_scanline
+    ENDIF
+
 ;----------------------------------------------------------------------
 ; _shift_viewport_right
 ; Shift all 128 scanlines of viewport right by 1 byte (8 pixels).
@@ -299,13 +596,20 @@ _svl_count:
 ; void shift_viewport_right(void)
 ;
 ; T-states: ~49,000 (128 × ~381T)
+; @budget BUDGET_SHIFT_H
 ;----------------------------------------------------------------------
 _shift_viewport_right:
+    IF !SOUND
     di
+    ENDIF
     ld (_svr_save_sp+1), sp
     ld sp, _scr_addr_table_direct
     ld a, VIEWPORT_HEIGHT           ; 128 scanlines
     ld (_svr_count), a
+    IF TILE_ATTRS
+    ld hl, VIEWPORT_ATTR + VIEWPORT_COLS - 2
+    ld (_svr_attr+1), hl            ; attribute source end = col 18 of char row 0
+    ENDIF
 
 _svr_scanline:
     pop hl                          ; 10T - screen addr from table
@@ -316,31 +620,36 @@ _svr_scanline:
     inc a                           ;  4T
     ld e, a                         ;  4T - dest end = col 19
 
-    ; 19 × LDD (16T each = 304T) - copy cols 18..0 to cols 19..1
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
-    LDD
+    ; (VIEWPORT_COLS-1) × LDD (16T each) - copy cols 18..0 to cols 19..1
+    REPT VIEWPORT_COLS - 1
     LDD
+    ENDR
 
     ld a, (_svr_count)              ; 13T
     dec a                           ;  4T
     ld (_svr_count), a              ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svr_scanline            ; 10T  @loop VIEWPORT_HEIGHT
+
+    ; Char row done: shift its attributes the same way
+_svr_attr:
+    ld hl, 0                        ; 10T - attr source end (self-mod patched)
+    ld d, h                         ;  4T
+    ld e, l                         ;  4T
+    inc e                           ;  4T - dest end = col 19
+    REPT VIEWPORT_COLS - 1
+    LDD
+    ENDR
+    ld bc, 32 + VIEWPORT_COLS - 1   ; 10T
+    add hl, bc                      ; 11T - next attribute row
+    ld (_svr_attr+1), hl            ; 16T
+    ld a, (_svr_count)              ; 13T
+    or a                            ;  4T
+    jp nz, _svr_scanline            ; 10T  @taken VIEWPORT_CHAR_ROWS-1
+    ELSE
     jp nz, _svr_scanline            ; 10T
+    ENDIF
 
 _svr_save_sp:
     ld sp, 0                        ; self-mod patched
@@ -350,6 +659,50 @@ _svr_save_sp:
 _svr_count:
     DEFB 0
 
+    IF MULTICOLOUR
+;----------------------------------------------------------------------
+; _shift_viewport_up_rows
+; As _shift_viewport_up, for destination char rows first..first+rows-1
+; (each copied from the row below it). first + rows < VIEWPORT_CHAR_ROWS.
+;
+; void shift_viewport_up_rows(unsigned char first_row, unsigned char rows)
+;
+; T-states: ~4,500 per char row + ~200
+; @budget BUDGET_SHIFT_UP_ROWS
+;----------------------------------------------------------------------
+_shift_viewport_up_rows:
+    ; SP+2 = first_row, SP+3 = rows
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    inc hl
+    ld e, (hl)              ; E = rows
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 16 LUT bytes per char row
+    ld bc, _scr_addr_table_direct
+    add hl, bc              ; HL = dest LUT entry
+    ld a, e
+    add a, a
+    add a, a
+    add a, a
+    ld (_svu_count), a      ; 8 scanlines per row
+    IF !SOUND
+    di
+    ENDIF
+    push ix                 ; save SDCC frame pointer
+    ld (_svu_save_sp+1), sp
+    push hl
+    pop ix                  ; IX = dest entries
+    ld bc, 16
+    add hl, bc
+    ld sp, hl               ; SP = source entries, one char row below
+    jp _svu_scanline
+    ENDIF
+
 ;----------------------------------------------------------------------
 ; _shift_viewport_up
 ; Shift viewport up by 1 char row (8 pixels). Copies char rows 1..15
@@ -363,17 +716,26 @@ _svr_count:
 ; void shift_viewport_up(void)
 ;
 ; T-states: ~68,000 (120 scanlines × ~563T)
+; @budget BUDGET_SHIFT_UP
 ;----------------------------------------------------------------------
 _shift_viewport_up:
+    IF !SOUND
     di
+    ENDIF
     push ix                         ; save SDCC frame pointer
     ld (_svu_save_sp+1), sp
     ; Source = char row 1 onward (table entry 8 = 16 bytes offset)
     ld sp, _scr_addr_table_direct + 16
     ; Dest = char row 0 onward (table entry 0)
     ld ix, _scr_addr_table_direct
-    ld a, 120                       ; 15 char rows × 8 scanlines
+    ld a, VIEWPORT_HEIGHT - 8       ; 15 char rows × 8 scanlines
     ld (_svu_count), a
+    IF TILE_ATTRS
+    ld hl, VIEWPORT_ATTR + 32
+    ld (_svu_asrc+1), hl            ; attribute rows 1.. to rows 0..
+    ld hl, VIEWPORT_ATTR
+    ld (_svu_adst+1), hl
+    ENDIF
 
 _svu_scanline:
     ; Source addr via SP trick
@@ -397,7 +759,30 @@ _svu_scanline:
     ld a, (_svu_count)              ; 13T
     dec a                           ;  4T
     ld (_svu_count), a              ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svu_scanline            ; 10T  @loop VIEWPORT_HEIGHT-8
+
+    ; Dest char row done: copy its attribute row too
+_svu_asrc:
+    ld hl, 0                        ; 10T - source row (self-mod patched)
+_svu_adst:
+    ld de, 0                        ; 10T - dest row (self-mod patched)
+    REPT VIEWPORT_COLS
+    LDI
+    ENDR
+    ld bc, 32 - VIEWPORT_COLS       ; 10T
+    add hl, bc                      ; 11T
+    ld (_svu_asrc+1), hl            ; 16T
+    ex de, hl                       ;  4T
+    add hl, bc                      ; 11T
+    ld (_svu_adst+1), hl            ; 16T
+    ld a, (_svu_count)              ; 13T
+    or a                            ;  4T
+    jp nz, _svu_scanline            ; 10T  @taken VIEWPORT_CHAR_ROWS-2
+    ELSE
     jp nz, _svu_scanline            ; 10T
+    ENDIF
 
 _svu_save_sp:
     ld sp, 0                        ; self-mod patched
@@ -408,6 +793,47 @@ _svu_save_sp:
 _svu_count:
     DEFB 0
 
+    IF MULTICOLOUR
+;----------------------------------------------------------------------
+; _shift_viewport_down_rows
+; As _shift_viewport_down, for destination char rows first..first+rows-1
+; (each copied from the row above it, bottom-up). first >= 1.
+;
+; void shift_viewport_down_rows(unsigned char first_row, unsigned char rows)
+;
+; T-states: ~4,750 per char row + ~200
+; @budget BUDGET_SHIFT_DN_ROWS
+;----------------------------------------------------------------------
+_shift_viewport_down_rows:
+    ; SP+2 = first_row, SP+3 = rows
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    inc hl
+    ld e, (hl)              ; E = rows
+    add a, e                ; A = last dest row + 1
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 16 LUT bytes per char row
+    ld bc, _scr_addr_table_direct - 18
+    add hl, bc              ; HL = source entry of the last dest scanline
+    ld a, e
+    add a, a
+    add a, a
+    add a, a
+    ld (_svd_count), a      ; 8 scanlines per row
+    IF !SOUND
+    di
+    ENDIF
+    push ix                 ; save SDCC frame pointer
+    push hl
+    pop ix
+    jp _svd_scanline
+    ENDIF
+
 ;----------------------------------------------------------------------
 ; _shift_viewport_down
 ; Shift viewport down by 1 char row (8 pixels). Copies char rows 0..14
@@ -420,15 +846,24 @@ _svu_count:
 ; void shift_viewport_down(void)
 ;
 ; T-states: ~71,000 (120 scanlines × ~591T)
+; @budget BUDGET_SHIFT_DN
 ;----------------------------------------------------------------------
 _shift_viewport_down:
+    IF !SOUND
     di
+    ENDIF
     push ix                         ; save SDCC frame pointer
     ; Start from bottom: source entry 119 (char row 14 scanline 7)
     ; dest is always source + 8 entries = +16 bytes in table
-    ld ix, _scr_addr_table_direct + 119 * 2
-    ld a, 120                       ; 15 char rows × 8 scanlines
+    ld ix, _scr_addr_table_direct + (VIEWPORT_HEIGHT - 9) * 2
+    ld a, VIEWPORT_HEIGHT - 8       ; 15 char rows × 8 scanlines
     ld (_svd_count), a
+    IF TILE_ATTRS
+    ld hl, VIEWPORT_ATTR + (VIEWPORT_CHAR_ROWS - 2) * 32
+    ld (_svd_asrc+1), hl            ; attribute rows 14.. to rows 15.., upward
+    ld hl, VIEWPORT_ATTR + (VIEWPORT_CHAR_ROWS - 1) * 32
+    ld (_svd_adst+1), hl
+    ENDIF
 
 _svd_scanline:
     ; Source addr via IX
@@ -454,7 +889,30 @@ _svd_scanline:
     ld a, (_svd_count)              ; 13T
     dec a                           ;  4T
     ld (_svd_count), a              ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svd_scanline            ; 10T  @loop VIEWPORT_HEIGHT-8
+
+    ; Dest char row done: copy its attribute row too
+_svd_asrc:
+    ld hl, 0                        ; 10T - source row (self-mod patched)
+_svd_adst:
+    ld de, 0                        ; 10T - dest row (self-mod patched)
+    REPT VIEWPORT_COLS
+    LDI
+    ENDR
+    ld bc, -32 - VIEWPORT_COLS      ; 10T - previous row
+    add hl, bc                      ; 11T
+    ld (_svd_asrc+1), hl            ; 16T
+    ex de, hl                       ;  4T
+    add hl, bc                      ; 11T
+    ld (_svd_adst+1), hl            ; 16T
+    ld a, (_svd_count)              ; 13T
+    or a                            ;  4T
+    jp nz, _svd_scanline            ; 10T  @taken VIEWPORT_CHAR_ROWS-2
+    ELSE
     jp nz, _svd_scanline            ; 10T
+    ENDIF
 
     pop ix                          ; restore SDCC frame pointer
     ei
@@ -464,248 +922,1584 @@ _svd_count:
     DEFB 0
 
 ;----------------------------------------------------------------------
-; _render_dirty_row
-; Render 1 row of 20 tiles (8 scanlines × 20 bytes) directly to screen.
-; Uses exx tile lookup pattern from draw_aligned.asm.
+; Multi-tile steps (dash): the _n shifts move the viewport by n columns or
+; n char rows in one pass, so a wider step copies less, not more. The
+; n-wide edges are drawn tile-major in one pass, cheaper per tile than the
+; 1-wide renderers, so the extra tiles of a dash edge come at a discount.
+; A normal step keeps the 1-tile routines above.
+; n is 1..SCROLL_STEP_MAX (budgets).
+;----------------------------------------------------------------------
+
+;----------------------------------------------------------------------
+; _shift_viewport_left_n
+; Shift all 128 scanlines left by n bytes (scroll right by n tiles):
+; cols n..19 move to cols 0..19-n. Each scanline enters the unrolled LDI
+; chain n-1 LDIs in (self-modified jump), so it copies 20-n bytes.
 ;
-; void render_dirty_row(unsigned char viewport_char_row, const unsigned char *map_row_ptr)
-;   viewport_char_row: 0-15 (row within viewport)
-;   map_row_ptr:       &map_data[map_tile_row * MAP_WIDTH + camera_tile_x]
+; void shift_viewport_left_n(unsigned char n)
 ;
-; T-states: ~10,600 uncontended (8 scanlines × 20 tiles × 65T)
+; T-states: ~50,600 for n = 1, ~2,050 less per extra tile (128 × 16T)
+; @budget BUDGET_SHIFT_H_N
 ;----------------------------------------------------------------------
-_render_dirty_row:
-    ; Read params from stack (SDCC sdcc_iy: char is 1 byte on stack)
-    ; SP+2   = viewport_char_row (1 byte)
-    ; SP+3,4 = map_row_ptr
+_shift_viewport_left_n:
     ld hl, 2
     add hl, sp
-    ld a, (hl)              ; A = viewport_char_row (0-15)
-    inc hl
-    ld e, (hl)
-    inc hl
-    ld d, (hl)              ; DE = map_row_ptr
-
-    ; Save map_row_ptr for reuse each scanline
-    ld (_rdr_map_ptr+1), de
-
-    ; Look up screen base address from table
-    ; Table offset = viewport_char_row * 16 (8 entries × 2 bytes per char row)
-    add a, a                ; ×2
-    add a, a                ; ×4
-    add a, a                ; ×8
-    add a, a                ; ×16
+    ld a, (hl)                      ; A = n
+    ld (_svln_dst+1), a             ; dest = source - n
     ld c, a
-    ld b, 0
-    ld hl, _scr_addr_table_direct
-    add hl, bc
-    ld e, (hl)
-    inc hl
-    ld d, (hl)              ; DE = screen addr for first scanline of row
-
-    ; Add viewport column offset
-    ld a, e
     add a, VIEWPORT_COL_OFFSET
+    ld (_svln_src+1), a             ; source = col n
+    ld a, c
+    dec a
+    add a, a                        ; skip n-1 LDIs (2 bytes each)
     ld e, a
+    ld d, 0
+    ld hl, _svln_ldi
+    add hl, de
+    ld (_svln_jump+1), hl           ; chain entry
+    IF TILE_ATTRS
+    ld hl, _svln_aldi
+    add hl, de
+    ld (_svln_ajump+1), hl          ; attribute chain entry
+    ld a, c
+    ld (_svln_adst+1), a
+    ld l, c
+    ld h, 0
+    ld de, VIEWPORT_ATTR
+    add hl, de
+    ld (_svln_attr+1), hl           ; attribute source = col n of char row 0
+    ld a, c
+    add a, 32 - VIEWPORT_COLS
+    ld l, a
+    ld h, 0
+    ld (_svln_astep+1), hl          ; to the next row: 32 - (20 - n)
+    ENDIF
 
+    IF !SOUND
     di
+    ENDIF
+    ld (_svln_save_sp+1), sp
+    ld sp, _scr_addr_table_direct
+    ld a, VIEWPORT_HEIGHT           ; 128 scanlines
+    ld (_svln_count), a
 
-    ; Setup: save screen base in self-mod location
-    ; Within a char row, next scanline = +0x100 (inc D)
-    ld (_rdr_scr_base), de
-
-    ; Alt regs: D' = TILE_PAGE, E' = in_tile_y (0-7)
-    exx
-    ld d, TILE_PAGE
-    ld e, 0                 ; in_tile_y starts at 0
-    exx
-
-    ld b, 8                 ; 8 scanlines per row
-
-_rdr_scanline:
-    push bc                 ; save scanline counter
-
-    ; Load map pointer (reset each scanline to same row start)
-_rdr_map_ptr:
-    ld hl, 0                ; self-mod: map_row_ptr
-    ld de, (_rdr_scr_base)  ; DE = screen address for this scanline
-
-    ; 20 tiles unrolled: read map, exx, lookup tile, exx, write to screen
-    ; Per tile: ld a,(hl)/inc hl/exx/add×3/add a,e/ld l,a/ld h,d/ld a,(hl)/exx/ld (de),a/inc e
-    ; = 7+6+4+4+4+4+4+4+4+7+4+7+4 = 67T per tile (inc hl is 6T not 4T)
-
-    REPT 20
-    ld a, (hl)              ;  7T - tile index from map
-    inc hl                  ;  6T - next map column
-    exx                     ;  4T
-    add a, a                ;  4T - ×2
-    add a, a                ;  4T - ×4
-    add a, a                ;  4T - ×8
-    add a, e                ;  4T - + in_tile_y
-    ld l, a                 ;  4T
-    ld h, d                 ;  4T - H = TILE_PAGE
-    ld a, (hl)              ;  7T - tile byte
-    exx                     ;  4T
-    ld (de), a              ;  7T - write to screen
-    inc e                   ;  4T - next screen column
+_svln_scanline:
+    pop hl                          ; 10T - screen addr from table
+    ld d, h                         ;  4T - dest H = same row
+    ld a, l                         ;  4T
+_svln_src:
+    add a, VIEWPORT_COL_OFFSET + 1  ;  7T - source = col n (self-mod patched)
+    ld l, a                         ;  4T
+_svln_dst:
+    sub 1                           ;  7T - dest = col 0 (self-mod patched: n)
+    ld e, a                         ;  4T
+_svln_jump:
+    jp _svln_ldi                    ; 10T - into the chain (self-mod patched)
+_svln_ldi:
+    REPT VIEWPORT_COLS - 1
+    LDI
     ENDR
 
-    ; Advance screen base for next scanline: D += 1 (next pixel row = +0x100)
-    ld hl, _rdr_scr_base+1
-    inc (hl)                ; 11T - screen H += 1
-
-    ; Increment in_tile_y in alt regs
-    exx
-    inc e                   ;  4T - E' = in_tile_y++
-    exx
-
-    pop bc                  ; restore scanline counter
-    dec b
-    jp nz, _rdr_scanline
-
+    ld a, (_svln_count)             ; 13T
+    dec a                           ;  4T
+    ld (_svln_count), a             ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svln_scanline           ; 10T  @loop VIEWPORT_HEIGHT
+
+    ; Char row done: shift its attributes the same way
+_svln_attr:
+    ld hl, 0                        ; 10T - attr source (self-mod patched)
+    ld a, l                         ;  4T
+_svln_adst:
+    sub 1                           ;  7T - dest = col 0 (self-mod patched: n)
+    ld e, a                         ;  4T
+    ld d, h                         ;  4T
+_svln_ajump:
+    jp _svln_aldi                   ; 10T - into the chain (self-mod patched)
+_svln_aldi:
+    REPT VIEWPORT_COLS - 1
+    LDI
+    ENDR
+_svln_astep:
+    ld bc, 32 - VIEWPORT_COLS + 1   ; 10T - self-mod patched: 32 - 20 + n
+    add hl, bc                      ; 11T - next attribute row
+    ld (_svln_attr+1), hl           ; 16T
+    ld a, (_svln_count)             ; 13T
+    or a                            ;  4T
+    jp nz, _svln_scanline           ; 10T  @taken VIEWPORT_CHAR_ROWS-1
+    ELSE
+    jp nz, _svln_scanline           ; 10T
+    ENDIF
+
+_svln_save_sp:
+    ld sp, 0                        ; self-mod patched
     ei
     ret
 
-_rdr_scr_base:
-    DEFW 0
+_svln_count:
+    DEFB 0
 
 ;----------------------------------------------------------------------
-; _render_full_viewport
-; Render entire 20×16 tile viewport to screen. Called once at startup.
-; Renders row by row (16 rows × 8 scanlines × 20 tiles).
+; _shift_viewport_right_n
+; Shift all 128 scanlines right by n bytes (scroll left by n tiles):
+; cols 0..19-n move to cols n..19, LDD from the right-hand end.
 ;
-; void render_full_viewport(const unsigned char *map_top_left)
-;   map_top_left: &map_data[camera_tile_y * MAP_WIDTH + camera_tile_x]
+; void shift_viewport_right_n(unsigned char n)
 ;
-; T-states: ~170,000 (~2.4 frames). Run with interrupts disabled at startup.
+; T-states: ~50,600 for n = 1, ~2,050 less per extra tile (128 × 16T)
+; @budget BUDGET_SHIFT_H_N
 ;----------------------------------------------------------------------
-_render_full_viewport:
-    ; Read map_top_left from stack (before push ix changes SP)
+_shift_viewport_right_n:
     ld hl, 2
     add hl, sp
-    ld e, (hl)
-    inc hl
-    ld d, (hl)              ; DE = map_top_left
-
-    ; Save map pointer
-    ld (_rfv_map_ptr), de
-
-    push ix                 ; save SDCC frame pointer
+    ld c, (hl)                      ; C = n
+    ld a, c
+    ld (_svrn_dst+1), a             ; dest end = source end + n
+    ld a, VIEWPORT_COL_OFFSET + VIEWPORT_COLS - 1
+    sub c
+    ld (_svrn_src+1), a             ; source end = col 19-n
+    ld a, c
+    dec a
+    add a, a                        ; skip n-1 LDDs (2 bytes each)
+    ld e, a
+    ld d, 0
+    ld hl, _svrn_ldd
+    add hl, de
+    ld (_svrn_jump+1), hl           ; chain entry
+    IF TILE_ATTRS
+    ld hl, _svrn_aldd
+    add hl, de
+    ld (_svrn_ajump+1), hl          ; attribute chain entry
+    ld a, c
+    ld (_svrn_adst+1), a
+    ld a, VIEWPORT_COLS - 1
+    sub c
+    ld l, a
+    ld h, 0
+    ld de, VIEWPORT_ATTR
+    add hl, de
+    ld (_svrn_attr+1), hl           ; attribute source end = col 19-n of char row 0
+    ld a, 32 + VIEWPORT_COLS
+    sub c
+    ld l, a
+    ld h, 0
+    ld (_svrn_astep+1), hl          ; to the next row: 32 + (20 - n)
+    ENDIF
+
+    IF !SOUND
     di
+    ENDIF
+    ld (_svrn_save_sp+1), sp
+    ld sp, _scr_addr_table_direct
+    ld a, VIEWPORT_HEIGHT           ; 128 scanlines
+    ld (_svrn_count), a
 
-    ; Alt regs: D' = TILE_PAGE, E' = in_tile_y
-    exx
-    ld d, TILE_PAGE
-    ld e, 0                 ; in_tile_y starts at 0
-    exx
-
-    ; Screen address table pointer
+_svrn_scanline:
+    pop hl                          ; 10T - screen addr from table
+    ld d, h                         ;  4T
+    ld a, l                         ;  4T
+_svrn_src:
+    add a, VIEWPORT_COL_OFFSET + VIEWPORT_COLS - 2  ; 7T - source end (self-mod patched)
+    ld l, a                         ;  4T
+_svrn_dst:
+    add a, 1                        ;  7T - dest end = col 19 (self-mod patched: n)
+    ld e, a                         ;  4T
+_svrn_jump:
+    jp _svrn_ldd                    ; 10T - into the chain (self-mod patched)
+_svrn_ldd:
+    REPT VIEWPORT_COLS - 1
+    LDD
+    ENDR
+
+    ld a, (_svrn_count)             ; 13T
+    dec a                           ;  4T
+    ld (_svrn_count), a             ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svrn_scanline           ; 10T  @loop VIEWPORT_HEIGHT
+
+    ; Char row done: shift its attributes the same way
+_svrn_attr:
+    ld hl, 0                        ; 10T - attr source end (self-mod patched)
+    ld a, l                         ;  4T
+_svrn_adst:
+    add a, 1                        ;  7T - dest end = col 19 (self-mod patched: n)
+    ld e, a                         ;  4T
+    ld d, h                         ;  4T
+_svrn_ajump:
+    jp _svrn_aldd                   ; 10T - into the chain (self-mod patched)
+_svrn_aldd:
+    REPT VIEWPORT_COLS - 1
+    LDD
+    ENDR
+_svrn_astep:
+    ld bc, 32 + VIEWPORT_COLS - 1   ; 10T - self-mod patched: 32 + 20 - n
+    add hl, bc                      ; 11T - next attribute row
+    ld (_svrn_attr+1), hl           ; 16T
+    ld a, (_svrn_count)             ; 13T
+    or a                            ;  4T
+    jp nz, _svrn_scanline           ; 10T  @taken VIEWPORT_CHAR_ROWS-1
+    ELSE
+    jp nz, _svrn_scanline           ; 10T
+    ENDIF
+
+_svrn_save_sp:
+    ld sp, 0                        ; self-mod patched
+    ei
+    ret
+
+_svrn_count:
+    DEFB 0
+
+;----------------------------------------------------------------------
+; _shift_viewport_up_n
+; Shift the viewport up by n char rows (scroll down by n tiles): char rows
+; n..15 move to rows 0..15-n, top-to-bottom. As _shift_viewport_up with
+; the source n char rows further down the LUT and (16-n)×8 scanlines.
+;
+; void shift_viewport_up_n(unsigned char n)
+;
+; T-states: ~68,000 for n = 1, ~4,500 less per extra tile (8 × 563T)
+; @budget BUDGET_SHIFT_UP_N
+;----------------------------------------------------------------------
+_shift_viewport_up_n:
+    ld hl, 2
+    add hl, sp
+    ld c, (hl)                      ; C = n
+    IF TILE_ATTRS
+    ld a, c
+    rrca
+    rrca
+    rrca                            ; n × 32 (n ≤ 7)
+    ld l, a
+    ld h, 0
+    ld de, VIEWPORT_ATTR
+    ld (_svun_adst+1), de           ; attribute rows n.. to rows 0..
+    add hl, de
+    ld (_svun_asrc+1), hl
+    ENDIF
+    ld a, c
+    add a, a
+    add a, a
+    add a, a
+    add a, a                        ; n × 16 bytes of LUT
+    ld e, a
+    ld d, 0
+    ld hl, _scr_addr_table_direct
+    add hl, de                      ; HL = source LUT entry (char row n)
+    ld a, VIEWPORT_CHAR_ROWS
+    sub c
+    add a, a
+    add a, a
+    add a, a                        ; (rows - n) × 8 scanlines
+    ld (_svun_count), a
+
+    IF !SOUND
+    di
+    ENDIF
+    push ix                         ; save SDCC frame pointer
+    ld (_svun_save_sp+1), sp
+    ld sp, hl                       ; SP = source LUT entry
+    ld ix, _scr_addr_table_direct   ; IX = dest LUT entry (char row 0)
+
+_svun_scanline:
+    pop hl                          ; 10T - source screen addr
+    ld a, l                         ;  4T
+    add a, VIEWPORT_COL_OFFSET      ;  7T
+    ld l, a                         ;  4T
+
+    ld e, (ix+0)                    ; 19T
+    ld d, (ix+1)                    ; 19T
+    inc ix                          ; 10T
+    inc ix                          ; 10T
+    ld a, e                         ;  4T
+    add a, VIEWPORT_COL_OFFSET      ;  7T
+    ld e, a                         ;  4T
+
+    ld bc, VIEWPORT_COLS            ; 10T
+    ldir                            ; 19×21 + 16 = 415T
+
+    ld a, (_svun_count)             ; 13T
+    dec a                           ;  4T
+    ld (_svun_count), a             ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svun_scanline           ; 10T  @loop VIEWPORT_HEIGHT-8
+
+    ; Dest char row done: copy its attribute row too
+_svun_asrc:
+    ld hl, 0                        ; 10T - source row (self-mod patched)
+_svun_adst:
+    ld de, 0                        ; 10T - dest row (self-mod patched)
+    REPT VIEWPORT_COLS
+    LDI
+    ENDR
+    ld bc, 32 - VIEWPORT_COLS       ; 10T
+    add hl, bc                      ; 11T
+    ld (_svun_asrc+1), hl           ; 16T
+    ex de, hl                       ;  4T
+    add hl, bc                      ; 11T
+    ld (_svun_adst+1), hl           ; 16T
+    ld a, (_svun_count)             ; 13T
+    or a                            ;  4T
+    jp nz, _svun_scanline           ; 10T  @taken VIEWPORT_CHAR_ROWS-2
+    ELSE
+    jp nz, _svun_scanline           ; 10T  @loop VIEWPORT_HEIGHT-8
+    ENDIF
+
+_svun_save_sp:
+    ld sp, 0                        ; self-mod patched
+    pop ix                          ; restore SDCC frame pointer
+    ei
+    ret
+
+_svun_count:
+    DEFB 0
+
+;----------------------------------------------------------------------
+; _shift_viewport_down_n
+; Shift the viewport down by n char rows (scroll up by n tiles): char rows
+; 0..15-n move to rows n..15, bottom-to-top. As _shift_viewport_down with
+; the dest n×8 LUT entries after the source (self-modified IX displacement,
+; so n is at most 7).
+;
+; void shift_viewport_down_n(unsigned char n)
+;
+; T-states: ~71,000 for n = 1, ~4,700 less per extra tile (8 × 591T)
+; @budget BUDGET_SHIFT_DN_N
+;----------------------------------------------------------------------
+_shift_viewport_down_n:
+    ld hl, 2
+    add hl, sp
+    ld c, (hl)                      ; C = n
+    IF TILE_ATTRS
+    ld a, c
+    rrca
+    rrca
+    rrca                            ; n × 32 (n ≤ 7)
+    ld e, a
+    ld d, 0
+    ld hl, VIEWPORT_ATTR + (VIEWPORT_CHAR_ROWS - 1) * 32
+    ld (_svdn_adst+1), hl           ; attribute rows 15-n.. to rows 15.., upward
+    or a
+    sbc hl, de
+    ld (_svdn_asrc+1), hl
+    ENDIF
+    ld a, c
+    add a, a
+    add a, a
+    add a, a
+    add a, a                        ; n × 16 bytes of LUT
+    ld (_svdn_dst_lo+2), a          ; dest = source + n char rows
+    inc a
+    ld (_svdn_dst_hi+2), a
+    ld a, VIEWPORT_CHAR_ROWS
+    sub c
+    add a, a
+    add a, a
+    add a, a                        ; (rows - n) × 8 scanlines
+    ld (_svdn_count), a
+    ld l, a
+    ld h, 0
+    dec hl
+    add hl, hl
+    ld de, _scr_addr_table_direct
+    add hl, de                      ; HL = last source LUT entry
+
+    IF !SOUND
+    di
+    ENDIF
+    push ix                         ; save SDCC frame pointer
+    push hl
+    pop ix                          ; IX = source, walking backward
+
+_svdn_scanline:
+    ld l, (ix+0)                    ; 19T
+    ld h, (ix+1)                    ; 19T
+    ld a, l                         ;  4T
+    add a, VIEWPORT_COL_OFFSET      ;  7T
+    ld l, a                         ;  4T - HL = source + offset
+
+_svdn_dst_lo:
+    ld e, (ix+16)                   ; 19T - displacement self-mod patched: n × 16
+_svdn_dst_hi:
+    ld d, (ix+17)                   ; 19T - n × 16 + 1
+    ld a, e                         ;  4T
+    add a, VIEWPORT_COL_OFFSET      ;  7T
+    ld e, a                         ;  4T - DE = dest + offset
+
+    ld bc, VIEWPORT_COLS            ; 10T
+    ldir                            ; 415T
+
+    dec ix                          ; 10T
+    dec ix                          ; 10T
+
+    ld a, (_svdn_count)             ; 13T
+    dec a                           ;  4T
+    ld (_svdn_count), a             ; 13T
+    IF TILE_ATTRS
+    and 7                           ;  7T
+    jp nz, _svdn_scanline           ; 10T  @loop VIEWPORT_HEIGHT-8
+
+    ; Dest char row done: copy its attribute row too
+_svdn_asrc:
+    ld hl, 0                        ; 10T - source row (self-mod patched)
+_svdn_adst:
+    ld de, 0                        ; 10T - dest row (self-mod patched)
+    REPT VIEWPORT_COLS
+    LDI
+    ENDR
+    ld bc, -32 - VIEWPORT_COLS      ; 10T - previous row
+    add hl, bc                      ; 11T
+    ld (_svdn_asrc+1), hl           ; 16T
+    ex de, hl                       ;  4T
+    add hl, bc                      ; 11T
+    ld (_svdn_adst+1), hl           ; 16T
+    ld a, (_svdn_count)             ; 13T
+    or a                            ;  4T
+    jp nz, _svdn_scanline           ; 10T  @taken VIEWPORT_CHAR_ROWS-2
+    ELSE
+    jp nz, _svdn_scanline           ; 10T  @loop VIEWPORT_HEIGHT-8
+    ENDIF
+
+    pop ix                          ; restore SDCC frame pointer
+    ei
+    ret
+
+_svdn_count:
+    DEFB 0
+
+;----------------------------------------------------------------------
+; _render_dirty_columns
+; Render the n-wide column edge of a dash step in one pass. Tile-major:
+; each char row's screen address is read from the LUT once, and each tile
+; is written down its 8 scanlines with inc d, so a tile costs ~255T
+; against ~400T in _render_dirty_column. The extra columns share the row
+; setup, so n = 3 costs ~2.2x one column, not 3x. No SP hijack: interrupts
+; stay on.
+;
+; void render_dirty_columns(unsigned char screen_col, const unsigned char *map_col_ptr, unsigned char n)
+;   screen_col:  physical screen byte offset of the leftmost column
+;   map_col_ptr: &map_data[camera_tile_y * MAP_STRIDE + leftmost map column]
+;
+; T-states: 16 rows × (n × ~255 + ~145): ~6,500 (n = 1) to ~14,600 (n = 3)
+; @budget BUDGET_RDCS
+;----------------------------------------------------------------------
+_render_dirty_columns:
+    ; SP+2 = screen_col, SP+3,4 = map_col_ptr, SP+5 = n
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    ld (_rdcs_col+1), a     ; screen column (self-mod)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_col_ptr
+    inc hl
+    ld a, (hl)
+    ld (_rdcs_n+1), a       ; tiles per char row (self-mod)
+
+    push ix                 ; save SDCC frame pointer
     ld ix, _scr_addr_table_direct
+    push de
+    exx
+    pop hl                  ; HL' = map pointer
+    ld bc, MAP_STRIDE       ; BC' = stride to next map row
+    exx
+    ld b, VIEWPORT_CHAR_ROWS
+
+_rdcs_row:
+    ld d, (ix+1)            ; 19T - scanline 0 of the char row
+_rdcs_col:
+    ld a, 0                 ;  7T - screen column (self-mod patched)
+    add a, (ix+0)           ; 19T
+    ld e, a                 ;  4T
+    exx                     ;  4T
+    push hl                 ; 11T - map pointer of the row's first tile
+    exx                     ;  4T
+_rdcs_n:
+    ld c, 0                 ;  7T - n (self-mod patched)
+
+_rdcs_tile:
+    exx                     ;  4T
+    ld a, (hl)              ;  7T - tile index
+    inc hl                  ;  6T - next map column
+    exx                     ;  4T
+    or a                    ;  4T
+    jr nz, _rdcs_tile_draw  ; 12T / 7T
+
+    REPT 7                  ; tile index 0 = blank
+    ld (de), a              ;  7T
+    inc d                   ;  4T
+    ENDR
+    ld (de), a
+    jp _rdcs_next           ; 10T
+
+_rdcs_tile_draw:
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    jr c, _rdcs_draw        ; 12T (no flip bits)
+    push bc
+    push de
+    ld d, TILE_PAGE
+    call _tile_flip_tile
+    pop de
+    pop bc
+    ld a, TILE_SCRATCH
+_rdcs_draw:
+    ENDIF
+
+    add a, a                ;  4T - ×2
+    add a, a                ;  4T - ×4
+    add a, a                ;  4T - ×8
+    ld l, a                 ;  4T
+    ld h, TILE_PAGE         ;  7T
+    REPT 7
+    ld a, (hl)              ;  7T - tile byte
+    ld (de), a              ;  7T
+    inc l                   ;  4T
+    inc d                   ;  4T - next scanline of the char cell
+    ENDR
+    ld a, (hl)
+    ld (de), a              ; scanline 7
+
+_rdcs_next:
+    ld a, d                 ;  4T
+    sub 7                   ;  7T
+    ld d, a                 ;  4T - back to scanline 0
+    inc e                   ;  4T - next screen column
+    dec c                   ;  4T
+    jp nz, _rdcs_tile       ; 10T  @loop 1..SCROLL_STEP_MAX
+
+    exx                     ;  4T
+    pop hl                  ; 10T
+    add hl, bc              ; 11T - next map row
+    exx                     ;  4T
+    ld de, 16               ; 10T
+    add ix, de              ; 15T - next char row's LUT entries
+    dec b                   ;  4T
+    jp nz, _rdcs_row        ; 10T  @loop VIEWPORT_CHAR_ROWS
+
+    pop ix                  ; restore SDCC frame pointer
+    ret
+
+;----------------------------------------------------------------------
+; _render_dirty_rows
+; Render the n-high row edge of a dash step in one pass, tile-major as
+; _render_dirty_columns: ~255T per tile and ~145T per char row, against
+; ~540T per tile in _render_dirty_row, so n = 2 or 3 rows cost about what
+; one row costs there.
+;
+; void render_dirty_rows(unsigned char viewport_char_row, const unsigned char *map_row_ptr, unsigned char n)
+;   viewport_char_row: top row of the edge (row within viewport)
+;   map_row_ptr:       &map_data[top map row * MAP_STRIDE + camera_tile_x]
+;
+; T-states: n × (20 × ~255 + ~145): ~5,300 (n = 1) to ~15,800 (n = 3)
+; @budget BUDGET_RDRS
+;----------------------------------------------------------------------
+_render_dirty_rows:
+    ; SP+2 = viewport_char_row, SP+3,4 = map_row_ptr, SP+5 = n
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_row_ptr
+    inc hl
+    ld b, (hl)              ; B = n
+
+    push ix                 ; save SDCC frame pointer
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; 8 LUT entries (16 bytes) per char row
+    push de
+    ld de, _scr_addr_table_direct
+    add hl, de
+    push hl
+    pop ix                  ; IX = LUT entry of the top row
+    exx
+    pop hl                  ; HL' = map pointer
+    ld bc, MAP_STRIDE       ; BC' = stride to next map row
+    exx
+
+_rdrs_row:
+    ld d, (ix+1)            ; 19T - scanline 0 of the char row
+    ld a, VIEWPORT_COL_OFFSET   ;  7T
+    add a, (ix+0)           ; 19T
+    ld e, a                 ;  4T
+    exx                     ;  4T
+    push hl                 ; 11T - map pointer of the row's first tile
+    exx                     ;  4T
+    ld c, VIEWPORT_COLS     ;  7T
+
+_rdrs_tile:
+    exx                     ;  4T
+    ld a, (hl)              ;  7T - tile index
+    inc hl                  ;  6T - next map column
+    exx                     ;  4T
+    or a                    ;  4T
+    jr nz, _rdrs_tile_draw  ; 12T / 7T
+
+    REPT 7                  ; tile index 0 = blank
+    ld (de), a              ;  7T
+    inc d                   ;  4T
+    ENDR
+    ld (de), a
+    jp _rdrs_next           ; 10T
+
+_rdrs_tile_draw:
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    jr c, _rdrs_draw        ; 12T (no flip bits)
+    push bc
+    push de
+    ld d, TILE_PAGE
+    call _tile_flip_tile
+    pop de
+    pop bc
+    ld a, TILE_SCRATCH
+_rdrs_draw:
+    ENDIF
+
+    add a, a                ;  4T - ×2
+    add a, a                ;  4T - ×4
+    add a, a                ;  4T - ×8
+    ld l, a                 ;  4T
+    ld h, TILE_PAGE         ;  7T
+    REPT 7
+    ld a, (hl)              ;  7T - tile byte
+    ld (de), a              ;  7T
+    inc l                   ;  4T
+    inc d                   ;  4T - next scanline of the char cell
+    ENDR
+    ld a, (hl)
+    ld (de), a              ; scanline 7
+
+_rdrs_next:
+    ld a, d                 ;  4T
+    sub 7                   ;  7T
+    ld d, a                 ;  4T - back to scanline 0
+    inc e                   ;  4T - next screen column
+    dec c                   ;  4T
+    jp nz, _rdrs_tile       ; 10T  @loop VIEWPORT_COLS
+
+    exx                     ;  4T
+    pop hl                  ; 10T
+    add hl, bc              ; 11T - next map row
+    exx                     ;  4T
+    ld de, 16               ; 10T
+    add ix, de              ; 15T - next char row's LUT entries
+    dec b                   ;  4T
+    jp nz, _rdrs_row        ; 10T  @loop 1..SCROLL_STEP_MAX
+
+    pop ix                  ; restore SDCC frame pointer
+    ret
+
+    IF TILE_ATTRS
+;----------------------------------------------------------------------
+; _attr_dirty_column
+; Write the attributes of one viewport column from the map: one table
+; lookup per tile (blank tiles included). Called after the column's pixels.
+;
+; void attr_dirty_column(unsigned char screen_col, const unsigned char *map_col_ptr)
+;   screen_col:  physical screen byte offset (VIEWPORT_COL_OFFSET + col)
+;   map_col_ptr: &map_data[camera_tile_y * MAP_STRIDE + map_tile_col]
+;
+; T-states: ~1,400 (16 tiles × ~80T)
+; @budget BUDGET_ADC
+;----------------------------------------------------------------------
+_attr_dirty_column:
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = screen_col
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_col_ptr
+    ld hl, 0x5800 + VIEWPORT_START_CHAR_ROW * 32
+    add a, l
+    ld l, a
+    adc a, h
+    sub l
+    ld h, a                 ; HL = attribute of the top tile
+    ex de, hl               ; HL = map, DE = attribute
+    ld b, ATTR_PAGE
+
+    REPT VIEWPORT_CHAR_ROWS
+    ld c, (hl)              ;  7T - map byte
+    ld a, (bc)              ;  7T - its attribute
+    ld (de), a              ;  7T
+    IF MAP_COL_STEP = 1
+    inc l                   ;  4T - next cell of the metatile strip
+    ELSE
+    IF MAP_STRIDE = 256
+    inc h                   ;  4T - next map row
+    ELSE
+    ld a, l                 ;  4T
+    add a, MAP_STRIDE & 0xFF  ; 7T
+    ld l, a                 ;  4T
+    ld a, h                 ;  4T
+    adc a, MAP_STRIDE / 256 ;  7T
+    ld h, a                 ;  4T - next map row
+    ENDIF
+    ENDIF
+    ld a, e                 ;  4T
+    add a, 32               ;  7T
+    ld e, a                 ;  4T
+    adc a, d                ;  4T
+    sub e                   ;  4T
+    ld d, a                 ;  4T - next attribute row
+    ENDR
+    ret
+
+;----------------------------------------------------------------------
+; _attr_dirty_row
+; Write the attributes of one viewport char row from the map.
+;
+; void attr_dirty_row(unsigned char viewport_char_row, const unsigned char *map_row_ptr)
+;   viewport_char_row: 0-15
+;   map_row_ptr:       &map_data[map_tile_row * MAP_STRIDE + camera_tile_x]
+;
+; T-states: ~800 (20 tiles × 31T)
+; @budget BUDGET_ADR
+;----------------------------------------------------------------------
+_attr_dirty_row:
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_row_ptr
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl              ; row × 32
+    ld bc, VIEWPORT_ATTR
+    add hl, bc
+    ex de, hl               ; HL = map, DE = attribute of the leftmost tile
+    ld b, ATTR_PAGE
+
+    REPT VIEWPORT_COLS
+    ld c, (hl)              ;  7T - map byte
+    ld a, (bc)              ;  7T - its attribute
+    ld (de), a              ;  7T
+    inc hl                  ;  6T
+    inc e                   ;  4T - a viewport row never crosses a page
+    ENDR
+    ret
+    ENDIF
+
+;----------------------------------------------------------------------
+; _render_dirty_row
+; Render 1 row of 20 tiles (8 scanlines × 20 bytes) directly to screen.
+; Uses exx tile lookup pattern from draw_aligned.asm.
+;
+; void render_dirty_row(unsigned char viewport_char_row, const unsigned char *map_row_ptr)
+;   viewport_char_row: 0-15 (row within viewport)
+;   map_row_ptr:       &map_data[map_tile_row * MAP_STRIDE + camera_tile_x]
+;
+; T-states: ~11,100 uncontended (8 scanlines × 20 tiles × 67T + setup)
+;   (~39,200 with TILE_FLIP if every tile is flipped)
+; @budget BUDGET_RDR
+;----------------------------------------------------------------------
+_render_dirty_row:
+    ; Read params from stack (SDCC sdcc_iy: char is 1 byte on stack)
+    ; SP+2   = viewport_char_row (1 byte)
+    ; SP+3,4 = map_row_ptr
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row (0-15)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = map_row_ptr
+
+    ; Save map_row_ptr for reuse each scanline
+    ld (_rdr_map_ptr+1), de
+
+    ; Look up screen base address from table
+    ; Table offset = viewport_char_row * 16 (8 entries × 2 bytes per char row)
+    IF VIEWPORT_CHAR_ROWS > 16
+    ld l, a
+    ld h, 0
+    add hl, hl              ; ×2
+    add hl, hl              ; ×4
+    add hl, hl              ; ×8
+    add hl, hl              ; ×16
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ELSE
+    add a, a                ; ×2
+    add a, a                ; ×4
+    add a, a                ; ×8
+    add a, a                ; ×16
+    ld c, a
+    ld b, 0
+    ld hl, _scr_addr_table_direct
+    add hl, bc
+    ENDIF
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = screen addr for first scanline of row
+
+    ; Add viewport column offset
+    ld a, e
+    add a, VIEWPORT_COL_OFFSET
+    ld e, a
+
+    IF !SOUND
+    di
+    ENDIF
+
+    ; Setup: save screen base in self-mod location
+    ; Within a char row, next scanline = +0x100 (inc D)
+    ld (_rdr_scr_base), de
+
+    ; Alt regs: D' = TILE_PAGE, E' = in_tile_y (0-7)
+    exx
+    ld d, TILE_PAGE
+    ld e, 0                 ; in_tile_y starts at 0
+    exx
+
+    ld b, 8                 ; 8 scanlines per row
+
+_rdr_scanline:
+    push bc                 ; save scanline counter
+
+    ; Load map pointer (reset each scanline to same row start)
+_rdr_map_ptr:
+    ld hl, 0                ; self-mod: map_row_ptr
+    ld de, (_rdr_scr_base)  ; DE = screen address for this scanline
+
+    ; 20 tiles unrolled: read map, exx, lookup tile, exx, write to screen
+    ; Per tile: ld a,(hl)/inc hl/exx/add×3/add a,e/ld l,a/ld h,d/ld a,(hl)/exx/ld (de),a/inc e
+    ; = 7+6+4+4+4+4+4+4+4+7+4+7+4 = 67T per tile (inc hl is 6T not 4T)
+    ; With a power-of-two MAP_STRIDE (or a metatile strip) a map row never
+    ; crosses a page, so inc l (4T) steps the column: 65T per tile
+
+    REPT VIEWPORT_COLS
+    ld a, (hl)              ;  7T - tile index from map
+    IF MAP_ROW_IN_PAGE
+    inc l                   ;  4T - next map column (row within one page)
+    ELSE
+    inc hl                  ;  6T - next map column
+    ENDIF
+    exx                     ;  4T
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    call nc, _tile_flip_to_scratch  ; 10T (no flip bits)
+    ENDIF
+    add a, a                ;  4T - ×2
+    add a, a                ;  4T - ×4
+    add a, a                ;  4T - ×8
+    add a, e                ;  4T - + in_tile_y
+    ld l, a                 ;  4T
+    ld h, d                 ;  4T - H = TILE_PAGE
+    ld a, (hl)              ;  7T - tile byte
+    exx                     ;  4T
+    ld (de), a              ;  7T - write to screen
+    inc e                   ;  4T - next screen column
+    ENDR
+
+    ; Advance screen base for next scanline: D += 1 (next pixel row = +0x100)
+    ld hl, _rdr_scr_base+1
+    inc (hl)                ; 11T - screen H += 1
+
+    ; Increment in_tile_y in alt regs
+    exx
+    inc e                   ;  4T - E' = in_tile_y++
+    exx
+
+    pop bc                  ; restore scanline counter
+    dec b
+    jp nz, _rdr_scanline
 
-    ld c, VIEWPORT_CHAR_ROWS   ; C = 16 char rows
-    ld b, 8                    ; B = 8 scanlines per char row
+    ei
+    ret
 
-_rfv_scanline:
-    push bc                 ; save counters
+_rdr_scr_base:
+    DEFW 0
 
-    ; Get screen address from table
-    ld e, (ix+0)
-    ld d, (ix+1)
-    inc ix
-    inc ix
+;----------------------------------------------------------------------
+; _clear_dirty_column
+; Zero 1 column (16 tiles, 128 scanlines). Used instead of
+; _render_dirty_column when the map occupancy bitmap says the span is blank.
+; One LUT entry per char row; the 8 scanlines of a char row are +0x100 apart.
+;
+; void clear_dirty_column(unsigned char screen_col)
+;   screen_col: physical screen byte offset
+;
+; T-states: ~2,400 uncontended (16 char rows × ~150T)
+; @budget BUDGET_CDC
+;----------------------------------------------------------------------
+_clear_dirty_column:
+    ld hl, 2
+    add hl, sp
+    ld c, (hl)              ; C = screen_col byte offset
+    ld e, 0                 ; E = fill byte
+
+    IF !SOUND
+    di
+    ENDIF
+    ld (_cdc_save_sp+1), sp ; save SP (self-modifying)
+    ld sp, _scr_addr_table_direct
+    ld b, VIEWPORT_CHAR_ROWS
+
+_cdc_char_row:
+    pop hl                  ; 10T - scanline 0 of this char row
+    ld a, l                 ;  4T
+    add a, c                ;  4T - + column offset
+    ld l, a                 ;  4T
+    REPT 7
+    ld (hl), e              ;  7T
+    inc h                   ;  4T - next scanline
+    ENDR
+    ld (hl), e              ;  7T - scanline 7
+    ld hl, 14               ; 10T - skip the other 7 LUT entries
+    add hl, sp              ; 11T
+    ld sp, hl               ;  6T
+    djnz _cdc_char_row      ; 13T
+
+_cdc_save_sp:
+    ld sp, 0                ; 10T - restore SP (self-mod patched)
+    ei
+    ret
+
+;----------------------------------------------------------------------
+; _clear_dirty_row
+; Zero 1 row (20 tiles × 8 scanlines). Used instead of _render_dirty_row
+; when the map occupancy bitmap says the span is blank.
+;
+; void clear_dirty_row(unsigned char viewport_char_row)
+;   viewport_char_row: 0-15 (row within viewport)
+;
+; T-states: ~2,000 uncontended (8 scanlines × 20 × 11T + setup)
+; @budget BUDGET_CDR
+;----------------------------------------------------------------------
+_clear_dirty_row:
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row (0-15)
+
+    ; Screen base from table: offset = viewport_char_row * 16
+    IF VIEWPORT_CHAR_ROWS > 16
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ELSE
+    add a, a
+    add a, a
+    add a, a
+    add a, a
+    ld c, a
+    ld b, 0
+    ld hl, _scr_addr_table_direct
+    add hl, bc
+    ENDIF
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = screen addr for first scanline of row
 
-    ; Add viewport column offset
     ld a, e
     add a, VIEWPORT_COL_OFFSET
     ld e, a
+    ld c, e                 ; C = first viewport column, reset per scanline
+
+    xor a
+    ld b, 8                 ; 8 scanlines per row
+
+_cdr_scanline:
+    REPT VIEWPORT_COLS
+    ld (de), a              ;  7T
+    inc e                   ;  4T
+    ENDR
+    ld e, c                 ;  4T
+    inc d                   ;  4T - next scanline (+0x100)
+    djnz _cdr_scanline      ; 13T
+
+    ret
+
+;----------------------------------------------------------------------
+; Edge cache strips
+; A strip holds exactly the bytes an edge render writes, in scanline order:
+;   column strip: VIEWPORT_HEIGHT bytes (16 tiles × 8 scanlines)
+;   row strip:    8 × VIEWPORT_COLS bytes (scanline 0 of every tile, then 1...)
+; Idle frames pre-render the next strips from the map; a scroll step saves
+; the strip that scrolls out. The step's edge phase then becomes a blit.
+;----------------------------------------------------------------------
+
+;----------------------------------------------------------------------
+; _prerender_edge_column
+; Render 1 column of 16 tiles into a column strip instead of the screen.
+; LDI counts the strip down in BC; tile 0 is the blank tile (all zero) in
+; the optimised tile page, so no blank shortcut is needed.
+;
+; void prerender_edge_column(unsigned char *strip, const unsigned char *map_col_ptr)
+;   map_col_ptr: &map_data[tile_row * MAP_STRIDE + tile_col]
+;
+; T-states: ~3,100 uncontended (16 tiles × ~190T)
+;   (~32,000 with TILE_FLIP if every tile is flipped)
+; @budget BUDGET_PEC
+;----------------------------------------------------------------------
+_prerender_edge_column:
+    ; SP+2,3 = strip, SP+4,5 = map_col_ptr
+    ld hl, 2
+    add hl, sp
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = strip
+    inc hl
+    ld a, (hl)
+    inc hl
+    ld h, (hl)
+    ld l, a                 ; HL = map_col_ptr
+
+    ; Alt regs: HL' = map pointer, BC' = MAP_STRIDE
+    push hl
+    exx
+    pop hl
+    IF MAP_COL_STEP <> 1 && MAP_COL_STEP <> 256
+    ld bc, MAP_STRIDE
+    ENDIF
+    exx
 
-    ; Load map pointer for this row
-    ld hl, (_rfv_map_ptr)
+    ld bc, VIEWPORT_HEIGHT  ; BC = strip bytes left (LDI counts down)
 
-    ; Draw 20 tiles for this scanline
-    REPT 20
+_pec_tile:
+    exx                     ;  4T
     ld a, (hl)              ;  7T - tile index
-    inc hl                  ;  6T
+    IF MAP_COL_STEP = 1
+    inc l                   ;  4T - next cell of the metatile strip
+    ELSE
+    IF MAP_STRIDE = 256
+    inc h                   ;  4T - next map row is the next page
+    ELSE
+    add hl, bc              ; 11T - advance map ptr by MAP_STRIDE
+    ENDIF
+    ENDIF
     exx                     ;  4T
-    add a, a                ;  4T
-    add a, a                ;  4T
-    add a, a                ;  4T
-    add a, e                ;  4T - + in_tile_y
+
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    jr c, _pec_tile_draw    ; 12T (no flip bits)
+    push bc
+    push de
+    ld d, TILE_PAGE
+    call _tile_flip_tile
+    pop de
+    pop bc
+    ld a, TILE_SCRATCH
+_pec_tile_draw:
+    ENDIF
+
+    add a, a                ;  4T - ×2
+    add a, a                ;  4T - ×4
+    add a, a                ;  4T - ×8
     ld l, a                 ;  4T
-    ld h, d                 ;  4T - TILE_PAGE
-    ld a, (hl)              ;  7T
-    exx                     ;  4T
-    ld (de), a              ;  7T
-    inc e                   ;  4T
+    ld h, TILE_PAGE         ;  7T
+    REPT 8
+    ldi                     ; 16T - tile byte to strip
     ENDR
+    jp pe, _pec_tile        ; 10T - until BC = 0  @loop VIEWPORT_CHAR_ROWS
+    ret
 
-    pop bc                  ; restore counters
+;----------------------------------------------------------------------
+; _prerender_edge_row
+; Render 1 row of 20 tiles into a row strip instead of the screen.
+; Same tile lookup as _render_dirty_row; the strip is written linearly.
+;
+; void prerender_edge_row(unsigned char *strip, const unsigned char *map_row_ptr)
+;   map_row_ptr: &map_data[tile_row * MAP_STRIDE + tile_col]
+;
+; T-states: ~10,500 uncontended (8 scanlines × 20 tiles × ~67T + setup)
+;   (~38,700 with TILE_FLIP if every tile is flipped)
+; @budget BUDGET_PER
+;----------------------------------------------------------------------
+_prerender_edge_row:
+    ; SP+2,3 = strip, SP+4,5 = map_row_ptr
+    ld hl, 2
+    add hl, sp
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = strip
+    inc hl
+    ld a, (hl)
+    inc hl
+    ld h, (hl)
+    ld l, a
+    ld (_per_map_ptr+1), hl ; map_row_ptr, reused each scanline
 
-    ; Advance in_tile_y
+    ; Alt regs: D' = TILE_PAGE, E' = in_tile_y (0-7)
     exx
-    inc e                   ;  4T
+    ld d, TILE_PAGE
+    ld e, 0
     exx
 
-    dec b
-    jp nz, _rfv_scanline    ; loop for 8 scanlines within char row
+    ld b, 8                 ; 8 scanlines per row
+
+_per_scanline:
+_per_map_ptr:
+    ld hl, 0                ; self-mod: map_row_ptr
+
+    REPT VIEWPORT_COLS
+    ld a, (hl)              ;  7T - tile index from map
+    IF MAP_ROW_IN_PAGE
+    inc l                   ;  4T - next map column (row within one page)
+    ELSE
+    inc hl                  ;  6T - next map column
+    ENDIF
+    exx                     ;  4T
+    IF TILE_FLIP
+    cp TILE_FLIP_MIN        ;  7T
+    call nc, _tile_flip_to_scratch  ; 10T (no flip bits)
+    ENDIF
+    add a, a                ;  4T - ×2
+    add a, a                ;  4T - ×4
+    add a, a                ;  4T - ×8
+    add a, e                ;  4T - + in_tile_y
+    ld l, a                 ;  4T
+    ld h, d                 ;  4T - H = TILE_PAGE
+    ld a, (hl)              ;  7T - tile byte
+    exx                     ;  4T
+    ld (de), a              ;  7T - write to strip
+    inc de                  ;  6T - next strip byte
+    ENDR
 
-    ; B exhausted: end of char row
-    ; Reset in_tile_y, advance map pointer, next char row
     exx
-    ld e, 0                 ; reset in_tile_y to 0
+    inc e                   ;  4T - E' = in_tile_y++
     exx
+    dec b
+    jp nz, _per_scanline
 
-    ld hl, (_rfv_map_ptr)
-    ld de, MAP_WIDTH
-    add hl, de
-    ld (_rfv_map_ptr), hl   ; advance to next map row
+    ret
+
+;----------------------------------------------------------------------
+; _blit_edge_column
+; Copy a column strip to the screen (replaces _render_dirty_column).
+; SP walks the strip, two scanlines per pop; IX walks the screen LUT one
+; entry per char row (the 8 scanlines of a char row are +0x100 apart).
+;
+; void blit_edge_column(unsigned char screen_col, const unsigned char *strip)
+;   screen_col: physical screen byte offset
+;
+; T-states: ~3,600 uncontended (16 char rows × 215T)
+; @budget BUDGET_BEC
+;----------------------------------------------------------------------
+_blit_edge_column:
+    ; SP+2 = screen_col (1 byte), SP+3,4 = strip
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    ld (_bec_col+1), a      ; column offset (self-modifying)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = strip
 
-    ld b, 8                 ; reset scanline counter
-    dec c                   ; next char row
-    jp nz, _rfv_scanline    ; loop for 16 char rows
+    push ix                 ; save SDCC frame pointer
+    ld ix, _scr_addr_table_direct
+    IF !SOUND
+    di
+    ENDIF
+    ld (_bec_save_sp+1), sp ; save SP (self-modifying)
+    ex de, hl
+    ld sp, hl               ; SP = strip
+    ld b, VIEWPORT_CHAR_ROWS
+
+_bec_char_row:
+    ld a, (ix+0)            ; 19T - scanline 0 of this char row
+_bec_col:
+    add a, 0                ;  7T - + column offset (self-mod patched)
+    ld l, a                 ;  4T
+    ld h, (ix+1)            ; 19T
+    ld de, 16               ; 10T - skip to the next char row's entry
+    add ix, de              ; 15T
+    REPT 4
+    pop de                  ; 10T - two strip bytes
+    ld (hl), e              ;  7T
+    inc h                   ;  4T - next scanline
+    ld (hl), d              ;  7T
+    inc h                   ;  4T
+    ENDR
+    djnz _bec_char_row      ; 13T
 
+_bec_save_sp:
+    ld sp, 0                ; restore SP (self-mod patched)
+    ei
     pop ix                  ; restore SDCC frame pointer
+    ret
+
+;----------------------------------------------------------------------
+; _blit_edge_row
+; Copy a row strip to the screen (replaces _render_dirty_row).
+;
+; void blit_edge_row(unsigned char viewport_char_row, const unsigned char *strip)
+;   viewport_char_row: 0-15 (row within viewport)
+;
+; T-states: ~2,900 uncontended (8 scanlines × 20 LDI + setup)
+; @budget BUDGET_BER
+;----------------------------------------------------------------------
+_blit_edge_row:
+    ; SP+2 = viewport_char_row (1 byte), SP+3,4 = strip
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row (0-15)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)
+    push de                 ; strip
+
+    ; Screen base from table: offset = viewport_char_row * 16
+    IF VIEWPORT_CHAR_ROWS > 16
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ELSE
+    add a, a
+    add a, a
+    add a, a
+    add a, a
+    ld c, a
+    ld b, 0
+    ld hl, _scr_addr_table_direct
+    add hl, bc
+    ENDIF
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = screen addr for first scanline of row
+
+    ld a, e
+    add a, VIEWPORT_COL_OFFSET
+    ld e, a                 ; A = first viewport column, reset per scanline
+    pop hl                  ; HL = strip
+    ld bc, 8 * VIEWPORT_COLS
+
+_ber_scanline:
+    REPT VIEWPORT_COLS
+    ldi                     ; 16T
+    ENDR
+    ret po                  ;  5T - BC = 0: all 8 scanlines copied
+    IF VIEWPORT_COL_OFFSET + VIEWPORT_COLS == 32
+    dec de                  ;  6T - undo the last LDI's carry into D (0x..E0 rows)
+    ENDIF
+    ld e, a                 ;  4T
+    inc d                   ;  4T - next scanline (+0x100)
+    jp _ber_scanline        ; 10T  @loop 8
+
+;----------------------------------------------------------------------
+; _save_edge_column
+; Copy 1 screen column into a column strip: the column about to scroll out,
+; kept so that reversing direction is a blit. Mirror of _blit_edge_column:
+; walks the char rows bottom-up and PUSHes two scanlines at a time.
+;
+; void save_edge_column(unsigned char screen_col, unsigned char *strip)
+;   screen_col: physical screen byte offset
+;
+; T-states: ~3,900 uncontended (16 char rows × 230T)
+; @budget BUDGET_SEC
+;----------------------------------------------------------------------
+_save_edge_column:
+    ; SP+2 = screen_col (1 byte), SP+3,4 = strip
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)
+    ld (_sec_col+1), a      ; column offset (self-modifying)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = strip
+    ld hl, VIEWPORT_HEIGHT
+    add hl, de              ; HL = end of strip
+
+    push ix                 ; save SDCC frame pointer
+    ld ix, _scr_addr_table_direct + (VIEWPORT_HEIGHT - 8) * 2  ; last char row
+    IF !SOUND
+    di
+    ENDIF
+    ld (_sec_save_sp+1), sp ; save SP (self-modifying)
+    ld sp, hl               ; SP = end of strip, filled downwards
+    ld b, VIEWPORT_CHAR_ROWS
+
+_sec_char_row:
+    ld a, (ix+0)            ; 19T
+_sec_col:
+    add a, 0                ;  7T - + column offset (self-mod patched)
+    ld l, a                 ;  4T
+    ld a, (ix+1)            ; 19T
+    add a, 7                ;  7T
+    ld h, a                 ;  4T - HL = scanline 7 of this char row
+    ld de, -16              ; 10T - previous char row's entry
+    add ix, de              ; 15T
+    REPT 4
+    ld d, (hl)              ;  7T - odd scanline (higher strip address)
+    dec h                   ;  4T
+    ld e, (hl)              ;  7T - even scanline
+    dec h                   ;  4T
+    push de                 ; 11T
+    ENDR
+    djnz _sec_char_row      ; 13T
+
+_sec_save_sp:
+    ld sp, 0                ; restore SP (self-mod patched)
     ei
+    pop ix                  ; restore SDCC frame pointer
     ret
 
-_rfv_map_ptr:
-    DEFW 0
+;----------------------------------------------------------------------
+; _save_edge_row
+; Copy 1 screen row into a row strip (the row about to scroll out).
+;
+; void save_edge_row(unsigned char viewport_char_row, unsigned char *strip)
+;   viewport_char_row: 0-15 (row within viewport)
+;
+; T-states: ~2,900 uncontended (8 scanlines × 20 LDI + setup)
+; @budget BUDGET_SER
+;----------------------------------------------------------------------
+_save_edge_row:
+    ; SP+2 = viewport_char_row (1 byte), SP+3,4 = strip
+    ld hl, 2
+    add hl, sp
+    ld a, (hl)              ; A = viewport_char_row (0-15)
+    inc hl
+    ld e, (hl)
+    inc hl
+    ld d, (hl)
+    push de                 ; strip
+
+    ; Screen base from table: offset = viewport_char_row * 16
+    IF VIEWPORT_CHAR_ROWS > 16
+    ld l, a
+    ld h, 0
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    add hl, hl
+    ld bc, _scr_addr_table_direct
+    add hl, bc
+    ELSE
+    add a, a
+    add a, a
+    add a, a
+    add a, a
+    ld c, a
+    ld b, 0
+    ld hl, _scr_addr_table_direct
+    add hl, bc
+    ENDIF
+    ld a, (hl)
+    inc hl
+    ld h, (hl)
+    add a, VIEWPORT_COL_OFFSET
+    ld l, a                 ; HL = screen, A = first viewport column
+    pop de                  ; DE = strip
+    ld bc, 8 * VIEWPORT_COLS
+
+_ser_scanline:
+    REPT VIEWPORT_COLS
+    ldi                     ; 16T
+    ENDR
+    ret po                  ;  5T - BC = 0: all 8 scanlines copied
+    IF VIEWPORT_COL_OFFSET + VIEWPORT_COLS == 32
+    dec hl                  ;  6T - undo the last LDI's carry into H (0x..E0 rows)
+    ENDIF
+    ld l, a                 ;  4T
+    inc h                   ;  4T - next scanline (+0x100)
+    jp _ser_scanline        ; 10T  @loop 8
+
+    IF METATILE
+;----------------------------------------------------------------------
+; _meta_expand_column
+; Expand one edge column of a metatile map into META_COL_STRIP: the cells
+; of column `sub` of META_COL_BLOCKS blocks down from meta_ptr, one byte
+; each. The block after the last visible one is expanded too (whole
+; blocks keep the unroll fixed), so the strip covers any first cell row.
+;
+; void meta_expand_column(const unsigned char *meta_ptr, unsigned char sub)
+;   meta_ptr: &map_data[(tile_row >> META_SHIFT) * MAP_STRIDE + (tile_col >> META_SHIFT)]
+;   sub:      tile_col & (METATILE - 1)
+;
+; T-states: ~800 for 2x2 (9 blocks × 85T), ~860 for 4x4 (5 × 160T)
+; @budget BUDGET_MEC
+;----------------------------------------------------------------------
+_meta_expand_column:
+    ; SP+2,3 = meta_ptr, SP+4 = sub
+    ld hl, 2
+    add hl, sp
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = meta_ptr
+    inc hl
+    ld c, (hl)              ; C = cell column in the block
+    ex de, hl               ; HL = map
+    IF MAP_STRIDE <> 256
+    ld de, MAP_STRIDE       ; DE = next block row
+    ENDIF
+    exx
+    ld hl, META_COL_STRIP   ; HL' = strip
+    ld d, META_PAGE         ; D' = dictionary page
+    exx
+
+    REPT META_COL_BLOCKS
+    ld a, (hl)              ;  7T - block: its cells' dictionary offset
+    IF MAP_STRIDE = 256
+    inc h                   ;  4T - next block row is the next page
+    ELSE
+    add hl, de              ; 11T - next block row
+    ENDIF
+    add a, c                ;  4T - + cell column
+    exx                     ;  4T
+    ld e, a                 ;  4T
+    ld a, (de)              ;  7T - cell
+    ld (hl), a              ;  7T
+    inc l                   ;  4T
+    REPT METATILE - 1
+    IF METATILE = 2
+    inc e                   ;  4T
+    inc e                   ;  4T - next cell row of the block
+    ELSE
+    ld a, e                 ;  4T
+    add a, METATILE         ;  7T
+    ld e, a                 ;  4T - next cell row of the block
+    ENDIF
+    ld a, (de)              ;  7T
+    ld (hl), a              ;  7T
+    inc l                   ;  4T
+    ENDR
+    exx                     ;  4T
+    ENDR
+    ret
+
+;----------------------------------------------------------------------
+; _meta_expand_row
+; Expand one edge row of a metatile map into META_ROW_STRIP: cell row
+; sub / METATILE of META_ROW_BLOCKS blocks from meta_ptr. A block's row is
+; METATILE consecutive dictionary bytes, copied with LDI; H' is reloaded per
+; block, as the last LDI of the page's last block carries into it.
+;
+; void meta_expand_row(const unsigned char *meta_ptr, unsigned char sub)
+;   meta_ptr: &map_data[(tile_row >> META_SHIFT) * MAP_STRIDE + (tile_col >> META_SHIFT)]
+;   sub:      (tile_row & (METATILE - 1)) * METATILE
+;
+; T-states: ~800 for 2x2 (11 blocks × 66T), ~700 for 4x4 (6 × 98T)
+; @budget BUDGET_MER
+;----------------------------------------------------------------------
+_meta_expand_row:
+    ; SP+2,3 = meta_ptr, SP+4 = sub
+    ld hl, 2
+    add hl, sp
+    ld e, (hl)
+    inc hl
+    ld d, (hl)              ; DE = meta_ptr
+    inc hl
+    ld c, (hl)              ; C = first cell of the row in a block
+    ex de, hl               ; HL = map
+    exx
+    ld de, META_ROW_STRIP   ; DE' = strip
+    exx
+
+    REPT META_ROW_BLOCKS
+    ld a, (hl)              ;  7T - block
+    IF MAP_STRIDE_SHIFT
+    inc l                   ;  4T - next block (map row within one page)
+    ELSE
+    inc hl                  ;  6T - next block
+    ENDIF
+    add a, c                ;  4T - + cell row
+    exx                     ;  4T
+    ld l, a                 ;  4T
+    ld h, META_PAGE         ;  7T
+    REPT METATILE
+    ldi                     ; 16T - cell to strip (BC' is scratch)
+    ENDR
+    exx                     ;  4T
+    ENDR
+    ret
+    ENDIF
+
+    IF TILE_FLIP
+;----------------------------------------------------------------------
+; _tile_flip_to_scratch
+; Decode one row of a flipped tile into the scratch tile.
+;   A = map byte (index | TILE_FLIP_H 0x80 | TILE_FLIP_V 0x40)
+;   D = TILE_PAGE, E = in_tile_y (0-7)
+; Returns A = TILE_SCRATCH. Clobbers BC, HL.
+;----------------------------------------------------------------------
+_tile_flip_to_scratch:
+    ld c, a                 ; C = flip bits
+    and TILE_INDEX_MASK
+    add a, a
+    add a, a
+    add a, a
+    ld l, a                 ; L = index * 8
+    ld a, e
+    bit 6, c
+    jr z, _tfs_no_v
+    xor 7                   ; V flip: read row 7-y
+_tfs_no_v:
+    add a, l
+    ld l, a
+    ld h, d
+    ld a, (hl)              ; source tile byte
+    bit 7, c
+    jr z, _tfs_no_h
+    ld l, a
+    ld h, REV_PAGE
+    ld a, (hl)              ; H flip: bit-reversed byte
+_tfs_no_h:
+    ld b, a
+    ld a, TILE_SCRATCH * 8
+    add a, e
+    ld l, a
+    ld h, d
+    ld (hl), b
+    ld a, TILE_SCRATCH
+    ret
+
+;----------------------------------------------------------------------
+; _tile_flip_tile
+; Decode all 8 rows of a flipped tile into the scratch tile.
+;   A = map byte, D = TILE_PAGE. Clobbers BC, DE, HL.
+;----------------------------------------------------------------------
+_tile_flip_tile:
+    ld e, 0
+_tft_row:
+    push af
+    call _tile_flip_to_scratch
+    pop af
+    inc e
+    bit 3, e
+    jr z, _tft_row          ; @loop 8
+    ret
+    ENDIF
 
 ;----------------------------------------------------------------------
-; Screen address lookup table for Y=64..191
-; 128 entries (16 char rows × 8 scanlines each)
+; Screen address lookup table, one entry per viewport scanline
+; (generated: Y=64..191, 128 entries for the default 20×16 viewport)
 ; ZX Spectrum: addr = 0x4000 | (Y&0xC0)<<5 | (Y&0x07)<<8 | (Y&0x38)<<2
 ;----------------------------------------------------------------------
+    IF SOUND
+_scr_addr_table_guard:
+    DEFW 0                  ; takes an interrupt's return address (sound.asm)
+    ENDIF
 _scr_addr_table_direct:
-    ; Y=64-71 (third 1, char row 0 in third)
-    DEFW 0x4800, 0x4900, 0x4A00, 0x4B00, 0x4C00, 0x4D00, 0x4E00, 0x4F00
-    ; Y=72-79 (third 1, char row 1)
-    DEFW 0x4820, 0x4920, 0x4A20, 0x4B20, 0x4C20, 0x4D20, 0x4E20, 0x4F20
-    ; Y=80-87 (third 1, char row 2)
-    DEFW 0x4840, 0x4940, 0x4A40, 0x4B40, 0x4C40, 0x4D40, 0x4E40, 0x4F40
-    ; Y=88-95 (third 1, char row 3)
-    DEFW 0x4860, 0x4960, 0x4A60, 0x4B60, 0x4C60, 0x4D60, 0x4E60, 0x4F60
-    ; Y=96-103 (third 1, char row 4)
-    DEFW 0x4880, 0x4980, 0x4A80, 0x4B80, 0x4C80, 0x4D80, 0x4E80, 0x4F80
-    ; Y=104-111 (third 1, char row 5)
-    DEFW 0x48A0, 0x49A0, 0x4AA0, 0x4BA0, 0x4CA0, 0x4DA0, 0x4EA0, 0x4FA0
-    ; Y=112-119 (third 1, char row 6)
-    DEFW 0x48C0, 0x49C0, 0x4AC0, 0x4BC0, 0x4CC0, 0x4DC0, 0x4EC0, 0x4FC0
-    ; Y=120-127 (third 1, char row 7)
-    DEFW 0x48E0, 0x49E0, 0x4AE0, 0x4BE0, 0x4CE0, 0x4DE0, 0x4EE0, 0x4FE0
-    ; Y=128-135 (third 2, char row 0)
-    DEFW 0x5000, 0x5100, 0x5200, 0x5300, 0x5400, 0x5500, 0x5600, 0x5700
-    ; Y=136-143 (third 2, char row 1)
-    DEFW 0x5020, 0x5120, 0x5220, 0x5320, 0x5420, 0x5520, 0x5620, 0x5720
-    ; Y=144-151 (third 2, char row 2)
-    DEFW 0x5040, 0x5140, 0x5240, 0x5340, 0x5440, 0x5540, 0x5640, 0x5740
-    ; Y=152-159 (third 2, char row 3)
-    DEFW 0x5060, 0x5160, 0x5260, 0x5360, 0x5460, 0x5560, 0x5660, 0x5760
-    ; Y=160-167 (third 2, char row 4)
-    DEFW 0x5080, 0x5180, 0x5280, 0x5380, 0x5480, 0x5580, 0x5680, 0x5780
-    ; Y=168-175 (third 2, char row 5)
-    DEFW 0x50A0, 0x51A0, 0x52A0, 0x53A0, 0x54A0, 0x55A0, 0x56A0, 0x57A0
-    ; Y=176-183 (third 2, char row 6)
-    DEFW 0x50C0, 0x51C0, 0x52C0, 0x53C0, 0x54C0, 0x55C0, 0x56C0, 0x57C0
-    ; Y=184-191 (third 2, char row 7)
-    DEFW 0x50E0, 0x51E0, 0x52E0, 0x53E0, 0x54E0, 0x55E0, 0x56E0, 0x57E0
+    INCLUDE "scr_addr_table.inc"
@@ -4,12 +4,31 @@
 ;
 ; Layout:
 ;   0x6000 - tiles     (2048 bytes, ends at 0x6800)
-;   0x6800 - map_data  (4608 bytes, ends at 0x7A00)
+;   0x6800 - map_data  (MAP_STRIDE × MAP_HEIGHT: 4608 bytes for 96×48 packed,
+;                       6144 at stride 128 - ends at 0x8000)
+;   Addresses come from viewport.inc (generate_viewport).
+;
+; The occupancy bitmaps (map_occ.bin) are linked into the program instead,
+; so a padded map can fill the contended area:
+;   map_row_occ (MAP_HEIGHT rows × ceil(MAP_WIDTH/8) bytes)
+;   map_col_occ (MAP_WIDTH cols × ceil(MAP_HEIGHT/8) bytes)
 
     SECTION code_user
 
+    INCLUDE "viewport.inc"
+
     PUBLIC _tiles
     DEFC _tiles = $6000
 
     PUBLIC _map_data
-    DEFC _map_data = $6800
+    DEFC _map_data = MAP_ADDR
+
+    SECTION rodata_user
+
+    PUBLIC _map_row_occ
+    PUBLIC _map_col_occ
+
+_map_row_occ:
+    BINARY "map_occ.bin"
+
+    DEFC _map_col_occ = _map_row_occ + MAP_HEIGHT * ((MAP_WIDTH + 7) / 8)
@@ -0,0 +1,19 @@
+// Generated by generate_viewport - do not edit
+#ifndef VIEWPORT_H
+#define VIEWPORT_H
+
+#define VIEWPORT_COLS           20
+#define VIEWPORT_CHAR_ROWS      16
+#define VIEWPORT_START_CHAR_ROW 8
+#define VIEWPORT_COL_OFFSET     6
+#define DIRTY_START_CHAR_ROW    4
+
+#define MAP_WIDTH  96
+#define MAP_HEIGHT 48
+#define MAP_STRIDE 128        // bytes per map row
+#define MAP_STRIDE_SHIFT 7  // log2(MAP_STRIDE), 0 if not a power of two
+
+#define METATILE   0        // cells per metatile side, 0 = cell map
+#define META_SHIFT 0
+
+#endif // VIEWPORT_H
@@ -0,0 +1,1301 @@
+// Minimal Z80 assembler for host-side tools: see z80_asm.h.
+//
+// Three passes over the sources: the first sizes every section, the second
+// settles label-dependent constants with the sections in place, the third
+// writes the bytes and reports anything still undefined or out of range.
+// Instruction sizes never depend on operand values, so the layout from the
+// first pass holds.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "z80_asm.h"
+
+#define MAX_LINE      512
+#define SYM_HASH      16384     // power of two, > max symbols
+#define MAX_SECTIONS  16
+#define MAX_FILES     16
+#define MAX_DIRS      8
+#define MAX_INCLUDE   8
+#define MAX_COND      32
+#define PASSES        3
+
+typedef struct {
+    char name[64];
+    int module;         // source file index, -1: PUBLIC or -D
+    long value;         // constant value, or offset into `section`
+    int section;        // -1: constant
+    int pass;           // pass that last defined it (0: -D, -1: PUBLIC only)
+} symbol;
+
+typedef struct {
+    char name[48];
+    long pc;            // location counter (offset) in the current pass
+    long size;          // size from the previous pass
+    long base;
+    int has_org;
+    long org;
+} section;
+
+typedef struct {
+    char *path;
+    char **lines;
+    int count;
+} source;
+
+struct z80_asm {
+    symbol *syms;
+    int sym_count;
+    int hash[SYM_HASH];         // symbol index + 1, 0 = empty
+    section secs[MAX_SECTIONS];
+    int sec_count;
+    int cur;
+    int module;                 // file being assembled
+    char *files[MAX_FILES];
+    int file_count;
+    char *dirs[MAX_DIRS];       // searched first by INCLUDE / BINARY
+    int dir_count;
+    source **srcs;              // loaded sources (files and includes)
+    int src_count;
+    int pass;
+    int final;
+    int errors;
+    const char *file;           // position for messages
+    int line;
+    uint8_t *mem;
+    long lo, hi;
+};
+
+// --- Errors ---
+
+static void asm_error(z80_asm *as, const char *msg, const char *detail) {
+    // Only the emitting pass reports, so each error appears once
+    if (!as->final) return;
+    fprintf(stderr, "%s:%d: %s%s%s\n", as->file ? as->file : "?", as->line, msg,
+            detail ? " " : "", detail ? detail : "");
+    as->errors++;
+}
+
+static void asm_fatal(z80_asm *as, const char *msg, const char *detail) {
+    fprintf(stderr, "%s:%d: %s%s%s\n", as->file ? as->file : "?", as->line, msg,
+            detail ? " " : "", detail ? detail : "");
+    as->errors++;
+}
+
+// --- Symbols ---
+
+// Each source file is a module, as with z80asm: its symbols are local
+// unless declared PUBLIC. INCLUDEd files belong to the including module.
+
+static unsigned hash_name(const char *s, int module) {
+    unsigned h = 5381 + (unsigned)module;
+    while (*s) h = h * 33 + (unsigned char)*s++;
+    return h & (SYM_HASH - 1);
+}
+
+static symbol *find_in(const z80_asm *as, const char *name, int module) {
+    unsigned h = hash_name(name, module);
+    while (as->hash[h]) {
+        symbol *s = &as->syms[as->hash[h] - 1];
+        if (s->module == module && strcmp(s->name, name) == 0) return s;
+        h = (h + 1) & (SYM_HASH - 1);
+    }
+    return NULL;
+}
+
+// Visible from the current module: its own symbols, then PUBLIC / -D ones
+static symbol *find_sym(const z80_asm *as, const char *name) {
+    symbol *s = find_in(as, name, as->module);
+    if (s) return s;
+    s = find_in(as, name, -1);
+    return s && s->pass >= 0 ? s : NULL;
+}
+
+static symbol *new_sym(z80_asm *as, const char *name, int module) {
+    unsigned h = hash_name(name, module);
+    symbol *s;
+    if (as->sym_count >= SYM_HASH / 2) {
+        fprintf(stderr, "Error: too many symbols\n");
+        exit(1);
+    }
+    while (as->hash[h]) h = (h + 1) & (SYM_HASH - 1);
+    as->hash[h] = as->sym_count + 1;
+    s = &as->syms[as->sym_count++];
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    s->module = module;
+    s->section = -1;
+    s->pass = -1;
+    return s;
+}
+
+static long sym_value(const z80_asm *as, const symbol *s) {
+    return s->section < 0 ? s->value : as->secs[s->section].base + s->value;
+}
+
+// Define a constant (section -1) or a label in this pass
+static void define(z80_asm *as, const char *name, long value, int sec) {
+    symbol *s = find_in(as, name, -1);
+    if (!s || s->pass == 0) {
+        // Not PUBLIC: local to the module (-D values still shadow it)
+        if (s && s->pass == 0) return;
+        s = find_in(as, name, as->module);
+        if (!s) s = new_sym(as, name, as->module);
+    }
+    if (s->pass == as->pass) {
+        asm_error(as, "symbol redefined:", name);
+        return;
+    }
+    s->value = value;
+    s->section = sec;
+    s->pass = as->pass;
+}
+
+// --- Expressions ---
+
+typedef struct {
+    z80_asm *as;
+    const char *p;
+    int ok;
+} expr_state;
+
+static long parse_or(expr_state *e);
+
+static void skip_ws(expr_state *e) {
+    while (*e->p == ' ' || *e->p == '\t') e->p++;
+}
+
+static long parse_number(expr_state *e) {
+    const char *s = e->p;
+    char buf[64];
+    int n = 0;
+    long v;
+    char *end;
+
+    if (*s == '$' || (*s == '0' && (s[1] == 'x' || s[1] == 'X'))) {
+        s += (*s == '$') ? 1 : 2;
+        v = strtol(s, &end, 16);
+        if (end == s) e->ok = 0;
+        e->p = end;
+        return v;
+    }
+    if (*s == '%') {
+        s++;
+        v = strtol(s, &end, 2);
+        if (end == s) e->ok = 0;
+        e->p = end;
+        return v;
+    }
+    while (isalnum((unsigned char)s[n]) && n < 63) {
+        buf[n] = s[n];
+        n++;
+    }
+    buf[n] = 0;
+    e->p = s + n;
+    if (n > 1 && (buf[n - 1] == 'h' || buf[n - 1] == 'H')) {
+        buf[n - 1] = 0;
+        v = strtol(buf, &end, 16);
+    } else if (n > 1 && (buf[n - 1] == 'b' || buf[n - 1] == 'B') && strspn(buf, "01") == (size_t)(n - 1)) {
+        buf[n - 1] = 0;
+        v = strtol(buf, &end, 2);
+    } else {
+        v = strtol(buf, &end, 10);
+    }
+    if (*end) e->ok = 0;
+    return v;
+}
+
+static long parse_primary(expr_state *e) {
+    skip_ws(e);
+    if (*e->p == '(') {
+        e->p++;
+        long v = parse_or(e);
+        skip_ws(e);
+        if (*e->p == ')') e->p++;
+        else e->ok = 0;
+        return v;
+    }
+    if (*e->p == '-') { e->p++; return -parse_primary(e); }
+    if (*e->p == '+') { e->p++; return parse_primary(e); }
+    if (*e->p == '~') { e->p++; return ~parse_primary(e); }
+    if (*e->p == '!') { e->p++; return !parse_primary(e); }
+    if (*e->p == '\'' && e->p[1] && e->p[2] == '\'') {
+        long v = (unsigned char)e->p[1];
+        e->p += 3;
+        return v;
+    }
+    if (*e->p == '$' && !isxdigit((unsigned char)e->p[1])) {
+        const section *sec = &e->as->secs[e->as->cur];
+        e->p++;
+        return sec->base + sec->pc;
+    }
+    if (isdigit((unsigned char)*e->p) || *e->p == '$' || *e->p == '%') return parse_number(e);
+    if (isalpha((unsigned char)*e->p) || *e->p == '_' || *e->p == '.') {
+        char name[64];
+        int n = 0;
+        while ((isalnum((unsigned char)*e->p) || *e->p == '_' || *e->p == '.') && n < 63) name[n++] = *e->p++;
+        name[n] = 0;
+        symbol *s = find_sym(e->as, name);
+        if (!s) {
+            // Forward references settle in the later passes
+            if (e->as->final) asm_error(e->as, "undefined symbol:", name);
+            return 0;
+        }
+        return sym_value(e->as, s);
+    }
+    e->ok = 0;
+    return 0;
+}
+
+static long parse_mul(expr_state *e) {
+    long v = parse_primary(e);
+    for (;;) {
+        skip_ws(e);
+        char c = *e->p;
+        if (c != '*' && c != '/' && c != '%') return v;
+        e->p++;
+        long r = parse_primary(e);
+        if (c == '*') v *= r;
+        else if (r == 0) { if (e->as->final) e->ok = 0; }
+        else if (c == '/') v /= r;
+        else v %= r;
+    }
+}
+
+static long parse_add(expr_state *e) {
+    long v = parse_mul(e);
+    for (;;) {
+        skip_ws(e);
+        char c = *e->p;
+        if (c != '+' && c != '-') return v;
+        e->p++;
+        long r = parse_mul(e);
+        v = c == '+' ? v + r : v - r;
+    }
+}
+
+static long parse_shift(expr_state *e) {
+    long v = parse_add(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '<' && e->p[1] == '<') { e->p += 2; v <<= parse_add(e); }
+        else if (e->p[0] == '>' && e->p[1] == '>') { e->p += 2; v >>= parse_add(e); }
+        else return v;
+    }
+}
+
+static long parse_cmp(expr_state *e) {
+    long v = parse_shift(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '=' && e->p[1] == '=') { e->p += 2; v = v == parse_shift(e); }
+        else if (e->p[0] == '!' && e->p[1] == '=') { e->p += 2; v = v != parse_shift(e); }
+        else if (e->p[0] == '<' && e->p[1] == '>') { e->p += 2; v = v != parse_shift(e); }
+        else if (e->p[0] == '<' && e->p[1] == '=') { e->p += 2; v = v <= parse_shift(e); }
+        else if (e->p[0] == '>' && e->p[1] == '=') { e->p += 2; v = v >= parse_shift(e); }
+        else if (e->p[0] == '<') { e->p++; v = v < parse_shift(e); }
+        else if (e->p[0] == '>') { e->p++; v = v > parse_shift(e); }
+        else if (e->p[0] == '=') { e->p++; v = v == parse_shift(e); }
+        else return v;
+    }
+}
+
+static long parse_and(expr_state *e) {
+    long v = parse_cmp(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '&' && e->p[1] == '&') { e->p += 2; v = parse_cmp(e) && v; }
+        else if (e->p[0] == '&') { e->p++; v &= parse_cmp(e); }
+        else return v;
+    }
+}
+
+static long parse_or(expr_state *e) {
+    long v = parse_and(e);
+    for (;;) {
+        skip_ws(e);
+        if (e->p[0] == '|' && e->p[1] == '|') { e->p += 2; v = parse_and(e) || v; }
+        else if (e->p[0] == '|') { e->p++; v |= parse_and(e); }
+        else if (e->p[0] == '^') { e->p++; v ^= parse_and(e); }
+        else return v;
+    }
+}
+
+static long eval(z80_asm *as, const char *s) {
+    expr_state e = { as, s, 1 };
+    long v = parse_or(&e);
+    skip_ws(&e);
+    if (*e.p) e.ok = 0;
+    if (!e.ok) asm_error(as, "bad expression:", s);
+    return v;
+}
+
+// IF / REPT / DEFS counts must be known in every pass
+static long eval_now(z80_asm *as, const char *s) {
+    int final = as->final;
+    as->final = 1;
+    long v = eval(as, s);
+    as->final = final;
+    return v;
+}
+
+// --- Text helpers ---
+
+static char *trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    size_t n = strlen(s);
+    while (n && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r' || s[n - 1] == '\n')) s[--n] = 0;
+    return s;
+}
+
+static void lower(char *dst, const char *src, size_t cap) {
+    size_t i = 0;
+    for (; src[i] && i + 1 < cap; i++) dst[i] = (char)tolower((unsigned char)src[i]);
+    dst[i] = 0;
+}
+
+// First word of a line, lower-cased
+static void first_word(const char *line, char *w, size_t cap) {
+    size_t n = 0;
+    while (line[n] && line[n] != ' ' && line[n] != '\t' && n + 1 < cap) n++;
+    snprintf(w, cap, "%.*s", (int)n, line);
+    for (size_t i = 0; w[i]; i++) w[i] = (char)tolower((unsigned char)w[i]);
+}
+
+// Strip a ';' comment outside quotes
+static void strip_comment(char *s) {
+    int inq = 0;
+    for (; *s; s++) {
+        if (*s == '"') inq = !inq;
+        else if (*s == ';' && !inq) { *s = 0; return; }
+    }
+}
+
+// Split on top-level commas (outside parentheses and quotes)
+static int split_operands(char *s, char **out, int max) {
+    int n = 0, depth = 0, inq = 0;
+    char *start = s;
+    if (!*trim(s)) return 0;
+    for (char *p = s;; p++) {
+        if (*p == '"') inq = !inq;
+        else if (!inq && *p == '(') depth++;
+        else if (!inq && *p == ')') depth--;
+        if (*p == 0 || (*p == ',' && depth == 0 && !inq)) {
+            int end = *p == 0;
+            *p = 0;
+            if (n < max) out[n] = trim(start);
+            n++;
+            if (end) break;
+            start = p + 1;
+        }
+    }
+    return n;
+}
+
+static int quoted_name(const char *s, char *out, size_t cap) {
+    const char *q1 = strchr(s, '"');
+    const char *q2 = q1 ? strchr(q1 + 1, '"') : NULL;
+    if (!q1 || !q2) return 0;
+    snprintf(out, cap, "%.*s", (int)(q2 - q1 - 1), q1 + 1);
+    return 1;
+}
+
+// INCLUDE / BINARY path: the include directories first, then relative to
+// the including file's directory
+static void relative_path(const z80_asm *as, const char *from, const char *name, char *out, size_t cap) {
+    const char *slash = strrchr(from, '/');
+    if (name[0] != '/') {
+        for (int i = 0; i < as->dir_count; i++) {
+            FILE *f;
+            snprintf(out, cap, "%s/%s", as->dirs[i], name);
+            if ((f = fopen(out, "rb")) != NULL) {
+                fclose(f);
+                return;
+            }
+        }
+    }
+    if (slash && name[0] != '/')
+        snprintf(out, cap, "%.*s/%s", (int)(slash - from), from, name);
+    else
+        snprintf(out, cap, "%s", name);
+}
+
+// --- Sources ---
+
+static source *load_source(z80_asm *as, const char *path) {
+    for (int i = 0; i < as->src_count; i++)
+        if (strcmp(as->srcs[i]->path, path) == 0) return as->srcs[i];
+
+    FILE *f = fopen(path, "r");
+    char buf[MAX_LINE];
+    int cap = 0;
+    if (!f) return NULL;
+    // Held by pointer: an INCLUDE loads while its parent is being read
+    as->srcs = (source **)realloc(as->srcs, (size_t)(as->src_count + 1) * sizeof(source *));
+    source *src = (source *)calloc(1, sizeof(source));
+    as->srcs[as->src_count++] = src;
+    src->path = strdup(path);
+    while (fgets(buf, sizeof(buf), f)) {
+        if (src->count == cap) {
+            cap = cap ? cap * 2 : 256;
+            src->lines = (char **)realloc(src->lines, (size_t)cap * sizeof(char *));
+        }
+        src->lines[src->count++] = strdup(buf);
+    }
+    fclose(f);
+    return src;
+}
+
+// --- Output ---
+
+static long here(const z80_asm *as) {
+    const section *s = &as->secs[as->cur];
+    return s->base + s->pc;
+}
+
+static void emit(z80_asm *as, long v) {
+    if (as->final) {
+        long addr = here(as);
+        if (addr < 0 || addr > 0xFFFF) asm_error(as, "address out of range", NULL);
+        else {
+            as->mem[addr] = (uint8_t)v;
+            if (addr < as->lo) as->lo = addr;
+            if (addr + 1 > as->hi) as->hi = addr + 1;
+        }
+    }
+    as->secs[as->cur].pc++;
+}
+
+static void emit_byte(z80_asm *as, long v) {
+    if (v < -128 || v > 255) asm_error(as, "byte value out of range", NULL);
+    emit(as, v & 0xFF);
+}
+
+static void emit_word(z80_asm *as, long v) {
+    if (v < -32768 || v > 65535) asm_error(as, "word value out of range", NULL);
+    emit(as, v & 0xFF);
+    emit(as, (v >> 8) & 0xFF);
+}
+
+static void select_section(z80_asm *as, const char *name) {
+    for (int i = 0; i < as->sec_count; i++) {
+        if (strcmp(as->secs[i].name, name) == 0) {
+            as->cur = i;
+            return;
+        }
+    }
+    if (as->sec_count == MAX_SECTIONS) {
+        asm_fatal(as, "too many sections", NULL);
+        return;
+    }
+    section *s = &as->secs[as->sec_count];
+    memset(s, 0, sizeof(*s));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    as->cur = as->sec_count++;
+}
+
+// --- Operands ---
+
+typedef enum {
+    O_R8,       // b c d e h l a (reg = 0-5, 7)
+    O_XR8,      // ixh ixl iyh iyl (reg = 4/5, prefix)
+    O_MHL,      // (hl)
+    O_MIDX,     // (ix+d) / (iy+d)
+    O_R16,      // bc de hl sp (reg = 0-3), ix/iy as hl with prefix
+    O_AF,       // af
+    O_AF_ALT,   // af'
+    O_MBC,      // (bc)
+    O_MDE,      // (de)
+    O_MSP,      // (sp)
+    O_MC,       // (c)
+    O_I,
+    O_R,
+    O_IMM,      // expression
+    O_MEM       // (expression)
+} op_kind;
+
+typedef struct {
+    op_kind kind;
+    int reg;
+    int prefix;     // 0, 0xDD or 0xFD
+    char expr[MAX_LINE];
+    char lc[MAX_LINE];  // lower-cased, spaces removed (conditions, registers)
+} operand;
+
+// "(...)" whose closing parenthesis is the last character
+static int wrapped(const char *s) {
+    size_t n = strlen(s);
+    int depth = 0;
+    if (n < 2 || s[0] != '(' || s[n - 1] != ')') return 0;
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == '(') depth++;
+        else if (s[i] == ')' && --depth == 0 && i != n - 1) return 0;
+    }
+    return 1;
+}
+
+static void parse_operand(const char *text, operand *o) {
+    static const char *r8[] = { "b", "c", "d", "e", "h", "l", NULL, "a" };
+    char lc[MAX_LINE];
+    int k = 0;
+    memset(o, 0, sizeof(*o));
+    snprintf(o->expr, sizeof(o->expr), "%s", text);
+    for (int i = 0; text[i] && k < (int)sizeof(lc) - 1; i++)
+        if (text[i] != ' ' && text[i] != '\t') lc[k++] = (char)tolower((unsigned char)text[i]);
+    lc[k] = 0;
+    snprintf(o->lc, sizeof(o->lc), "%s", lc);
+
+    for (int i = 0; i < 8; i++) {
+        if (r8[i] && strcmp(lc, r8[i]) == 0) { o->kind = O_R8; o->reg = i; return; }
+    }
+    if (!strcmp(lc, "ixh") || !strcmp(lc, "xh")) { o->kind = O_XR8; o->reg = 4; o->prefix = 0xDD; return; }
+    if (!strcmp(lc, "ixl") || !strcmp(lc, "xl")) { o->kind = O_XR8; o->reg = 5; o->prefix = 0xDD; return; }
+    if (!strcmp(lc, "iyh") || !strcmp(lc, "yh")) { o->kind = O_XR8; o->reg = 4; o->prefix = 0xFD; return; }
+    if (!strcmp(lc, "iyl") || !strcmp(lc, "yl")) { o->kind = O_XR8; o->reg = 5; o->prefix = 0xFD; return; }
+    if (!strcmp(lc, "bc")) { o->kind = O_R16; o->reg = 0; return; }
+    if (!strcmp(lc, "de")) { o->kind = O_R16; o->reg = 1; return; }
+    if (!strcmp(lc, "hl")) { o->kind = O_R16; o->reg = 2; return; }
+    if (!strcmp(lc, "sp")) { o->kind = O_R16; o->reg = 3; return; }
+    if (!strcmp(lc, "ix")) { o->kind = O_R16; o->reg = 2; o->prefix = 0xDD; return; }
+    if (!strcmp(lc, "iy")) { o->kind = O_R16; o->reg = 2; o->prefix = 0xFD; return; }
+    if (!strcmp(lc, "af")) { o->kind = O_AF; return; }
+    if (!strcmp(lc, "af'")) { o->kind = O_AF_ALT; return; }
+    if (!strcmp(lc, "i")) { o->kind = O_I; return; }
+    if (!strcmp(lc, "r")) { o->kind = O_R; return; }
+    if (!strcmp(lc, "(hl)")) { o->kind = O_MHL; o->reg = 6; return; }
+    if (!strcmp(lc, "(bc)")) { o->kind = O_MBC; return; }
+    if (!strcmp(lc, "(de)")) { o->kind = O_MDE; return; }
+    if (!strcmp(lc, "(sp)")) { o->kind = O_MSP; return; }
+    if (!strcmp(lc, "(c)")) { o->kind = O_MC; return; }
+    if ((!strncmp(lc, "(ix", 3) || !strncmp(lc, "(iy", 3))
+        && (lc[3] == ')' || lc[3] == '+' || lc[3] == '-') && wrapped(lc)) {
+        const char *t = text;
+        o->kind = O_MIDX;
+        o->reg = 6;
+        o->prefix = lc[2] == 'x' ? 0xDD : 0xFD;
+        // Displacement: the original text between "ix"/"iy" and ')'
+        while (*t && tolower((unsigned char)*t) != 'i') t++;
+        t += 2;
+        snprintf(o->expr, sizeof(o->expr), "%s", t);
+        o->expr[strlen(o->expr) - 1] = 0;     // drop ')'
+        if (!*trim(o->expr)) snprintf(o->expr, sizeof(o->expr), "0");
+        return;
+    }
+    if (wrapped(text)) {
+        size_t n = strlen(text);
+        o->kind = O_MEM;
+        snprintf(o->expr, sizeof(o->expr), "%.*s", (int)(n - 2), text + 1);
+        return;
+    }
+    o->kind = O_IMM;
+}
+
+// Condition code for jp/jr/call/ret, -1 if none
+static int condition(const char *lc) {
+    static const char *cc[] = { "nz", "z", "nc", "c", "po", "pe", "p", "m" };
+    for (int i = 0; i < 8; i++) if (!strcmp(lc, cc[i])) return i;
+    return -1;
+}
+
+// Registers that take (hl)/(ix+d) positions: r8, (hl), (ix+d), ixh/ixl
+static int is_r8ish(const operand *o) {
+    return o->kind == O_R8 || o->kind == O_MHL || o->kind == O_MIDX || o->kind == O_XR8;
+}
+
+// Prefix + opcode + displacement for an 8-bit register operand at `op`
+static void emit_r8op(z80_asm *as, const operand *o, long op) {
+    if (o->prefix) emit(as, o->prefix);
+    emit(as, op);
+    if (o->kind == O_MIDX) {
+        long d = eval(as, o->expr);
+        if (d < -128 || d > 127) asm_error(as, "index offset out of range", o->expr);
+        emit(as, d & 0xFF);
+    }
+}
+
+// Two 8-bit register operands may not mix IX and IY, ixh/ixl with h/l or
+// (hl), or (ix+d) with anything but a plain register (h and l stay h and l)
+static int r8_pair_ok(const operand *a, const operand *b) {
+    int pa = a->kind == O_XR8 ? a->prefix : 0, pb = b->kind == O_XR8 ? b->prefix : 0;
+    if (a->kind == O_MIDX || b->kind == O_MIDX) {
+        const operand *r = a->kind == O_MIDX ? b : a;
+        return r->kind == O_R8;
+    }
+    if (a->kind == O_MHL && b->kind == O_MHL) return 0;
+    if (pa && pb && pa != pb) return 0;
+    if ((pa || pb) && (a->kind == O_MHL || b->kind == O_MHL)) return 0;
+    if (pa && b->kind == O_R8 && (b->reg == 4 || b->reg == 5)) return 0;
+    if (pb && a->kind == O_R8 && (a->reg == 4 || a->reg == 5)) return 0;
+    return 1;
+}
+
+static void emit_rel(z80_asm *as, long op, const char *target) {
+    long t = eval(as, target);
+    long d = t - (here(as) + 2);
+    emit(as, op);
+    if (as->final && (d < -128 || d > 127)) asm_error(as, "relative jump out of range:", target);
+    emit(as, d & 0xFF);
+}
+
+static int encode_ld(z80_asm *as, operand *a, operand *b) {
+    // 8-bit register / memory moves
+    if (is_r8ish(a) && is_r8ish(b)) {
+        if (!r8_pair_ok(a, b)) return 0;
+        const operand *p = a->prefix ? a : b;
+        if (p->prefix) emit(as, p->prefix);
+        emit(as, 0x40 | a->reg << 3 | b->reg);
+        if (p->kind == O_MIDX) {
+            long d = eval(as, p->expr);
+            if (d < -128 || d > 127) asm_error(as, "index offset out of range", p->expr);
+            emit(as, d & 0xFF);
+        }
+        return 1;
+    }
+    if (is_r8ish(a) && b->kind == O_IMM) {
+        emit_r8op(as, a, 0x06 | a->reg << 3);
+        emit_byte(as, eval(as, b->expr));
+        return 1;
+    }
+    if (a->kind == O_R8 && a->reg == 7) {
+        if (b->kind == O_MBC) { emit(as, 0x0A); return 1; }
+        if (b->kind == O_MDE) { emit(as, 0x1A); return 1; }
+        if (b->kind == O_MEM) { emit(as, 0x3A); emit_word(as, eval(as, b->expr)); return 1; }
+        if (b->kind == O_I) { emit(as, 0xED); emit(as, 0x57); return 1; }
+        if (b->kind == O_R) { emit(as, 0xED); emit(as, 0x5F); return 1; }
+    }
+    if (b->kind == O_R8 && b->reg == 7) {
+        if (a->kind == O_MBC) { emit(as, 0x02); return 1; }
+        if (a->kind == O_MDE) { emit(as, 0x12); return 1; }
+        if (a->kind == O_MEM) { emit(as, 0x32); emit_word(as, eval(as, a->expr)); return 1; }
+        if (a->kind == O_I) { emit(as, 0xED); emit(as, 0x47); return 1; }
+        if (a->kind == O_R) { emit(as, 0xED); emit(as, 0x4F); return 1; }
+    }
+    // 16-bit
+    if (a->kind == O_R16) {
+        if (b->kind == O_IMM) {
+            if (a->prefix) emit(as, a->prefix);
+            emit(as, 0x01 | a->reg << 4);
+            emit_word(as, eval(as, b->expr));
+            return 1;
+        }
+        if (b->kind == O_MEM) {
+            if (a->reg == 2) {
+                if (a->prefix) emit(as, a->prefix);
+                emit(as, 0x2A);
+            } else {
+                emit(as, 0xED);
+                emit(as, 0x4B | a->reg << 4);
+            }
+            emit_word(as, eval(as, b->expr));
+            return 1;
+        }
+        if (a->reg == 3 && !a->prefix && b->kind == O_R16 && b->reg == 2) {
+            if (b->prefix) emit(as, b->prefix);
+            emit(as, 0xF9);
+            return 1;
+        }
+    }
+    if (a->kind == O_MEM && b->kind == O_R16) {
+        if (b->reg == 2) {
+            if (b->prefix) emit(as, b->prefix);
+            emit(as, 0x22);
+        } else {
+            emit(as, 0xED);
+            emit(as, 0x43 | b->reg << 4);
+        }
+        emit_word(as, eval(as, a->expr));
+        return 1;
+    }
+    return 0;
+}
+
+// add/adc/sub/sbc/and/xor/or/cp
+static int encode_alu(z80_asm *as, int op, operand *ops, int n) {
+    operand *src;
+    if (n == 2 && ops[0].kind == O_R8 && ops[0].reg == 7) src = &ops[1];
+    else if (n == 1) src = &ops[0];
+    else return 0;
+    if (is_r8ish(src)) {
+        emit_r8op(as, src, 0x80 | op << 3 | src->reg);
+        return 1;
+    }
+    if (src->kind == O_IMM) {
+        emit(as, 0xC6 | op << 3);
+        emit_byte(as, eval(as, src->expr));
+        return 1;
+    }
+    return 0;
+}
+
+static int encode_add16(z80_asm *as, const char *mn, operand *a, operand *b) {
+    if (a->kind != O_R16 || a->reg != 2 || b->kind != O_R16) return 0;
+    if (b->reg == 2 && b->prefix != a->prefix) return 0;
+    if (!strcmp(mn, "add")) {
+        if (a->prefix) emit(as, a->prefix);
+        emit(as, 0x09 | b->reg << 4);
+        return 1;
+    }
+    if (a->prefix || b->prefix) return 0;
+    emit(as, 0xED);
+    emit(as, (!strcmp(mn, "adc") ? 0x4A : 0x42) | b->reg << 4);
+    return 1;
+}
+
+static int encode_cb(z80_asm *as, long op, operand *o) {
+    if (!is_r8ish(o) || o->kind == O_XR8) return 0;
+    if (o->kind == O_MIDX) {
+        long d = eval(as, o->expr);
+        if (d < -128 || d > 127) asm_error(as, "index offset out of range", o->expr);
+        emit(as, o->prefix);
+        emit(as, 0xCB);
+        emit(as, d & 0xFF);
+        emit(as, op | 6);
+        return 1;
+    }
+    emit(as, 0xCB);
+    emit(as, op | o->reg);
+    return 1;
+}
+
+typedef struct {
+    const char *mn;
+    int len;
+    uint8_t b[2];
+} fixed_op;
+
+static const fixed_op fixed_ops[] = {
+    { "nop", 1, { 0x00 } }, { "halt", 1, { 0x76 } }, { "di", 1, { 0xF3 } }, { "ei", 1, { 0xFB } },
+    { "exx", 1, { 0xD9 } }, { "scf", 1, { 0x37 } }, { "ccf", 1, { 0x3F } }, { "cpl", 1, { 0x2F } },
+    { "daa", 1, { 0x27 } }, { "rla", 1, { 0x17 } }, { "rra", 1, { 0x1F } }, { "rlca", 1, { 0x07 } },
+    { "rrca", 1, { 0x0F } }, { "neg", 2, { 0xED, 0x44 } }, { "reti", 2, { 0xED, 0x4D } },
+    { "retn", 2, { 0xED, 0x45 } }, { "rld", 2, { 0xED, 0x6F } }, { "rrd", 2, { 0xED, 0x67 } },
+    { "ldi", 2, { 0xED, 0xA0 } }, { "cpi", 2, { 0xED, 0xA1 } }, { "ini", 2, { 0xED, 0xA2 } },
+    { "outi", 2, { 0xED, 0xA3 } }, { "ldd", 2, { 0xED, 0xA8 } }, { "cpd", 2, { 0xED, 0xA9 } },
+    { "ind", 2, { 0xED, 0xAA } }, { "outd", 2, { 0xED, 0xAB } }, { "ldir", 2, { 0xED, 0xB0 } },
+    { "cpir", 2, { 0xED, 0xB1 } }, { "inir", 2, { 0xED, 0xB2 } }, { "otir", 2, { 0xED, 0xB3 } },
+    { "lddr", 2, { 0xED, 0xB8 } }, { "cpdr", 2, { 0xED, 0xB9 } }, { "indr", 2, { 0xED, 0xBA } },
+    { "otdr", 2, { 0xED, 0xBB } },
+    { NULL, 0, { 0 } }
+};
+
+static int encode(z80_asm *as, const char *mn, operand *ops, int n) {
+    static const char *alu[] = { "add", "adc", "sub", "sbc", "and", "xor", "or", "cp", NULL };
+    static const char *rot[] = { "rlc", "rrc", "rl", "rr", "sla", "sra", "sll", "srl", NULL };
+    operand *a = &ops[0], *b = &ops[1];
+
+    for (int i = 0; fixed_ops[i].mn; i++) {
+        if (strcmp(mn, fixed_ops[i].mn) == 0) {
+            if (n) return 0;
+            for (int k = 0; k < fixed_ops[i].len; k++) emit(as, fixed_ops[i].b[k]);
+            return 1;
+        }
+    }
+    if (!strcmp(mn, "ld")) return n == 2 && encode_ld(as, a, b);
+    if (!strcmp(mn, "push") || !strcmp(mn, "pop")) {
+        int base = mn[1] == 'u' ? 0xC5 : 0xC1;
+        if (n != 1) return 0;
+        if (a->kind == O_AF) { emit(as, base | 3 << 4); return 1; }
+        if (a->kind != O_R16 || a->reg == 3) return 0;
+        if (a->prefix) emit(as, a->prefix);
+        emit(as, base | a->reg << 4);
+        return 1;
+    }
+    if (n == 2 && (!strcmp(mn, "add") || !strcmp(mn, "adc") || !strcmp(mn, "sbc")) && a->kind == O_R16)
+        return encode_add16(as, mn, a, b);
+    for (int i = 0; alu[i]; i++)
+        if (!strcmp(mn, alu[i])) return encode_alu(as, i, ops, n);
+    if (!strcmp(mn, "inc") || !strcmp(mn, "dec")) {
+        int dec = mn[0] == 'd';
+        if (n != 1) return 0;
+        if (is_r8ish(a)) { emit_r8op(as, a, (dec ? 0x05 : 0x04) | a->reg << 3); return 1; }
+        if (a->kind == O_R16) {
+            if (a->prefix) emit(as, a->prefix);
+            emit(as, (dec ? 0x0B : 0x03) | a->reg << 4);
+            return 1;
+        }
+        return 0;
+    }
+    if (!strcmp(mn, "jp")) {
+        if (n == 1 && a->kind == O_MHL) { emit(as, 0xE9); return 1; }
+        if (n == 1 && a->kind == O_MIDX && !strcmp(a->expr, "0")) { emit(as, a->prefix); emit(as, 0xE9); return 1; }
+        if (n == 1 && a->kind == O_IMM) { emit(as, 0xC3); emit_word(as, eval(as, a->expr)); return 1; }
+        if (n == 2 && condition(a->lc) >= 0 && b->kind == O_IMM) {
+            emit(as, 0xC2 | condition(a->lc) << 3);
+            emit_word(as, eval(as, b->expr));
+            return 1;
+        }
+        return 0;
+    }
+    if (!strcmp(mn, "jr")) {
+        if (n == 1 && a->kind == O_IMM) { emit_rel(as, 0x18, a->expr); return 1; }
+        if (n == 2 && condition(a->lc) >= 0 && condition(a->lc) < 4 && b->kind == O_IMM) {
+            emit_rel(as, 0x20 | condition(a->lc) << 3, b->expr);
+            return 1;
+        }
+        return 0;
+    }
+    if (!strcmp(mn, "djnz")) {
+        if (n != 1 || a->kind != O_IMM) return 0;
+        emit_rel(as, 0x10, a->expr);
+        return 1;
+    }
+    if (!strcmp(mn, "call")) {
+        if (n == 1 && a->kind == O_IMM) { emit(as, 0xCD); emit_word(as, eval(as, a->expr)); return 1; }
+        if (n == 2 && condition(a->lc) >= 0 && b->kind == O_IMM) {
+            emit(as, 0xC4 | condition(a->lc) << 3);
+            emit_word(as, eval(as, b->expr));
+            return 1;
+        }
+        return 0;
+    }
+    if (!strcmp(mn, "ret")) {
+        if (n == 0) { emit(as, 0xC9); return 1; }
+        if (n == 1 && condition(a->lc) >= 0) { emit(as, 0xC0 | condition(a->lc) << 3); return 1; }
+        return 0;
+    }
+    if (!strcmp(mn, "rst")) {
+        long v;
+        if (n != 1 || a->kind != O_IMM) return 0;
+        v = eval(as, a->expr);
+        if (v & ~0x38) asm_error(as, "bad RST address", a->expr);
+        emit(as, 0xC7 | (v & 0x38));
+        return 1;
+    }
+    if (!strcmp(mn, "ex")) {
+        if (n != 2) return 0;
+        if (a->kind == O_R16 && a->reg == 1 && b->kind == O_R16 && b->reg == 2 && !b->prefix) { emit(as, 0xEB); return 1; }
+        if (a->kind == O_AF && b->kind == O_AF_ALT) { emit(as, 0x08); return 1; }
+        if (a->kind == O_MSP && b->kind == O_R16 && b->reg == 2) {
+            if (b->prefix) emit(as, b->prefix);
+            emit(as, 0xE3);
+            return 1;
+        }
+        return 0;
+    }
+    if (!strcmp(mn, "im")) {
+        static const uint8_t mode[] = { 0x46, 0x56, 0x5E };
+        long v;
+        if (n != 1 || a->kind != O_IMM) return 0;
+        v = eval(as, a->expr);
+        if (v < 0 || v > 2) { asm_error(as, "bad interrupt mode", a->expr); v = 0; }
+        emit(as, 0xED);
+        emit(as, mode[v]);
+        return 1;
+    }
+    if (!strcmp(mn, "in")) {
+        if (n != 2) return 0;
+        if (a->kind == O_R8 && a->reg == 7 && b->kind == O_MEM) {
+            emit(as, 0xDB);
+            emit_byte(as, eval(as, b->expr));
+            return 1;
+        }
+        if (a->kind == O_R8 && b->kind == O_MC) { emit(as, 0xED); emit(as, 0x40 | a->reg << 3); return 1; }
+        return 0;
+    }
+    if (!strcmp(mn, "out")) {
+        if (n != 2) return 0;
+        if (a->kind == O_MEM && b->kind == O_R8 && b->reg == 7) {
+            emit(as, 0xD3);
+            emit_byte(as, eval(as, a->expr));
+            return 1;
+        }
+        if (a->kind == O_MC && b->kind == O_R8) { emit(as, 0xED); emit(as, 0x41 | b->reg << 3); return 1; }
+        return 0;
+    }
+    for (int i = 0; rot[i]; i++)
+        if (!strcmp(mn, rot[i])) return n == 1 && encode_cb(as, i << 3, a);
+    if (!strcmp(mn, "bit") || !strcmp(mn, "res") || !strcmp(mn, "set")) {
+        int base = mn[0] == 'b' ? 0x40 : mn[0] == 'r' ? 0x80 : 0xC0;
+        long bit;
+        if (n != 2 || a->kind != O_IMM) return 0;
+        bit = eval(as, a->expr);
+        if (bit < 0 || bit > 7) { asm_error(as, "bad bit number", a->expr); bit = 0; }
+        return encode_cb(as, base | bit << 3, b);
+    }
+    return 0;
+}
+
+// --- Statements ---
+
+static void data_list(z80_asm *as, char *args, int word) {
+    char *items[256];
+    int n = split_operands(args, items, 256);
+    if (n > 256) { asm_error(as, "too many DEFB/DEFW items", NULL); n = 256; }
+    for (int i = 0; i < n; i++) {
+        char *it = items[i];
+        size_t len = strlen(it);
+        if (!word && len >= 2 && it[0] == '"' && it[len - 1] == '"') {
+            for (size_t k = 1; k + 1 < len; k++) emit(as, (unsigned char)it[k]);
+        } else if (word) {
+            emit_word(as, eval(as, it));
+        } else {
+            emit_byte(as, eval(as, it));
+        }
+    }
+}
+
+static void statement(z80_asm *as, const source *src, char *s) {
+    char word[64], lw[64];
+
+    s = trim(s);
+    // Label: "name:" possibly followed by a statement
+    {
+        int n = 0;
+        while ((isalnum((unsigned char)s[n]) || s[n] == '_' || s[n] == '.') && n < 63) n++;
+        if (n > 0 && s[n] == ':' && !isdigit((unsigned char)s[0])) {
+            char name[64];
+            snprintf(name, sizeof(name), "%.*s", n, s);
+            define(as, name, as->secs[as->cur].pc, as->cur);
+            s = trim(s + n + 1);
+        }
+    }
+    if (!*s) return;
+
+    {
+        int n = 0;
+        while (s[n] && s[n] != ' ' && s[n] != '\t' && n < 63) n++;
+        snprintf(word, sizeof(word), "%.*s", n, s);
+        lower(lw, word, sizeof(lw));
+        s = trim(s + n);
+    }
+
+    // "NAME EQU expr" / "NAME = expr"
+    {
+        char second[64];
+        int n = 0;
+        while (s[n] && s[n] != ' ' && s[n] != '\t' && n < 63) n++;
+        snprintf(second, sizeof(second), "%.*s", n, s);
+        lower(second, second, sizeof(second));
+        if (!strcmp(second, "equ") || !strcmp(second, "=")) {
+            define(as, word, eval(as, trim(s + n)), -1);
+            return;
+        }
+    }
+
+    if (!strcmp(lw, "defc")) {
+        char *eq = strchr(s, '=');
+        if (!eq) { asm_error(as, "bad DEFC", NULL); return; }
+        *eq = 0;
+        define(as, trim(s), eval(as, trim(eq + 1)), -1);
+        return;
+    }
+    if (!strcmp(lw, "public") || !strcmp(lw, "global")) {
+        char *names[64];
+        int n = split_operands(s, names, 64);
+        for (int i = 0; i < n && i < 64; i++) {
+            symbol *local = find_in(as, names[i], as->module);
+            if (find_in(as, names[i], -1)) continue;
+            if (local) {
+                // Declared after its definition: promote it
+                local->module = -1;
+                symbol *pub = new_sym(as, names[i], -1);
+                *pub = *local;
+                local->name[0] = 0;
+            } else {
+                new_sym(as, names[i], -1);
+            }
+        }
+        return;
+    }
+    if (!strcmp(lw, "extern") || !strcmp(lw, "module"))
+        return;
+    if (!strcmp(lw, "section")) {
+        select_section(as, s);
+        return;
+    }
+    if (!strcmp(lw, "org")) {
+        section *sec = &as->secs[as->cur];
+        if (sec->pc) asm_error(as, "ORG after code in section", sec->name);
+        sec->has_org = 1;
+        sec->org = eval_now(as, s);
+        return;
+    }
+    if (!strcmp(lw, "defb") || !strcmp(lw, "db") || !strcmp(lw, "defm") || !strcmp(lw, "dm")) {
+        data_list(as, s, 0);
+        return;
+    }
+    if (!strcmp(lw, "defw") || !strcmp(lw, "dw")) {
+        data_list(as, s, 1);
+        return;
+    }
+    if (!strcmp(lw, "defs") || !strcmp(lw, "ds")) {
+        char *items[2];
+        int n = split_operands(s, items, 2);
+        long count = n > 0 ? eval_now(as, items[0]) : 0;
+        long fill = n > 1 ? eval(as, items[1]) : 0;
+        if (count < 0) { asm_error(as, "negative DEFS", NULL); count = 0; }
+        for (long i = 0; i < count; i++) emit(as, fill & 0xFF);
+        return;
+    }
+    if (!strcmp(lw, "binary") || !strcmp(lw, "incbin")) {
+        char name[256], path[512];
+        FILE *f;
+        int c;
+        if (!quoted_name(s, name, sizeof(name))) { asm_error(as, "bad BINARY", NULL); return; }
+        relative_path(as, src->path, name, path, sizeof(path));
+        f = fopen(path, "rb");
+        if (!f) { asm_fatal(as, "cannot open BINARY", path); return; }
+        while ((c = fgetc(f)) != EOF) emit(as, c);
+        fclose(f);
+        return;
+    }
+
+    // Instruction
+    {
+        char *texts[3];
+        operand ops[3];
+        int n = split_operands(s, texts, 3);
+        if (n > 2) { asm_error(as, "too many operands:", word); return; }
+        for (int i = 0; i < n; i++) parse_operand(texts[i], &ops[i]);
+        if (!encode(as, lw, ops, n)) asm_error(as, "unknown instruction or operands:", word);
+    }
+}
+
+// --- Conditional assembly, REPT and INCLUDE ---
+
+typedef struct {
+    int active[MAX_COND];
+    int taken[MAX_COND];
+    int sp;
+} cond_stack;
+
+static int cond_active(const cond_stack *cs) {
+    for (int i = 0; i <= cs->sp; i++) if (!cs->active[i]) return 0;
+    return 1;
+}
+
+static void process_range(z80_asm *as, source *src, int start, int end, int depth);
+
+static void process_line(z80_asm *as, source *src, int idx, cond_stack *cs, int depth) {
+    char buf[MAX_LINE], lw[16];
+    snprintf(buf, sizeof(buf), "%s", src->lines[idx]);
+    strip_comment(buf);
+    char *line = trim(buf);
+    first_word(line, lw, sizeof(lw));
+
+    as->file = src->path;
+    as->line = idx + 1;
+
+    if (!strcmp(lw, "if") || !strcmp(lw, "ifdef") || !strcmp(lw, "ifndef")) {
+        long v = 0;
+        char *expr = trim(line + strlen(lw));
+        if (cs->sp + 1 == MAX_COND) { asm_fatal(as, "IF nested too deep", NULL); return; }
+        if (cond_active(cs)) {
+            if (!strcmp(lw, "if")) {
+                v = eval_now(as, expr);
+            } else {
+                symbol *s = find_sym(as, expr);
+                int known = s && (s->pass == 0 || s->pass == as->pass);
+                v = known == (lw[2] == 'd');
+            }
+        }
+        cs->sp++;
+        cs->active[cs->sp] = v != 0;
+        cs->taken[cs->sp] = v != 0;
+        return;
+    }
+    if (!strcmp(lw, "else")) {
+        if (cs->sp == 0) { asm_error(as, "ELSE without IF", NULL); return; }
+        cs->active[cs->sp] = !cs->taken[cs->sp];
+        return;
+    }
+    if (!strcmp(lw, "endif")) {
+        if (cs->sp == 0) { asm_error(as, "ENDIF without IF", NULL); return; }
+        cs->sp--;
+        return;
+    }
+    if (!cond_active(cs)) return;
+
+    if (!strcmp(lw, "include")) {
+        char name[256], path[512];
+        source *inc;
+        if (!quoted_name(line, name, sizeof(name)) || depth >= MAX_INCLUDE) {
+            asm_fatal(as, "bad INCLUDE", NULL);
+            return;
+        }
+        relative_path(as, src->path, name, path, sizeof(path));
+        inc = load_source(as, path);
+        if (!inc) {
+            asm_fatal(as, "cannot open INCLUDE", path);
+            return;
+        }
+        process_range(as, inc, 0, inc->count, depth + 1);
+        return;
+    }
+
+    // Backslash separates statements on one line
+    {
+        char *stmt = line;
+        for (;;) {
+            char *bs = strchr(stmt, '\\');
+            if (bs) *bs = 0;
+            statement(as, src, stmt);
+            if (!bs) break;
+            stmt = bs + 1;
+        }
+    }
+}
+
+static void process_range(z80_asm *as, source *src, int start, int end, int depth) {
+    cond_stack cs;
+    memset(&cs, 0, sizeof(cs));
+    cs.active[0] = 1;
+
+    for (int i = start; i < end; i++) {
+        char tmp[MAX_LINE], lw[16];
+        snprintf(tmp, sizeof(tmp), "%s", src->lines[i]);
+        strip_comment(tmp);
+        char *line = trim(tmp);
+        first_word(line, lw, sizeof(lw));
+
+        if (!strcmp(lw, "rept") && cond_active(&cs)) {
+            int nest = 1, j;
+            as->file = src->path;
+            as->line = i + 1;
+            long count = eval_now(as, trim(line + 4));
+            for (j = i + 1; j < end; j++) {
+                char t2[MAX_LINE], w2[16];
+                snprintf(t2, sizeof(t2), "%s", src->lines[j]);
+                strip_comment(t2);
+                first_word(trim(t2), w2, sizeof(w2));
+                if (!strcmp(w2, "rept")) nest++;
+                else if (!strcmp(w2, "endr") && --nest == 0) break;
+            }
+            if (j == end) {
+                asm_fatal(as, "REPT without ENDR", NULL);
+                return;
+            }
+            for (long r = 0; r < count; r++) process_range(as, src, i + 1, j, depth);
+            i = j;
+            continue;
+        }
+        process_line(as, src, i, &cs, depth);
+    }
+    if (cs.sp) {
+        as->file = src->path;
+        as->line = end;
+        asm_error(as, "IF without ENDIF", NULL);
+    }
+}
+
+// --- Layout ---
+
+static int section_rank(const char *name) {
+    if (!strncmp(name, "code", 4) || !*name) return 0;
+    if (!strncmp(name, "rodata", 6)) return 1;
+    if (!strncmp(name, "data", 4)) return 2;
+    if (!strncmp(name, "bss", 3)) return 3;
+    return 2;
+}
+
+static void layout(z80_asm *as, long org) {
+    long addr = org;
+    for (int rank = 0; rank < 4; rank++) {
+        for (int i = 0; i < as->sec_count; i++) {
+            section *s = &as->secs[i];
+            if (section_rank(s->name) != rank) continue;
+            if (s->has_org) {
+                s->base = s->org;
+                continue;
+            }
+            s->base = addr;
+            addr += s->size;
+        }
+    }
+}
+
+// --- Public interface ---
+
+z80_asm *z80_asm_new(void) {
+    z80_asm *as = (z80_asm *)calloc(1, sizeof(z80_asm));
+    as->syms = (symbol *)calloc(SYM_HASH / 2, sizeof(symbol));
+    return as;
+}
+
+void z80_asm_free(z80_asm *as) {
+    if (!as) return;
+    for (int i = 0; i < as->src_count; i++) {
+        for (int k = 0; k < as->srcs[i]->count; k++) free(as->srcs[i]->lines[k]);
+        free(as->srcs[i]->lines);
+        free(as->srcs[i]->path);
+        free(as->srcs[i]);
+    }
+    for (int i = 0; i < as->file_count; i++) free(as->files[i]);
+    for (int i = 0; i < as->dir_count; i++) free(as->dirs[i]);
+    free(as->srcs);
+    free(as->syms);
+    free(as);
+}
+
+void z80_asm_define(z80_asm *as, const char *name, long value) {
+    symbol *s = find_in(as, name, -1);
+    if (!s) s = new_sym(as, name, -1);
+    s->value = value;
+    s->section = -1;
+    s->pass = 0;
+}
+
+void z80_asm_source(z80_asm *as, const char *path) {
+    if (as->file_count == MAX_FILES) {
+        fprintf(stderr, "Error: too many source files\n");
+        exit(1);
+    }
+    as->files[as->file_count++] = strdup(path);
+}
+
+void z80_asm_include(z80_asm *as, const char *dir) {
+    if (as->dir_count == MAX_DIRS) {
+        fprintf(stderr, "Error: too many include directories\n");
+        exit(1);
+    }
+    as->dirs[as->dir_count++] = strdup(dir);
+}
+
+int z80_asm_build(z80_asm *as, uint8_t *mem, uint16_t org, long *lo, long *hi) {
+    as->mem = mem;
+    as->lo = 0x10000;
+    as->hi = 0;
+    as->errors = 0;
+    as->sec_count = 0;
+    for (as->pass = 1; as->pass <= PASSES; as->pass++) {
+        as->final = as->pass == PASSES;
+        for (int i = 0; i < as->sec_count; i++) as->secs[i].pc = 0;
+        select_section(as, "");
+        for (int f = 0; f < as->file_count; f++) {
+            source *src = load_source(as, as->files[f]);
+            as->module = f;
+            if (!src) {
+                fprintf(stderr, "Error: cannot open %s\n", as->files[f]);
+                return ++as->errors;
+            }
+            select_section(as, "");
+            process_range(as, src, 0, src->count, 0);
+        }
+        if (as->errors) return as->errors;
+        for (int i = 0; i < as->sec_count; i++) {
+            if (as->final && as->secs[i].size != as->secs[i].pc) {
+                fprintf(stderr, "Error: section %s changed size between passes\n", as->secs[i].name);
+                as->errors++;
+            }
+            as->secs[i].size = as->secs[i].pc;
+        }
+        layout(as, org);
+    }
+    if (lo) *lo = as->lo;
+    if (hi) *hi = as->hi;
+    return as->errors;
+}
+
+int z80_asm_lookup(const z80_asm *as, const char *name, long *value) {
+    const symbol *s = find_in(as, name, -1);
+    // Not PUBLIC: the first module that defines it
+    for (int m = 0; (!s || s->pass < 0) && m < as->file_count; m++) s = find_in(as, name, m);
+    if (!s || s->pass < 0) {
+        *value = 0;
+        return 0;
+    }
+    *value = sym_value(as, s);
+    return 1;
+}
@@ -0,0 +1,40 @@
+#ifndef Z80_ASM_H
+#define Z80_ASM_H
+
+// Minimal Z80 assembler for host-side tools (asm_check).
+// Reads the z88dk-z80asm subset the renderer sources use: EQU/DEFC,
+// IF/IFDEF/IFNDEF/ELSE/ENDIF, REPT/ENDR, INCLUDE, BINARY, DEFB/DEFW/DEFS/
+// DEFM, SECTION, ORG, PUBLIC/EXTERN and the documented instruction set
+// (plus IXH/IXL/IYH/IYL). Sections are laid out one after another from the
+// build origin: code_* first, then rodata_*, data_* and bss_*; a section
+// with an ORG is placed at that address instead.
+//
+// EXTERN symbols are not linked: define them with z80_asm_define() before
+// z80_asm_build(). Errors go to stderr as "file:line: message".
+
+#include <stdint.h>
+
+typedef struct z80_asm z80_asm;
+
+z80_asm *z80_asm_new(void);
+void z80_asm_free(z80_asm *as);
+
+// -DNAME=value, as z88dk-z80asm -D (also resolves EXTERNs)
+void z80_asm_define(z80_asm *as, const char *name, long value);
+
+// Add a source file; files are assembled in the order added. Each file is
+// a module: its symbols are local unless PUBLIC, as when z80asm links them.
+void z80_asm_source(z80_asm *as, const char *path);
+
+// Directory searched before the including file's own for INCLUDE / BINARY
+// (-I); a generated viewport.inc can live outside the tree
+void z80_asm_include(z80_asm *as, const char *dir);
+
+// Assemble into mem (64K). Returns the number of errors; *lo / *hi get
+// the lowest address written and one past the highest.
+int z80_asm_build(z80_asm *as, uint8_t *mem, uint16_t org, long *lo, long *hi);
+
+// Value of a label or constant after z80_asm_build(); 0 if undefined
+int z80_asm_lookup(const z80_asm *as, const char *name, long *value);
+
+#endif // Z80_ASM_H
@@ -0,0 +1,737 @@
+// Minimal Z80 interpreter for host-side tools. See z80_core.h.
+
+#include "z80_core.h"
+
+#define FLAG_C  0x01
+#define FLAG_N  0x02
+#define FLAG_PV 0x04
+#define FLAG_X  0x08
+#define FLAG_H  0x10
+#define FLAG_Y  0x20
+#define FLAG_Z  0x40
+#define FLAG_S  0x80
+
+static uint8_t sz53p[256];     // S, Z, X/Y and parity flags for a result byte
+static int tables_ready = 0;
+
+static void init_tables(void) {
+    for (int i = 0; i < 256; i++) {
+        int p = 0;
+        for (int b = 0; b < 8; b++) p ^= (i >> b) & 1;
+        sz53p[i] = (uint8_t)((i & (FLAG_S | FLAG_X | FLAG_Y)) | (i == 0 ? FLAG_Z : 0) | (p ? 0 : FLAG_PV));
+    }
+    tables_ready = 1;
+}
+
+// --- Memory with optional contention ---
+
+static const uint8_t contention_pattern[8] = { 6, 5, 4, 3, 2, 1, 0, 0 };
+
+static void contend(z80 *cpu, uint16_t addr) {
+    if (!cpu->contended || addr < 0x4000 || addr >= 0x8000) return;
+    unsigned long t = cpu->frame_t + cpu->pending;
+    if (t < cpu->screen_t) return;
+    t -= cpu->screen_t;
+    if (t >= 192UL * (unsigned long)cpu->line_t) return;
+    unsigned long x = t % (unsigned long)cpu->line_t;
+    if (x >= 128) return;
+    cpu->pending += contention_pattern[x & 7];
+    cpu->delay += contention_pattern[x & 7];
+}
+
+static uint8_t rd(z80 *cpu, uint16_t addr) {
+    contend(cpu, addr);
+    cpu->pending += 3;
+    return cpu->mem[addr];
+}
+
+static void wr(z80 *cpu, uint16_t addr, uint8_t v) {
+    contend(cpu, addr);
+    cpu->pending += 3;
+    if (addr >= 0x4000) cpu->mem[addr] = v;
+}
+
+static uint16_t rd16(z80 *cpu, uint16_t addr) {
+    uint8_t lo = rd(cpu, addr);
+    return (uint16_t)(lo | (rd(cpu, (uint16_t)(addr + 1)) << 8));
+}
+
+static void wr16(z80 *cpu, uint16_t addr, uint16_t v) {
+    wr(cpu, addr, (uint8_t)v);
+    wr(cpu, (uint16_t)(addr + 1), (uint8_t)(v >> 8));
+}
+
+static uint8_t fetch(z80 *cpu) {
+    return rd(cpu, cpu->pc++);
+}
+
+static uint16_t fetch16(z80 *cpu) {
+    uint16_t v = rd16(cpu, cpu->pc);
+    cpu->pc += 2;
+    return v;
+}
+
+static void inc_r(z80 *cpu) {
+    cpu->r = (uint8_t)((cpu->r & 0x80) | ((cpu->r + 1) & 0x7F));
+}
+
+static void push16(z80 *cpu, uint16_t v) {
+    cpu->sp -= 2;
+    wr16(cpu, cpu->sp, v);
+}
+
+static uint16_t pop16(z80 *cpu) {
+    uint16_t v = rd16(cpu, cpu->sp);
+    cpu->sp += 2;
+    return v;
+}
+
+// --- Register pairs ---
+
+#define BC(c) ((uint16_t)(((c)->b << 8) | (c)->c))
+#define DE(c) ((uint16_t)(((c)->d << 8) | (c)->e))
+#define HL(c) ((uint16_t)(((c)->h << 8) | (c)->l))
+#define AF(c) ((uint16_t)(((c)->a << 8) | (c)->f))
+
+static void set_bc(z80 *c, uint16_t v) { c->b = (uint8_t)(v >> 8); c->c = (uint8_t)v; }
+static void set_de(z80 *c, uint16_t v) { c->d = (uint8_t)(v >> 8); c->e = (uint8_t)v; }
+static void set_hl(z80 *c, uint16_t v) { c->h = (uint8_t)(v >> 8); c->l = (uint8_t)v; }
+static void set_af(z80 *c, uint16_t v) { c->a = (uint8_t)(v >> 8); c->f = (uint8_t)v; }
+
+// prefix: 0 = HL, 1 = IX, 2 = IY
+static uint16_t get_xy(z80 *c, int prefix) {
+    return prefix == 1 ? c->ix : prefix == 2 ? c->iy : HL(c);
+}
+
+static void set_xy(z80 *c, int prefix, uint16_t v) {
+    if (prefix == 1) c->ix = v;
+    else if (prefix == 2) c->iy = v;
+    else set_hl(c, v);
+}
+
+// 8-bit register by index (B,C,D,E,H,L,-,A); H/L map to IXH/IXL under a prefix
+static uint8_t get_r8(z80 *c, int idx, int prefix) {
+    switch (idx) {
+        case 0: return c->b;
+        case 1: return c->c;
+        case 2: return c->d;
+        case 3: return c->e;
+        case 4: return prefix == 1 ? (uint8_t)(c->ix >> 8) : prefix == 2 ? (uint8_t)(c->iy >> 8) : c->h;
+        case 5: return prefix == 1 ? (uint8_t)c->ix : prefix == 2 ? (uint8_t)c->iy : c->l;
+        default: return c->a;
+    }
+}
+
+static void set_r8(z80 *c, int idx, int prefix, uint8_t v) {
+    switch (idx) {
+        case 0: c->b = v; break;
+        case 1: c->c = v; break;
+        case 2: c->d = v; break;
+        case 3: c->e = v; break;
+        case 4:
+            if (prefix == 1) c->ix = (uint16_t)((c->ix & 0x00FF) | (v << 8));
+            else if (prefix == 2) c->iy = (uint16_t)((c->iy & 0x00FF) | (v << 8));
+            else c->h = v;
+            break;
+        case 5:
+            if (prefix == 1) c->ix = (uint16_t)((c->ix & 0xFF00) | v);
+            else if (prefix == 2) c->iy = (uint16_t)((c->iy & 0xFF00) | v);
+            else c->l = v;
+            break;
+        default: c->a = v; break;
+    }
+}
+
+// 16-bit pair by index (BC,DE,HL/IX/IY,SP)
+static uint16_t get_rp(z80 *c, int idx, int prefix) {
+    switch (idx) {
+        case 0: return BC(c);
+        case 1: return DE(c);
+        case 2: return get_xy(c, prefix);
+        default: return c->sp;
+    }
+}
+
+static void set_rp(z80 *c, int idx, int prefix, uint16_t v) {
+    switch (idx) {
+        case 0: set_bc(c, v); break;
+        case 1: set_de(c, v); break;
+        case 2: set_xy(c, prefix, v); break;
+        default: c->sp = v; break;
+    }
+}
+
+// --- ALU ---
+
+static void alu8(z80 *c, int op, uint8_t v) {
+    uint8_t a = c->a;
+    unsigned int r;
+    switch (op) {
+        case 0:  // ADD
+        case 1:  // ADC
+            r = a + v + (op == 1 ? (c->f & FLAG_C) : 0);
+            c->f = (uint8_t)((sz53p[r & 0xFF] & ~FLAG_PV) | ((a ^ v ^ r) & FLAG_H)
+                | (((a ^ ~v) & (a ^ r) & 0x80) ? FLAG_PV : 0) | (r > 0xFF ? FLAG_C : 0));
+            c->a = (uint8_t)r;
+            break;
+        case 2:  // SUB
+        case 3:  // SBC
+        case 7:  // CP
+            r = a - v - (op == 3 ? (c->f & FLAG_C) : 0);
+            c->f = (uint8_t)((sz53p[r & 0xFF] & ~FLAG_PV) | FLAG_N | ((a ^ v ^ r) & FLAG_H)
+                | (((a ^ v) & (a ^ r) & 0x80) ? FLAG_PV : 0) | ((r & 0x100) ? FLAG_C : 0));
+            if (op == 7) c->f = (uint8_t)((c->f & ~(FLAG_X | FLAG_Y)) | (v & (FLAG_X | FLAG_Y)));
+            else c->a = (uint8_t)r;
+            break;
+        case 4:  // AND
+            c->a = a & v;
+            c->f = (uint8_t)(sz53p[c->a] | FLAG_H);
+            break;
+        case 5:  // XOR
+            c->a = a ^ v;
+            c->f = sz53p[c->a];
+            break;
+        default: // OR
+            c->a = a | v;
+            c->f = sz53p[c->a];
+            break;
+    }
+}
+
+static uint8_t inc8(z80 *c, uint8_t v) {
+    uint8_t r = (uint8_t)(v + 1);
+    c->f = (uint8_t)((c->f & FLAG_C) | (sz53p[r] & ~FLAG_PV) | ((r & 0x0F) == 0 ? FLAG_H : 0) | (v == 0x7F ? FLAG_PV : 0));
+    return r;
+}
+
+static uint8_t dec8(z80 *c, uint8_t v) {
+    uint8_t r = (uint8_t)(v - 1);
+    c->f = (uint8_t)((c->f & FLAG_C) | (sz53p[r] & ~FLAG_PV) | FLAG_N | ((v & 0x0F) == 0 ? FLAG_H : 0) | (v == 0x80 ? FLAG_PV : 0));
+    return r;
+}
+
+static uint16_t add16(z80 *c, uint16_t a, uint16_t b) {
+    unsigned long r = (unsigned long)a + b;
+    c->f = (uint8_t)((c->f & (FLAG_S | FLAG_Z | FLAG_PV)) | ((r >> 8) & (FLAG_X | FLAG_Y))
+        | (((a ^ b ^ r) >> 8) & FLAG_H) | (r > 0xFFFF ? FLAG_C : 0));
+    return (uint16_t)r;
+}
+
+static uint16_t adc16(z80 *c, uint16_t a, uint16_t b) {
+    unsigned long r = (unsigned long)a + b + (c->f & FLAG_C);
+    uint16_t r16 = (uint16_t)r;
+    c->f = (uint8_t)(((r16 >> 8) & (FLAG_S | FLAG_X | FLAG_Y)) | (r16 == 0 ? FLAG_Z : 0)
+        | (((a ^ b ^ r) >> 8) & FLAG_H) | (((a ^ ~b) & (a ^ r) & 0x8000) ? FLAG_PV : 0)
+        | (r > 0xFFFF ? FLAG_C : 0));
+    return r16;
+}
+
+static uint16_t sbc16(z80 *c, uint16_t a, uint16_t b) {
+    unsigned long r = (unsigned long)a - b - (c->f & FLAG_C);
+    uint16_t r16 = (uint16_t)r;
+    c->f = (uint8_t)(((r16 >> 8) & (FLAG_S | FLAG_X | FLAG_Y)) | (r16 == 0 ? FLAG_Z : 0) | FLAG_N
+        | (((a ^ b ^ r) >> 8) & FLAG_H) | (((a ^ b) & (a ^ r) & 0x8000) ? FLAG_PV : 0)
+        | ((r & 0x10000) ? FLAG_C : 0));
+    return r16;
+}
+
+static uint8_t rot8(z80 *c, int op, uint8_t v) {
+    uint8_t r, carry;
+    switch (op) {
+        case 0: carry = v >> 7; r = (uint8_t)((v << 1) | carry); break;               // RLC
+        case 1: carry = v & 1;  r = (uint8_t)((v >> 1) | (carry << 7)); break;        // RRC
+        case 2: carry = v >> 7; r = (uint8_t)((v << 1) | (c->f & FLAG_C)); break;     // RL
+        case 3: carry = v & 1;  r = (uint8_t)((v >> 1) | ((c->f & FLAG_C) << 7)); break; // RR
+        case 4: carry = v >> 7; r = (uint8_t)(v << 1); break;                         // SLA
+        case 5: carry = v & 1;  r = (uint8_t)((v >> 1) | (v & 0x80)); break;          // SRA
+        case 6: carry = v >> 7; r = (uint8_t)((v << 1) | 1); break;                   // SLL
+        default: carry = v & 1; r = (uint8_t)(v >> 1); break;                         // SRL
+    }
+    c->f = (uint8_t)(sz53p[r] | carry);
+    return r;
+}
+
+static void bit8(z80 *c, int bit, uint8_t v, uint8_t xy) {
+    uint8_t r = v & (uint8_t)(1 << bit);
+    c->f = (uint8_t)((c->f & FLAG_C) | FLAG_H | (r ? (r & FLAG_S) : (FLAG_Z | FLAG_PV)) | (xy & (FLAG_X | FLAG_Y)));
+}
+
+static void daa(z80 *c) {
+    uint8_t a = c->a, corr = 0, carry = c->f & FLAG_C;
+    if ((c->f & FLAG_H) || (a & 0x0F) > 9) corr |= 0x06;
+    if (carry || a > 0x99) { corr |= 0x60; carry = FLAG_C; }
+    if (c->f & FLAG_N) {
+        c->a = (uint8_t)(a - corr);
+        c->f = (uint8_t)(sz53p[c->a] | FLAG_N | carry | (((c->f & FLAG_H) && (a & 0x0F) < 6) ? FLAG_H : 0));
+    } else {
+        c->a = (uint8_t)(a + corr);
+        c->f = (uint8_t)(sz53p[c->a] | carry | (((a & 0x0F) > 9) ? FLAG_H : 0));
+    }
+}
+
+static int cond(z80 *c, int cc) {
+    switch (cc) {
+        case 0: return !(c->f & FLAG_Z);
+        case 1: return  (c->f & FLAG_Z);
+        case 2: return !(c->f & FLAG_C);
+        case 3: return  (c->f & FLAG_C);
+        case 4: return !(c->f & FLAG_PV);
+        case 5: return  (c->f & FLAG_PV);
+        case 6: return !(c->f & FLAG_S);
+        default: return (c->f & FLAG_S);
+    }
+}
+
+// --- Prefixed groups ---
+
+static int exec_cb(z80 *c, int prefix) {
+    if (prefix) {
+        // DDCB/FDCB d op: operate on (IX/IY+d), optionally copy result to a register
+        int8_t d = (int8_t)fetch(c);
+        uint8_t op = fetch(c);
+        uint16_t addr = (uint16_t)(get_xy(c, prefix) + d);
+        uint8_t v = rd(c, addr), r;
+        int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+        if (x == 1) {
+            bit8(c, y, v, (uint8_t)(addr >> 8));
+            return 16;
+        }
+        if (x == 0) r = rot8(c, y, v);
+        else if (x == 2) r = (uint8_t)(v & ~(1 << y));
+        else r = (uint8_t)(v | (1 << y));
+        wr(c, addr, r);
+        if (z != 6) set_r8(c, z, 0, r);
+        return 19;
+    }
+
+    uint8_t op = fetch(c);
+    inc_r(c);
+    int x = op >> 6, y = (op >> 3) & 7, z = op & 7;
+    uint8_t v = z == 6 ? rd(c, HL(c)) : get_r8(c, z, 0), r;
+    if (x == 1) {
+        bit8(c, y, v, z == 6 ? 0 : v);
+        return z == 6 ? 12 : 8;
+    }
+    if (x == 0) r = rot8(c, y, v);
+    else if (x == 2) r = (uint8_t)(v & ~(1 << y));
+    else r = (uint8_t)(v | (1 << y));
+    if (z == 6) { wr(c, HL(c), r); return 15; }
+    set_r8(c, z, 0, r);
+    return 8;
+}
+
+static int block_op(z80 *c, uint8_t op) {
+    int y = (op >> 3) & 7, z = op & 3;
+    int dir = (y & 1) ? -1 : 1;        // LDI/CPI/INI/OUTI vs LDD/CPD/IND/OUTD
+    int repeat = y >= 6;
+    uint16_t bc;
+
+    switch (z) {
+        case 0: { // LDI/LDD/LDIR/LDDR
+            uint8_t v = rd(c, HL(c));
+            wr(c, DE(c), v);
+            set_hl(c, (uint16_t)(HL(c) + dir));
+            set_de(c, (uint16_t)(DE(c) + dir));
+            bc = (uint16_t)(BC(c) - 1);
+            set_bc(c, bc);
+            uint8_t n = (uint8_t)(v + c->a);
+            c->f = (uint8_t)((c->f & (FLAG_S | FLAG_Z | FLAG_C)) | (bc ? FLAG_PV : 0)
+                | (n & FLAG_X) | ((n << 4) & FLAG_Y));
+            if (repeat && bc) { c->pc -= 2; return 21; }
+            return 16;
+        }
+        case 1: { // CPI/CPD/CPIR/CPDR
+            uint8_t v = rd(c, HL(c));
+            uint8_t r = (uint8_t)(c->a - v);
+            set_hl(c, (uint16_t)(HL(c) + dir));
+            bc = (uint16_t)(BC(c) - 1);
+            set_bc(c, bc);
+            uint8_t hf = (uint8_t)((c->a ^ v ^ r) & FLAG_H);
+            uint8_t n = (uint8_t)(r - (hf ? 1 : 0));
+            c->f = (uint8_t)((c->f & FLAG_C) | FLAG_N | (r & FLAG_S) | (r == 0 ? FLAG_Z : 0) | hf
+                | (bc ? FLAG_PV : 0) | (n & FLAG_X) | ((n << 4) & FLAG_Y));
+            if (repeat && bc && r) { c->pc -= 2; return 21; }
+            return 16;
+        }
+        case 2: { // INI/IND/INIR/INDR
+            uint8_t v = c->port_in ? c->port_in(c->ctx, BC(c)) : 0xFF;
+            wr(c, HL(c), v);
+            set_hl(c, (uint16_t)(HL(c) + dir));
+            c->b--;
+            c->f = (uint8_t)((sz53p[c->b] & ~FLAG_PV) | FLAG_N | (c->f & FLAG_C));
+            if (repeat && c->b) { c->pc -= 2; return 21; }
+            return 16;
+        }
+        default: { // OUTI/OUTD/OTIR/OTDR
+            uint8_t v = rd(c, HL(c));
+            c->b--;
+            if (c->port_out) c->port_out(c->ctx, BC(c), v);
+            set_hl(c, (uint16_t)(HL(c) + dir));
+            c->f = (uint8_t)((sz53p[c->b] & ~FLAG_PV) | FLAG_N | (c->f & FLAG_C));
+            if (repeat && c->b) { c->pc -= 2; return 21; }
+            return 16;
+        }
+    }
+}
+
+static int exec_ed(z80 *c) {
+    uint8_t op = fetch(c);
+    inc_r(c);
+    int x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+
+    if (x == 2 && y >= 4 && z <= 3) return block_op(c, op);
+    if (x != 1) return 8;   // NONI / NOP
+
+    switch (z) {
+        case 0: { // IN r,(C)
+            uint8_t v = c->port_in ? c->port_in(c->ctx, BC(c)) : 0xFF;
+            if (y != 6) set_r8(c, y, 0, v);
+            c->f = (uint8_t)((c->f & FLAG_C) | sz53p[v]);
+            return 12;
+        }
+        case 1: // OUT (C),r
+            if (c->port_out) c->port_out(c->ctx, BC(c), y == 6 ? 0 : get_r8(c, y, 0));
+            return 12;
+        case 2: // SBC/ADC HL,rr
+            set_hl(c, q ? adc16(c, HL(c), get_rp(c, p, 0)) : sbc16(c, HL(c), get_rp(c, p, 0)));
+            return 15;
+        case 3: { // LD (nn),rr / LD rr,(nn)
+            uint16_t nn = fetch16(c);
+            if (q) set_rp(c, p, 0, rd16(c, nn));
+            else wr16(c, nn, get_rp(c, p, 0));
+            return 20;
+        }
+        case 4: { // NEG
+            uint8_t v = c->a;
+            c->a = 0;
+            alu8(c, 2, v);
+            return 8;
+        }
+        case 5: // RETN / RETI
+            c->pc = pop16(c);
+            c->iff1 = c->iff2;
+            return 14;
+        case 6: // IM n
+            c->im = (uint8_t)((y & 3) == 0 || (y & 3) == 1 ? 0 : (y & 3) - 1);
+            return 8;
+        default:
+            switch (y) {
+                case 0: c->i = c->a; return 9;                      // LD I,A
+                case 1: c->r = c->a; return 9;                      // LD R,A
+                case 2:                                             // LD A,I
+                case 3:                                             // LD A,R
+                    c->a = y == 2 ? c->i : c->r;
+                    c->f = (uint8_t)((c->f & FLAG_C) | (sz53p[c->a] & ~FLAG_PV) | (c->iff2 ? FLAG_PV : 0));
+                    return 9;
+                case 4: { // RRD
+                    uint8_t m = rd(c, HL(c));
+                    wr(c, HL(c), (uint8_t)((c->a << 4) | (m >> 4)));
+                    c->a = (uint8_t)((c->a & 0xF0) | (m & 0x0F));
+                    c->f = (uint8_t)((c->f & FLAG_C) | sz53p[c->a]);
+                    return 18;
+                }
+                case 5: { // RLD
+                    uint8_t m = rd(c, HL(c));
+                    wr(c, HL(c), (uint8_t)((m << 4) | (c->a & 0x0F)));
+                    c->a = (uint8_t)((c->a & 0xF0) | (m >> 4));
+                    c->f = (uint8_t)((c->f & FLAG_C) | sz53p[c->a]);
+                    return 18;
+                }
+                default: return 8;
+            }
+    }
+}
+
+// --- Main opcode table (unprefixed and DD/FD) ---
+
+static int exec_main(z80 *c, uint8_t op, int prefix) {
+    int x = op >> 6, y = (op >> 3) & 7, z = op & 7, p = y >> 1, q = y & 1;
+
+    // Effective address for (HL) / (IX+d) operands
+    #define MEM_ADDR() (prefix ? (uint16_t)(get_xy(c, prefix) + (int8_t)fetch(c)) : HL(c))
+
+    switch (x) {
+    case 0:
+        switch (z) {
+        case 0:
+            switch (y) {
+                case 0: return 4;                                   // NOP
+                case 1: {                                           // EX AF,AF'
+                    uint8_t t;
+                    t = c->a; c->a = c->a_; c->a_ = t;
+                    t = c->f; c->f = c->f_; c->f_ = t;
+                    return 4;
+                }
+                case 2: {                                           // DJNZ
+                    int8_t d = (int8_t)fetch(c);
+                    if (--c->b) { c->pc = (uint16_t)(c->pc + d); return 13; }
+                    return 8;
+                }
+                case 3: {                                           // JR
+                    int8_t d = (int8_t)fetch(c);
+                    c->pc = (uint16_t)(c->pc + d);
+                    return 12;
+                }
+                default: {                                          // JR cc
+                    int8_t d = (int8_t)fetch(c);
+                    if (cond(c, y - 4)) { c->pc = (uint16_t)(c->pc + d); return 12; }
+                    return 7;
+                }
+            }
+        case 1:
+            if (!q) { set_rp(c, p, prefix, fetch16(c)); return 10; }   // LD rr,nn
+            set_xy(c, prefix, add16(c, get_xy(c, prefix), get_rp(c, p, prefix)));  // ADD HL,rr
+            return 11;
+        case 2:
+            switch (y) {
+                case 0: wr(c, BC(c), c->a); return 7;
+                case 1: c->a = rd(c, BC(c)); return 7;
+                case 2: wr(c, DE(c), c->a); return 7;
+                case 3: c->a = rd(c, DE(c)); return 7;
+                case 4: wr16(c, fetch16(c), get_xy(c, prefix)); return 16;
+                case 5: set_xy(c, prefix, rd16(c, fetch16(c))); return 16;
+                case 6: wr(c, fetch16(c), c->a); return 13;
+                default: c->a = rd(c, fetch16(c)); return 13;
+            }
+        case 3:
+            set_rp(c, p, prefix, (uint16_t)(get_rp(c, p, prefix) + (q ? -1 : 1)));  // INC/DEC rr
+            return 6;
+        case 4:
+        case 5:
+            if (y == 6) {                                           // INC/DEC (HL)
+                uint16_t addr = MEM_ADDR();
+                uint8_t v = rd(c, addr);
+                wr(c, addr, z == 4 ? inc8(c, v) : dec8(c, v));
+                return prefix ? 19 : 11;
+            }
+            set_r8(c, y, prefix, z == 4 ? inc8(c, get_r8(c, y, prefix)) : dec8(c, get_r8(c, y, prefix)));
+            return 4;
+        case 6:
+            if (y == 6) {                                           // LD (HL),n
+                uint16_t addr = MEM_ADDR();
+                wr(c, addr, fetch(c));
+                return prefix ? 15 : 10;
+            }
+            set_r8(c, y, prefix, fetch(c));                         // LD r,n
+            return 7;
+        default:
+            switch (y) {
+                case 0: case 1: case 2: case 3: {                   // RLCA/RRCA/RLA/RRA
+                    uint8_t keep = c->f & (FLAG_S | FLAG_Z | FLAG_PV);
+                    c->a = rot8(c, y, c->a);
+                    c->f = (uint8_t)(keep | (c->f & (FLAG_C | FLAG_X | FLAG_Y)));
+                    return 4;
+                }
+                case 4: daa(c); return 4;
+                case 5:                                             // CPL
+                    c->a = (uint8_t)~c->a;
+                    c->f = (uint8_t)((c->f & (FLAG_S | FLAG_Z | FLAG_PV | FLAG_C)) | FLAG_H | FLAG_N
+                        | (c->a & (FLAG_X | FLAG_Y)));
+                    return 4;
+                case 6:                                             // SCF
+                    c->f = (uint8_t)((c->f & (FLAG_S | FLAG_Z | FLAG_PV)) | FLAG_C | (c->a & (FLAG_X | FLAG_Y)));
+                    return 4;
+                default:                                            // CCF
+                    c->f = (uint8_t)(((c->f & (FLAG_S | FLAG_Z | FLAG_PV | FLAG_C)) | ((c->f & FLAG_C) ? FLAG_H : 0)
+                        | (c->a & (FLAG_X | FLAG_Y))) ^ FLAG_C);
+                    return 4;
+            }
+        }
+
+    case 1:
+        if (op == 0x76) {                                           // HALT
+            c->halted = 1;
+            c->pc--;
+            return 4;
+        }
+        if (y == 6) {                                               // LD (HL),r
+            uint16_t addr = MEM_ADDR();
+            wr(c, addr, get_r8(c, z, 0));
+            return prefix ? 15 : 7;
+        }
+        if (z == 6) {                                               // LD r,(HL)
+            uint16_t addr = MEM_ADDR();
+            set_r8(c, y, 0, rd(c, addr));
+            return prefix ? 15 : 7;
+        }
+        set_r8(c, y, prefix, get_r8(c, z, prefix));                 // LD r,r'
+        return 4;
+
+    case 2:
+        if (z == 6) {                                               // ALU (HL)
+            uint16_t addr = MEM_ADDR();
+            alu8(c, y, rd(c, addr));
+            return prefix ? 15 : 7;
+        }
+        alu8(c, y, get_r8(c, z, prefix));
+        return 4;
+
+    default:
+        switch (z) {
+        case 0:                                                     // RET cc
+            if (cond(c, y)) { c->pc = pop16(c); return 11; }
+            return 5;
+        case 1:
+            if (!q) {                                               // POP rr
+                uint16_t v = pop16(c);
+                if (p == 3) set_af(c, v);
+                else set_rp(c, p, prefix, v);
+                return 10;
+            }
+            switch (p) {
+                case 0: c->pc = pop16(c); return 10;                // RET
+                case 1: {                                           // EXX
+                    uint8_t t;
+                    t = c->b; c->b = c->b_; c->b_ = t;
+                    t = c->c; c->c = c->c_; c->c_ = t;
+                    t = c->d; c->d = c->d_; c->d_ = t;
+                    t = c->e; c->e = c->e_; c->e_ = t;
+                    t = c->h; c->h = c->h_; c->h_ = t;
+                    t = c->l; c->l = c->l_; c->l_ = t;
+                    return 4;
+                }
+                case 2: c->pc = get_xy(c, prefix); return 4; // JP (HL)
+                default: c->sp = get_xy(c, prefix); return 6; // LD SP,HL
+            }
+        case 2: {                                                   // JP cc,nn
+            uint16_t nn = fetch16(c);
+            if (cond(c, y)) c->pc = nn;
+            return 10;
+        }
+        case 3:
+            switch (y) {
+                case 0: c->pc = fetch16(c); return 10;              // JP nn
+                case 1: return exec_cb(c, prefix);                  // CB prefix
+                case 2: {                                           // OUT (n),A
+                    uint8_t n = fetch(c);
+                    if (c->port_out) c->port_out(c->ctx, (uint16_t)((c->a << 8) | n), c->a);
+                    return 11;
+                }
+                case 3: {                                           // IN A,(n)
+                    uint8_t n = fetch(c);
+                    c->a = c->port_in ? c->port_in(c->ctx, (uint16_t)((c->a << 8) | n)) : 0xFF;
+                    return 11;
+                }
+                case 4: {                                           // EX (SP),HL
+                    uint16_t v = rd16(c, c->sp);
+                    wr16(c, c->sp, get_xy(c, prefix));
+                    set_xy(c, prefix, v);
+                    return 19;
+                }
+                case 5: {                                           // EX DE,HL
+                    uint16_t t = DE(c);
+                    set_de(c, HL(c));
+                    set_hl(c, t);
+                    return 4;
+                }
+                case 6: c->iff1 = c->iff2 = 0; return 4;            // DI
+                default:                                            // EI
+                    c->iff1 = c->iff2 = 1;
+                    c->ei_delay = 1;
+                    return 4;
+            }
+        case 4: {                                                   // CALL cc,nn
+            uint16_t nn = fetch16(c);
+            if (cond(c, y)) { push16(c, c->pc); c->pc = nn; return 17; }
+            return 10;
+        }
+        case 5:
+            if (!q) {                                               // PUSH rr
+                push16(c, p == 3 ? AF(c) : get_rp(c, p, prefix));
+                return 11;
+            }
+            if (p == 0) {                                           // CALL nn
+                uint16_t nn = fetch16(c);
+                push16(c, c->pc);
+                c->pc = nn;
+                return 17;
+            }
+            return 4;   // DD/ED/FD prefixes are handled by the callers
+        case 6:
+            alu8(c, y, fetch(c));                                   // ALU n
+            return 7;
+        default:                                                    // RST
+            push16(c, c->pc);
+            c->pc = (uint16_t)(y * 8);
+            return 11;
+        }
+    }
+    #undef MEM_ADDR
+}
+
+void z80_reset(z80 *cpu) {
+    if (!tables_ready) init_tables();
+    cpu->a = cpu->f = cpu->b = cpu->c = cpu->d = cpu->e = cpu->h = cpu->l = 0xFF;
+    cpu->a_ = cpu->f_ = cpu->b_ = cpu->c_ = cpu->d_ = cpu->e_ = cpu->h_ = cpu->l_ = 0xFF;
+    cpu->ix = cpu->iy = 0xFFFF;
+    cpu->sp = 0xFFFF;
+    cpu->pc = 0;
+    cpu->i = cpu->r = 0;
+    cpu->iff1 = cpu->iff2 = 0;
+    cpu->im = 0;
+    cpu->halted = 0;
+    cpu->ei_delay = 0;
+    cpu->tstates = 0;
+    cpu->frame_t = 0;
+    cpu->screen_t = ZX_FIRST_SCREEN_T;
+    cpu->line_t = ZX_LINE_TSTATES;
+    cpu->pending = 0;
+}
+
+int z80_step(z80 *cpu) {
+    int t;
+    cpu->pending = 0;
+    cpu->delay = 0;
+    cpu->ei_delay = 0;
+
+    if (cpu->halted) {
+        inc_r(cpu);
+        t = 4;
+    } else {
+        int prefix = 0;
+        uint8_t op = fetch(cpu);
+        inc_r(cpu);
+        t = 0;
+        // Chains of DD/FD prefixes: the last one wins, each costs 4T
+        while (op == 0xDD || op == 0xFD) {
+            prefix = op == 0xDD ? 1 : 2;
+            op = fetch(cpu);
+            inc_r(cpu);
+            t += 4;
+        }
+        if (op == 0xED) t += exec_ed(cpu);
+        else t += exec_main(cpu, op, prefix);
+    }
+
+    // The timing tables already include the 3T/4T memory cycles, so only
+    // the contention delay accumulated by the accesses is added here.
+    t += (int)cpu->delay;
+    cpu->tstates += (unsigned long)t;
+    cpu->frame_t += (unsigned long)t;
+    return t;
+}
+
+int z80_interrupt(z80 *cpu) {
+    int t;
+    if (!cpu->iff1 || cpu->ei_delay) return 0;
+    cpu->pending = 0;
+    cpu->delay = 0;
+    if (cpu->halted) {
+        cpu->halted = 0;
+        cpu->pc++;
+    }
+    cpu->iff1 = cpu->iff2 = 0;
+    inc_r(cpu);
+    push16(cpu, cpu->pc);
+    if (cpu->im == 2) {
+        cpu->pc = rd16(cpu, (uint16_t)((cpu->i << 8) | 0xFF));
+        t = 19;
+    } else {
+        cpu->pc = 0x0038;
+        t = 13;
+    }
+    t += (int)cpu->delay;
+    cpu->tstates += (unsigned long)t;
+    cpu->frame_t += (unsigned long)t;
+    return t;
+}
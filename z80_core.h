@@ -0,0 +1,57 @@
+#ifndef Z80_CORE_H
+#define Z80_CORE_H
+
+// Minimal Z80 interpreter for host-side tools (replay_trace).
+// Executes documented + commonly used undocumented opcodes with
+// standard T-state timings. Memory is a flat 64K array; I/O goes
+// through callbacks so the caller can model the ULA / keyboard.
+//
+// Contention: when `contended` is set, every memory access to
+// 0x4000-0x7FFF made while the ULA is fetching the display pays the
+// delay pattern (6,5,4,3,2,1,0,0). Delays are computed from the
+// instruction start time, so the model is approximate (within a few
+// T-states per instruction) but good enough for budget tracking.
+// z80_reset sets the 48K display timing; a 128K caller sets screen_t
+// and line_t to ZX128_FIRST_SCREEN_T and ZX128_LINE_TSTATES.
+
+#include <stdint.h>
+
+#define ZX_FRAME_TSTATES      69888
+#define ZX_FIRST_SCREEN_T     14335
+#define ZX_LINE_TSTATES       224
+#define ZX128_FIRST_SCREEN_T  14361
+#define ZX128_LINE_TSTATES    228
+
+typedef struct z80 {
+    uint8_t a, f, b, c, d, e, h, l;
+    uint8_t a_, f_, b_, c_, d_, e_, h_, l_;
+    uint16_t ix, iy, sp, pc;
+    uint8_t i, r;
+    uint8_t iff1, iff2, im;
+    uint8_t halted;
+    uint8_t ei_delay;           // EI: interrupts accepted after next instruction
+
+    unsigned long tstates;      // total T-states since reset
+    unsigned long frame_t;      // T-states within current frame
+    int contended;              // apply memory contention
+    unsigned long screen_t;     // first contended T-state of the frame
+    int line_t;                 // T-states per display line
+
+    uint8_t *mem;               // 64K address space (0x0000-0x3FFF is ROM)
+    uint8_t (*port_in)(void *ctx, uint16_t port);
+    void (*port_out)(void *ctx, uint16_t port, uint8_t value);
+    void *ctx;
+
+    unsigned int pending;       // T-state offset of the current access within the step
+    unsigned int delay;         // contention delay accumulated this step
+} z80;
+
+void z80_reset(z80 *cpu);
+
+// Execute one instruction (or one HALT cycle). Returns T-states used.
+int z80_step(z80 *cpu);
+
+// Raise the maskable interrupt. Returns T-states used (0 if masked).
+int z80_interrupt(z80 *cpu);
+
+#endif // Z80_CORE_H